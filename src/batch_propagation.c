@@ -0,0 +1,920 @@
+#include "batch_propagation.h"
+#include "solar_system.h"
+#include "tle_db.h"
+#include "defines.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//SGP4 constants (WGS72), as used by libpredict. Earth radius and time constants are in defines.h
+#define XKE 0.0743669161
+#define CK2 5.413080E-4
+#define CK4 0.62098875E-6
+#define QOMS2T 1.88027916E-9
+#define S_DENSITY 1.01222928
+#define XJ3 -2.53881E-6
+#define AE 1.0
+#define TOTHRD (2.0/3.0)
+#define XMNPDA 1.44E3
+#define E6A 1.0E-6
+
+//earth flattening, earth rotation rate relative to the sun and solar radius
+#define EARTH_FLATTENING 3.35281066474748E-3
+#define OMEGA_E 1.00273790934
+#define SOLAR_RADIUS 6.96000E5
+
+//minimum orbital period for deep space satellites (minutes)
+#define DEEP_SPACE_PERIOD 225.0
+
+//sun elevation below which satellites can be visible to the naked eye (degrees)
+#define NAUTICAL_TWILIGHT_SUN_ELEVATION -12.0
+
+//number of satellites propagated together through the kernel loops, chosen so that the intermediate arrays fit in L1 cache
+#define BATCH_BLOCK_SIZE 64
+
+//compile kernels both for AVX2 and for the baseline instruction set, with runtime selection
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define BATCH_PROPAGATION_KERNEL __attribute__((target_clones("avx2","default")))
+#endif
+#endif
+#ifndef BATCH_PROPAGATION_KERNEL
+#define BATCH_PROPAGATION_KERNEL
+#endif
+
+//number of double arrays in a satellite batch
+#define BATCH_NUM_ARRAYS 49
+
+//number of double arrays holding the SGP4 state, which come before the result arrays
+#define BATCH_NUM_STATE_ARRAYS 36
+
+//margin added to the footprint radius and subtracted from the inclination bound, covering the differences between geodetic
+//and geocentric latitudes and between mean and osculating elements (radians)
+#define PREFILTER_ANGLE_MARGIN (1.0*M_PI/180.0)
+
+//factor applied to the apogee radius and angular rate of deep space satellites, which are subject to larger perturbations
+#define PREFILTER_DEEP_SPACE_FACTOR 1.1
+
+//maximum time a satellite is skipped before it is propagated again (days)
+#define PREFILTER_MAX_SKIP (1.0/24.0)
+
+/**
+ * Get pointers to all double arrays in a satellite batch.
+ *
+ * \param batch Satellite batch
+ * \param ret_arrays Returned pointers to the array pointers, BATCH_NUM_ARRAYS long
+ * \return Number of arrays
+ **/
+static int batch_propagation_arrays(struct batch_propagation *batch, double ***ret_arrays)
+{
+	struct batch_sgp4_state *s = &(batch->sgp4);
+	double **arrays[] = {&s->epoch, &s->decay_time, &s->xmo, &s->xnodeo, &s->omegao, &s->eo, &s->xincl, &s->aodp, &s->xnodp,
+		&s->bstar, &s->c1, &s->c4, &s->c5, &s->d2, &s->d3, &s->d4, &s->t2cof, &s->t3cof, &s->t4cof, &s->t5cof, &s->xmdot,
+		&s->omgdot, &s->xnodot, &s->xnodcf, &s->omgcof, &s->xmcof, &s->eta, &s->delmo, &s->sinmo, &s->xlcof, &s->aycof,
+		&s->x3thm1, &s->x1mth2, &s->x7thm1, &s->cosio, &s->sinio,
+		&batch->position_x, &batch->position_y, &batch->position_z, &batch->velocity_x, &batch->velocity_y, &batch->velocity_z,
+		&batch->latitude, &batch->longitude, &batch->altitude, &batch->azimuth, &batch->elevation, &batch->range, &batch->range_rate};
+	int num_arrays = sizeof(arrays)/sizeof(arrays[0]);
+	memcpy(ret_arrays, arrays, sizeof(arrays));
+	return num_arrays;
+}
+
+struct batch_propagation *batch_propagation_create(int num_satellites)
+{
+	struct batch_propagation *batch = (struct batch_propagation*)calloc(1, sizeof(struct batch_propagation));
+	batch->num_satellites = num_satellites;
+	batch->orbital_elements = (const predict_orbital_elements_t**)calloc(num_satellites, sizeof(predict_orbital_elements_t*));
+	batch->use_libpredict = (bool*)calloc(num_satellites, sizeof(bool));
+	batch->eclipsed = (bool*)calloc(num_satellites, sizeof(bool));
+	batch->visible = (bool*)calloc(num_satellites, sizeof(bool));
+	batch->decayed = (bool*)calloc(num_satellites, sizeof(bool));
+	batch->earliest_rise = (double*)calloc(num_satellites, sizeof(double));
+	batch->propagated = (bool*)calloc(num_satellites, sizeof(bool));
+
+	double **arrays[BATCH_NUM_ARRAYS];
+	int num_arrays = batch_propagation_arrays(batch, arrays);
+	batch->data = (double*)calloc((size_t)num_arrays*num_satellites, sizeof(double));
+	for (int i=0; i < num_arrays; i++) {
+		*(arrays[i]) = batch->data + (size_t)i*num_satellites;
+	}
+	return batch;
+}
+
+void batch_propagation_destroy(struct batch_propagation **batch)
+{
+	free((*batch)->orbital_elements);
+	free((*batch)->use_libpredict);
+	free((*batch)->eclipsed);
+	free((*batch)->visible);
+	free((*batch)->decayed);
+	free((*batch)->earliest_rise);
+	free((*batch)->propagated);
+	free((*batch)->data);
+	if ((*batch)->gather_block != NULL) {
+		batch_propagation_destroy(&((*batch)->gather_block));
+	}
+	free(*batch);
+	*batch = NULL;
+}
+
+void batch_propagation_set_satellite(struct batch_propagation *batch, int index, const predict_orbital_elements_t *orbital_elements)
+{
+	struct batch_sgp4_state *s = &(batch->sgp4);
+	batch->orbital_elements[index] = orbital_elements;
+	batch->earliest_rise[index] = 0; //propagate in next run
+
+	//orbital elements in SGP4 units
+	double xno = orbital_elements->mean_motion*TWOPI/XMNPDA;
+	double eo = orbital_elements->eccentricity;
+	double xincl = orbital_elements->inclination*M_PI/180.0;
+	double omegao = orbital_elements->argument_of_perigee*M_PI/180.0;
+	double xmo = orbital_elements->mean_anomaly*M_PI/180.0;
+	double bstar = orbital_elements->bstar_drag_term/AE;
+	double epoch = tle_db_epoch(orbital_elements->epoch_year, orbital_elements->epoch_day);
+
+	s->epoch[index] = epoch;
+	s->xmo[index] = xmo;
+	s->xnodeo[index] = orbital_elements->right_ascension*M_PI/180.0;
+	s->omegao[index] = omegao;
+	s->eo[index] = eo;
+	s->xincl[index] = xincl;
+	s->bstar[index] = bstar;
+
+	//decay criterion of libpredict
+	s->decay_time[index] = epoch + (16.666666 - orbital_elements->mean_motion)/(10.0*fabs(orbital_elements->derivative_mean_motion));
+
+	//recover original mean motion and semimajor axis from the elements
+	double a1 = pow(XKE/xno, TOTHRD);
+	double cosio = cos(xincl);
+	double theta2 = cosio*cosio;
+	double x3thm1 = 3*theta2 - 1.0;
+	double eosq = eo*eo;
+	double betao2 = 1 - eosq;
+	double betao = sqrt(betao2);
+	double del1 = 1.5*CK2*x3thm1/(a1*a1*betao*betao2);
+	double ao = a1*(1 - del1*(0.5*TOTHRD + del1*(1 + 134.0/81.0*del1)));
+	double delo = 1.5*CK2*x3thm1/(ao*ao*betao*betao2);
+	double xnodp = xno/(1 + delo);
+	double aodp = ao/(1 - delo);
+
+	//deep space satellites are handled by libpredict
+	batch->use_libpredict[index] = (TWOPI/xnodp >= DEEP_SPACE_PERIOD);
+
+	//simplified drag model for perigee below 220 km
+	bool simple = (aodp*(1 - eo)/AE) < (220/XKMPER + AE);
+
+	//altitude dependent atmospheric density parameters for perigee below 156 km
+	double s4 = S_DENSITY;
+	double qoms24 = QOMS2T;
+	double perige = (aodp*(1 - eo) - AE)*XKMPER;
+	if (perige < 156.0) {
+		s4 = perige - 78.0;
+		if (perige <= 98.0) {
+			s4 = 20.0;
+		}
+		qoms24 = pow((120 - s4)*AE/XKMPER, 4);
+		s4 = s4/XKMPER + AE;
+	}
+
+	double pinvsq = 1/(aodp*aodp*betao2*betao2);
+	double tsi = 1/(aodp - s4);
+	double eta = aodp*eo*tsi;
+	double etasq = eta*eta;
+	double eeta = eo*eta;
+	double psisq = fabs(1 - etasq);
+	double coef = qoms24*pow(tsi, 4);
+	double coef1 = coef/pow(psisq, 3.5);
+	double c2 = coef1*xnodp*(aodp*(1 + 1.5*etasq + eeta*(4 + etasq)) + 0.75*CK2*tsi/psisq*x3thm1*(8 + 3*etasq*(8 + etasq)));
+	double c1 = bstar*c2;
+	double sinio = sin(xincl);
+	double a3ovk2 = -XJ3/CK2*AE*AE*AE;
+	double c3 = 0;
+	if (eo > 1.0e-4) {
+		c3 = coef*tsi*a3ovk2*xnodp*AE*sinio/eo;
+	}
+	double x1mth2 = 1 - theta2;
+	double c4 = 2*xnodp*coef1*aodp*betao2*(eta*(2 + 0.5*etasq) + eo*(0.5 + 2*etasq) - 2*CK2*tsi/(aodp*psisq)*(-3*x3thm1*(1 - 2*eeta + etasq*(1.5 - 0.5*eeta)) + 0.75*x1mth2*(2*etasq - eeta*(1 + etasq))*cos(2*omegao)));
+	double c5 = 2*coef1*aodp*betao2*(1 + 2.75*(etasq + eeta) + eeta*etasq);
+	double theta4 = theta2*theta2;
+	double temp1 = 3*CK2*pinvsq*xnodp;
+	double temp2 = temp1*CK2*pinvsq;
+	double temp3 = 1.25*CK4*pinvsq*pinvsq*xnodp;
+	double xmdot = xnodp + 0.5*temp1*betao*x3thm1 + 0.0625*temp2*betao*(13 - 78*theta2 + 137*theta4);
+	double x1m5th = 1 - 5*theta2;
+	double omgdot = -0.5*temp1*x1m5th + 0.0625*temp2*(7 - 114*theta2 + 395*theta4) + temp3*(3 - 36*theta2 + 49*theta4);
+	double xhdot1 = -temp1*cosio;
+	double xnodot = xhdot1 + (0.5*temp2*(4 - 19*theta2) + 2*temp3*(3 - 7*theta2))*cosio;
+	double omgcof = bstar*c3*cos(omegao);
+	double xmcof = 0;
+	if (eo > 1.0e-4) {
+		xmcof = -TOTHRD*coef*bstar*AE/eeta;
+	}
+
+	//avoid division by zero for inclination of 180 degrees
+	double cosio_1 = 1 + cosio;
+	if (fabs(cosio_1) < 1.5e-12) {
+		cosio_1 = 1.5e-12;
+	}
+
+	s->aodp[index] = aodp;
+	s->xnodp[index] = xnodp;
+	s->c1[index] = c1;
+	s->c4[index] = c4;
+	s->t2cof[index] = 1.5*c1;
+	s->xmdot[index] = xmdot;
+	s->omgdot[index] = omgdot;
+	s->xnodot[index] = xnodot;
+	s->xnodcf[index] = 3.5*betao2*xhdot1*c1;
+	s->eta[index] = eta;
+	s->delmo[index] = pow(1 + eta*cos(xmo), 3);
+	s->sinmo[index] = sin(xmo);
+	s->xlcof[index] = 0.125*a3ovk2*sinio*(3 + 5*cosio)/cosio_1;
+	s->aycof[index] = 0.25*a3ovk2*sinio;
+	s->x3thm1[index] = x3thm1;
+	s->x1mth2[index] = x1mth2;
+	s->x7thm1[index] = 7*theta2 - 1;
+	s->cosio[index] = cosio;
+	s->sinio[index] = sinio;
+
+	//full drag model terms, zero for the simplified model so that both are handled by the same kernel
+	s->c5[index] = 0;
+	s->omgcof[index] = 0;
+	s->xmcof[index] = 0;
+	s->d2[index] = 0;
+	s->d3[index] = 0;
+	s->d4[index] = 0;
+	s->t3cof[index] = 0;
+	s->t4cof[index] = 0;
+	s->t5cof[index] = 0;
+	if (!simple) {
+		double c1sq = c1*c1;
+		double d2 = 4*aodp*tsi*c1sq;
+		double temp = d2*tsi*c1/3.0;
+		double d3 = (17*aodp + s4)*temp;
+		double d4 = 0.5*temp*aodp*tsi*(221*aodp + 31*s4)*c1;
+		s->c5[index] = c5;
+		s->omgcof[index] = omgcof;
+		s->xmcof[index] = xmcof;
+		s->d2[index] = d2;
+		s->d3[index] = d3;
+		s->d4[index] = d4;
+		s->t3cof[index] = d2 + 2*c1sq;
+		s->t4cof[index] = 0.25*(3*d3 + c1*(12*d2 + 10*c1sq));
+		s->t5cof[index] = 0.2*(3*d4 + 12*c1*d3 + 6*d2*d2 + 15*c1sq*(2*d2 + c1sq));
+	}
+}
+
+void batch_propagation_copy_satellite(struct batch_propagation *batch, int index, const struct batch_propagation *source, int source_index)
+{
+	batch->orbital_elements[index] = source->orbital_elements[source_index];
+	batch->use_libpredict[index] = source->use_libpredict[source_index];
+
+	double **arrays[BATCH_NUM_ARRAYS];
+	double **source_arrays[BATCH_NUM_ARRAYS];
+	int num_arrays = batch_propagation_arrays(batch, arrays);
+	batch_propagation_arrays((struct batch_propagation*)source, source_arrays);
+	for (int i=0; i < num_arrays; i++) {
+		(*arrays[i])[index] = (*source_arrays[i])[source_index];
+	}
+	batch->eclipsed[index] = source->eclipsed[source_index];
+	batch->visible[index] = source->visible[source_index];
+	batch->decayed[index] = source->decayed[source_index];
+	batch->earliest_rise[index] = source->earliest_rise[source_index];
+	batch->propagated[index] = source->propagated[source_index];
+
+	//earliest rise times are only valid for the time and observer of the propagation they were calculated in
+	batch->time = source->time;
+	memcpy(batch->prefilter_observer, source->prefilter_observer, sizeof(batch->prefilter_observer));
+}
+
+/**
+ * Reduce angle to [0, 2*pi).
+ *
+ * \param x Angle
+ * \return Reduced angle
+ **/
+static inline double batch_propagation_fmod2p(double x)
+{
+	double ret = fmod(x, TWOPI);
+	if (ret < 0.0) {
+		ret += TWOPI;
+	}
+	return ret;
+}
+
+/**
+ * Calculate Greenwich mean sidereal time, as ThetaG_JD() in libpredict.
+ *
+ * \param jd Julian date
+ * \return Sidereal time (radians)
+ **/
+static double batch_propagation_theta_g(double jd)
+{
+	double ut = fmod(jd + 0.5, 1.0);
+	jd = jd - ut;
+	double tu = (jd - 2451545.0)/36525;
+	double gmst = 24110.54841 + tu*(8640184.812866 + tu*(0.093104 - tu*6.2E-6));
+	gmst = fmod(gmst + SECDAY*OMEGA_E*ut, SECDAY);
+	if (gmst < 0.0) {
+		gmst += SECDAY;
+	}
+	return TWOPI*gmst/SECDAY;
+}
+
+/**
+ * Quantities common to all satellites in a propagation step.
+ **/
+struct batch_tick {
+	///Time
+	predict_julian_date_t time;
+	///Greenwich mean sidereal time (radians)
+	double theta_g;
+	///Observer ECI position (km)
+	double observer_position[3];
+	///Observer ECI velocity (km/s)
+	double observer_velocity[3];
+	///Sine and cosine of observer latitude
+	double sin_lat, cos_lat;
+	///Sine and cosine of observer local sidereal time
+	double sin_theta, cos_theta;
+	///Sun ECI position (km)
+	double sun[3];
+	///Distance to the sun (km)
+	double sun_distance;
+	///Whether the sun is low enough for satellites to be visible
+	bool dark;
+};
+
+/**
+ * Propagate and observe a block of satellites.
+ *
+ * Split into loops over intermediate arrays. Loops without calls to transcendental functions are vectorized,
+ * the remaining loops run one satellite at a time.
+ *
+ * \param batch Satellite batch
+ * \param begin Index of first satellite in the block
+ * \param n Number of satellites in the block, at most BATCH_BLOCK_SIZE
+ * \param tick Common quantities
+ **/
+BATCH_PROPAGATION_KERNEL
+static void batch_propagation_block(struct batch_propagation *batch, int begin, int n, const struct batch_tick *tick)
+{
+	const struct batch_sgp4_state *s = &(batch->sgp4);
+	const double *epoch = s->epoch + begin;
+	const double *xmo = s->xmo + begin;
+	const double *xnodeo = s->xnodeo + begin;
+	const double *omegao = s->omegao + begin;
+	const double *eo = s->eo + begin;
+	const double *xincl = s->xincl + begin;
+	const double *aodp = s->aodp + begin;
+	const double *xnodp = s->xnodp + begin;
+	const double *bstar = s->bstar + begin;
+	const double *c1 = s->c1 + begin;
+	const double *c4 = s->c4 + begin;
+	const double *c5 = s->c5 + begin;
+	const double *d2 = s->d2 + begin;
+	const double *d3 = s->d3 + begin;
+	const double *d4 = s->d4 + begin;
+	const double *t2cof = s->t2cof + begin;
+	const double *t3cof = s->t3cof + begin;
+	const double *t4cof = s->t4cof + begin;
+	const double *t5cof = s->t5cof + begin;
+	const double *xmdot = s->xmdot + begin;
+	const double *omgdot = s->omgdot + begin;
+	const double *xnodot = s->xnodot + begin;
+	const double *xnodcf = s->xnodcf + begin;
+	const double *omgcof = s->omgcof + begin;
+	const double *xmcof = s->xmcof + begin;
+	const double *eta = s->eta + begin;
+	const double *delmo = s->delmo + begin;
+	const double *sinmo = s->sinmo + begin;
+	const double *xlcof = s->xlcof + begin;
+	const double *aycof = s->aycof + begin;
+	const double *x3thm1 = s->x3thm1 + begin;
+	const double *x1mth2 = s->x1mth2 + begin;
+	const double *x7thm1 = s->x7thm1 + begin;
+	const double *cosio = s->cosio + begin;
+	const double *sinio = s->sinio + begin;
+
+	double tsince[BATCH_BLOCK_SIZE], xmdf[BATCH_BLOCK_SIZE], omgadf[BATCH_BLOCK_SIZE], xnode[BATCH_BLOCK_SIZE];
+	double cube[BATCH_BLOCK_SIZE], xmp[BATCH_BLOCK_SIZE], omega[BATCH_BLOCK_SIZE], tempa[BATCH_BLOCK_SIZE], tempe[BATCH_BLOCK_SIZE], templ[BATCH_BLOCK_SIZE];
+	double sin_xmp[BATCH_BLOCK_SIZE], sin_omega[BATCH_BLOCK_SIZE], cos_omega[BATCH_BLOCK_SIZE];
+	double a[BATCH_BLOCK_SIZE], xn[BATCH_BLOCK_SIZE], axn[BATCH_BLOCK_SIZE], ayn[BATCH_BLOCK_SIZE], capu[BATCH_BLOCK_SIZE];
+	double sinepw[BATCH_BLOCK_SIZE], cosepw[BATCH_BLOCK_SIZE];
+	double sinu[BATCH_BLOCK_SIZE], cosu[BATCH_BLOCK_SIZE], rk[BATCH_BLOCK_SIZE], duk[BATCH_BLOCK_SIZE], xnodek[BATCH_BLOCK_SIZE], xinck[BATCH_BLOCK_SIZE], rdotk[BATCH_BLOCK_SIZE], rfdotk[BATCH_BLOCK_SIZE];
+	double sinuk[BATCH_BLOCK_SIZE], cosuk[BATCH_BLOCK_SIZE], sinik[BATCH_BLOCK_SIZE], cosik[BATCH_BLOCK_SIZE], sinnok[BATCH_BLOCK_SIZE], cosnok[BATCH_BLOCK_SIZE];
+	double pos_x[BATCH_BLOCK_SIZE], pos_y[BATCH_BLOCK_SIZE], pos_z[BATCH_BLOCK_SIZE], vel_x[BATCH_BLOCK_SIZE], vel_y[BATCH_BLOCK_SIZE], vel_z[BATCH_BLOCK_SIZE];
+	double top_s[BATCH_BLOCK_SIZE], top_e[BATCH_BLOCK_SIZE], top_z[BATCH_BLOCK_SIZE], range[BATCH_BLOCK_SIZE], range_rate[BATCH_BLOCK_SIZE];
+
+	//secular gravity and atmospheric drag
+	for (int k=0; k < n; k++) {
+		tsince[k] = (tick->time - epoch[k])*XMNPDA;
+		xmdf[k] = xmo[k] + xmdot[k]*tsince[k];
+		omgadf[k] = omegao[k] + omgdot[k]*tsince[k];
+		double xnoddf = xnodeo[k] + xnodot[k]*tsince[k];
+		xnode[k] = xnoddf + xnodcf[k]*tsince[k]*tsince[k];
+	}
+	for (int k=0; k < n; k++) {
+		double temp = 1 + eta[k]*cos(xmdf[k]);
+		cube[k] = temp*temp*temp;
+	}
+	for (int k=0; k < n; k++) {
+		double tsq = tsince[k]*tsince[k];
+		double tcube = tsq*tsince[k];
+		double tfour = tsince[k]*tcube;
+		double delm = xmcof[k]*(cube[k] - delmo[k]);
+		double temp = omgcof[k]*tsince[k] + delm;
+		xmp[k] = xmdf[k] + temp;
+		omega[k] = omgadf[k] - temp;
+		tempa[k] = 1 - c1[k]*tsince[k] - d2[k]*tsq - d3[k]*tcube - d4[k]*tfour;
+		tempe[k] = bstar[k]*c4[k]*tsince[k];
+		templ[k] = t2cof[k]*tsq + t3cof[k]*tcube + tfour*(t4cof[k] + tsince[k]*t5cof[k]);
+	}
+	for (int k=0; k < n; k++) {
+		sin_xmp[k] = sin(xmp[k]);
+		sin_omega[k] = sin(omega[k]);
+		cos_omega[k] = cos(omega[k]);
+	}
+
+	//long period periodics
+	for (int k=0; k < n; k++) {
+		double e = eo[k] - (tempe[k] + bstar[k]*c5[k]*(sin_xmp[k] - sinmo[k]));
+		a[k] = aodp[k]*tempa[k]*tempa[k];
+		double xl = xmp[k] + omega[k] + xnode[k] + xnodp[k]*templ[k];
+		double beta2 = 1 - e*e;
+		xn[k] = XKE/(a[k]*sqrt(a[k]));
+		axn[k] = e*cos_omega[k];
+		double temp = 1/(a[k]*beta2);
+		double xll = temp*xlcof[k]*axn[k];
+		double aynl = temp*aycof[k];
+		ayn[k] = e*sin_omega[k] + aynl;
+		capu[k] = xl + xll - xnode[k];
+	}
+
+	//solve Kepler's equation
+	for (int k=0; k < n; k++) {
+		double u = batch_propagation_fmod2p(capu[k]);
+		double temp2 = u;
+		double sin_e = 0, cos_e = 1;
+		for (int i=0; i < 10; i++) {
+			sin_e = sin(temp2);
+			cos_e = cos(temp2);
+			double epw = (u - ayn[k]*cos_e + axn[k]*sin_e - temp2)/(1 - axn[k]*cos_e - ayn[k]*sin_e) + temp2;
+			if (fabs(epw - temp2) <= E6A) {
+				break;
+			}
+			temp2 = epw;
+		}
+		sinepw[k] = sin_e;
+		cosepw[k] = cos_e;
+	}
+
+	//short period periodics
+	for (int k=0; k < n; k++) {
+		double temp3 = axn[k]*sinepw[k];
+		double temp4 = ayn[k]*cosepw[k];
+		double temp5 = axn[k]*cosepw[k];
+		double temp6 = ayn[k]*sinepw[k];
+		double ecose = temp5 + temp6;
+		double esine = temp3 - temp4;
+		double elsq = axn[k]*axn[k] + ayn[k]*ayn[k];
+		double temp = 1 - elsq;
+		double pl = a[k]*temp;
+		double r = a[k]*(1 - ecose);
+		double temp1 = 1/r;
+		double rdot = XKE*sqrt(a[k])*esine*temp1;
+		double rfdot = XKE*sqrt(pl)*temp1;
+		double temp2 = a[k]*temp1;
+		double betal = sqrt(temp);
+		temp3 = 1/(1 + betal);
+		cosu[k] = temp2*(cosepw[k] - axn[k] + ayn[k]*esine*temp3);
+		sinu[k] = temp2*(sinepw[k] - ayn[k] - axn[k]*esine*temp3);
+		double sin2u = 2*sinu[k]*cosu[k];
+		double cos2u = 2*cosu[k]*cosu[k] - 1;
+		temp = 1/pl;
+		temp1 = CK2*temp;
+		temp2 = temp1*temp;
+
+		rk[k] = r*(1 - 1.5*temp2*betal*x3thm1[k]) + 0.5*temp1*x1mth2[k]*cos2u;
+		duk[k] = -0.25*temp2*x7thm1[k]*sin2u;
+		xnodek[k] = xnode[k] + 1.5*temp2*cosio[k]*sin2u;
+		xinck[k] = xincl[k] + 1.5*temp2*cosio[k]*sinio[k]*cos2u;
+		rdotk[k] = rdot - xn[k]*temp1*x1mth2[k]*sin2u;
+		rfdotk[k] = rfdot + xn[k]*temp1*(x1mth2[k]*cos2u + 1.5*x3thm1[k]);
+	}
+	for (int k=0; k < n; k++) {
+		double uk = atan2(sinu[k], cosu[k]) + duk[k];
+		sinuk[k] = sin(uk);
+		cosuk[k] = cos(uk);
+		sinik[k] = sin(xinck[k]);
+		cosik[k] = cos(xinck[k]);
+		sinnok[k] = sin(xnodek[k]);
+		cosnok[k] = cos(xnodek[k]);
+	}
+
+	//orientation vectors, position and velocity, and topocentric coordinates
+	for (int k=0; k < n; k++) {
+		double xmx = -sinnok[k]*cosik[k];
+		double xmy = cosnok[k]*cosik[k];
+		double ux = xmx*sinuk[k] + cosnok[k]*cosuk[k];
+		double uy = xmy*sinuk[k] + sinnok[k]*cosuk[k];
+		double uz = sinik[k]*sinuk[k];
+		double vx = xmx*cosuk[k] - cosnok[k]*sinuk[k];
+		double vy = xmy*cosuk[k] - sinnok[k]*sinuk[k];
+		double vz = sinik[k]*cosuk[k];
+
+		pos_x[k] = rk[k]*ux*XKMPER;
+		pos_y[k] = rk[k]*uy*XKMPER;
+		pos_z[k] = rk[k]*uz*XKMPER;
+		vel_x[k] = (rdotk[k]*ux + rfdotk[k]*vx)*XKMPER/60.0;
+		vel_y[k] = (rdotk[k]*uy + rfdotk[k]*vy)*XKMPER/60.0;
+		vel_z[k] = (rdotk[k]*uz + rfdotk[k]*vz)*XKMPER/60.0;
+
+		double range_x = pos_x[k] - tick->observer_position[0];
+		double range_y = pos_y[k] - tick->observer_position[1];
+		double range_z = pos_z[k] - tick->observer_position[2];
+		double rgvel_x = vel_x[k] - tick->observer_velocity[0];
+		double rgvel_y = vel_y[k] - tick->observer_velocity[1];
+		double rgvel_z = vel_z[k] - tick->observer_velocity[2];
+		range[k] = sqrt(range_x*range_x + range_y*range_y + range_z*range_z);
+		range_rate[k] = (range_x*rgvel_x + range_y*rgvel_y + range_z*rgvel_z)/range[k];
+		top_s[k] = tick->sin_lat*tick->cos_theta*range_x + tick->sin_lat*tick->sin_theta*range_y - tick->cos_lat*range_z;
+		top_e[k] = -tick->sin_theta*range_x + tick->cos_theta*range_y;
+		top_z[k] = tick->cos_lat*tick->cos_theta*range_x + tick->cos_lat*tick->sin_theta*range_y + tick->sin_lat*range_z;
+	}
+
+	//angles, geodetic coordinates and eclipse status
+	double e2 = EARTH_FLATTENING*(2 - EARTH_FLATTENING);
+	for (int k=0; k < n; k++) {
+		int i = begin + k;
+		batch->position_x[i] = pos_x[k];
+		batch->position_y[i] = pos_y[k];
+		batch->position_z[i] = pos_z[k];
+		batch->velocity_x[i] = vel_x[k];
+		batch->velocity_y[i] = vel_y[k];
+		batch->velocity_z[i] = vel_z[k];
+		batch->range[i] = range[k];
+		batch->range_rate[i] = range_rate[k];
+
+		double azimuth = atan(-top_e[k]/top_s[k]);
+		if (top_s[k] > 0.0) {
+			azimuth += M_PI;
+		}
+		if (azimuth < 0.0) {
+			azimuth += TWOPI;
+		}
+		double sin_elevation = top_z[k]/range[k];
+		if (sin_elevation > 1.0) {
+			sin_elevation = 1.0;
+		} else if (sin_elevation < -1.0) {
+			sin_elevation = -1.0;
+		}
+		batch->azimuth[i] = azimuth;
+		batch->elevation[i] = asin(sin_elevation);
+
+		//geodetic latitude, by iteration
+		double r = sqrt(pos_x[k]*pos_x[k] + pos_y[k]*pos_y[k]);
+		double lat = atan2(pos_z[k], r);
+		double phi, c;
+		do {
+			phi = lat;
+			double sinphi = sin(phi);
+			c = 1/sqrt(1 - e2*sinphi*sinphi);
+			lat = atan2(pos_z[k] + XKMPER*c*e2*sinphi, r);
+		} while (fabs(lat - phi) >= 1E-10);
+		double lon = batch_propagation_fmod2p(atan2(pos_y[k], pos_x[k]) - tick->theta_g);
+		if (lon > M_PI) {
+			lon -= TWOPI;
+		}
+		batch->latitude[i] = lat;
+		batch->longitude[i] = lon;
+		batch->altitude[i] = r/cos(lat) - XKMPER*c;
+
+		//eclipse by the earth, as is_eclipsed() in libpredict
+		double pos_norm = sqrt(pos_x[k]*pos_x[k] + pos_y[k]*pos_y[k] + pos_z[k]*pos_z[k]);
+		double sd_earth = asin(XKMPER/pos_norm);
+		double rho_x = tick->sun[0] - pos_x[k];
+		double rho_y = tick->sun[1] - pos_y[k];
+		double rho_z = tick->sun[2] - pos_z[k];
+		double sd_sun = asin(SOLAR_RADIUS/sqrt(rho_x*rho_x + rho_y*rho_y + rho_z*rho_z));
+		double cos_delta = -(tick->sun[0]*pos_x[k] + tick->sun[1]*pos_y[k] + tick->sun[2]*pos_z[k])/(tick->sun_distance*pos_norm);
+		if (cos_delta > 1.0) {
+			cos_delta = 1.0;
+		} else if (cos_delta < -1.0) {
+			cos_delta = -1.0;
+		}
+		double depth = sd_earth - sd_sun - acos(cos_delta);
+		bool eclipsed = (sd_earth >= sd_sun) && (depth >= 0);
+
+		batch->eclipsed[i] = eclipsed;
+		batch->visible[i] = !eclipsed && tick->dark && (batch->elevation[i] > 0);
+		batch->decayed[i] = batch->sgp4.decay_time[i] < tick->time;
+	}
+}
+
+/**
+ * Propagate and observe a single satellite using libpredict, and store the results in the batch arrays.
+ *
+ * \param batch Satellite batch
+ * \param index Satellite index
+ * \param observer Observer
+ * \param time Time
+ **/
+static void batch_propagation_libpredict(struct batch_propagation *batch, int index, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	struct predict_position orbit;
+	struct predict_observation obs;
+	predict_orbit(batch->orbital_elements[index], &orbit, time);
+	predict_observe_orbit(observer, &orbit, &obs);
+
+	batch->position_x[index] = orbit.position[0];
+	batch->position_y[index] = orbit.position[1];
+	batch->position_z[index] = orbit.position[2];
+	batch->velocity_x[index] = orbit.velocity[0];
+	batch->velocity_y[index] = orbit.velocity[1];
+	batch->velocity_z[index] = orbit.velocity[2];
+	batch->latitude[index] = orbit.latitude;
+	batch->longitude[index] = orbit.longitude;
+	batch->altitude[index] = orbit.altitude;
+	batch->eclipsed[index] = orbit.eclipsed;
+	batch->decayed[index] = orbit.decayed;
+	batch->azimuth[index] = obs.azimuth;
+	batch->elevation[index] = obs.elevation;
+	batch->range[index] = obs.range;
+	batch->range_rate[index] = obs.range_rate;
+	batch->visible[index] = obs.visible;
+}
+
+/**
+ * Propagate and observe satellites gathered from different blocks of the batch, by copying their SGP4 state into
+ * a single block, and copying the results back.
+ *
+ * \param batch Satellite batch
+ * \param indices Indices of the satellites
+ * \param n Number of satellites, at most BATCH_BLOCK_SIZE
+ * \param tick Common quantities
+ **/
+static void batch_propagation_gathered_block(struct batch_propagation *batch, const int *indices, int n, const struct batch_tick *tick)
+{
+	if (batch->gather_block == NULL) {
+		batch->gather_block = batch_propagation_create(BATCH_BLOCK_SIZE);
+	}
+	struct batch_propagation *block = batch->gather_block;
+
+	double **arrays[BATCH_NUM_ARRAYS];
+	double **block_arrays[BATCH_NUM_ARRAYS];
+	int num_arrays = batch_propagation_arrays(batch, arrays);
+	batch_propagation_arrays(block, block_arrays);
+
+	for (int j=0; j < BATCH_NUM_STATE_ARRAYS; j++) {
+		for (int k=0; k < n; k++) {
+			(*block_arrays[j])[k] = (*arrays[j])[indices[k]];
+		}
+	}
+
+	batch_propagation_block(block, 0, n, tick);
+
+	for (int j=BATCH_NUM_STATE_ARRAYS; j < num_arrays; j++) {
+		for (int k=0; k < n; k++) {
+			(*arrays[j])[indices[k]] = (*block_arrays[j])[k];
+		}
+	}
+	for (int k=0; k < n; k++) {
+		batch->eclipsed[indices[k]] = block->eclipsed[k];
+		batch->visible[indices[k]] = block->visible[k];
+		batch->decayed[indices[k]] = block->decayed[k];
+	}
+}
+
+/**
+ * Calculate the earliest time at which a satellite can rise above the horizon of the observer or decay, from the
+ * results of its propagation.
+ *
+ * \param batch Satellite batch
+ * \param index Satellite index
+ * \param observer Observer
+ * \param time Time of the propagation
+ * \return Earliest rise time
+ **/
+static predict_julian_date_t batch_propagation_earliest_rise(const struct batch_propagation *batch, int index, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	const struct batch_sgp4_state *s = &(batch->sgp4);
+	double factor = batch->use_libpredict[index] ? PREFILTER_DEEP_SPACE_FACTOR : 1.0;
+	double polar_radius = AE*(1 - EARTH_FLATTENING);
+	double apogee = s->aodp[index]*(1 + s->eo[index])*factor;
+	if ((batch->elevation[index] > 0) || batch->decayed[index] || (apogee <= polar_radius)) {
+		return time;
+	}
+
+	//footprint radius at apogee as an earth central angle, extended by the horizon dip at the observer altitude
+	double observer_altitude = fmax(observer->altitude, 0)/1000.0/XKMPER;
+	double footprint = acos(polar_radius/apogee) + acos(polar_radius/(polar_radius + observer_altitude)) + PREFILTER_ANGLE_MARGIN;
+
+	predict_julian_date_t earliest_rise = time + PREFILTER_MAX_SKIP;
+	if (s->decay_time[index] < earliest_rise) {
+		earliest_rise = s->decay_time[index];
+	}
+
+	//sub-satellite point never gets further from the equator than the inclination
+	double max_latitude = s->xincl[index];
+	if (max_latitude > M_PI/2.0) {
+		max_latitude = M_PI - max_latitude;
+	}
+	if (fabs(observer->latitude) - max_latitude - PREFILTER_ANGLE_MARGIN > footprint) {
+		return earliest_rise;
+	}
+
+	//central angle between the sub-satellite point and the observer
+	double latitude = batch->latitude[index];
+	double cos_distance = sin(latitude)*sin(observer->latitude) + cos(latitude)*cos(observer->latitude)*cos(batch->longitude[index] - observer->longitude);
+	if (cos_distance > 1.0) {
+		cos_distance = 1.0;
+	} else if (cos_distance < -1.0) {
+		cos_distance = -1.0;
+	}
+	double distance = acos(cos_distance);
+	if (distance <= footprint) {
+		return time;
+	}
+
+	//upper bound for the angular rate of the sub-satellite point: angular rate at perigee, precession and earth rotation (radians/day)
+	double eo = s->eo[index];
+	double perigee_factor = (1 + eo)*(1 + eo)/pow(1 - eo*eo, 1.5);
+	double rate = ((fabs(s->xmdot[index])*perigee_factor + fabs(s->omgdot[index]) + fabs(s->xnodot[index]))*XMNPDA + TWOPI*OMEGA_E)*factor;
+	if (time + (distance - footprint)/rate < earliest_rise) {
+		earliest_rise = time + (distance - footprint)/rate;
+	}
+	return earliest_rise;
+}
+
+/**
+ * Calculate the quantities common to all satellites in a propagation step.
+ *
+ * \param observer Observer
+ * \param time Time
+ * \param tick Returned common quantities
+ **/
+static void batch_propagation_tick(const predict_observer_t *observer, predict_julian_date_t time, struct batch_tick *tick)
+{
+	tick->time = time;
+
+	//observer position and velocity, as Calculate_User_PosVel() in libpredict
+	double jd = time + JULIAN_TIME_DIFF;
+	tick->theta_g = batch_propagation_theta_g(jd);
+	double theta = batch_propagation_fmod2p(tick->theta_g + observer->longitude);
+	double sin_lat = sin(observer->latitude);
+	double cos_lat = cos(observer->latitude);
+	double altitude = observer->altitude/1000.0;
+	double c = 1/sqrt(1 + EARTH_FLATTENING*(EARTH_FLATTENING - 2)*sin_lat*sin_lat);
+	double sq = (1 - EARTH_FLATTENING)*(1 - EARTH_FLATTENING)*c;
+	double achcp = (XKMPER*c + altitude)*cos_lat;
+	double mfactor = TWOPI*(OMEGA_E/SECDAY);
+	tick->observer_position[0] = achcp*cos(theta);
+	tick->observer_position[1] = achcp*sin(theta);
+	tick->observer_position[2] = (XKMPER*sq + altitude)*sin_lat;
+	tick->observer_velocity[0] = -mfactor*tick->observer_position[1];
+	tick->observer_velocity[1] = mfactor*tick->observer_position[0];
+	tick->observer_velocity[2] = 0;
+	tick->sin_lat = sin_lat;
+	tick->cos_lat = cos_lat;
+	tick->sin_theta = sin(theta);
+	tick->cos_theta = cos(theta);
+
+	//sun position for eclipse calculations, and sun elevation for visibility
+	solar_system_sun_position(time, tick->sun);
+	tick->sun_distance = sqrt(tick->sun[0]*tick->sun[0] + tick->sun[1]*tick->sun[1] + tick->sun[2]*tick->sun[2]);
+	struct predict_observation sun_obs;
+	solar_system_observe_sun(observer, time, &sun_obs);
+	tick->dark = sun_obs.elevation*180.0/M_PI < NAUTICAL_TWILIGHT_SUN_ELEVATION;
+}
+
+/**
+ * Propagate the satellites of the batch, and update their earliest rise times.
+ *
+ * \param batch Satellite batch
+ * \param observer Observer
+ * \param time Time
+ * \param required Whether each satellite has to be propagated regardless of its earliest rise time. Can be NULL
+ * \param prefilter Whether to skip satellites that can not be above the horizon, or to propagate all satellites
+ **/
+static void batch_propagation_run_satellites(struct batch_propagation *batch, const predict_observer_t *observer, predict_julian_date_t time, const bool *required, bool prefilter)
+{
+	struct batch_tick tick;
+	batch_propagation_tick(observer, time, &tick);
+
+	//earliest rise times are only valid for the observer they were calculated for, and for later times
+	double prefilter_observer[3] = {observer->latitude, observer->longitude, observer->altitude};
+	if ((memcmp(prefilter_observer, batch->prefilter_observer, sizeof(prefilter_observer)) != 0) || (time < batch->time)) {
+		prefilter = false;
+		memcpy(batch->prefilter_observer, prefilter_observer, sizeof(prefilter_observer));
+	}
+	for (int i=0; i < batch->num_satellites; i++) {
+		batch->propagated[i] = !prefilter || (time >= batch->earliest_rise[i]) || ((required != NULL) && required[i]);
+	}
+
+	//propagate fully selected blocks in place, and gather the selected satellites of the remaining blocks
+	int gathered[BATCH_BLOCK_SIZE];
+	int num_gathered = 0;
+	for (int begin=0; begin < batch->num_satellites; begin += BATCH_BLOCK_SIZE) {
+		int n = batch->num_satellites - begin;
+		if (n > BATCH_BLOCK_SIZE) {
+			n = BATCH_BLOCK_SIZE;
+		}
+
+		int num_selected = 0;
+		for (int i=begin; i < begin + n; i++) {
+			num_selected += batch->propagated[i];
+		}
+		if (num_selected == n) {
+			batch_propagation_block(batch, begin, n, &tick);
+			continue;
+		}
+
+		for (int i=begin; i < begin + n; i++) {
+			if (batch->propagated[i] && !batch->use_libpredict[i]) {
+				gathered[num_gathered++] = i;
+			}
+			if (num_gathered == BATCH_BLOCK_SIZE) {
+				batch_propagation_gathered_block(batch, gathered, num_gathered, &tick);
+				num_gathered = 0;
+			}
+		}
+	}
+	if (num_gathered > 0) {
+		batch_propagation_gathered_block(batch, gathered, num_gathered, &tick);
+	}
+
+	//results of deep space satellites are replaced by libpredict's
+	for (int i=0; i < batch->num_satellites; i++) {
+		if (batch->use_libpredict[i] && batch->propagated[i]) {
+			batch_propagation_libpredict(batch, i, observer, time);
+		}
+	}
+
+	for (int i=0; i < batch->num_satellites; i++) {
+		if (batch->propagated[i]) {
+			batch->earliest_rise[i] = batch_propagation_earliest_rise(batch, i, observer, time);
+		}
+	}
+	batch->time = time;
+}
+
+void batch_propagation_run(struct batch_propagation *batch, const predict_observer_t *observer, predict_julian_date_t time)
+{
+	batch_propagation_run_satellites(batch, observer, time, NULL, false);
+}
+
+void batch_propagation_run_prefiltered(struct batch_propagation *batch, const predict_observer_t *observer, predict_julian_date_t time, const bool *required)
+{
+	batch_propagation_run_satellites(batch, observer, time, required, true);
+}
+
+void batch_propagation_run_selected(struct batch_propagation *batch, const predict_observer_t *observer, const int *indices, int num_indices)
+{
+	struct batch_tick tick;
+	batch_propagation_tick(observer, batch->time, &tick);
+
+	int gathered[BATCH_BLOCK_SIZE];
+	int num_gathered = 0;
+	for (int i=0; i < num_indices; i++) {
+		if (batch->use_libpredict[indices[i]]) {
+			batch_propagation_libpredict(batch, indices[i], observer, batch->time);
+		} else {
+			gathered[num_gathered++] = indices[i];
+		}
+		if ((num_gathered == BATCH_BLOCK_SIZE) || ((i == num_indices - 1) && (num_gathered > 0))) {
+			batch_propagation_gathered_block(batch, gathered, num_gathered, &tick);
+			num_gathered = 0;
+		}
+	}
+
+	for (int i=0; i < num_indices; i++) {
+		batch->propagated[indices[i]] = true;
+		batch->earliest_rise[indices[i]] = batch_propagation_earliest_rise(batch, indices[i], observer, batch->time);
+	}
+}
+
+void batch_propagation_get_result(const struct batch_propagation *batch, int index, struct predict_position *ret_orbit, struct predict_observation *ret_obs)
+{
+	memset(ret_orbit, 0, sizeof(struct predict_position));
+	ret_orbit->time = batch->time;
+	ret_orbit->position[0] = batch->position_x[index];
+	ret_orbit->position[1] = batch->position_y[index];
+	ret_orbit->position[2] = batch->position_z[index];
+	ret_orbit->velocity[0] = batch->velocity_x[index];
+	ret_orbit->velocity[1] = batch->velocity_y[index];
+	ret_orbit->velocity[2] = batch->velocity_z[index];
+	ret_orbit->latitude = batch->latitude[index];
+	ret_orbit->longitude = batch->longitude[index];
+	ret_orbit->altitude = batch->altitude[index];
+	ret_orbit->eclipsed = batch->eclipsed[index];
+	ret_orbit->decayed = batch->decayed[index];
+
+	memset(ret_obs, 0, sizeof(struct predict_observation));
+	ret_obs->time = batch->time;
+	ret_obs->azimuth = batch->azimuth[index];
+	ret_obs->elevation = batch->elevation[index];
+	ret_obs->range = batch->range[index];
+	ret_obs->range_rate = batch->range_rate[index];
+	ret_obs->visible = batch->visible[index];
+}
@@ -0,0 +1,218 @@
+#ifndef BATCH_PROPAGATION_H_DEFINED
+#define BATCH_PROPAGATION_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+
+/**
+ * Propagation and observation of a whole set of satellites for a single timestamp.
+ *
+ * The SGP4 state of each satellite is kept in structure-of-arrays form, and the satellites are propagated
+ * in blocks through a sequence of loops over these arrays. The loops without transcendental functions are
+ * vectorized by the compiler, and are on x86-64 compiled both for AVX2 and for the baseline instruction
+ * set, with the variant selected at runtime. Deep space satellites (orbital period of 225 minutes or more)
+ * are propagated and observed using libpredict.
+ *
+ * Near-earth satellites are propagated using the same SGP4 model (WGS72 constants) as libpredict, with the
+ * same observation, eclipse and visibility calculations, step by step. Results are expected to differ from
+ * libpredict's only by floating point rounding. The tolerance is 1 meter in position and 1 mm/s in velocity,
+ * checked against the reference vectors of satellite 00005 in Vallado et al., "Revisiting Spacetrack
+ * Report #3" (AIAA 2006-6753), which the implementation reproduces to within 1 cm.
+ *
+ * batch_propagation_run_prefiltered() skips satellites that cannot be above the horizon. After each
+ * propagation, an earliest possible rise time is derived from the geometry of the orbit: the sub-satellite
+ * point has to come within the footprint radius at apogee of the observer, and can approach it no faster
+ * than the angular rate at perigee plus the rotation rate of the earth. Satellites whose inclination keeps
+ * the sub-satellite point too far north or south of the observer can not rise at all.
+ **/
+
+/**
+ * SGP4 state of each satellite, initialized from the orbital elements. Each array has one element per satellite.
+ * Quantities follow the naming in Spacetrack Report #3, and are in units of earth radii and minutes.
+ *
+ * Coefficients only used for the full drag model (d2, d3, d4, t3cof, t4cof, t5cof, c5, omgcof, xmcof) are zero for
+ * satellites with perigee below 220 km, for which the simplified drag model applies.
+ **/
+struct batch_sgp4_state {
+	///Epoch of orbital elements (predict julian date)
+	double *epoch;
+	///Time at which satellite is considered to be decayed (predict julian date)
+	double *decay_time;
+	double *xmo;
+	double *xnodeo;
+	double *omegao;
+	double *eo;
+	double *xincl;
+	double *aodp;
+	double *xnodp;
+	double *bstar;
+	double *c1;
+	double *c4;
+	double *c5;
+	double *d2;
+	double *d3;
+	double *d4;
+	double *t2cof;
+	double *t3cof;
+	double *t4cof;
+	double *t5cof;
+	double *xmdot;
+	double *omgdot;
+	double *xnodot;
+	double *xnodcf;
+	double *omgcof;
+	double *xmcof;
+	double *eta;
+	double *delmo;
+	double *sinmo;
+	double *xlcof;
+	double *aycof;
+	double *x3thm1;
+	double *x1mth2;
+	double *x7thm1;
+	double *cosio;
+	double *sinio;
+};
+
+/**
+ * Batch of satellites to be propagated together.
+ **/
+struct batch_propagation {
+	///Number of satellites
+	int num_satellites;
+	///Orbital elements of each satellite, owned by the caller
+	const predict_orbital_elements_t **orbital_elements;
+	///Whether each satellite is propagated using libpredict instead of the batch kernels
+	bool *use_libpredict;
+	///SGP4 state
+	struct batch_sgp4_state sgp4;
+	///Memory for all double arrays, in one contiguous allocation
+	double *data;
+
+	///Time of the last propagation
+	predict_julian_date_t time;
+	///ECI position of each satellite (km)
+	double *position_x;
+	double *position_y;
+	double *position_z;
+	///ECI velocity of each satellite (km/s)
+	double *velocity_x;
+	double *velocity_y;
+	double *velocity_z;
+	///Geodetic latitude of each satellite (radians)
+	double *latitude;
+	///Longitude of each satellite (radians, -pi to pi)
+	double *longitude;
+	///Altitude of each satellite (km)
+	double *altitude;
+	///Azimuth of each satellite, as seen from the observer (radians)
+	double *azimuth;
+	///Elevation of each satellite, as seen from the observer (radians)
+	double *elevation;
+	///Range of each satellite (km)
+	double *range;
+	///Range rate of each satellite (km/s)
+	double *range_rate;
+	///Whether each satellite is in the earth's shadow
+	bool *eclipsed;
+	///Whether each satellite is visible to the naked eye from the observer
+	bool *visible;
+	///Whether each satellite has decayed
+	bool *decayed;
+
+	///Earliest time at which each satellite can be above the horizon of the prefilter observer or decay, as of its last propagation (predict julian date)
+	double *earliest_rise;
+	///Whether each satellite was propagated in the last run. Skipped satellites keep the results of their last propagation
+	bool *propagated;
+	///Latitude, longitude and altitude of the observer for which earliest_rise was calculated
+	double prefilter_observer[3];
+	///Single block of satellites, used for propagating the satellites gathered from partially skipped blocks
+	struct batch_propagation *gather_block;
+};
+
+/**
+ * Create batch of satellites. All satellites have to be set using batch_propagation_set_satellite() before
+ * batch_propagation_run() is called.
+ *
+ * \param num_satellites Number of satellites
+ * \return Satellite batch
+ **/
+struct batch_propagation *batch_propagation_create(int num_satellites);
+
+/**
+ * Free satellite batch.
+ *
+ * \param batch Satellite batch
+ **/
+void batch_propagation_destroy(struct batch_propagation **batch);
+
+/**
+ * Set satellite in batch, and initialize its SGP4 state.
+ *
+ * \param batch Satellite batch
+ * \param index Satellite index
+ * \param orbital_elements Orbital elements. The pointer is kept, and has to be valid until the satellite is replaced or the batch is destroyed
+ **/
+void batch_propagation_set_satellite(struct batch_propagation *batch, int index, const predict_orbital_elements_t *orbital_elements);
+
+/**
+ * Copy a satellite from another batch, including its SGP4 state, the results of its last propagation and its earliest
+ * rise time, so that it does not have to be initialized or propagated again. The time and observer of the last
+ * propagation are taken from the source batch, so all satellites of the destination batch that are not set using
+ * batch_propagation_set_satellite() should be copied from the same batch.
+ *
+ * \param batch Destination batch
+ * \param index Satellite index in destination batch
+ * \param source Source batch
+ * \param source_index Satellite index in source batch
+ **/
+void batch_propagation_copy_satellite(struct batch_propagation *batch, int index, const struct batch_propagation *source, int source_index);
+
+/**
+ * Propagate all satellites to the given time, and observe them from the given observer.
+ * Results are stored in the result arrays of the batch.
+ *
+ * \param batch Satellite batch
+ * \param observer Observer
+ * \param time Time
+ **/
+void batch_propagation_run(struct batch_propagation *batch, const predict_observer_t *observer, predict_julian_date_t time);
+
+/**
+ * Propagate the satellites that can be above the horizon of the observer at the given time, or that are
+ * explicitly required, and observe them from the given observer. The remaining satellites are guaranteed to be
+ * below the horizon and not to have decayed, and keep the results of their last propagation. All satellites are
+ * propagated when the observer differs from the one in the previous run.
+ *
+ * \param batch Satellite batch
+ * \param observer Observer
+ * \param time Time
+ * \param required Whether each satellite has to be propagated regardless of its earliest rise time. Can be NULL
+ **/
+void batch_propagation_run_prefiltered(struct batch_propagation *batch, const predict_observer_t *observer, predict_julian_date_t time, const bool *required);
+
+/**
+ * Propagate the listed satellites to the time of the last run, for satellites that were skipped by
+ * batch_propagation_run_prefiltered() but turn out to be needed. The results and earliest rise times of the
+ * other satellites are left unchanged.
+ *
+ * \param batch Satellite batch
+ * \param observer Observer, same as in the last run
+ * \param indices Indices of the satellites to propagate
+ * \param num_indices Number of indices
+ **/
+void batch_propagation_run_selected(struct batch_propagation *batch, const predict_observer_t *observer, const int *indices, int num_indices);
+
+/**
+ * Get results of last batch_propagation_run() for a satellite in the form returned by predict_orbit() and predict_observe_orbit().
+ * Only the fields calculated by the batch (time, position, velocity, latitude, longitude, altitude, eclipsed, decayed for the orbit,
+ * time, azimuth, elevation, range, range_rate and visible for the observation) are set, the rest are zeroed.
+ *
+ * \param batch Satellite batch
+ * \param index Satellite index
+ * \param ret_orbit Returned orbit
+ * \param ret_obs Returned observation
+ **/
+void batch_propagation_get_result(const struct batch_propagation *batch, int index, struct predict_position *ret_orbit, struct predict_observation *ret_obs);
+
+#endif
@@ -0,0 +1,531 @@
+#include "db_snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "xdg_basedirs.h"
+
+//identifier at start of snapshot file
+#define DB_SNAPSHOT_MAGIC "FLYBYSNP"
+#define DB_SNAPSHOT_MAGIC_LENGTH 8
+
+//snapshot format version, to be increased on any change in the file format or in the data structures that are stored
+#define DB_SNAPSHOT_VERSION 1
+
+//used for detecting snapshots written on a machine with different byte order
+#define DB_SNAPSHOT_BYTE_ORDER_MARK 0x01020304
+
+/**
+ * Get file properties of source file.
+ *
+ * \param path Path to file
+ * \param ret_info Returned file properties
+ **/
+static void db_snapshot_file_info(const char *path, struct db_snapshot_file_info *ret_info)
+{
+	memset(ret_info, 0, sizeof(struct db_snapshot_file_info));
+	struct stat file_stat;
+	if (stat(path, &file_stat) == 0) {
+		ret_info->exists = 1;
+		ret_info->mtime_sec = file_stat.st_mtim.tv_sec;
+		ret_info->mtime_nsec = file_stat.st_mtim.tv_nsec;
+		ret_info->size = file_stat.st_size;
+	}
+}
+
+/**
+ * Add TLE directory and the regular files within to list of source files, files sorted by filename.
+ *
+ * \param dirpath TLE directory, with trailing '/'
+ * \param ret_sources List of source files
+ **/
+static void db_snapshot_add_tle_dir(const char *dirpath, string_array_t *ret_sources)
+{
+	string_array_add(ret_sources, dirpath);
+
+	string_array_t filepaths = {0};
+	DIR *d = opendir(dirpath);
+	if (d) {
+		struct dirent *file;
+		while ((file = readdir(d)) != NULL) {
+			if (file->d_type == DT_REG) {
+				char full_path[MAX_NUM_CHARS];
+				snprintf(full_path, MAX_NUM_CHARS, "%s%s", dirpath, file->d_name);
+				string_array_add(&filepaths, full_path);
+			}
+		}
+		closedir(d);
+	}
+	string_array_sort(&filepaths);
+
+	for (int i=0; i < string_array_size(&filepaths); i++) {
+		string_array_add(ret_sources, string_array_get(&filepaths, i));
+	}
+	string_array_free(&filepaths);
+}
+
+void db_snapshot_sources_from_search_paths(struct db_snapshot_sources *ret_sources)
+{
+	string_array_t *paths = &(ret_sources->paths);
+	char path[MAX_NUM_CHARS];
+	char *data_home = xdg_data_home();
+	char *config_home = xdg_config_home();
+	char *data_dirs_str = xdg_data_dirs();
+	string_array_t data_dirs = {0};
+	stringsplit(data_dirs_str, &data_dirs);
+	free(data_dirs_str);
+
+	//TLE files
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, TLE_RELATIVE_DIR_PATH);
+	db_snapshot_add_tle_dir(path, paths);
+	for (int i=0; i < string_array_size(&data_dirs); i++) {
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), TLE_RELATIVE_DIR_PATH);
+		db_snapshot_add_tle_dir(path, paths);
+	}
+
+	//whitelist
+	snprintf(path, MAX_NUM_CHARS, "%s%s", config_home, WHITELIST_RELATIVE_FILE_PATH);
+	string_array_add(paths, path);
+
+	//transponder databases
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, DB_RELATIVE_FILE_PATH);
+	string_array_add(paths, path);
+	for (int i=0; i < string_array_size(&data_dirs); i++) {
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), DB_RELATIVE_FILE_PATH);
+		string_array_add(paths, path);
+	}
+
+	string_array_free(&data_dirs);
+	free(data_home);
+	free(config_home);
+
+	//record file properties before any of the files are read
+	ret_sources->file_info = (struct db_snapshot_file_info*)malloc(sizeof(struct db_snapshot_file_info)*string_array_size(paths));
+	for (int i=0; i < string_array_size(paths); i++) {
+		db_snapshot_file_info(string_array_get(paths, i), &(ret_sources->file_info[i]));
+	}
+}
+
+void db_snapshot_sources_free(struct db_snapshot_sources *sources)
+{
+	string_array_free(&(sources->paths));
+	free(sources->file_info);
+	sources->file_info = NULL;
+}
+
+char *db_snapshot_default_path()
+{
+	char *cache_home = xdg_cache_home();
+	char dirpath[MAX_NUM_CHARS];
+	snprintf(dirpath, MAX_NUM_CHARS, "%s%s", cache_home, FLYBY_RELATIVE_ROOT_PATH);
+
+	//create XDG_CACHE_HOME/flyby/, failure is not fatal since the snapshot only is a cache
+	bool dir_exists = true;
+	if ((mkdir(cache_home, 0700) != 0) && (errno != EEXIST)) {
+		dir_exists = false;
+	}
+	if (dir_exists && (mkdir(dirpath, 0700) != 0) && (errno != EEXIST)) {
+		dir_exists = false;
+	}
+
+	char *ret_string = NULL;
+	if (dir_exists) {
+		ret_string = (char*)malloc(sizeof(char)*MAX_NUM_CHARS);
+		snprintf(ret_string, MAX_NUM_CHARS, "%s%s", cache_home, DB_SNAPSHOT_RELATIVE_FILE_PATH);
+	}
+	free(cache_home);
+	return ret_string;
+}
+
+/**
+ * Write string to snapshot file, prefixed by its length.
+ *
+ * \param fd File
+ * \param string String
+ **/
+static void db_snapshot_write_string(FILE *fd, const char *string)
+{
+	uint32_t length = strlen(string);
+	fwrite(&length, sizeof(length), 1, fd);
+	fwrite(string, sizeof(char), length, fd);
+}
+
+int db_snapshot_to_file(const char *snapshot_file, struct db_snapshot_sources *sources, const struct tle_db *tle_db, const struct transponder_db *transponder_db)
+{
+	//write to temporary file and rename it afterwards, so that an interrupted write never leaves a partial snapshot
+	char temp_file[MAX_NUM_CHARS];
+	snprintf(temp_file, MAX_NUM_CHARS, "%s.%d", snapshot_file, getpid());
+	FILE *fd = fopen(temp_file, "w");
+	if (fd == NULL) {
+		return -1;
+	}
+
+	//header
+	uint32_t version = DB_SNAPSHOT_VERSION;
+	uint32_t byte_order = DB_SNAPSHOT_BYTE_ORDER_MARK;
+	fwrite(DB_SNAPSHOT_MAGIC, sizeof(char), DB_SNAPSHOT_MAGIC_LENGTH, fd);
+	fwrite(&version, sizeof(version), 1, fd);
+	fwrite(&byte_order, sizeof(byte_order), 1, fd);
+
+	//source files, with the file properties recorded before the databases were read
+	uint32_t num_sources = string_array_size(&(sources->paths));
+	fwrite(&num_sources, sizeof(num_sources), 1, fd);
+	for (int i=0; i < num_sources; i++) {
+		const struct db_snapshot_file_info *info = &(sources->file_info[i]);
+		db_snapshot_write_string(fd, string_array_get(&(sources->paths), i));
+		fwrite(&(info->exists), sizeof(info->exists), 1, fd);
+		fwrite(&(info->mtime_sec), sizeof(info->mtime_sec), 1, fd);
+		fwrite(&(info->mtime_nsec), sizeof(info->mtime_nsec), 1, fd);
+		fwrite(&(info->size), sizeof(info->size), 1, fd);
+	}
+
+	//TLE filenames, referred to by index from the TLE entries
+	string_array_t filenames = tle_db_filenames(tle_db);
+	uint32_t num_filenames = string_array_size(&filenames);
+	fwrite(&num_filenames, sizeof(num_filenames), 1, fd);
+	for (int i=0; i < num_filenames; i++) {
+		db_snapshot_write_string(fd, string_array_get(&filenames, i));
+	}
+
+	//TLE entries
+	uint32_t num_tles = tle_db->num_tles;
+	uint8_t read_from_xdg = tle_db->read_from_xdg;
+	fwrite(&num_tles, sizeof(num_tles), 1, fd);
+	fwrite(&read_from_xdg, sizeof(read_from_xdg), 1, fd);
+	for (int i=0; i < num_tles; i++) {
+		const struct tle_db_entry *entry = tle_db_get_entry(tle_db, i);
+		int64_t satellite_number = entry->satellite_number;
+		uint8_t enabled = entry->enabled;
+		uint32_t filename_index = string_array_find(&filenames, entry->filename);
+		fwrite(&satellite_number, sizeof(satellite_number), 1, fd);
+		fwrite(&enabled, sizeof(enabled), 1, fd);
+		fwrite(&filename_index, sizeof(filename_index), 1, fd);
+		fwrite(entry->line1, sizeof(char), TLE_LINE_LENGTH, fd);
+		fwrite(entry->line2, sizeof(char), TLE_LINE_LENGTH, fd);
+		db_snapshot_write_string(fd, entry->name);
+	}
+	string_array_free(&filenames);
+
+	//transponder entries, only entries that have been loaded from any file
+	uint8_t loaded = transponder_db->loaded;
+	uint32_t num_entries = 0;
+	for (int i=0; i < transponder_db->num_sats; i++) {
+		if (transponder_db->sats[i].location != LOCATION_NONE) {
+			num_entries++;
+		}
+	}
+	fwrite(&loaded, sizeof(loaded), 1, fd);
+	fwrite(&num_entries, sizeof(num_entries), 1, fd);
+	for (uint32_t i=0; i < transponder_db->num_sats; i++) {
+		const struct sat_db_entry *entry = &(transponder_db->sats[i]);
+		if (entry->location == LOCATION_NONE) {
+			continue;
+		}
+		uint8_t squintflag = entry->squintflag;
+		int32_t location = entry->location;
+		int32_t num_transponders = entry->num_transponders;
+		fwrite(&i, sizeof(i), 1, fd);
+		fwrite(&squintflag, sizeof(squintflag), 1, fd);
+		fwrite(&(entry->alat), sizeof(entry->alat), 1, fd);
+		fwrite(&(entry->alon), sizeof(entry->alon), 1, fd);
+		fwrite(&location, sizeof(location), 1, fd);
+		fwrite(&num_transponders, sizeof(num_transponders), 1, fd);
+		for (int j=0; j < entry->num_transponders; j++) {
+			const struct transponder *transponder = &(entry->transponders[j]);
+			db_snapshot_write_string(fd, transponder->name);
+			fwrite(&(transponder->uplink_start), sizeof(double), 1, fd);
+			fwrite(&(transponder->uplink_end), sizeof(double), 1, fd);
+			fwrite(&(transponder->downlink_start), sizeof(double), 1, fd);
+			fwrite(&(transponder->downlink_end), sizeof(double), 1, fd);
+		}
+	}
+
+	fwrite(DB_SNAPSHOT_MAGIC, sizeof(char), DB_SNAPSHOT_MAGIC_LENGTH, fd);
+
+	bool write_error = ferror(fd);
+	if ((fclose(fd) != 0) || write_error || (rename(temp_file, snapshot_file) != 0)) {
+		unlink(temp_file);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Position in memory mapped snapshot file.
+ **/
+struct db_snapshot_reader {
+	///Current position
+	const char *pos;
+	///End of file
+	const char *end;
+	///Set to true when attempting to read beyond the end of the file
+	bool error;
+};
+
+/**
+ * Read data from snapshot.
+ *
+ * \param reader Snapshot reader
+ * \param ret_data Returned data
+ * \param size Number of bytes to read
+ * \return True on success, false if there is not enough data left
+ **/
+static bool db_snapshot_read(struct db_snapshot_reader *reader, void *ret_data, size_t size)
+{
+	if (reader->error || (reader->end - reader->pos < size)) {
+		reader->error = true;
+		return false;
+	}
+	memcpy(ret_data, reader->pos, size);
+	reader->pos += size;
+	return true;
+}
+
+/**
+ * Read string from snapshot.
+ *
+ * \param reader Snapshot reader
+ * \param ret_string Returned string, of size MAX_NUM_CHARS
+ * \return True on success, false otherwise
+ **/
+static bool db_snapshot_read_string(struct db_snapshot_reader *reader, char *ret_string)
+{
+	uint32_t length = 0;
+	if (!db_snapshot_read(reader, &length, sizeof(length)) || (length >= MAX_NUM_CHARS)) {
+		reader->error = true;
+		return false;
+	}
+	if (!db_snapshot_read(reader, ret_string, length)) {
+		return false;
+	}
+	ret_string[length] = '\0';
+	return true;
+}
+
+/**
+ * Check that the source files stored in the snapshot correspond to the supplied source files, and are unchanged.
+ *
+ * \param reader Snapshot reader
+ * \param sources Source files
+ * \return True if the snapshot is up to date
+ **/
+static bool db_snapshot_sources_unchanged(struct db_snapshot_reader *reader, struct db_snapshot_sources *sources)
+{
+	uint32_t num_sources = 0;
+	if (!db_snapshot_read(reader, &num_sources, sizeof(num_sources)) || (num_sources != string_array_size(&(sources->paths)))) {
+		return false;
+	}
+
+	for (int i=0; i < num_sources; i++) {
+		char path[MAX_NUM_CHARS] = {0};
+		struct db_snapshot_file_info stored_info = {0};
+		db_snapshot_read_string(reader, path);
+		db_snapshot_read(reader, &(stored_info.exists), sizeof(stored_info.exists));
+		db_snapshot_read(reader, &(stored_info.mtime_sec), sizeof(stored_info.mtime_sec));
+		db_snapshot_read(reader, &(stored_info.mtime_nsec), sizeof(stored_info.mtime_nsec));
+		db_snapshot_read(reader, &(stored_info.size), sizeof(stored_info.size));
+		if (reader->error || (strcmp(path, string_array_get(&(sources->paths), i)) != 0)) {
+			return false;
+		}
+
+		struct db_snapshot_file_info current_info = sources->file_info[i];
+		if ((current_info.exists != stored_info.exists) || (current_info.mtime_sec != stored_info.mtime_sec) ||
+		    (current_info.mtime_nsec != stored_info.mtime_nsec) || (current_info.size != stored_info.size)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Read TLE entries from snapshot.
+ *
+ * \param reader Snapshot reader
+ * \param ret_tle_db Returned TLE database
+ * \return True on success, false otherwise
+ **/
+static bool db_snapshot_read_tle_db(struct db_snapshot_reader *reader, struct tle_db *ret_tle_db)
+{
+	uint32_t num_filenames = 0;
+	if (!db_snapshot_read(reader, &num_filenames, sizeof(num_filenames))) {
+		return false;
+	}
+	string_array_t filenames = {0};
+	for (int i=0; i < num_filenames; i++) {
+		char filename[MAX_NUM_CHARS] = {0};
+		if (!db_snapshot_read_string(reader, filename)) {
+			break;
+		}
+		string_array_add(&filenames, filename);
+	}
+
+	uint32_t num_tles = 0;
+	uint8_t read_from_xdg = 0;
+	if (!db_snapshot_read(reader, &num_tles, sizeof(num_tles)) ||
+	    !db_snapshot_read(reader, &read_from_xdg, sizeof(read_from_xdg))) {
+		string_array_free(&filenames);
+		return false;
+	}
+	ret_tle_db->read_from_xdg = read_from_xdg;
+
+	for (int i=0; i < num_tles; i++) {
+		int64_t satellite_number = 0;
+		uint8_t enabled = 0;
+		uint32_t filename_index = 0;
+		char name[MAX_NUM_CHARS] = {0};
+		struct tle_db_entry entry = {0};
+		if (!db_snapshot_read(reader, &satellite_number, sizeof(satellite_number)) ||
+		    !db_snapshot_read(reader, &enabled, sizeof(enabled)) ||
+		    !db_snapshot_read(reader, &filename_index, sizeof(filename_index)) ||
+		    !db_snapshot_read(reader, entry.line1, TLE_LINE_LENGTH) ||
+		    !db_snapshot_read(reader, entry.line2, TLE_LINE_LENGTH) ||
+		    !db_snapshot_read_string(reader, name) ||
+		    (filename_index >= num_filenames)) {
+			reader->error = true;
+			break;
+		}
+
+		entry.satellite_number = satellite_number;
+		entry.name = name;
+		entry.filename = string_array_get(&filenames, filename_index);
+		tle_db_add_entry(ret_tle_db, &entry);
+		tle_db_entry_set_enabled(ret_tle_db, i, enabled);
+	}
+	string_array_free(&filenames);
+
+	return !reader->error && (ret_tle_db->num_tles == num_tles);
+}
+
+/**
+ * Read transponder entries from snapshot.
+ *
+ * \param reader Snapshot reader
+ * \param ret_transponder_db Returned transponder database, with size corresponding to the TLE database
+ * \return True on success, false otherwise
+ **/
+static bool db_snapshot_read_transponder_db(struct db_snapshot_reader *reader, struct transponder_db *ret_transponder_db)
+{
+	uint8_t loaded = 0;
+	uint32_t num_entries = 0;
+	if (!db_snapshot_read(reader, &loaded, sizeof(loaded)) ||
+	    !db_snapshot_read(reader, &num_entries, sizeof(num_entries))) {
+		return false;
+	}
+	ret_transponder_db->loaded = loaded;
+
+	for (int i=0; i < num_entries; i++) {
+		uint32_t index = 0;
+		uint8_t squintflag = 0;
+		int32_t location = 0;
+		int32_t num_transponders = 0;
+		if (!db_snapshot_read(reader, &index, sizeof(index)) || (index >= ret_transponder_db->num_sats)) {
+			reader->error = true;
+			break;
+		}
+		struct sat_db_entry *entry = &(ret_transponder_db->sats[index]);
+		if (!db_snapshot_read(reader, &squintflag, sizeof(squintflag)) ||
+		    !db_snapshot_read(reader, &(entry->alat), sizeof(entry->alat)) ||
+		    !db_snapshot_read(reader, &(entry->alon), sizeof(entry->alon)) ||
+		    !db_snapshot_read(reader, &location, sizeof(location)) ||
+		    !db_snapshot_read(reader, &num_transponders, sizeof(num_transponders)) ||
+		    (num_transponders < 0) || (num_transponders > MAX_NUM_TRANSPONDERS)) {
+			reader->error = true;
+			break;
+		}
+		entry->squintflag = squintflag;
+		entry->location = location;
+		entry->num_transponders = num_transponders;
+
+		for (int j=0; j < num_transponders; j++) {
+			struct transponder *transponder = &(entry->transponders[j]);
+			if (!db_snapshot_read_string(reader, transponder->name) ||
+			    !db_snapshot_read(reader, &(transponder->uplink_start), sizeof(double)) ||
+			    !db_snapshot_read(reader, &(transponder->uplink_end), sizeof(double)) ||
+			    !db_snapshot_read(reader, &(transponder->downlink_start), sizeof(double)) ||
+			    !db_snapshot_read(reader, &(transponder->downlink_end), sizeof(double))) {
+				reader->error = true;
+				break;
+			}
+		}
+	}
+	return !reader->error;
+}
+
+int db_snapshot_from_file(const char *snapshot_file, struct db_snapshot_sources *sources, struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db)
+{
+	int fd = open(snapshot_file, O_RDONLY);
+	if (fd == -1) {
+		return DB_SNAPSHOT_FILE_READING_ERROR;
+	}
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) == -1) || (file_stat.st_size == 0)) {
+		close(fd);
+		return DB_SNAPSHOT_FILE_READING_ERROR;
+	}
+	const char *buffer = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buffer == MAP_FAILED) {
+		return DB_SNAPSHOT_FILE_READING_ERROR;
+	}
+
+	struct db_snapshot_reader reader = {.pos = buffer, .end = buffer + file_stat.st_size, .error = false};
+	int retval = DB_SNAPSHOT_SUCCESS;
+
+	//check header
+	char magic[DB_SNAPSHOT_MAGIC_LENGTH] = {0};
+	uint32_t version = 0;
+	uint32_t byte_order = 0;
+	db_snapshot_read(&reader, magic, DB_SNAPSHOT_MAGIC_LENGTH);
+	db_snapshot_read(&reader, &version, sizeof(version));
+	db_snapshot_read(&reader, &byte_order, sizeof(byte_order));
+	if (reader.error || (memcmp(magic, DB_SNAPSHOT_MAGIC, DB_SNAPSHOT_MAGIC_LENGTH) != 0) || (version != DB_SNAPSHOT_VERSION) || (byte_order != DB_SNAPSHOT_BYTE_ORDER_MARK)) {
+		retval = DB_SNAPSHOT_INVALID;
+	}
+
+	if ((retval == DB_SNAPSHOT_SUCCESS) && !db_snapshot_sources_unchanged(&reader, sources)) {
+		retval = DB_SNAPSHOT_OUTDATED;
+	}
+
+	//read databases into temporary structs, so that the returned databases are left untouched on failure
+	struct tle_db *tle_db = NULL;
+	struct transponder_db *transponder_db = NULL;
+	if (retval == DB_SNAPSHOT_SUCCESS) {
+		tle_db = tle_db_create();
+		if (!db_snapshot_read_tle_db(&reader, tle_db)) {
+			retval = DB_SNAPSHOT_INVALID;
+		}
+	}
+	if (retval == DB_SNAPSHOT_SUCCESS) {
+		transponder_db = transponder_db_create(tle_db);
+		if (!db_snapshot_read_transponder_db(&reader, transponder_db)) {
+			retval = DB_SNAPSHOT_INVALID;
+		}
+	}
+	if (retval == DB_SNAPSHOT_SUCCESS) {
+		db_snapshot_read(&reader, magic, DB_SNAPSHOT_MAGIC_LENGTH);
+		if (reader.error || (memcmp(magic, DB_SNAPSHOT_MAGIC, DB_SNAPSHOT_MAGIC_LENGTH) != 0) || (reader.pos != reader.end)) {
+			retval = DB_SNAPSHOT_INVALID;
+		}
+	}
+	munmap((void*)buffer, file_stat.st_size);
+
+	if (retval == DB_SNAPSHOT_SUCCESS) {
+		//swap read TLE database into the returned struct
+		struct tle_db previous_tle_db = *ret_tle_db;
+		*ret_tle_db = *tle_db;
+		*tle_db = previous_tle_db;
+		*ret_transponder_db = transponder_db;
+	} else if (transponder_db != NULL) {
+		transponder_db_destroy(&transponder_db);
+	}
+	if (tle_db != NULL) {
+		tle_db_destroy(&tle_db);
+	}
+	return retval;
+}
@@ -0,0 +1,104 @@
+#ifndef DB_SNAPSHOT_H_DEFINED
+#define DB_SNAPSHOT_H_DEFINED
+
+#include "tle_db.h"
+#include "transponder_db.h"
+#include "string_array.h"
+#include <stdint.h>
+
+/**
+ * Binary snapshot of the resolved TLE database (including whitelist flags) and transponder database,
+ * used for skipping the parsing and merging of all TLE, whitelist and transponder files on startup.
+ *
+ * The snapshot contains the list of source files it was generated from, along with their modification
+ * times and sizes. The snapshot is only used when all source files are unchanged.
+ **/
+
+/**
+ * Return values of db_snapshot_from_file().
+ **/
+enum db_snapshot_status {
+	///Snapshot was read successfully
+	DB_SNAPSHOT_SUCCESS = 0,
+	///Snapshot file could not be read
+	DB_SNAPSHOT_FILE_READING_ERROR = -1,
+	///Snapshot file has wrong format or version
+	DB_SNAPSHOT_INVALID = -2,
+	///Source files have changed since the snapshot was written
+	DB_SNAPSHOT_OUTDATED = -3
+};
+
+/**
+ * File properties used for deciding whether a source file has changed since the snapshot was written.
+ **/
+struct db_snapshot_file_info {
+	///Whether file exists
+	uint8_t exists;
+	///Modification time, seconds
+	int64_t mtime_sec;
+	///Modification time, nanoseconds
+	int64_t mtime_nsec;
+	///File size
+	int64_t size;
+};
+
+/**
+ * Source files of the databases, along with their file properties.
+ **/
+struct db_snapshot_sources {
+	///Paths to source files
+	string_array_t paths;
+	///File properties of each source file, as they were when the list was created
+	struct db_snapshot_file_info *file_info;
+};
+
+/**
+ * Get the list of source files that the TLE, whitelist and transponder databases are read from when
+ * using the XDG search paths: the TLE directories, the TLE files within them, the whitelist file and the
+ * transponder database files. Paths that do not exist are included, so that their creation invalidates the snapshot.
+ *
+ * The file properties are recorded immediately, and should be obtained before the databases are read. A file that
+ * is modified while the databases are read will then make the snapshot outdated on the next start.
+ *
+ * \param ret_sources Returned list of source files, to be free'd using db_snapshot_sources_free()
+ **/
+void db_snapshot_sources_from_search_paths(struct db_snapshot_sources *ret_sources);
+
+/**
+ * Free memory allocated in list of source files.
+ *
+ * \param sources List of source files
+ **/
+void db_snapshot_sources_free(struct db_snapshot_sources *sources);
+
+/**
+ * Write snapshot of TLE database and transponder database to file.
+ *
+ * \param snapshot_file Snapshot filename
+ * \param sources Source files the databases were read from, as returned by db_snapshot_sources_from_search_paths() before the databases were read. The recorded file properties are stored in the snapshot
+ * \param tle_db TLE database
+ * \param transponder_db Transponder database
+ * \return 0 on success, -1 otherwise
+ **/
+int db_snapshot_to_file(const char *snapshot_file, struct db_snapshot_sources *sources, const struct tle_db *tle_db, const struct transponder_db *transponder_db);
+
+/**
+ * Read snapshot of TLE database and transponder database from file.
+ *
+ * \param snapshot_file Snapshot filename
+ * \param sources Source files the databases should be read from, as returned by db_snapshot_sources_from_search_paths(). Have to correspond to the source files stored in the snapshot, with unchanged modification times and sizes
+ * \param ret_tle_db Returned TLE database, assumed to be empty
+ * \param ret_transponder_db Returned transponder database, allocated using transponder_db_create() on success
+ * \return DB_SNAPSHOT_SUCCESS on success, one of the other values in enum db_snapshot_status otherwise
+ **/
+int db_snapshot_from_file(const char *snapshot_file, struct db_snapshot_sources *sources, struct tle_db *ret_tle_db, struct transponder_db **ret_transponder_db);
+
+/**
+ * Get default path to snapshot file, XDG_CACHE_HOME/flyby/startup.snapshot. Creates the directory if missing.
+ * Returned string has to be free'd after use.
+ *
+ * \return Path to snapshot file, NULL if the directory could not be created
+ **/
+char *db_snapshot_default_path();
+
+#endif
@@ -0,0 +1,254 @@
+#include "db_watcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include "xdg_basedirs.h"
+
+//events signifying that a file has been completely written or moved into place
+#define DB_WATCHER_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+/**
+ * Add watch on directory, if it exists.
+ *
+ * \param watcher Database watcher
+ * \param path Directory path, with trailing '/'
+ * \param tle_dir Whether directory is a TLE directory
+ **/
+static void db_watcher_add(struct db_watcher *watcher, const char *path, bool tle_dir)
+{
+	int wd = inotify_add_watch(watcher->fd, path, DB_WATCHER_EVENTS);
+	if (wd == -1) {
+		return;
+	}
+
+	struct db_watch *watches = (struct db_watch*)realloc(watcher->watches, sizeof(struct db_watch)*(watcher->num_watches+1));
+	if (watches == NULL) {
+		inotify_rm_watch(watcher->fd, wd);
+		return;
+	}
+	watcher->watches = watches;
+
+	struct db_watch *watch = &(watcher->watches[watcher->num_watches]);
+	watch->wd = wd;
+	strncpy(watch->path, path, MAX_NUM_CHARS-1);
+	watch->path[MAX_NUM_CHARS-1] = '\0';
+	watch->tle_dir = tle_dir;
+	watcher->num_watches++;
+}
+
+struct db_watcher *db_watcher_create()
+{
+	struct db_watcher *watcher = (struct db_watcher*)malloc(sizeof(struct db_watcher));
+	memset(watcher, 0, sizeof(struct db_watcher));
+	watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher->fd == -1) {
+		return watcher;
+	}
+
+	char path[MAX_NUM_CHARS];
+	char *data_home = xdg_data_home();
+	char *data_dirs_str = xdg_data_dirs();
+	string_array_t data_dirs = {0};
+	stringsplit(data_dirs_str, &data_dirs);
+	free(data_dirs_str);
+
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, TLE_RELATIVE_DIR_PATH);
+	db_watcher_add(watcher, path, true);
+	snprintf(path, MAX_NUM_CHARS, "%s%s", data_home, FLYBY_RELATIVE_ROOT_PATH);
+	db_watcher_add(watcher, path, false);
+
+	for (int i=0; i < string_array_size(&data_dirs); i++) {
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), TLE_RELATIVE_DIR_PATH);
+		db_watcher_add(watcher, path, true);
+		snprintf(path, MAX_NUM_CHARS, "%s%s", string_array_get(&data_dirs, i), FLYBY_RELATIVE_ROOT_PATH);
+		db_watcher_add(watcher, path, false);
+	}
+
+	string_array_free(&data_dirs);
+	free(data_home);
+	return watcher;
+}
+
+void db_watcher_destroy(struct db_watcher **watcher)
+{
+	if ((*watcher)->fd != -1) {
+		close((*watcher)->fd);
+	}
+	free((*watcher)->watches);
+	free(*watcher);
+	*watcher = NULL;
+}
+
+/**
+ * Add file to list of changed files, if not already present.
+ *
+ * \param dirpath Directory, with trailing '/'
+ * \param filename Filename within directory
+ * \param changed_files List of changed files
+ **/
+static void db_watcher_add_changed_file(const char *dirpath, const char *filename, string_array_t *changed_files)
+{
+	char path[PATH_MAX];
+	int length = snprintf(path, PATH_MAX, "%s%s", dirpath, filename);
+	if ((length < 0) || (length >= PATH_MAX)) {
+		//path too long to be opened, skip file
+		return;
+	}
+	if (string_array_find(changed_files, path) == -1) {
+		string_array_add(changed_files, path);
+	}
+}
+
+/**
+ * Mark all files in all watched TLE directories as changed. Used when the inotify event queue has overflowed.
+ *
+ * \param watcher Database watcher
+ * \param changed_files List of changed files
+ **/
+static void db_watcher_add_all_tle_files(struct db_watcher *watcher, string_array_t *changed_files)
+{
+	for (int i=0; i < watcher->num_watches; i++) {
+		if (!watcher->watches[i].tle_dir) {
+			continue;
+		}
+		DIR *d = opendir(watcher->watches[i].path);
+		if (d) {
+			struct dirent *file;
+			while ((file = readdir(d)) != NULL) {
+				if (file->d_type == DT_REG) {
+					db_watcher_add_changed_file(watcher->watches[i].path, file->d_name, changed_files);
+				}
+			}
+			closedir(d);
+		}
+	}
+}
+
+/**
+ * Read pending inotify events without blocking.
+ *
+ * \param watcher Database watcher
+ * \param changed_tle_files Returned list of changed TLE files
+ * \return True if any transponder database file has changed
+ **/
+static bool db_watcher_read_events(struct db_watcher *watcher, string_array_t *changed_tle_files)
+{
+	const char *db_filename = DB_RELATIVE_FILE_PATH + strlen(FLYBY_RELATIVE_ROOT_PATH);
+	bool transponder_db_changed = false;
+
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	while (true) {
+		ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+		if (length <= 0) {
+			break;
+		}
+
+		const struct inotify_event *event;
+		for (char *ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + event->len) {
+			event = (const struct inotify_event*)ptr;
+			if (event->mask & IN_Q_OVERFLOW) {
+				//events were lost, treat everything as changed
+				db_watcher_add_all_tle_files(watcher, changed_tle_files);
+				transponder_db_changed = true;
+				continue;
+			}
+			if (event->len == 0) {
+				continue;
+			}
+
+			for (int i=0; i < watcher->num_watches; i++) {
+				const struct db_watch *watch = &(watcher->watches[i]);
+				if (watch->wd != event->wd) {
+					continue;
+				}
+				if (watch->tle_dir) {
+					db_watcher_add_changed_file(watch->path, event->name, changed_tle_files);
+				} else if (strcmp(event->name, db_filename) == 0) {
+					transponder_db_changed = true;
+				}
+			}
+		}
+	}
+	return transponder_db_changed;
+}
+
+/**
+ * Get precedence of the TLE directory containing the given file, following the order of the search paths used
+ * in tle_db_from_search_paths(): XDG_DATA_HOME first, then XDG_DATA_DIRS in their listed order.
+ *
+ * \param watcher Database watcher
+ * \param filename TLE file
+ * \return Index of the watched TLE directory containing the file, lower index meaning higher precedence. Files outside the watched TLE directories get the lowest precedence, watcher->num_watches
+ **/
+static int db_watcher_tle_dir_precedence(const struct db_watcher *watcher, const char *filename)
+{
+	for (int i=0; i < watcher->num_watches; i++) {
+		const struct db_watch *watch = &(watcher->watches[i]);
+		size_t dir_length = strlen(watch->path);
+		if (watch->tle_dir && (strncmp(filename, watch->path, dir_length) == 0) && (strchr(filename + dir_length, '/') == NULL)) {
+			return i;
+		}
+	}
+	return watcher->num_watches;
+}
+
+int db_watcher_reload(struct db_watcher *watcher, struct tle_db *tle_db, struct transponder_db *transponder_db, bool *ret_updated_tles)
+{
+	for (int i=0; i < tle_db->num_tles; i++) {
+		ret_updated_tles[i] = false;
+	}
+	if (watcher->fd == -1) {
+		return 0;
+	}
+
+	int status = 0;
+	string_array_t changed_tle_files = {0};
+	bool transponder_db_changed = db_watcher_read_events(watcher, &changed_tle_files);
+
+	//update TLE entries with more recent entries in changed files. Entries read from a directory of higher precedence
+	//are left alone, as in tle_db_from_search_paths()
+	for (int i=0; i < string_array_size(&changed_tle_files); i++) {
+		const char *changed_file = string_array_get(&changed_tle_files, i);
+		int file_precedence = db_watcher_tle_dir_precedence(watcher, changed_file);
+		struct tle_db *file_db = tle_db_create();
+		if (tle_db_from_changing_file(changed_file, file_db) == 0) {
+			for (int j=0; j < file_db->num_tles; j++) {
+				int tle_index = tle_db_find_entry(tle_db, file_db->tles[j].satellite_number);
+				if ((tle_index == -1) || !tle_db_entry_is_newer_than(file_db->tles[j], tle_db->tles[tle_index])) {
+					continue;
+				}
+				if (file_precedence > db_watcher_tle_dir_precedence(watcher, tle_db->tles[tle_index].filename)) {
+					continue;
+				}
+
+				//update orbital elements only, keep old filename and name
+				struct tle_db_entry updated_entry = file_db->tles[j];
+				updated_entry.filename = tle_db->tles[tle_index].filename;
+				updated_entry.name = tle_db->tles[tle_index].name;
+				tle_db_overwrite_entry(tle_index, tle_db, &updated_entry);
+				ret_updated_tles[tle_index] = true;
+				status |= DB_WATCHER_TLES_UPDATED;
+			}
+		}
+		tle_db_destroy(&file_db);
+	}
+	string_array_free(&changed_tle_files);
+
+	//reload transponder database into a new struct, and move its entries into the existing database
+	if (transponder_db_changed) {
+		struct transponder_db *new_transponder_db = transponder_db_create(tle_db);
+		transponder_db_from_search_paths(tle_db, new_transponder_db);
+
+		struct sat_db_entry *sats = transponder_db->sats;
+		transponder_db->sats = new_transponder_db->sats;
+		transponder_db->loaded = new_transponder_db->loaded;
+		new_transponder_db->sats = sats;
+		transponder_db_destroy(&new_transponder_db);
+		status |= DB_WATCHER_TRANSPONDERS_UPDATED;
+	}
+	return status;
+}
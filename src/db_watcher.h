@@ -0,0 +1,80 @@
+#ifndef DB_WATCHER_H_DEFINED
+#define DB_WATCHER_H_DEFINED
+
+#include <stdbool.h>
+#include "tle_db.h"
+#include "transponder_db.h"
+
+/**
+ * Watches the TLE directories and the transponder database files in the XDG search paths for changes
+ * using inotify, so that TLE and transponder databases can be reloaded while flyby is running.
+ **/
+
+/**
+ * Watched directory.
+ **/
+struct db_watch {
+	///inotify watch descriptor
+	int wd;
+	///Directory path, with trailing '/'
+	char path[MAX_NUM_CHARS];
+	///Whether the directory is a TLE directory, or a directory containing a transponder database
+	bool tle_dir;
+};
+
+/**
+ * Database watcher.
+ **/
+struct db_watcher {
+	///inotify file descriptor, -1 if watching is not available
+	int fd;
+	///Number of watched directories
+	int num_watches;
+	///Watched directories
+	struct db_watch *watches;
+};
+
+/**
+ * Return flags of db_watcher_reload().
+ **/
+enum db_watcher_reload_status {
+	///TLE entries were updated
+	DB_WATCHER_TLES_UPDATED = (1u << 1),
+	///Transponder database was reloaded
+	DB_WATCHER_TRANSPONDERS_UPDATED = (1u << 2)
+};
+
+/**
+ * Create watcher on the TLE directories and the directories containing the transponder database files in
+ * XDG_DATA_HOME and XDG_DATA_DIRS. Directories that do not exist are not watched.
+ *
+ * \return Database watcher
+ **/
+struct db_watcher *db_watcher_create();
+
+/**
+ * Free database watcher.
+ *
+ * \param watcher Database watcher
+ **/
+void db_watcher_destroy(struct db_watcher **watcher);
+
+/**
+ * Reload the files that have changed since the last call, without blocking.
+ *
+ * Changed TLE files are parsed and compared against the TLE database. The orbital elements of an entry are
+ * updated when the changed file contains a TLE with a more recent epoch, and the changed file is in a TLE directory
+ * of the same or higher precedence than the file the entry was read from (XDG_DATA_HOME over XDG_DATA_DIRS).
+ * The name and filename of the entry are kept. Satellites that are not already in the TLE database are ignored,
+ * as when updating the database using tle_db_update(). When any transponder database file has changed, the
+ * transponder database is reloaded from the search paths.
+ *
+ * \param watcher Database watcher
+ * \param tle_db TLE database
+ * \param transponder_db Transponder database
+ * \param ret_updated_tles Returned flags for which TLE entries were updated, of tle_db->num_tles length
+ * \return Combination of flags in enum db_watcher_reload_status
+ **/
+int db_watcher_reload(struct db_watcher *watcher, struct tle_db *tle_db, struct transponder_db *transponder_db, bool *ret_updated_tles);
+
+#endif
@@ -7,10 +7,21 @@
 //Height of window on bottom of multitrack defining the main menu options
 #define MAIN_MENU_OPTS_WIN_HEIGHT 3
 
+//Interval between updates of the interactive screens, aligned to whole seconds of the wall clock (seconds)
+#define UI_TICK_INTERVAL 1.0
+
 #define EARTH_RADIUS_KM		6.378137E3		/* WGS 84 Earth radius km */
-#define HALF_DELAY_TIME	5
 #define	KM_TO_MI		0.621371		/* km to miles */
 
+//constants of the SGP4 and sun models in libpredict, for the code that reimplements parts of them
+#define XKMPER			6.378135E3		/* WGS 72 earth radius km */
+#define SECDAY			8.6400E4		/* seconds per day */
+#define TWOPI			(2.0*M_PI)
+#define JULIAN_TIME_DIFF	2444238.5		/* julian date of predict julian date 0 */
+
+//UNIX time of predict julian date 0 (1979-12-31 00:00:00 UTC), for conversions that keep fractions of a second
+#define JULIAN_EPOCH_UNIX_TIME	315446400.0
+
 
 //inactive/deselected color style for settings field
 #define FIELDSTYLE_INACTIVE COLOR_PAIR(1)|A_UNDERLINE
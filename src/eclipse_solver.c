@@ -0,0 +1,208 @@
+#include "eclipse_solver.h"
+#include "root_finder.h"
+#include "defines.h"
+#include <math.h>
+
+//gravitational parameter of the earth (km^3/s^2), as in libpredict
+#define GM 3.986008E5
+
+//number of samples of the eclipse depth per orbit
+#define ECLIPSE_SOLVER_STEPS_PER_ORBIT 8
+
+//minimum time step between samples (days)
+#define ECLIPSE_SOLVER_MIN_STEP (1.0/86400.0)
+
+//maximum duration of an eclipse before the search is abandoned (days)
+#define ECLIPSE_SOLVER_MAX_ECLIPSE_DURATION 1.0
+
+//margin on the bound of the rate of change of the eclipse depth, for the perturbations of the orbit
+#define ECLIPSE_SOLVER_RATE_MARGIN 1.05
+
+//apparent motion of the sun around the earth (radians/day)
+#define ECLIPSE_SOLVER_SUN_RATE (2.0*M_PI/365.25)
+
+/**
+ * State of a single eclipse search.
+ **/
+struct eclipse_solver {
+	///Orbital elements of satellite
+	const predict_orbital_elements_t *orbital_elements;
+	///Time step between coarse samples (days)
+	double step;
+	///Upper bound of the rate of change of the eclipse depth (radians/day)
+	double max_depth_rate;
+	///Whether the satellite has decayed at any of the propagations
+	bool decayed;
+	///Number of propagations so far
+	int num_propagations;
+};
+
+/**
+ * Initialize solver state, with the time step and the bound on the rate of change of the eclipse depth calculated
+ * from the orbital elements.
+ *
+ * The depth is the angular radius of the earth minus the angular radius of the sun and the angle between the
+ * directions to the earth and the sun, as seen from the satellite. The direction to the earth turns at most with
+ * the angular velocity of the satellite at perigee, and the angular radius of the earth changes at most with the
+ * largest radial velocity of the orbit. The direction to the sun changes with the motion of the sun.
+ *
+ * \param solver Solver state
+ * \param orbital_elements Orbital elements of satellite
+ **/
+static void eclipse_solver_init(struct eclipse_solver *solver, const predict_orbital_elements_t *orbital_elements)
+{
+	solver->orbital_elements = orbital_elements;
+	solver->decayed = false;
+	solver->num_propagations = 0;
+
+	double mean_motion = orbital_elements->mean_motion*TWOPI/SECDAY;
+	double eccentricity = orbital_elements->eccentricity;
+	double semi_major_axis = cbrt(GM/(mean_motion*mean_motion));
+	double semi_latus_rectum = semi_major_axis*(1.0 - eccentricity*eccentricity);
+	double perigee = semi_major_axis*(1.0 - eccentricity);
+	double perigee_velocity = sqrt(GM/semi_latus_rectum)*(1.0 + eccentricity);
+	double max_radial_velocity = sqrt(GM/semi_latus_rectum)*eccentricity;
+
+	//keep the bound finite for orbits grazing the earth
+	double tangent_length = sqrt(fmax(perigee*perigee - XKMPER*XKMPER, 0.01*XKMPER*XKMPER));
+
+	double max_depth_rate = perigee_velocity/perigee + XKMPER*max_radial_velocity/(perigee*tangent_length);
+	solver->max_depth_rate = ECLIPSE_SOLVER_RATE_MARGIN*max_depth_rate*SECDAY + ECLIPSE_SOLVER_SUN_RATE;
+
+	solver->step = 1.0/(orbital_elements->mean_motion*ECLIPSE_SOLVER_STEPS_PER_ORBIT);
+	if (solver->step < ECLIPSE_SOLVER_MIN_STEP) {
+		solver->step = ECLIPSE_SOLVER_MIN_STEP;
+	}
+}
+
+/**
+ * Propagate satellite and get its eclipse depth, positive when the satellite is eclipsed.
+ *
+ * \param data Solver state, struct eclipse_solver
+ * \param time Time
+ * \return Eclipse depth (radians), NAN when the satellite has decayed
+ **/
+static double eclipse_solver_depth(void *data, predict_julian_date_t time)
+{
+	struct eclipse_solver *solver = (struct eclipse_solver*)data;
+	struct predict_position orbit;
+	predict_orbit(solver->orbital_elements, &orbit, time);
+	solver->num_propagations++;
+	solver->decayed = solver->decayed || orbit.decayed;
+	if (solver->decayed) {
+		return NAN;
+	}
+
+	//libpredict does not eclipse satellites from which the earth appears smaller than the sun, regardless of the depth
+	if (orbit.eclipsed) {
+		return fabs(orbit.eclipse_depth);
+	} else {
+		return -fabs(orbit.eclipse_depth);
+	}
+}
+
+/**
+ * Step from a sample towards a time limit until the satellite crosses the shadow boundary.
+ *
+ * \param solver Solver state
+ * \param time Time of sample
+ * \param depth Eclipse depth at sample
+ * \param limit Time limit, before or after the sample
+ * \param ret_crossing Returned time of crossing
+ * \param ret_time Returned time of the sample right after the crossing
+ * \param ret_depth Returned eclipse depth at the sample right after the crossing
+ * \return True if a crossing was found before the limit, false if no crossing was found or the satellite decayed
+ **/
+static bool eclipse_solver_sweep(struct eclipse_solver *solver, double time, double depth, double limit, predict_julian_date_t *ret_crossing, double *ret_time, double *ret_depth)
+{
+	double direction = (limit >= time) ? 1.0 : -1.0;
+	while (direction*(limit - time) > 0) {
+		double next_time = time + direction*solver->step;
+		if (direction*(next_time - limit) > 0) {
+			next_time = limit;
+		}
+		double next_depth = eclipse_solver_depth(solver, next_time);
+		if (solver->decayed) {
+			return false;
+		}
+		if (root_finder_first_crossing(eclipse_solver_depth, solver, solver->max_depth_rate, 2.0*ECLIPSE_SOLVER_MIN_STEP, ECLIPSE_SOLVER_TOLERANCE, time, depth, next_time, next_depth, ret_crossing, ret_time, ret_depth)) {
+			return true;
+		}
+		time = next_time;
+		depth = next_depth;
+	}
+	return false;
+}
+
+/**
+ * Find eclipse. See eclipse_solver_next_eclipse().
+ *
+ * \param solver Solver state
+ * \param start_time Start of search
+ * \param end_time End of shadow entry search
+ * \param ret_eclipse Returned eclipse
+ * \return Search status
+ **/
+static enum eclipse_solver_status eclipse_solver_find_eclipse(struct eclipse_solver *solver, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_events *ret_eclipse)
+{
+	double time = start_time;
+	double depth = eclipse_solver_depth(solver, time);
+	if (solver->decayed) {
+		return ECLIPSE_SOLVER_FAILED;
+	}
+
+	if (depth > 0) {
+		//eclipse in progress, step backwards to its entry
+		double entry_time, entry_depth;
+		if (!eclipse_solver_sweep(solver, time, depth, start_time - ECLIPSE_SOLVER_MAX_ECLIPSE_DURATION, &(ret_eclipse->entry), &entry_time, &entry_depth)) {
+			return ECLIPSE_SOLVER_FAILED;
+		}
+	} else if (!eclipse_solver_sweep(solver, time, depth, end_time, &(ret_eclipse->entry), &time, &depth)) {
+		return solver->decayed ? ECLIPSE_SOLVER_FAILED : ECLIPSE_SOLVER_NO_ECLIPSE;
+	}
+
+	//step forward from the first eclipsed sample to shadow exit
+	if (!eclipse_solver_sweep(solver, time, depth, ret_eclipse->entry + ECLIPSE_SOLVER_MAX_ECLIPSE_DURATION, &(ret_eclipse->exit), &time, &depth) || solver->decayed) {
+		return ECLIPSE_SOLVER_FAILED;
+	}
+	return ECLIPSE_SOLVER_ECLIPSE_FOUND;
+}
+
+enum eclipse_solver_status eclipse_solver_next_eclipse(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_events *ret_eclipse, int *ret_num_propagations)
+{
+	struct eclipse_solver solver;
+	eclipse_solver_init(&solver, orbital_elements);
+
+	enum eclipse_solver_status status = eclipse_solver_find_eclipse(&solver, start_time, end_time, ret_eclipse);
+	if (ret_num_propagations != NULL) {
+		*ret_num_propagations = solver.num_propagations;
+	}
+	return status;
+}
+
+bool eclipse_solver_eclipsed_time(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, double *ret_eclipsed_time, int *ret_num_propagations)
+{
+	struct eclipse_solver solver;
+	eclipse_solver_init(&solver, orbital_elements);
+
+	double eclipsed_time = 0;
+	predict_julian_date_t time = start_time;
+	enum eclipse_solver_status status = ECLIPSE_SOLVER_NO_ECLIPSE;
+	while (time < end_time) {
+		struct eclipse_events eclipse;
+		status = eclipse_solver_find_eclipse(&solver, time, end_time, &eclipse);
+		if (status != ECLIPSE_SOLVER_ECLIPSE_FOUND) {
+			break;
+		}
+		eclipsed_time += fmin(eclipse.exit, end_time) - fmax(eclipse.entry, time);
+
+		//continue the search right after the shadow exit
+		time = eclipse.exit + ECLIPSE_SOLVER_MIN_STEP;
+	}
+
+	*ret_eclipsed_time = eclipsed_time;
+	if (ret_num_propagations != NULL) {
+		*ret_num_propagations = solver.num_propagations;
+	}
+	return status != ECLIPSE_SOLVER_FAILED;
+}
@@ -0,0 +1,70 @@
+#ifndef ECLIPSE_SOLVER_H_DEFINED
+#define ECLIPSE_SOLVER_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+
+/**
+ * Solver for the times a satellite enters and exits the shadow of the earth.
+ *
+ * The eclipse depth from predict_orbit() (the angle by which the disk of the sun is hidden behind the earth, as
+ * seen from the satellite) is sampled in a fixed number of steps per orbit. The rate of change of the depth is
+ * bounded by the angular velocity of the satellite at perigee, so that intervals where both samples are too far
+ * from the shadow boundary to reach it within the interval can be skipped, and only the remaining intervals are
+ * subdivided. Shadow entry and exit are then refined using Brent's root finding method on the depth, and agree
+ * with the eclipse flag from predict_orbit() within ECLIPSE_SOLVER_TOLERANCE.
+ **/
+
+//tolerance of the shadow entry and exit times (days, 0.1 seconds)
+#define ECLIPSE_SOLVER_TOLERANCE (0.1/86400.0)
+
+/**
+ * Shadow entry and exit of a single eclipse.
+ **/
+struct eclipse_events {
+	///Time the satellite enters the shadow of the earth
+	predict_julian_date_t entry;
+	///Time the satellite exits the shadow of the earth
+	predict_julian_date_t exit;
+};
+
+/**
+ * Return values of eclipse_solver_next_eclipse().
+ **/
+enum eclipse_solver_status {
+	///Eclipse was found
+	ECLIPSE_SOLVER_ECLIPSE_FOUND,
+	///Satellite stays in sunlight until the end of the search
+	ECLIPSE_SOLVER_NO_ECLIPSE,
+	///Satellite decayed during the search, or the eclipse did not end within a day
+	ECLIPSE_SOLVER_FAILED
+};
+
+/**
+ * Find the current or next eclipse of a satellite, i.e. the first eclipse with shadow exit after the given time.
+ * When the satellite is eclipsed at the start time, the eclipse in progress is returned with its actual entry time,
+ * which is before the start time.
+ *
+ * \param orbital_elements Orbital elements of satellite
+ * \param start_time Start of search
+ * \param end_time Time after which the search for a shadow entry is abandoned
+ * \param ret_eclipse Returned eclipse
+ * \param ret_num_propagations Returned number of orbit propagations used in the search. Can be NULL
+ * \return ECLIPSE_SOLVER_ECLIPSE_FOUND if an eclipse was found and ret_eclipse was set, ECLIPSE_SOLVER_NO_ECLIPSE or ECLIPSE_SOLVER_FAILED otherwise
+ **/
+enum eclipse_solver_status eclipse_solver_next_eclipse(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_events *ret_eclipse, int *ret_num_propagations);
+
+/**
+ * Calculate the time a satellite spends in the shadow of the earth within a time interval, from the shadow
+ * entry and exit times of the eclipses overlapping the interval.
+ *
+ * \param orbital_elements Orbital elements of satellite
+ * \param start_time Start of interval
+ * \param end_time End of interval
+ * \param ret_eclipsed_time Returned time spent in eclipse (days)
+ * \param ret_num_propagations Returned number of orbit propagations used. Can be NULL
+ * \return True if the eclipsed time was calculated, false if the satellite decayed
+ **/
+bool eclipse_solver_eclipsed_time(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, double *ret_eclipsed_time, int *ret_num_propagations);
+
+#endif
@@ -0,0 +1,117 @@
+#include "ephemeris_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct ephemeris_cache *ephemeris_cache_create(const predict_orbital_elements_t *orbital_elements, double window_length)
+{
+	struct ephemeris_cache *cache = (struct ephemeris_cache*)calloc(1, sizeof(struct ephemeris_cache));
+	cache->orbital_elements = orbital_elements;
+	cache->window_length = window_length;
+	cache->fitted = false;
+	return cache;
+}
+
+void ephemeris_cache_destroy(struct ephemeris_cache **cache)
+{
+	free(*cache);
+	*cache = NULL;
+}
+
+/**
+ * Fit Chebyshev series to the position and velocity over the window starting at the given time.
+ *
+ * \param cache Ephemeris cache
+ * \param window_start Start of the window
+ **/
+static void ephemeris_cache_fit(struct ephemeris_cache *cache, predict_julian_date_t window_start)
+{
+	const int n = EPHEMERIS_CACHE_NUM_COEFFICIENTS;
+	double half_length = cache->window_length/2.0;
+	double midpoint = window_start + half_length;
+
+	//propagate at the chebyshev nodes
+	double positions[EPHEMERIS_CACHE_NUM_COEFFICIENTS][3];
+	double velocities[EPHEMERIS_CACHE_NUM_COEFFICIENTS][3];
+	bool decayed = false;
+	for (int k=0; k < n; k++) {
+		struct predict_position orbit;
+		predict_orbit(cache->orbital_elements, &orbit, midpoint + half_length*cos(M_PI*(k + 0.5)/n));
+		decayed = decayed || orbit.decayed;
+		memcpy(positions[k], orbit.position, sizeof(double)*3);
+		memcpy(velocities[k], orbit.velocity, sizeof(double)*3);
+	}
+
+	//discrete cosine transform of the samples
+	for (int j=0; j < n; j++) {
+		for (int i=0; i < 3; i++) {
+			cache->position[i][j] = 0;
+			cache->velocity[i][j] = 0;
+		}
+		for (int k=0; k < n; k++) {
+			double weight = 2.0/n*cos(M_PI*j*(k + 0.5)/n);
+			for (int i=0; i < 3; i++) {
+				cache->position[i][j] += weight*positions[k][i];
+				cache->velocity[i][j] += weight*velocities[k][i];
+			}
+		}
+	}
+
+	cache->window_start = window_start;
+	cache->decayed = decayed;
+	cache->fitted = true;
+	cache->num_fits++;
+}
+
+/**
+ * Evaluate Chebyshev series using Clenshaw's recurrence.
+ *
+ * \param coefficients Chebyshev coefficients, EPHEMERIS_CACHE_NUM_COEFFICIENTS long
+ * \param x Point within [-1, 1]
+ * \return Value of the series
+ **/
+static double ephemeris_cache_evaluate(const double *coefficients, double x)
+{
+	double b1 = 0;
+	double b2 = 0;
+	for (int j=EPHEMERIS_CACHE_NUM_COEFFICIENTS-1; j > 0; j--) {
+		double b = 2*x*b1 - b2 + coefficients[j];
+		b2 = b1;
+		b1 = b;
+	}
+	return x*b1 - b2 + 0.5*coefficients[0];
+}
+
+bool ephemeris_cache_orbit(struct ephemeris_cache *cache, predict_julian_date_t time, struct predict_position *ret_orbit)
+{
+	//fit window containing the time, with windows aligned to multiples of the window length
+	if (!cache->fitted || (time < cache->window_start) || (time >= cache->window_start + cache->window_length)) {
+		ephemeris_cache_fit(cache, floor(time/cache->window_length)*cache->window_length);
+	}
+
+	memset(ret_orbit, 0, sizeof(struct predict_position));
+	ret_orbit->time = time;
+	if (cache->decayed) {
+		ret_orbit->decayed = true;
+		return false;
+	}
+
+	double x = 2.0*(time - cache->window_start)/cache->window_length - 1.0;
+	for (int i=0; i < 3; i++) {
+		ret_orbit->position[i] = ephemeris_cache_evaluate(cache->position[i], x);
+		ret_orbit->velocity[i] = ephemeris_cache_evaluate(cache->velocity[i], x);
+	}
+	return true;
+}
+
+bool ephemeris_cache_observe(struct ephemeris_cache *cache, const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs)
+{
+	struct predict_position orbit;
+	if (!ephemeris_cache_orbit(cache, time, &orbit)) {
+		memset(ret_obs, 0, sizeof(struct predict_observation));
+		ret_obs->time = time;
+		return false;
+	}
+	predict_observe_orbit(observer, &orbit, ret_obs);
+	return true;
+}
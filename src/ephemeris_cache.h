@@ -0,0 +1,88 @@
+#ifndef EPHEMERIS_CACHE_H_DEFINED
+#define EPHEMERIS_CACHE_H_DEFINED
+
+#include <stdbool.h>
+#include <predict/predict.h>
+
+/**
+ * Cache of Chebyshev polynomial fits of the ECI position and velocity of a single satellite, for position,
+ * range rate and doppler queries at arbitrary sub-second times.
+ *
+ * Time is divided into windows of fixed length. The first query within a window propagates the satellite
+ * using libpredict at the EPHEMERIS_CACHE_NUM_COEFFICIENTS Chebyshev nodes of the window, and fits a Chebyshev
+ * series to each coordinate of the position and of the velocity. Later queries within the window evaluate the
+ * series using Clenshaw's recurrence, at a cost of a few dozen flops per coordinate.
+ *
+ * With the default window of 10 minutes, the truncation error of the fits is below the meter-level noise that the
+ * iterative solution of Kepler's equation leaves in libpredict's positions. The fits are within 20 meters in position
+ * and 2 cm/s in velocity of libpredict for low earth orbit satellites, i.e. within 0.05 Hz in doppler shift at 435 MHz.
+ **/
+
+//number of Chebyshev coefficients fitted to each coordinate
+#define EPHEMERIS_CACHE_NUM_COEFFICIENTS 12
+
+//default length of the fitted windows (days)
+#define EPHEMERIS_CACHE_DEFAULT_WINDOW (10.0/1440.0)
+
+/**
+ * Chebyshev fits of the orbit of a satellite over the current window.
+ **/
+struct ephemeris_cache {
+	///Orbital elements, owned by the caller
+	const predict_orbital_elements_t *orbital_elements;
+	///Length of the windows (days)
+	double window_length;
+	///Whether a window has been fitted
+	bool fitted;
+	///Start of the fitted window
+	predict_julian_date_t window_start;
+	///Whether the satellite decays within the fitted window
+	bool decayed;
+	///Chebyshev coefficients of the ECI position (km), for each coordinate
+	double position[3][EPHEMERIS_CACHE_NUM_COEFFICIENTS];
+	///Chebyshev coefficients of the ECI velocity (km/s), for each coordinate
+	double velocity[3][EPHEMERIS_CACHE_NUM_COEFFICIENTS];
+	///Number of windows fitted so far
+	int num_fits;
+};
+
+/**
+ * Create ephemeris cache for a satellite.
+ *
+ * \param orbital_elements Orbital elements. The pointer is kept, and has to be valid until the cache is destroyed
+ * \param window_length Length of the fitted windows (days), e.g. EPHEMERIS_CACHE_DEFAULT_WINDOW
+ * \return Ephemeris cache
+ **/
+struct ephemeris_cache *ephemeris_cache_create(const predict_orbital_elements_t *orbital_elements, double window_length);
+
+/**
+ * Free ephemeris cache.
+ *
+ * \param cache Ephemeris cache
+ **/
+void ephemeris_cache_destroy(struct ephemeris_cache **cache);
+
+/**
+ * Get position and velocity of the satellite at the given time, fitting the window containing the time if necessary.
+ * Only time, position and velocity are set, the rest of the fields are zeroed.
+ *
+ * \param cache Ephemeris cache
+ * \param time Time
+ * \param ret_orbit Returned orbit
+ * \return True if the position was obtained, false if the satellite decays within the window, in which case predict_orbit() should be used instead
+ **/
+bool ephemeris_cache_orbit(struct ephemeris_cache *cache, predict_julian_date_t time, struct predict_position *ret_orbit);
+
+/**
+ * Observe the satellite from the given observer at the given time, using the position and velocity from the cache.
+ * The satellite is assumed to be sunlit when calculating its visibility.
+ *
+ * \param cache Ephemeris cache
+ * \param observer Observer
+ * \param time Time
+ * \param ret_obs Returned observation, as from predict_observe_orbit()
+ * \return True if the observation was obtained, false if the satellite decays within the window
+ **/
+bool ephemeris_cache_observe(struct ephemeris_cache *cache, const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs);
+
+#endif
@@ -0,0 +1,160 @@
+#include "event_loop.h"
+#include "defines.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+//indices of the input and timer file descriptors among the polled file descriptors
+#define EVENT_LOOP_INPUT_FD 0
+#define EVENT_LOOP_TIMER_FD 1
+
+struct event_loop *event_loop_create(int input_fd, double tick_interval)
+{
+	struct event_loop *loop = (struct event_loop*)calloc(1, sizeof(struct event_loop));
+	loop->tick_interval = tick_interval;
+	loop->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	//poll() ignores negative file descriptors, so a missing timerfd can be kept in place
+	loop->fds[EVENT_LOOP_INPUT_FD].fd = input_fd;
+	loop->fds[EVENT_LOOP_INPUT_FD].events = POLLIN;
+	loop->fds[EVENT_LOOP_TIMER_FD].fd = loop->timer_fd;
+	loop->fds[EVENT_LOOP_TIMER_FD].events = POLLIN;
+	loop->num_fds = 2;
+	loop->event_scheduled = false;
+	return loop;
+}
+
+void event_loop_destroy(struct event_loop **loop)
+{
+	if (*loop == NULL) {
+		return;
+	}
+
+	if ((*loop)->timer_fd != -1) {
+		close((*loop)->timer_fd);
+	}
+	free(*loop);
+	*loop = NULL;
+}
+
+bool event_loop_watch_fd(struct event_loop *loop, int fd)
+{
+	if ((fd < 0) || (loop->num_fds >= EVENT_LOOP_MAX_WATCHED_FDS + 2)) {
+		return false;
+	}
+
+	loop->fds[loop->num_fds].fd = fd;
+	loop->fds[loop->num_fds].events = POLLIN;
+	loop->num_fds++;
+	return true;
+}
+
+void event_loop_schedule(struct event_loop *loop, predict_julian_date_t time)
+{
+	if (!loop->event_scheduled || (time < loop->next_event)) {
+		loop->next_event = time;
+		loop->event_scheduled = true;
+	}
+}
+
+/**
+ * Get wall clock time.
+ *
+ * \return Seconds since the unix epoch
+ **/
+static double event_loop_current_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return now.tv_sec + now.tv_nsec*1.0e-9;
+}
+
+/**
+ * Get time of the next wakeup from the timer, at the next tick or an earlier scheduled event.
+ *
+ * \param loop Event loop
+ * \param current_time Current time (seconds since the unix epoch)
+ * \return Time of wakeup (seconds since the unix epoch)
+ **/
+static double event_loop_deadline(const struct event_loop *loop, double current_time)
+{
+	double deadline = (floor(current_time/loop->tick_interval) + 1.0)*loop->tick_interval;
+	if (loop->event_scheduled) {
+		double event_time = loop->next_event*SECDAY + JULIAN_EPOCH_UNIX_TIME;
+		if (event_time < deadline) {
+			deadline = (event_time > current_time) ? event_time : current_time;
+		}
+	}
+	return deadline;
+}
+
+/**
+ * Arm timerfd at an absolute wall clock time. The timer also expires when the wall clock is set, so that ticks stay
+ * aligned after clock adjustments.
+ *
+ * \param timer_fd timerfd
+ * \param deadline Expiration time (seconds since the unix epoch)
+ * \return True if the timer was armed, false otherwise
+ **/
+static bool event_loop_arm_timer(int timer_fd, double deadline)
+{
+	struct itimerspec timer = {0};
+	double seconds = floor(deadline);
+	timer.it_value.tv_sec = seconds;
+	timer.it_value.tv_nsec = (deadline - seconds)*1.0e9;
+	if (timer.it_value.tv_nsec >= 1000000000L) {
+		timer.it_value.tv_sec++;
+		timer.it_value.tv_nsec -= 1000000000L;
+	}
+
+	//zero expiration time would disarm the timer
+	if ((timer.it_value.tv_sec == 0) && (timer.it_value.tv_nsec == 0)) {
+		timer.it_value.tv_nsec = 1;
+	}
+	return timerfd_settime(timer_fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &timer, NULL) == 0;
+}
+
+int event_loop_wait(struct event_loop *loop)
+{
+	double current_time = event_loop_current_time();
+	double deadline = event_loop_deadline(loop, current_time);
+	loop->event_scheduled = false;
+
+	int timeout = -1;
+	if ((loop->timer_fd == -1) || !event_loop_arm_timer(loop->timer_fd, deadline)) {
+		timeout = ceil((deadline - current_time)*1000.0);
+	}
+
+	for (int i=0; i < loop->num_fds; i++) {
+		loop->fds[i].revents = 0;
+	}
+	int ret = poll(loop->fds, loop->num_fds, timeout);
+	if (ret == -1) {
+		return EVENT_LOOP_INTERRUPTED;
+	}
+
+	int events = 0;
+	if (ret == 0) {
+		events |= EVENT_LOOP_TIMER;
+	}
+	if (loop->fds[EVENT_LOOP_INPUT_FD].revents != 0) {
+		events |= EVENT_LOOP_INPUT;
+	}
+	if (loop->fds[EVENT_LOOP_TIMER_FD].revents != 0) {
+		//clear expiration, read fails with ECANCELED when the wall clock was set
+		uint64_t num_expirations;
+		if ((read(loop->timer_fd, &num_expirations, sizeof(num_expirations)) > 0) || (errno == ECANCELED)) {
+			events |= EVENT_LOOP_TIMER;
+		}
+	}
+	for (int i=EVENT_LOOP_TIMER_FD+1; i < loop->num_fds; i++) {
+		if (loop->fds[i].revents != 0) {
+			events |= EVENT_LOOP_WATCHED_FD;
+		}
+	}
+	return events;
+}
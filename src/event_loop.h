@@ -0,0 +1,95 @@
+#ifndef EVENT_LOOP_H_DEFINED
+#define EVENT_LOOP_H_DEFINED
+
+#include <stdbool.h>
+#include <poll.h>
+#include <predict/predict.h>
+
+/**
+ * Event loop for the interactive screens, replacing polling of the keyboard at a fixed rate.
+ *
+ * The loop sleeps in poll() on the keyboard input, a timerfd and any additional watched file descriptors. The timer
+ * is armed at the next whole multiple of the tick interval of the wall clock, where displayed values like the current
+ * time and countdowns change, or at an earlier event scheduled for the current wait, like an AOS or LOS. Nothing is
+ * recomputed or redrawn between these wakeups.
+ **/
+
+//maximum number of additional file descriptors watched by the event loop
+#define EVENT_LOOP_MAX_WATCHED_FDS 8
+
+/**
+ * Return flags of event_loop_wait().
+ **/
+enum event_loop_wakeup {
+	///Input is available
+	EVENT_LOOP_INPUT = (1u << 0),
+	///Tick or scheduled event was reached
+	EVENT_LOOP_TIMER = (1u << 1),
+	///A watched file descriptor is readable
+	EVENT_LOOP_WATCHED_FD = (1u << 2),
+	///Waiting was interrupted by a signal, e.g. on terminal resize
+	EVENT_LOOP_INTERRUPTED = (1u << 3)
+};
+
+/**
+ * Event loop.
+ **/
+struct event_loop {
+	///Interval between ticks, aligned to the wall clock (seconds)
+	double tick_interval;
+	///timerfd, -1 if not available, in which case the poll() timeout is used instead
+	int timer_fd;
+	///Polled file descriptors: input, timer and watched file descriptors
+	struct pollfd fds[EVENT_LOOP_MAX_WATCHED_FDS + 2];
+	///Number of polled file descriptors
+	int num_fds;
+	///Whether an event is scheduled for the next wait
+	bool event_scheduled;
+	///Earliest scheduled event
+	predict_julian_date_t next_event;
+};
+
+/**
+ * Create event loop.
+ *
+ * \param input_fd Input file descriptor, usually STDIN_FILENO
+ * \param tick_interval Interval between ticks (seconds). Ticks occur at whole multiples of the interval of the wall clock
+ * \return Event loop
+ **/
+struct event_loop *event_loop_create(int input_fd, double tick_interval);
+
+/**
+ * Free event loop. Watched file descriptors are not closed.
+ *
+ * \param loop Event loop
+ **/
+void event_loop_destroy(struct event_loop **loop);
+
+/**
+ * Wake up the event loop when a file descriptor becomes readable. The caller is responsible for reading it.
+ *
+ * \param loop Event loop
+ * \param fd File descriptor
+ * \return True if the file descriptor is watched, false if it is invalid or too many file descriptors are watched
+ **/
+bool event_loop_watch_fd(struct event_loop *loop, int fd);
+
+/**
+ * Schedule wakeup at an event for the next call to event_loop_wait(). The earliest of the scheduled events is used,
+ * and the schedule is cleared when waiting.
+ *
+ * \param loop Event loop
+ * \param time Time of event
+ **/
+void event_loop_schedule(struct event_loop *loop, predict_julian_date_t time);
+
+/**
+ * Sleep until input is available, a watched file descriptor is readable, or the next tick or scheduled event is
+ * reached.
+ *
+ * \param loop Event loop
+ * \return Combination of flags in enum event_loop_wakeup
+ **/
+int event_loop_wait(struct event_loop *loop);
+
+#endif
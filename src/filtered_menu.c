@@ -164,7 +164,7 @@ void filtered_menu_pattern_match(struct filtered_menu *list, const struct tle_db
 		}
 
 		//check against TLE filename
-		char *fname_uppercase = str_to_uppercase(tle_db->tles[i].filename);
+		char *fname_uppercase = str_to_uppercase(tle_db_entry_filename(tle_db, i));
 		if (pattern_match(fname_uppercase, pattern)) {
 			display_items[i] = true;
 		}
@@ -172,7 +172,7 @@ void filtered_menu_pattern_match(struct filtered_menu *list, const struct tle_db
 
 		//check against satellite number
 		char satnum_str[MAX_NUM_CHARS];
-		snprintf(satnum_str, MAX_NUM_CHARS, "%ld", tle_db->tles[i].satellite_number);
+		snprintf(satnum_str, MAX_NUM_CHARS, "%ld", tle_db_entry_satellite_number(tle_db, i));
 		if (pattern_match(satnum_str, pattern)) {
 			display_items[i] = true;
 		}
@@ -234,7 +234,7 @@ void filtered_menu_from_tle_db(struct filtered_menu *list, const struct tle_db *
 {
 	string_array_t string_list = {0};
 	for (int i=0; i < db->num_tles; i++) {
-		string_array_add(&string_list, db->tles[i].name);
+		string_array_add(&string_list, tle_db_entry_name(db, i));
 	}
 
 	filtered_menu_from_stringarray(list, &string_list, my_menu_win);
@@ -1,6 +1,7 @@
 #include "hamlib_status.h"
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include "hamlib.h"
 #include "ui.h"
 #include "defines.h"
@@ -310,7 +311,7 @@ void rigctld_form_update(rigctld_info_t *rigctld, struct rigctld_form *form)
 
 void hamlib_status(rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink, enum hamlib_status_background_clearing clear)
 {
-	halfdelay(HALF_DELAY_TIME);
+	struct event_loop *event_loop = event_loop_create(STDIN_FILENO, UI_TICK_INTERVAL);
 
 	//prepare status forms
 	int row = HAMLIB_SETTINGS_WINDOW_START_ROW;
@@ -338,12 +339,13 @@ void hamlib_status(rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_in
 		rotctld_form_update(rotctld, rotctld_form);
 
 		//key input handling
-		int key = getch();
+		int key = wait_for_input(event_loop);
 		if (key != ERR) {
 			break;
 		}
 	}
 
+	event_loop_destroy(&event_loop);
 	rigctld_form_free(&downlink_form);
 	rigctld_form_free(&uplink_form);
 	rotctld_form_free(&rotctld_form);
@@ -13,8 +13,13 @@
 #include "tle_db.h"
 #include "xdg_basedirs.h"
 #include "transponder_db.h"
+#include "db_snapshot.h"
 #include "option_help.h"
+#include "track_astronomical_bodies.h"
+#include "pass_predictions.h"
+#include "prediction_output.h"
 #include <libgen.h>
+#include <time.h>
 
 //longopt value identificators for command line options without shorthand
 #define FLYBY_OPT_UPLINK_PORT 202
@@ -22,6 +27,16 @@
 #define FLYBY_OPT_DOWNLINK_PORT 204
 #define FLYBY_OPT_DOWNLINK_VFO 205
 #define FLYBY_OPT_ADD_TLE 207
+#define FLYBY_OPT_PREDICT_SUN_MOON 208
+#define FLYBY_OPT_FROM 209
+#define FLYBY_OPT_TO 210
+#define FLYBY_OPT_PREDICT_PASSES 211
+#define FLYBY_OPT_MIN_ELEVATION 212
+#define FLYBY_OPT_OUTPUT 213
+#define FLYBY_OPT_FORMAT 214
+
+//default duration of headless predictions (days)
+#define FLYBY_DEFAULT_PREDICTION_DURATION 7.0
 
 /**
  * Parse input argument on format host:port to each separate argument.
@@ -59,6 +74,33 @@ void parse_to_host_and_port(const char *argument, char *host, char *port)
 	free(trimmed_argument);
 }
 
+/**
+ * Parse time argument on format YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS (UTC).
+ *
+ * \param argument Input argument
+ * \return Parsed time
+ **/
+predict_julian_date_t parse_time(const char *argument)
+{
+	struct tm parsed_time = {0};
+	int num_parsed_chars = 0;
+	int num_fields = sscanf(argument, "%d-%d-%dT%d:%d:%d%n", &parsed_time.tm_year, &parsed_time.tm_mon, &parsed_time.tm_mday, &parsed_time.tm_hour, &parsed_time.tm_min, &parsed_time.tm_sec, &num_parsed_chars);
+	if (num_fields != 6) {
+		parsed_time.tm_hour = 0;
+		parsed_time.tm_min = 0;
+		parsed_time.tm_sec = 0;
+		num_parsed_chars = 0;
+		num_fields = sscanf(argument, "%d-%d-%d%n", &parsed_time.tm_year, &parsed_time.tm_mon, &parsed_time.tm_mday, &num_parsed_chars);
+	}
+	if (((num_fields != 6) && (num_fields != 3)) || (num_parsed_chars != strlen(argument))) {
+		fprintf(stderr, "Error in format of argument: expected YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS, got %s.\n", argument);
+		exit(1);
+	}
+	parsed_time.tm_year -= 1900;
+	parsed_time.tm_mon -= 1;
+	return predict_to_julian(timegm(&parsed_time));
+}
+
 int main(int argc, char **argv)
 {
 	//rotctl options
@@ -87,6 +129,16 @@ int main(int argc, char **argv)
 	char qth_filename[MAX_NUM_CHARS] = {0};
 	bool qth_cmd_filename_set = false;
 
+	//headless prediction options
+	bool predict_sun_moon = false;
+	bool predict_passes = false;
+	double prediction_min_elevation = 0;
+	char prediction_output_filename[MAX_NUM_CHARS] = {0};
+	enum prediction_output_format prediction_format = PREDICTION_OUTPUT_TEXT;
+	predict_julian_date_t prediction_start = predict_to_julian(time(NULL));
+	predict_julian_date_t prediction_end = 0;
+	bool prediction_end_set = false;
+
 	//command line options
 	struct option_extended options[] = {
 		{{"add-tle-file",		required_argument,	0,	FLYBY_OPT_ADD_TLE},
@@ -129,6 +181,34 @@ int main(int argc, char **argv)
 			"VFO_NAME",
 			"Specify rigctld downlink VFO."
 		},
+		{{"predict-sun-moon",		no_argument,		0,	FLYBY_OPT_PREDICT_SUN_MOON},
+			NULL,
+			"Print rise, transit and set of the sun and the moon at the QTH between --from and --to, and exit."
+		},
+		{{"predict-passes",		no_argument,		0,	FLYBY_OPT_PREDICT_PASSES},
+			NULL,
+			"Print all passes of the enabled satellites over the QTH between --from and --to in AOS order, and exit."
+		},
+		{{"min-elevation",		required_argument,	0,	FLYBY_OPT_MIN_ELEVATION},
+			"ELEVATION",
+			"Only print passes reaching at least ELEVATION degrees with --predict-passes. Defaults to 0."
+		},
+		{{"from",			required_argument,	0,	FLYBY_OPT_FROM},
+			"TIME",
+			"Start of headless predictions, as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS in UTC. Defaults to the current time."
+		},
+		{{"to",				required_argument,	0,	FLYBY_OPT_TO},
+			"TIME",
+			"End of headless predictions, as YYYY-MM-DD or YYYY-MM-DDTHH:MM:SS in UTC. Defaults to 7 days after the start."
+		},
+		{{"output",			required_argument,	0,	FLYBY_OPT_OUTPUT},
+			"FILE",
+			"Write headless predictions to FILE instead of standard output."
+		},
+		{{"format",			required_argument,	0,	FLYBY_OPT_FORMAT},
+			"FORMAT",
+			"Format of headless predictions: text, csv, jsonl or ics. Defaults to text."
+		},
 		{{"help",			no_argument,		0,	'h'},
 			NULL,
 			"Show help."
@@ -188,6 +268,37 @@ int main(int argc, char **argv)
 			case FLYBY_OPT_DOWNLINK_VFO: //downlink vfo
 				strncpy(rigctld_downlink_vfo, optarg, MAX_NUM_CHARS);
 				break;
+			case FLYBY_OPT_PREDICT_SUN_MOON: //sun and moon predictions
+				predict_sun_moon = true;
+				break;
+			case FLYBY_OPT_PREDICT_PASSES: //pass predictions
+				predict_passes = true;
+				break;
+			case FLYBY_OPT_MIN_ELEVATION: { //minimum elevation of predicted passes
+				char *end = NULL;
+				prediction_min_elevation = strtod(optarg, &end);
+				if ((end == optarg) || (*end != '\0') || !(fabs(prediction_min_elevation) <= 90.0)) {
+					fprintf(stderr, "Error in format of argument: expected elevation between -90 and 90 degrees, got %s.\n", optarg);
+					exit(1);
+				}
+				break;
+			}
+			case FLYBY_OPT_FROM: //start of predictions
+				prediction_start = parse_time(optarg);
+				break;
+			case FLYBY_OPT_TO: //end of predictions
+				prediction_end = parse_time(optarg);
+				prediction_end_set = true;
+				break;
+			case FLYBY_OPT_OUTPUT: //output file of predictions
+				strncpy(prediction_output_filename, optarg, MAX_NUM_CHARS-1);
+				break;
+			case FLYBY_OPT_FORMAT: //output format of predictions
+				if (!prediction_output_format_from_string(optarg, &prediction_format)) {
+					fprintf(stderr, "Unknown prediction output format %s. Use text, csv, jsonl or ics.\n", optarg);
+					exit(1);
+				}
+				break;
 			case 'h': //help
 				getopt_long_show_help(usage_instructions, options, short_options);
 				return 0;
@@ -206,6 +317,11 @@ int main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (prediction_end_set && (prediction_end <= prediction_start)) {
+		fprintf(stderr, "End of predictions (--to) has to be after the start (--from).\n");
+		exit(1);
+	}
+
 	//add TLE files to XDG data home and exit
 	int num_tle_add_files = string_array_size(&tle_add_filenames);
 	if (num_tle_add_files > 0) {
@@ -247,25 +363,112 @@ int main(int argc, char **argv)
 			}
 			tle_db_destroy(&temp_db);
 		}
-	} else {
-		//TLEs are read from XDG dirs
-		tle_db_from_search_paths(tle_db);
 	}
 
-	whitelist_from_search_paths(tle_db);
+	//use startup snapshot of TLE, whitelist and transponder databases when reading from XDG dirs and all source files are unchanged
+	struct transponder_db *transponder_db = NULL;
+	struct db_snapshot_sources snapshot_sources = {0};
+	char *snapshot_file = NULL;
+	int num_update_files = string_array_size(&tle_update_filenames);
+	if ((num_cmd_tle_files == 0) && (num_update_files == 0)) {
+		db_snapshot_sources_from_search_paths(&snapshot_sources);
+		snapshot_file = db_snapshot_default_path();
+		if ((snapshot_file != NULL) && (db_snapshot_from_file(snapshot_file, &snapshot_sources, tle_db, &transponder_db) != DB_SNAPSHOT_SUCCESS)) {
+			transponder_db = NULL;
+		}
+	}
+
+	if (transponder_db == NULL) {
+		if (num_cmd_tle_files == 0) {
+			//TLEs are read from XDG dirs
+			tle_db_from_search_paths(tle_db);
+		}
+		whitelist_from_search_paths(tle_db);
+	}
 
 	//use tle update files to update the TLE database, if present
-	int num_update_files = string_array_size(&tle_update_filenames);
 	if (num_update_files > 0) {
+		printf("Updating TLE database using");
 		for (int i=0; i < num_update_files; i++) {
-			printf("Updating TLE database using %s:\n\n", string_array_get(&tle_update_filenames, i));
-			update_tle_database(string_array_get(&tle_update_filenames, i), tle_db);
-			printf("\n");
+			printf(" %s", string_array_get(&tle_update_filenames, i));
 		}
+		printf(":\n\n");
+		update_tle_database_from_files(&tle_update_filenames, tle_db);
+		printf("\n");
 		string_array_free(&tle_update_filenames);
 		return 0;
 	}
 
+	//read flyby config files
+	predict_observer_t *observer = predict_create_observer("", 0, 0, 0);
+	bool is_new_user = false;
+	enum qth_file_state qth_state = QTH_FILE_HOME;
+
+	if (qth_cmd_filename_set) {
+		int retval = qth_from_file(qth_filename, observer);
+		if (retval != 0) {
+			fprintf(stderr, "QTH file %s could not be loaded.\n", qth_filename);
+			return 1;
+		}
+	} else {
+		qth_state = qth_from_search_paths(observer);
+		is_new_user = qth_state != QTH_FILE_HOME;
+		char *temp = qth_default_writepath();
+		strncpy(qth_filename, temp, MAX_NUM_CHARS);
+		free(temp);
+	}
+
+	//read transponder database, and update the snapshot when any of the databases were read from their files. Done
+	//also before headless predictions, which do not use the transponder database, since the snapshot contains both
+	if (transponder_db == NULL) {
+		transponder_db = transponder_db_create(tle_db);
+		transponder_db_from_search_paths(tle_db, transponder_db);
+
+		if (snapshot_file != NULL) {
+			db_snapshot_to_file(snapshot_file, &snapshot_sources, tle_db, transponder_db);
+		}
+	}
+	db_snapshot_sources_free(&snapshot_sources);
+	free(snapshot_file);
+
+	//print headless predictions and exit
+	if (predict_sun_moon || predict_passes) {
+		if (!prediction_end_set) {
+			prediction_end = prediction_start + FLYBY_DEFAULT_PREDICTION_DURATION;
+		}
+		bool written = false;
+		FILE *prediction_file = stdout;
+		if (qth_state == QTH_FILE_NOTFOUND) {
+			//headless predictions have no QTH setup screen to fall back to
+			fprintf(stderr, "No QTH file found. Specify one using --qth-file, or run flyby once without prediction options to create one.\n");
+		} else if ((strlen(prediction_output_filename) > 0) && ((prediction_file = fopen(prediction_output_filename, "w")) == NULL)) {
+			fprintf(stderr, "Could not open %s for writing.\n", prediction_output_filename);
+		} else {
+			struct prediction_output *output = prediction_output_create(prediction_file, prediction_format);
+			if (predict_sun_moon) {
+				astronomical_body_write_events(output, observer, prediction_start, prediction_end);
+			}
+			if (predict_passes) {
+				struct pass_predictions *predictions = pass_predictions_create(tle_db, observer, prediction_start, prediction_end, prediction_min_elevation*M_PI/180.0, 0);
+				pass_predictions_write(output, predictions, tle_db);
+				pass_predictions_destroy(&predictions);
+			}
+			written = prediction_output_destroy(&output);
+			if (prediction_file != stdout) {
+				written = (fclose(prediction_file) == 0) && written;
+			}
+			if (!written) {
+				fprintf(stderr, "Could not write predictions.\n");
+			}
+		}
+
+		predict_destroy_observer(observer);
+		tle_db_destroy(&tle_db);
+		transponder_db_destroy(&transponder_db);
+		free(long_options);
+		return written ? 0 : 1;
+	}
+
 	//connect to rotctld
 	rotctld_info_t rotctld = {.host = ROTCTLD_DEFAULT_HOST, .port = ROTCTLD_DEFAULT_PORT};
 	if (use_rotctl) {
@@ -314,26 +517,6 @@ int main(int argc, char **argv)
 		}
 	}
 
-	//read flyby config files
-	predict_observer_t *observer = predict_create_observer("", 0, 0, 0);
-	bool is_new_user = false;
-
-	if (qth_cmd_filename_set) {
-		int retval = qth_from_file(qth_filename, observer);
-		if (retval != 0) {
-			fprintf(stderr, "QTH file %s could not be loaded.\n", qth_filename);
-			return 1;
-		}
-	} else {
-		is_new_user = qth_from_search_paths(observer) != QTH_FILE_HOME;
-		char *temp = qth_default_writepath();
-		strncpy(qth_filename, temp, MAX_NUM_CHARS);
-		free(temp);
-	}
-
-	struct transponder_db *transponder_db = transponder_db_create(tle_db);
-	transponder_db_from_search_paths(tle_db, transponder_db);
-
 	run_flyby_curses_ui(is_new_user, qth_filename, observer, tle_db, transponder_db, &rotctld, &downlink, &uplink);
 
 	//disconnect from rigctl and rotctl
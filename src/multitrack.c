@@ -6,6 +6,9 @@
 #include <curses.h>
 #include <stdlib.h>
 #include "tle_db.h"
+#include "batch_propagation.h"
+#include "worker_pool.h"
+#include "pass_table.h"
 #include "multitrack.h"
 #include "ui.h"
 
@@ -35,13 +38,21 @@ void multitrack_settings_from_file(multitrack_listing_t *listing);
 void multitrack_settings_to_file(multitrack_listing_t *listing);
 
 /**
- * Create entry in multitrack satellite listing.
+ * Initialize entry in multitrack satellite listing.
  *
- * \param name Satellite name
- * \param orbital_elements Orbital elements of satellite, created from TLE
- * \return Multitrack entry
+ * \param entry Multitrack entry, stored in the arena of the listing
  **/
-multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_elements_t *orbital_elements);
+void multitrack_init_entry(multitrack_entry_t *entry);
+
+/**
+ * Classify the orbit of a satellite entry, and whether the satellite can rise above the horizon of the QTH.
+ * Run when the entry is created, and again when its orbital elements change.
+ *
+ * \param entry Multitrack entry
+ * \param elements Orbital elements of satellite
+ * \param qth QTH coordinates
+ **/
+void multitrack_classify_entry(multitrack_entry_t *entry, const predict_orbital_elements_t *elements, const predict_observer_t *qth);
 
 /**
  * Print scrollbar for satellite listing.
@@ -51,29 +62,39 @@ multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_el
 void multitrack_print_scrollbar(multitrack_listing_t *listing);
 
 /**
- * Display entry in satellite listing.
+ * Display entry in satellite listing. The display string of the entry is formatted first if its displayed values have changed.
  *
- * \param window Window to display entry in
+ * \param listing Satellite listing
  * \param row Row
  * \param col Column
- * \param entry Satellite entry
+ * \param entry_index Index of entry
+ * \param selected Whether the entry is selected by the menu marker
  **/
-void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry);
+void multitrack_display_entry(multitrack_listing_t *listing, int row, int col, int entry_index, bool selected);
 
 /**
- * Update display strings and status in satellite entry.
+ * Update status in satellite entry. No strings are formatted here, since only the entries shown on screen are
+ * formatted by multitrack_display_entry(). Called from the worker threads, and must only modify the given entry.
  *
  * \param max_elevation_threshold Max elevation threshold
  * \param qth QTH coordinates
  * \param entry Multitrack entry
+ * \param orbital_elements Orbital elements of satellite
  * \param time Time at which satellite status should be calculated
+ * \param orbit Satellite position at the given time
+ * \param obs Observation of the satellite at the given time
+ * \param pass Current or next pass of the satellite from the pass table, or NULL if not available
  * \return True if aos/los times change, false otherwise
  **/
-bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, predict_julian_date_t time);
+bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, const struct predict_position *orbit, const struct predict_observation *obs, const struct pass_events *pass);
 
 /**
  * Sort satellite listing in different categories: Currently above horizon, below horizon but will rise, will never rise above horizon, decayed satellites. The satellites below the horizon are sorted internally according to AOS times.
  *
+ * The sorted index is kept ordered between calls, and only the entries whose sort key changed since the last sort are
+ * moved, at a cost of O(log N) comparisons each. When many entries changed, the changed entries are sorted separately and
+ * merged with the rest in a single pass.
+ *
  * \param listing Satellite listing
  **/
 void multitrack_sort_listing(multitrack_listing_t *listing);
@@ -258,20 +279,34 @@ void multitrack_resize(multitrack_listing_t *listing);
 
 /** Multitrack satellite listing function implementations. **/
 
-multitrack_entry_t *multitrack_create_entry(const char *name, predict_orbital_elements_t *orbital_elements)
+void multitrack_init_entry(multitrack_entry_t *entry)
 {
-	multitrack_entry_t *entry = (multitrack_entry_t*)malloc(sizeof(multitrack_entry_t));
-	entry->orbital_elements = orbital_elements;
-	entry->name = strdup(name);
 	entry->next_aos = 0;
 	entry->next_los = 0;
 	entry->above_horizon = 0;
-	entry->geostationary = 0;
+	entry->orbit_class = ORBIT_CLASS_LEO;
+	entry->aos_happens = true;
+	entry->can_predict = true;
 	entry->never_visible = 0;
 	entry->decayed = 0;
 	entry->max_elevation = 0;
 	entry->above_max_elevation_threshold = true;
-	return entry;
+}
+
+//minimum mean motion of low earth orbits, corresponding to an orbital period of 128 minutes (revolutions per day)
+#define LEO_MIN_MEAN_MOTION 11.25
+
+void multitrack_classify_entry(multitrack_entry_t *entry, const predict_orbital_elements_t *elements, const predict_observer_t *qth)
+{
+	if (predict_is_geosynchronous(elements)) {
+		entry->orbit_class = ORBIT_CLASS_GEO;
+	} else if (elements->mean_motion >= LEO_MIN_MEAN_MOTION) {
+		entry->orbit_class = ORBIT_CLASS_LEO;
+	} else {
+		entry->orbit_class = ORBIT_CLASS_MEO;
+	}
+	entry->aos_happens = predict_aos_happens(elements, qth->latitude);
+	entry->can_predict = entry->aos_happens && (entry->orbit_class != ORBIT_CLASS_GEO);
 }
 
 void multitrack_resize(multitrack_listing_t *listing)
@@ -314,9 +349,21 @@ multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, st
 	multitrack_resize(listing);
 
 	listing->num_entries = 0;
+	listing->time = 0;
+	listing->arena = NULL;
 	listing->entries = NULL;
+	listing->entry_details = NULL;
 	listing->tle_db_mapping = NULL;
 	listing->sorted_index = NULL;
+	listing->sort_keys = NULL;
+	listing->sort_keys_valid = false;
+	listing->batch = NULL;
+	listing->aoslos_changed = NULL;
+	listing->sort_key_changed = NULL;
+	listing->propagation_required = NULL;
+	listing->skipped_entries = NULL;
+	listing->worker_pool = worker_pool_create(0);
+	listing->pass_table = NULL;
 
 	listing->qth = observer;
 
@@ -346,7 +393,7 @@ void multitrack_search_listing(multitrack_listing_t *listing)
 		return;
 	}
 	for (int i=0; i < listing->num_entries; i++) {
-		if (strstr(listing->entries[listing->sorted_index[i]]->name, expression) != NULL) {
+		if (strstr(listing->entry_details[listing->sorted_index[i]].name, expression) != NULL) {
 			multitrack_search_field_add_match(listing->search_field, i);
 		}
 	}
@@ -363,34 +410,89 @@ void multitrack_listing_next_match(multitrack_listing_t *listing)
 	}
 }
 
-void multitrack_free_entry(multitrack_entry_t **entry)
-{
-	predict_destroy_orbital_elements((*entry)->orbital_elements);
-	free((*entry)->name);
-	free(*entry);
-	*entry = NULL;
-}
-
 void multitrack_free_entries(multitrack_listing_t *listing)
 {
-	if (listing->entries != NULL) {
-		for (int i=0; i < listing->num_entries; i++) {
-			multitrack_free_entry(&(listing->entries[i]));
-		}
-		free(listing->entries);
-		listing->entries = NULL;
-	}
-	if (listing->tle_db_mapping != NULL) {
-		free(listing->tle_db_mapping);
-		listing->tle_db_mapping = NULL;
+	for (int i=0; i < listing->num_entries; i++) {
+		tle_db_orbital_elements_release(&(listing->entry_details[i].orbital_elements));
 	}
-	if (listing->sorted_index != NULL) {
-		free(listing->sorted_index);
-		listing->sorted_index = NULL;
+	free(listing->arena);
+	listing->arena = NULL;
+	listing->entries = NULL;
+	listing->entry_details = NULL;
+	listing->tle_db_mapping = NULL;
+	listing->sorted_index = NULL;
+	listing->sort_keys = NULL;
+	listing->sort_keys_valid = false;
+	listing->aoslos_changed = NULL;
+	listing->sort_key_changed = NULL;
+	listing->propagation_required = NULL;
+	listing->skipped_entries = NULL;
+	if (listing->batch != NULL) {
+		batch_propagation_destroy(&(listing->batch));
 	}
 	listing->num_entries = 0;
 }
 
+//alignment of the arrays in the arena of the listing, so that each array starts on a cache line (bytes)
+#define MULTITRACK_ARENA_ALIGNMENT 64
+
+/**
+ * Reserve space for an array in the arena of the listing, aligned to MULTITRACK_ARENA_ALIGNMENT.
+ *
+ * \param arena_size Size of the arena, updated with the reserved space
+ * \param size Size of the array
+ * \return Offset of the array within the arena
+ **/
+static size_t multitrack_arena_reserve(size_t *arena_size, size_t size)
+{
+	size_t offset = ((*arena_size + MULTITRACK_ARENA_ALIGNMENT - 1)/MULTITRACK_ARENA_ALIGNMENT)*MULTITRACK_ARENA_ALIGNMENT;
+	*arena_size = offset + size;
+	return offset;
+}
+
+/**
+ * Allocate the arena of the listing, containing the entries, their details and names, and all arrays with one element
+ * per entry. The hot entry data used in every update and sort is kept in its own contiguous array, apart from the data
+ * only needed for display.
+ *
+ * \param listing Satellite listing
+ * \param num_entries Number of entries
+ * \param names_size Total size of the satellite names, including terminating null characters
+ * \return Start of the space reserved for the satellite names, or NULL on allocation failure
+ **/
+static char *multitrack_allocate_arena(multitrack_listing_t *listing, int num_entries, size_t names_size)
+{
+	size_t arena_size = 0;
+	size_t entries_offset = multitrack_arena_reserve(&arena_size, sizeof(multitrack_entry_t)*num_entries);
+	size_t sort_keys_offset = multitrack_arena_reserve(&arena_size, sizeof(struct multitrack_sort_key)*num_entries);
+	size_t sorted_index_offset = multitrack_arena_reserve(&arena_size, sizeof(int)*num_entries);
+	size_t aoslos_changed_offset = multitrack_arena_reserve(&arena_size, sizeof(bool)*num_entries);
+	size_t sort_key_changed_offset = multitrack_arena_reserve(&arena_size, sizeof(bool)*num_entries);
+	size_t propagation_required_offset = multitrack_arena_reserve(&arena_size, sizeof(bool)*num_entries);
+	size_t tle_db_mapping_offset = multitrack_arena_reserve(&arena_size, sizeof(int)*num_entries);
+	size_t skipped_entries_offset = multitrack_arena_reserve(&arena_size, sizeof(int)*num_entries);
+	size_t entry_details_offset = multitrack_arena_reserve(&arena_size, sizeof(struct multitrack_entry_details)*num_entries);
+	size_t names_offset = multitrack_arena_reserve(&arena_size, names_size);
+
+	if (posix_memalign(&(listing->arena), MULTITRACK_ARENA_ALIGNMENT, arena_size) != 0) {
+		listing->arena = NULL;
+		return NULL;
+	}
+	char *arena = (char*)listing->arena;
+	memset(arena, 0, arena_size);
+
+	listing->entries = (multitrack_entry_t*)(arena + entries_offset);
+	listing->sort_keys = (struct multitrack_sort_key*)(arena + sort_keys_offset);
+	listing->sorted_index = (int*)(arena + sorted_index_offset);
+	listing->aoslos_changed = (bool*)(arena + aoslos_changed_offset);
+	listing->sort_key_changed = (bool*)(arena + sort_key_changed_offset);
+	listing->propagation_required = (bool*)(arena + propagation_required_offset);
+	listing->tle_db_mapping = (int*)(arena + tle_db_mapping_offset);
+	listing->skipped_entries = (int*)(arena + skipped_entries_offset);
+	listing->entry_details = (struct multitrack_entry_details*)(arena + entry_details_offset);
+	return arena + names_offset;
+}
+
 void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_db)
 {
 	werase(listing->window);
@@ -398,24 +500,36 @@ void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_d
 	multitrack_free_entries(listing);
 
 	int num_enabled_tles = 0;
+	size_t names_size = 0;
 	for (int i=0; i < tle_db->num_tles; i++) {
 		if (tle_db_entry_enabled(tle_db, i)) {
 			num_enabled_tles++;
+			names_size += strlen(tle_db_entry_name(tle_db, i)) + 1;
 		}
 	}
 
-	listing->num_entries = num_enabled_tles;
+	char *names = NULL;
+	if (num_enabled_tles > 0) {
+		names = multitrack_allocate_arena(listing, num_enabled_tles, names_size);
+	}
 
-	if (listing->num_entries > 0) {
-		listing->entries = (multitrack_entry_t**)malloc(sizeof(multitrack_entry_t*)*num_enabled_tles);
-		listing->tle_db_mapping = (int*)calloc(num_enabled_tles, sizeof(int));
-		listing->sorted_index = (int*)calloc(tle_db->num_tles, sizeof(int));
+	if (names != NULL) {
+		listing->num_entries = num_enabled_tles;
+		listing->batch = batch_propagation_create(num_enabled_tles);
 
 		int j=0;
 		for (int i=0; i < tle_db->num_tles; i++) {
 			if (tle_db_entry_enabled(tle_db, i)) {
-				predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, i);
-				listing->entries[j] = multitrack_create_entry(tle_db_entry_name(tle_db, i), orbital_elements);
+				struct multitrack_entry_details *details = &(listing->entry_details[j]);
+				size_t name_length = strlen(tle_db_entry_name(tle_db, i)) + 1;
+				memcpy(names, tle_db_entry_name(tle_db, i), name_length);
+				details->name = names;
+				names += name_length;
+				details->orbital_elements = tle_db_entry_get_orbital_elements(tle_db, i);
+
+				multitrack_init_entry(&(listing->entries[j]));
+				multitrack_classify_entry(&(listing->entries[j]), details->orbital_elements->elements, listing->qth);
+				batch_propagation_set_satellite(listing->batch, j, details->orbital_elements->elements);
 				listing->tle_db_mapping[j] = i;
 				listing->sorted_index[j] = j;
 				j++;
@@ -433,6 +547,24 @@ void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_d
 	multitrack_resize(listing);
 }
 
+void multitrack_update_orbital_elements(multitrack_listing_t *listing, struct tle_db *tle_db, const bool *updated_tles)
+{
+	for (int i=0; i < listing->num_entries; i++) {
+		int tle_index = listing->tle_db_mapping[i];
+		if ((tle_index < tle_db->num_tles) && updated_tles[tle_index]) {
+			multitrack_entry_t *entry = &(listing->entries[i]);
+			struct multitrack_entry_details *details = &(listing->entry_details[i]);
+			tle_db_orbital_elements_release(&(details->orbital_elements));
+			details->orbital_elements = tle_db_entry_get_orbital_elements(tle_db, tle_index);
+			multitrack_classify_entry(entry, details->orbital_elements->elements, listing->qth);
+			batch_propagation_set_satellite(listing->batch, i, details->orbital_elements->elements);
+			entry->next_aos = 0;
+			entry->next_los = 0;
+			listing->should_sort = true;
+		}
+	}
+}
+
 NCURSES_ATTR_T multitrack_colors(double range, double elevation)
 {
 	if (range < 8000)
@@ -463,164 +595,455 @@ NCURSES_ATTR_T multitrack_colors(double range, double elevation)
 #define SATELLITE_FAR_COLOR COLOR_PAIR(4)
 #define SATELLITE_IGNORED_COLOR COLOR_PAIR(3)
 
-bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, predict_julian_date_t time)
+bool multitrack_update_entry(double max_elevation_threshold, predict_observer_t *qth, multitrack_entry_t *entry, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, const struct predict_position *orbit, const struct predict_observation *obs, const struct pass_events *pass)
 {
-	entry->geostationary = false;
+	bool geostationary = (entry->orbit_class == ORBIT_CLASS_GEO);
+	bool can_predict = entry->can_predict && !(orbit->decayed);
 
-	struct predict_observation obs;
-	struct predict_position orbit;
-	predict_orbit(entry->orbital_elements, &orbit, time);
-	predict_observe_orbit(qth, &orbit, &obs);
+	entry->above_max_elevation_threshold = (entry->max_elevation > max_elevation_threshold);
 
-	//sun status
-	char sunstat;
-	if (!orbit.eclipsed) {
-		if (obs.visible) {
-			sunstat='V';
+	//predict next aos/los and maximum elevation
+	bool calculate_next_los = can_predict && (time > entry->next_los) && (obs->elevation > 0);
+	bool calculate_next_aos = can_predict && (time > entry->next_aos) && (obs->elevation < 0);
+
+	//use precomputed pass when it agrees with the current state of the satellite
+	bool use_pass = (pass != NULL) && ((calculate_next_los && (pass->aos <= time)) || (calculate_next_aos && (pass->aos > time)));
+	if (use_pass) {
+		if (calculate_next_los) {
+			entry->next_los = pass->los;
 		} else {
-			sunstat='D';
+			entry->next_aos = pass->aos;
 		}
+		entry->max_elevation = pass->max_elevation*180.0/M_PI;
+	}
+
+	if (calculate_next_los && !use_pass) {
+		entry->next_los= predict_next_los(qth, orbital_elements, time).time;
+	}
+
+	if ((calculate_next_aos || calculate_next_los) && !use_pass) {
+		struct predict_observation max_elevation_obs = predict_at_max_elevation(qth, orbital_elements, time);
+		entry->max_elevation = max_elevation_obs.elevation*180.0/M_PI;
+	}
+
+	if (calculate_next_aos && !use_pass) {
+		entry->next_aos = predict_next_aos(qth, orbital_elements, time).time;
+	}
+
+	//use current elevation as max elevation if satellite is above horizon and geostationary
+	if (geostationary && obs->elevation > 0) {
+	       entry->max_elevation = obs->elevation*180.0/M_PI;
+	}
+
+	entry->above_horizon = obs->elevation > 0;
+	entry->decayed = orbit->decayed;
+
+	entry->never_visible = !entry->aos_happens || (geostationary && (obs->elevation <= 0.0));
+	return calculate_next_aos || calculate_next_los;
+}
+
+/**
+ * Formats of the AOS/LOS field in the satellite listing.
+ **/
+enum multitrack_aoslos_format {
+	///Empty
+	AOSLOS_FORMAT_NONE,
+	///Geostationary satellite above the horizon
+	AOSLOS_FORMAT_GEOSTATIONARY,
+	///Satellite that never rises
+	AOSLOS_FORMAT_NO_AOS,
+	///Number of days until AOS/LOS
+	AOSLOS_FORMAT_DAYS,
+	///Number of whole hours until LOS
+	AOSLOS_FORMAT_HOURS,
+	///Minutes and seconds until AOS/LOS, value in seconds
+	AOSLOS_FORMAT_COUNTDOWN,
+	///UTC time of AOS, value in minutes since the unix epoch
+	AOSLOS_FORMAT_CLOCK
+};
+
+//time before AOS at which the countdown is shown instead of the time of AOS (days)
+#define SATELLITE_CLOSE_TIME 0.00694
+
+//length of the AOS/LOS field and of the pass information field (max elevation and AOS/LOS) in the satellite listing
+#define MULTITRACK_AOSLOS_LENGTH 32
+#define MULTITRACK_PASS_INFO_LENGTH 48
+
+/**
+ * Get the seconds within the hour of a time difference converted using predict_from_julian(), as shown by "%M:%S".
+ *
+ * \param difference Time difference
+ * \return Seconds within the hour
+ **/
+static long multitrack_seconds_within_hour(predict_julian_date_t difference)
+{
+	long seconds = predict_from_julian(difference) % 3600;
+	return (seconds < 0) ? seconds + 3600 : seconds;
+}
+
+/**
+ * Get the values shown for an entry in the satellite listing, rounded to the displayed precision.
+ *
+ * \param entry Multitrack entry
+ * \param time Time of the last update
+ * \param orbit Satellite position at the time of the last update
+ * \param obs Observation of the satellite at the time of the last update
+ * \param ret_values Returned display values
+ **/
+static void multitrack_entry_display_values(const multitrack_entry_t *entry, predict_julian_date_t time, const struct predict_position *orbit, const struct predict_observation *obs, struct multitrack_display_values *ret_values)
+{
+	struct multitrack_display_values values = {0};
+	bool geostationary = (entry->orbit_class == ORBIT_CLASS_GEO);
+	bool can_predict = entry->can_predict && !(entry->decayed);
+
+	//sun status
+	if (!orbit->eclipsed) {
+		values.sun_status = obs->visible ? 'V' : 'D';
 	} else {
-		sunstat='N';
+		values.sun_status = 'N';
 	}
 
 	//satellite approaching status
-	char rangestat;
-	if (fabs(obs.range_rate) < 0.1) {
-		rangestat = '=';
-	} else if (obs.range_rate < 0.0) {
-		rangestat = '/';
-	} else if (obs.range_rate > 0.0) {
-		rangestat = '\\';
+	if (obs->range_rate < -0.1) {
+		values.range_status = '/';
+	} else if (obs->range_rate > 0.1) {
+		values.range_status = '\\';
+	} else {
+		values.range_status = '=';
 	}
 
-	//set text formatting attributes according to satellite state, set AOS/LOS string
-	bool can_predict = !predict_is_geosynchronous(entry->orbital_elements) && predict_aos_happens(entry->orbital_elements, qth->latitude) && !(orbit.decayed);
-	char pass_info[MAX_NUM_CHARS] = {0};
-	char aos_los[MAX_NUM_CHARS] = {0};
-
-	if (obs.elevation >= 0) {
+	//set text formatting attributes according to satellite state, set AOS/LOS field
+	values.attributes = SATELLITE_IGNORED_COLOR;
+	if (obs->elevation >= 0) {
 		//different colours according to range and elevation
-		entry->display_attributes = multitrack_colors(obs.range, obs.elevation*180/M_PI);
+		values.attributes = multitrack_colors(obs->range, obs->elevation*180/M_PI);
 
-		if (predict_is_geosynchronous(entry->orbital_elements)){
-			sprintf(aos_los, "*GeoS*");
-			entry->geostationary = true;
+		if (geostationary) {
+			values.aoslos_format = AOSLOS_FORMAT_GEOSTATIONARY;
+		} else if ((entry->next_los - time) > 1.0) {
+			values.aoslos_format = AOSLOS_FORMAT_DAYS;
+			values.aoslos_value = (int)(entry->next_los - time);
 		} else {
-			time_t epoch = predict_from_julian(entry->next_los - time);
-			struct tm timeval;
-			gmtime_r(&epoch, &timeval);
-			if ((entry->next_los - time) > 1.0) {
-				int num_days = (entry->next_los - time);
-				snprintf(aos_los, MAX_NUM_CHARS, ">%2.dd", num_days);
-			} else if (timeval.tm_hour > 0) {
-				strftime(aos_los, MAX_NUM_CHARS, ">%kh", &timeval);
+			long seconds = predict_from_julian(entry->next_los - time) % 86400;
+			seconds = (seconds < 0) ? seconds + 86400 : seconds;
+			if (seconds >= 3600) {
+				values.aoslos_format = AOSLOS_FORMAT_HOURS;
+				values.aoslos_value = seconds/3600;
 			} else {
-				strftime(aos_los, MAX_NUM_CHARS, "%M:%S", &timeval);
+				values.aoslos_format = AOSLOS_FORMAT_COUNTDOWN;
+				values.aoslos_value = seconds;
 			}
-
 		}
-	} else if ((obs.elevation < 0) && can_predict) {
-		if ((entry->next_aos-time) < 0.00694) {
-			//satellite is close, set bold
-			entry->display_attributes = SATELLITE_CLOSE_COLOR;
-			time_t epoch = predict_from_julian(entry->next_aos - time);
-			strftime(aos_los, MAX_NUM_CHARS, "%M:%S", gmtime(&epoch)); //minutes and seconds left until AOS
+	} else if ((obs->elevation < 0) && can_predict) {
+		if ((entry->next_aos - time) < SATELLITE_CLOSE_TIME) {
+			//satellite is close, set bold and show minutes and seconds left until AOS
+			values.attributes = SATELLITE_CLOSE_COLOR;
+			values.aoslos_format = AOSLOS_FORMAT_COUNTDOWN;
+			values.aoslos_value = multitrack_seconds_within_hour(entry->next_aos - time);
 		} else {
 			//satellite is far, set normal coloring
-			entry->display_attributes = SATELLITE_FAR_COLOR;
-			time_t aoslos_epoch = predict_from_julian(entry->next_aos);
-			time_t curr_epoch = predict_from_julian(time);
-			struct tm aostime, currtime;
-			gmtime_r(&aoslos_epoch, &aostime);
-			gmtime_r(&curr_epoch, &currtime);
-			char temp[MAX_NUM_CHARS];
-			strftime(temp, MAX_NUM_CHARS, "%H:%MZ", &aostime);
+			values.attributes = SATELLITE_FAR_COLOR;
 			int num_days = entry->next_aos - time;
 			if (num_days == 0) {
-				strncpy(aos_los, temp, MAX_NUM_CHARS);
+				values.aoslos_format = AOSLOS_FORMAT_CLOCK;
+				values.aoslos_value = predict_from_julian(entry->next_aos)/60;
 			} else {
-				snprintf(aos_los, MAX_NUM_CHARS, ">%2.dd", num_days);
+				values.aoslos_format = AOSLOS_FORMAT_DAYS;
+				values.aoslos_value = num_days;
 			}
 		}
 	} else if (!can_predict) {
-		entry->display_attributes = SATELLITE_IGNORED_COLOR;
-		sprintf(aos_los, "*GeoS-NoAOS*");
+		values.aoslos_format = AOSLOS_FORMAT_NO_AOS;
 	}
 
-	entry->above_max_elevation_threshold = (entry->max_elevation > max_elevation_threshold);
 	if (!entry->above_max_elevation_threshold) {
-		entry->display_attributes = SATELLITE_IGNORED_COLOR;
+		values.attributes = SATELLITE_IGNORED_COLOR;
 	}
 
-	char abs_pos_string[MAX_NUM_CHARS] = {0};
-	sprintf(abs_pos_string, "%3.0f  %3.0f", orbit.latitude*180.0/M_PI, orbit.longitude*180.0/M_PI);
+	values.azimuth = lround(obs->azimuth*180.0/M_PI*10.0);
+	values.elevation = lround(obs->elevation*180.0/M_PI*10.0);
+	values.latitude = lround(orbit->latitude*180.0/M_PI);
+	values.longitude = lround(orbit->longitude*180.0/M_PI);
+	values.altitude = lround(orbit->altitude);
+	values.range = lround(obs->range);
+	values.max_elevation = entry->max_elevation;
 
-	//predict next aos/los and maximum elevation
-	bool calculate_next_los = can_predict && (time > entry->next_los) && (obs.elevation > 0);
-	bool calculate_next_aos = can_predict && (time > entry->next_aos) && (obs.elevation < 0);
-	if (calculate_next_los) {
-		entry->next_los= predict_next_los(qth, entry->orbital_elements, time).time;
+	//overwrite everything if orbit was decayed
+	if (entry->decayed) {
+		memset(&values, 0, sizeof(values));
+		values.attributes = COLOR_PAIR(2);
+		values.decayed = true;
 	}
+	*ret_values = values;
+}
 
-	if (calculate_next_aos || calculate_next_los) {
-		struct predict_observation max_elevation_obs = predict_at_max_elevation(qth, entry->orbital_elements, time);
-		entry->max_elevation = max_elevation_obs.elevation*180.0/M_PI;
-	}
+/**
+ * Check whether two sets of display values are equal.
+ *
+ * \param a Display values
+ * \param b Display values
+ * \return True if all values are equal, false otherwise
+ **/
+static bool multitrack_display_values_equal(const struct multitrack_display_values *a, const struct multitrack_display_values *b)
+{
+	return (a->attributes == b->attributes) && (a->azimuth == b->azimuth) && (a->elevation == b->elevation) &&
+		(a->latitude == b->latitude) && (a->longitude == b->longitude) && (a->altitude == b->altitude) &&
+		(a->range == b->range) && (a->sun_status == b->sun_status) && (a->range_status == b->range_status) &&
+		(a->max_elevation == b->max_elevation) && (a->aoslos_format == b->aoslos_format) &&
+		(a->aoslos_value == b->aoslos_value) && (a->decayed == b->decayed);
+}
+
+/**
+ * Format the display string of an entry in the satellite listing, when the displayed values have changed since it was
+ * last formatted. The position of the satellite is taken from the last propagation of the listing.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Index of entry
+ **/
+static void multitrack_format_entry(multitrack_listing_t *listing, int entry_index)
+{
+	multitrack_entry_t *entry = &(listing->entries[entry_index]);
+	struct multitrack_entry_details *details = &(listing->entry_details[entry_index]);
 
-	if (calculate_next_aos) {
-		entry->next_aos = predict_next_aos(qth, entry->orbital_elements, time).time;
+	struct predict_position orbit;
+	struct predict_observation obs;
+	batch_propagation_get_result(listing->batch, entry_index, &orbit, &obs);
+
+	struct multitrack_display_values values;
+	multitrack_entry_display_values(entry, listing->time, &orbit, &obs, &values);
+	if (details->display_string_valid && multitrack_display_values_equal(&values, &(details->display_values))) {
+		return;
 	}
+	details->display_values = values;
+	details->display_string_valid = true;
 
-	//use current elevation as max elevation if satellite is above horizon and geostationary
-	if (entry->geostationary && obs.elevation > 0) {
-	       entry->max_elevation = obs.elevation*180.0/M_PI;
+	if (values.decayed) {
+		snprintf(details->display_string, MULTITRACK_DISPLAY_STRING_LENGTH, " %-10.8s ----------------     Decayed       --------------- ", details->name);
+		return;
 	}
 
-	char max_ele_str[MAX_NUM_CHARS] = {0};
-	snprintf(max_ele_str, MAX_NUM_CHARS, "%d", (int)(entry->max_elevation));
+	char aos_los[MULTITRACK_AOSLOS_LENGTH] = {0};
+	switch (values.aoslos_format) {
+		case AOSLOS_FORMAT_GEOSTATIONARY:
+			snprintf(aos_los, MULTITRACK_AOSLOS_LENGTH, "*GeoS*");
+			break;
+		case AOSLOS_FORMAT_NO_AOS:
+			snprintf(aos_los, MULTITRACK_AOSLOS_LENGTH, "*GeoS-NoAOS*");
+			break;
+		case AOSLOS_FORMAT_DAYS:
+			snprintf(aos_los, MULTITRACK_AOSLOS_LENGTH, ">%2.ldd", values.aoslos_value);
+			break;
+		case AOSLOS_FORMAT_HOURS:
+			snprintf(aos_los, MULTITRACK_AOSLOS_LENGTH, ">%2ldh", values.aoslos_value);
+			break;
+		case AOSLOS_FORMAT_COUNTDOWN:
+			snprintf(aos_los, MULTITRACK_AOSLOS_LENGTH, "%02ld:%02ld", values.aoslos_value/60, values.aoslos_value%60);
+			break;
+		case AOSLOS_FORMAT_CLOCK: {
+			time_t aos_epoch = values.aoslos_value*60;
+			struct tm aostime;
+			gmtime_r(&aos_epoch, &aostime);
+			strftime(aos_los, MULTITRACK_AOSLOS_LENGTH, "%H:%MZ", &aostime);
+			break;
+		}
+	}
 
-	if (can_predict) {
-		snprintf(pass_info, MAX_NUM_CHARS, "%s %6s", max_ele_str, aos_los);
+	char pass_info[MULTITRACK_PASS_INFO_LENGTH] = {0};
+	if (entry->can_predict) {
+		snprintf(pass_info, MULTITRACK_PASS_INFO_LENGTH, "%d %6s", values.max_elevation, aos_los);
 	} else {
-		snprintf(pass_info, MAX_NUM_CHARS, "%s", aos_los);
+		snprintf(pass_info, MULTITRACK_PASS_INFO_LENGTH, "%s", aos_los);
 	}
 
-	//altitude and range in km/miles
-	double disp_altitude = orbit.altitude;
-	double disp_range = obs.range;
+	snprintf(details->display_string, MULTITRACK_DISPLAY_STRING_LENGTH, " %-10.8s%5.1f  %5.1f %3d  %3d%6d %6d %c %c %12s ", details->name, values.azimuth/10.0, values.elevation/10.0, values.latitude, values.longitude, values.altitude, values.range, values.sun_status, values.range_status, pass_info);
+}
 
-	//set string to display
-	char disp_string[MAX_NUM_CHARS];
-	sprintf(disp_string, " %-10.8s%5.1f  %5.1f %8s%6.0f %6.0f %c %c %12s ", entry->name, obs.azimuth*180.0/M_PI, obs.elevation*180.0/M_PI, abs_pos_string, disp_altitude, disp_range, sunstat, rangestat, pass_info);
+/**
+ * Categories of the multitrack listing, in display order.
+ **/
+enum multitrack_category {
+	///Above the horizon
+	CATEGORY_ABOVE_HORIZON,
+	///Below the horizon, but will rise
+	CATEGORY_WILL_RISE,
+	///Passes below the max elevation threshold
+	CATEGORY_BELOW_THRESHOLD,
+	///Never rises above the horizon
+	CATEGORY_NEVER_VISIBLE,
+	///Decayed
+	CATEGORY_DECAYED,
+	///Number of categories
+	NUM_CATEGORIES
+};
 
-	//overwrite everything if orbit was decayed
-	if (orbit.decayed) {
-		entry->display_attributes = COLOR_PAIR(2);
-		sprintf(disp_string, " %-10.8s ----------------     Decayed       --------------- ", entry->name);
+//sorted index is merged in a single pass instead of moving entries one by one when more than 1/N of the entries changed
+#define MULTITRACK_INCREMENTAL_SORT_FRACTION 16
+
+/**
+ * Get category of a satellite entry in the multitrack listing.
+ *
+ * \param entry Multitrack entry
+ * \return Category
+ **/
+static enum multitrack_category multitrack_entry_category(const multitrack_entry_t *entry)
+{
+	if (entry->decayed) {
+		return CATEGORY_DECAYED;
+	} else if (entry->above_horizon && entry->above_max_elevation_threshold) {
+		return CATEGORY_ABOVE_HORIZON;
+	} else if (!entry->never_visible && entry->above_max_elevation_threshold) {
+		return CATEGORY_WILL_RISE;
+	} else if (!entry->never_visible) {
+		return CATEGORY_BELOW_THRESHOLD;
 	}
+	return CATEGORY_NEVER_VISIBLE;
+}
 
-	memcpy(entry->display_string, disp_string, sizeof(char)*MAX_NUM_CHARS);
+/**
+ * Get sort key of a satellite entry. Satellites above the horizon and below the max elevation threshold are sorted by
+ * descending max elevation, satellites that will rise by ascending AOS, or together with the satellites above the horizon
+ * when sorting by max elevation. The remaining satellites are kept in entry order.
+ *
+ * \param entry Multitrack entry
+ * \param sort_option Sorting option defined in enum sort_options
+ * \param ret_key Returned sort key
+ **/
+static void multitrack_entry_sort_key(const multitrack_entry_t *entry, int sort_option, struct multitrack_sort_key *ret_key)
+{
+	enum multitrack_category category = multitrack_entry_category(entry);
+	ret_key->category = category;
+	ret_key->group = category;
+	ret_key->value = 0;
+	if ((category == CATEGORY_WILL_RISE) && (sort_option == SORT_BY_MAX_ELEVATION)) {
+		ret_key->group = CATEGORY_ABOVE_HORIZON;
+	}
 
-	entry->above_horizon = obs.elevation > 0;
-	entry->decayed = orbit.decayed;
+	if ((ret_key->group == CATEGORY_ABOVE_HORIZON) || (ret_key->group == CATEGORY_BELOW_THRESHOLD)) {
+		ret_key->value = -entry->max_elevation;
+	} else if (ret_key->group == CATEGORY_WILL_RISE) {
+		ret_key->value = entry->next_aos;
+	}
 
-	entry->never_visible = !predict_aos_happens(entry->orbital_elements, qth->latitude) || (predict_is_geosynchronous(entry->orbital_elements) && (obs.elevation <= 0.0));
-	return calculate_next_aos || calculate_next_los;
+	//keep the order total
+	if (isnan(ret_key->value)) {
+		ret_key->value = 0;
+	}
+}
+
+/**
+ * Check whether the sort key of an entry differs from its sort key at the last sort.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Entry index
+ * \return True if the entry has to be moved in the sorted index, false otherwise
+ **/
+static bool multitrack_sort_key_changed(const multitrack_listing_t *listing, int entry_index)
+{
+	if (!listing->sort_keys_valid) {
+		return true;
+	}
+	struct multitrack_sort_key key;
+	multitrack_entry_sort_key(&(listing->entries[entry_index]), listing->sort_option, &key);
+	const struct multitrack_sort_key *sorted_key = &(listing->sort_keys[entry_index]);
+	return (key.category != sorted_key->category) || (key.group != sorted_key->group) || (key.value != sorted_key->value);
+}
+
+//number of entries between each progress update when entries are prepared for the first time
+#define MULTITRACK_PROGRESS_INTERVAL 256
+
+/**
+ * Shared state of the entry update tasks run in multitrack_update_listing_data().
+ **/
+struct multitrack_update_task {
+	///Multitrack listing
+	multitrack_listing_t *listing;
+	///Time at which entries should be updated
+	predict_julian_date_t time;
+	///Index of the entry corresponding to task index 0
+	int first_entry;
+	///Indices of the entries corresponding to each task index, used instead of first_entry when not NULL
+	const int *entry_indices;
+};
+
+/**
+ * Update a single entry in the listing. Run in parallel by the worker pool, and should only touch its own entry.
+ *
+ * \param data Task state, struct multitrack_update_task
+ * \param index Task index
+ **/
+static void multitrack_update_entry_task(void *data, int index)
+{
+	struct multitrack_update_task *task = (struct multitrack_update_task*)data;
+	multitrack_listing_t *listing = task->listing;
+	int entry_index = (task->entry_indices != NULL) ? task->entry_indices[index] : task->first_entry + index;
+
+	struct predict_position orbit;
+	struct predict_observation obs;
+	batch_propagation_get_result(listing->batch, entry_index, &orbit, &obs);
+
+	struct pass_events pass;
+	bool has_pass = (listing->pass_table != NULL) && (pass_table_next_pass(listing->pass_table, listing->tle_db_mapping[entry_index], task->time, &pass) == PASS_TABLE_PASS_FOUND);
+	listing->aoslos_changed[entry_index] = multitrack_update_entry(listing->max_elevation_threshold, listing->qth, &(listing->entries[entry_index]), listing->entry_details[entry_index].orbital_elements->elements, task->time, &orbit, &obs, has_pass ? &pass : NULL);
+	listing->sort_key_changed[entry_index] = multitrack_sort_key_changed(listing, entry_index);
+}
+
+/**
+ * Mark the entries shown on screen as required in the next propagation, since their positions are displayed even
+ * when they are below the horizon.
+ *
+ * \param listing Multitrack listing
+ * \param ret_skipped_indices Returned indices of the entries shown on screen that were skipped in the last propagation, at most num_entries long. Can be NULL
+ * \return Number of entries shown on screen that were skipped in the last propagation
+ **/
+static int multitrack_mark_displayed_entries(multitrack_listing_t *listing, int *ret_skipped_indices)
+{
+	memset(listing->propagation_required, 0, sizeof(bool)*listing->num_entries);
+	int num_skipped = 0;
+	for (int i=listing->top_index; ((i <= listing->bottom_index) && (i < listing->num_entries)); i++) {
+		int entry_index = listing->sorted_index[i];
+		listing->propagation_required[entry_index] = true;
+		if (!listing->batch->propagated[entry_index]) {
+			if (ret_skipped_indices != NULL) {
+				ret_skipped_indices[num_skipped] = entry_index;
+			}
+			num_skipped++;
+		}
+	}
+	return num_skipped;
 }
 
 void multitrack_update_listing_data(multitrack_listing_t *listing, predict_julian_date_t time)
 {
-	for (int i=0; i < listing->num_entries; i++) {
-		if (listing->not_displayed) {
-			//display progress information when this is the first time entries are displayed
+	listing->time = time;
+
+	//propagate all satellites that can be above the horizon, and the satellites shown on screen
+	if (listing->num_entries > 0) {
+		multitrack_mark_displayed_entries(listing, NULL);
+		batch_propagation_run_prefiltered(listing->batch, listing->qth, time, listing->propagation_required);
+	}
+
+	//update entries in parallel
+	struct multitrack_update_task task = {.listing = listing, .time = time, .first_entry = 0, .entry_indices = NULL};
+	if (listing->not_displayed) {
+		//display progress information when this is the first time entries are displayed
+		for (task.first_entry = 0; task.first_entry < listing->num_entries; task.first_entry += MULTITRACK_PROGRESS_INTERVAL) {
 			wattrset(listing->window, COLOR_PAIR(1));
-			mvwprintw(listing->window, 0, 1, "Preparing entry %d of %d\n", i, listing->num_entries);
+			mvwprintw(listing->window, 0, 1, "Preparing entry %d of %d\n", task.first_entry, listing->num_entries);
 			wrefresh(listing->window);
+
+			int num_tasks = listing->num_entries - task.first_entry;
+			if (num_tasks > MULTITRACK_PROGRESS_INTERVAL) {
+				num_tasks = MULTITRACK_PROGRESS_INTERVAL;
+			}
+			worker_pool_run(listing->worker_pool, num_tasks, multitrack_update_entry_task, &task);
 		}
-		multitrack_entry_t *entry = listing->entries[i];
-		bool aoslos_changed = multitrack_update_entry(listing->max_elevation_threshold, listing->qth, entry, time);
-		if (aoslos_changed) {
+	} else {
+		worker_pool_run(listing->worker_pool, listing->num_entries, multitrack_update_entry_task, &task);
+	}
+
+	//merge results in entry order
+	for (int i=0; i < listing->num_entries; i++) {
+		if (listing->aoslos_changed[i] || listing->sort_key_changed[i]) {
 			listing->should_sort = true;
 		}
 	}
@@ -628,158 +1051,471 @@ void multitrack_update_listing_data(multitrack_listing_t *listing, predict_julia
 	if (!listing->not_displayed && !multitrack_option_selector_visible(listing->option_selector) && !multitrack_search_field_visible(listing->search_field) && listing->should_sort) {
 		multitrack_sort_listing(listing); //freeze sorting when option selector is hovering over a satellite
 		listing->should_sort = false;
+
+		//satellites sorted onto the screen may have been skipped in the propagation, and would show outdated positions
+		int num_skipped = multitrack_mark_displayed_entries(listing, listing->skipped_entries);
+		if (num_skipped > 0) {
+			batch_propagation_run_selected(listing->batch, listing->qth, listing->skipped_entries, num_skipped);
+			task.entry_indices = listing->skipped_entries;
+			worker_pool_run(listing->worker_pool, num_skipped, multitrack_update_entry_task, &task);
+		}
 	}
 
 	listing->not_displayed = false;
 }
 
 /**
- * Used for sorting according to sort_value using qsort, but retain access to original index.
+ * Update time of the next event with the next AOS or LOS of an entry.
+ *
+ * \param entry Multitrack entry
+ * \param time Current time
+ * \param next_event Earliest event so far, or 0 if there is none. Updated when the event of the entry is earlier
+ * \return True if the entry has an event after the current time, false otherwise
+ **/
+static bool multitrack_entry_next_event(const multitrack_entry_t *entry, predict_julian_date_t time, predict_julian_date_t *next_event)
+{
+	if (!entry->can_predict || entry->decayed) {
+		return false;
+	}
+
+	predict_julian_date_t event = entry->above_horizon ? entry->next_los : entry->next_aos;
+	if (event <= time) {
+		return false;
+	}
+	if ((*next_event == 0) || (event < *next_event)) {
+		*next_event = event;
+	}
+	return true;
+}
+
+predict_julian_date_t multitrack_next_event(multitrack_listing_t *listing, predict_julian_date_t time)
+{
+	predict_julian_date_t next_event = 0;
+
+	//sorting is frozen or pending, and the categories in the sorted index can be outdated
+	if (!listing->sort_keys_valid || listing->should_sort) {
+		for (int i=0; i < listing->num_entries; i++) {
+			multitrack_entry_next_event(&(listing->entries[i]), time, &next_event);
+		}
+		return next_event;
+	}
+
+	//satellites that will rise are sorted by AOS after the satellites above the horizon, so that only the first with
+	//an AOS after the current time is needed. Satellites that never rise or have decayed have no events
+	int will_rise_start = listing->num_above_horizon;
+	int will_rise_end = will_rise_start + listing->num_below_horizon;
+	int below_threshold_end = will_rise_end + listing->num_below_threshold;
+	if (listing->sort_option != SORT_BY_AOS) {
+		will_rise_start = will_rise_end;
+	}
+	for (int i=0; i < will_rise_start; i++) {
+		multitrack_entry_next_event(&(listing->entries[listing->sorted_index[i]]), time, &next_event);
+	}
+	for (int i=will_rise_start; i < will_rise_end; i++) {
+		if (multitrack_entry_next_event(&(listing->entries[listing->sorted_index[i]]), time, &next_event)) {
+			break;
+		}
+	}
+	for (int i=will_rise_end; i < below_threshold_end; i++) {
+		multitrack_entry_next_event(&(listing->entries[listing->sorted_index[i]]), time, &next_event);
+	}
+
+	//entries shown on screen can have been updated after the sort
+	for (int i=listing->top_index; ((i <= listing->bottom_index) && (i < listing->num_entries)); i++) {
+		multitrack_entry_next_event(&(listing->entries[listing->sorted_index[i]]), time, &next_event);
+	}
+	return next_event;
+}
+
+/**
+ * Compare two entries by sort key, using the entry index as tie-breaker so that the order is total and stable.
+ *
+ * \param key_a Sort key of first entry
+ * \param index_a Index of first entry
+ * \param key_b Sort key of second entry
+ * \param index_b Index of second entry
+ * \return Negative if the first entry goes before the second, positive if after, 0 if the entries are the same
+ **/
+static int multitrack_compare_sort_keys(const struct multitrack_sort_key *key_a, int index_a, const struct multitrack_sort_key *key_b, int index_b)
+{
+	if (key_a->group != key_b->group) {
+		return (key_a->group < key_b->group) ? -1 : 1;
+	}
+	if (key_a->value != key_b->value) {
+		return (key_a->value < key_b->value) ? -1 : 1;
+	}
+	return (index_a > index_b) - (index_a < index_b);
+}
+
+/**
+ * Used for sorting the changed entries using qsort, but retain access to original index.
  **/
 struct sort_helper {
+	///Entry index
 	int index;
-	double sort_value;
+	///Sort key
+	struct multitrack_sort_key key;
 };
 
 /**
- * Comparison function for qsort (sort in ascending order).
+ * Comparison function for qsort, ordering by multitrack_compare_sort_keys().
  **/
-int ascending(const void *lvalue, const void *rvalue)
+static int multitrack_compare_sort_helpers(const void *lvalue, const void *rvalue)
 {
-	return ceil(((struct sort_helper*)lvalue)->sort_value - ((struct sort_helper*)rvalue)->sort_value);
+	const struct sort_helper *left = (const struct sort_helper*)lvalue;
+	const struct sort_helper *right = (const struct sort_helper*)rvalue;
+	return multitrack_compare_sort_keys(&(left->key), left->index, &(right->key), right->index);
 }
 
 /**
- * Comparison function for qsort (sort in descending order).
+ * Move a single entry to its position according to a new sort key, in a sorted index that is otherwise ordered by
+ * the sort keys of the listing. The current and the new position are found by binary search, and the entries in
+ * between are shifted by one.
+ *
+ * \param listing Satellite listing
+ * \param entry_index Entry index
+ * \param key New sort key of entry
  **/
-int descending(const void *lvalue, const void *rvalue)
+static void multitrack_move_sorted_entry(multitrack_listing_t *listing, int entry_index, const struct multitrack_sort_key *key)
 {
-	return ceil(((struct sort_helper*)rvalue)->sort_value - ((struct sort_helper*)lvalue)->sort_value);
+	int *sorted_index = listing->sorted_index;
+
+	//current position, from the sort key the entry was sorted by
+	int position = 0;
+	int last = listing->num_entries - 1;
+	while (position < last) {
+		int mid = position + (last - position)/2;
+		if (multitrack_compare_sort_keys(&(listing->sort_keys[entry_index]), entry_index, &(listing->sort_keys[sorted_index[mid]]), sorted_index[mid]) > 0) {
+			position = mid + 1;
+		} else {
+			last = mid;
+		}
+	}
+	listing->sort_keys[entry_index] = *key;
+
+	//binary search for the new position among the entries before or after the current position
+	int new_position = position;
+	if ((position > 0) && (multitrack_compare_sort_keys(key, entry_index, &(listing->sort_keys[sorted_index[position-1]]), sorted_index[position-1]) < 0)) {
+		int low = 0;
+		int high = position - 1;
+		while (low < high) {
+			int mid = low + (high - low)/2;
+			if (multitrack_compare_sort_keys(key, entry_index, &(listing->sort_keys[sorted_index[mid]]), sorted_index[mid]) < 0) {
+				high = mid;
+			} else {
+				low = mid + 1;
+			}
+		}
+		new_position = low;
+		memmove(sorted_index + new_position + 1, sorted_index + new_position, sizeof(int)*(position - new_position));
+	} else if ((position < listing->num_entries - 1) && (multitrack_compare_sort_keys(key, entry_index, &(listing->sort_keys[sorted_index[position+1]]), sorted_index[position+1]) > 0)) {
+		int low = position + 1;
+		int high = listing->num_entries - 1;
+		while (low < high) {
+			int mid = low + (high - low + 1)/2;
+			if (multitrack_compare_sort_keys(key, entry_index, &(listing->sort_keys[sorted_index[mid]]), sorted_index[mid]) > 0) {
+				low = mid;
+			} else {
+				high = mid - 1;
+			}
+		}
+		new_position = low;
+		memmove(sorted_index + position, sorted_index + position + 1, sizeof(int)*(new_position - position));
+	}
+	sorted_index[new_position] = entry_index;
 }
 
 /**
- * Sort entry_mapping according to satellite values and sorting options.
+ * Sort the changed entries by their new sort keys and merge them with the unchanged entries, which are already in order.
  *
- * \param entries Satellite entries
- * \param num_entries Number of entries in entry_mapping
- * \param entry_mapping Entry mapping, maps indices in entries
- * \param sort_option Sorting option defined in enum sort_options. Currently assumed to be either SORT_BY_AOS (sort by next_aos field in ascending order) or SORT_BY_MAX_ELEVATION (sort by max_elevation in descending order)
+ * \param listing Satellite listing
+ * \param changed Sort helpers of the changed entries, with the new sort keys
+ * \param num_changed Number of changed entries
  **/
-void sort_satellites(multitrack_entry_t **entries, int num_entries, int *entry_mapping, int sort_option)
-{
-	//prepare array for sorting using stdlib's qsort
-	struct sort_helper *sorting = (struct sort_helper*)malloc(sizeof(struct sort_helper)*num_entries);
-	for (int i=0; i < num_entries; i++) {
-		sorting[i].index = entry_mapping[i];
-		if (sort_option == SORT_BY_MAX_ELEVATION) {
-			sorting[i].sort_value = entries[entry_mapping[i]]->max_elevation;
-		} else if (sort_option == SORT_BY_AOS) {
-			sorting[i].sort_value = entries[entry_mapping[i]]->next_aos;
+static void multitrack_merge_sorted_entries(multitrack_listing_t *listing, struct sort_helper *changed, int num_changed)
+{
+	qsort(changed, num_changed, sizeof(struct sort_helper), multitrack_compare_sort_helpers);
+
+	//unchanged entries in their current order
+	int num_unchanged = 0;
+	int *unchanged = (int*)malloc(sizeof(int)*(listing->num_entries - num_changed + 1));
+	if (listing->sort_keys_valid) {
+		for (int i=0; i < listing->num_entries; i++) {
+			if (!listing->sort_key_changed[listing->sorted_index[i]]) {
+				unchanged[num_unchanged++] = listing->sorted_index[i];
+			}
 		}
+	}
 
+	for (int i=0; i < num_changed; i++) {
+		listing->sort_keys[changed[i].index] = changed[i].key;
 	}
 
-	if (sort_option == SORT_BY_MAX_ELEVATION) {
-		qsort(sorting, num_entries, sizeof(struct sort_helper), descending);
-	} else if (sort_option == SORT_BY_AOS) {
-		qsort(sorting, num_entries, sizeof(struct sort_helper), ascending);
+	int i = 0;
+	int j = 0;
+	for (int position=0; position < listing->num_entries; position++) {
+		int entry_index;
+		if ((j >= num_changed) || ((i < num_unchanged) && (multitrack_compare_sort_keys(&(listing->sort_keys[unchanged[i]]), unchanged[i], &(changed[j].key), changed[j].index) < 0))) {
+			entry_index = unchanged[i++];
+		} else {
+			entry_index = changed[j++].index;
+		}
+		listing->sorted_index[position] = entry_index;
 	}
+	free(unchanged);
+}
 
-	//extract results
-	for (int i=0; i < num_entries; i++) {
-		entry_mapping[i] = sorting[i].index;
+void multitrack_sort_listing(multitrack_listing_t *listing)
+{
+	int num_orbits = listing->num_entries;
+	if (num_orbits == 0) {
+		return;
 	}
 
-	free(sorting);
+	//entries flagged during the last update
+	if (!listing->sort_keys_valid) {
+		for (int i=0; i < num_orbits; i++) {
+			listing->sort_key_changed[i] = true;
+		}
+	}
+	int num_changed = 0;
+	for (int i=0; i < num_orbits; i++) {
+		if (listing->sort_key_changed[i]) {
+			num_changed++;
+		}
+	}
+	struct sort_helper *changed = (struct sort_helper*)malloc(sizeof(struct sort_helper)*(num_changed + 1));
+	num_changed = 0;
+	for (int i=0; i < num_orbits; i++) {
+		if (listing->sort_key_changed[i]) {
+			changed[num_changed].index = i;
+			multitrack_entry_sort_key(&(listing->entries[i]), listing->sort_option, &(changed[num_changed].key));
+			num_changed++;
+		}
+	}
+
+	//update the number of entries in each category from the categories of the moved entries
+	int counts[NUM_CATEGORIES] = {0};
+	if (listing->sort_keys_valid) {
+		counts[CATEGORY_ABOVE_HORIZON] = listing->num_above_horizon;
+		counts[CATEGORY_WILL_RISE] = listing->num_below_horizon;
+		counts[CATEGORY_BELOW_THRESHOLD] = listing->num_below_threshold;
+		counts[CATEGORY_NEVER_VISIBLE] = listing->num_nevervisible;
+		counts[CATEGORY_DECAYED] = listing->num_decayed;
+	}
+	for (int i=0; i < num_changed; i++) {
+		if (listing->sort_keys_valid) {
+			counts[listing->sort_keys[changed[i].index].category]--;
+		}
+		counts[changed[i].key.category]++;
+	}
+	listing->num_above_horizon = counts[CATEGORY_ABOVE_HORIZON];
+	listing->num_below_horizon = counts[CATEGORY_WILL_RISE];
+	listing->num_below_threshold = counts[CATEGORY_BELOW_THRESHOLD];
+	listing->num_nevervisible = counts[CATEGORY_NEVER_VISIBLE];
+	listing->num_decayed = counts[CATEGORY_DECAYED];
+
+	if (!listing->sort_keys_valid || (num_changed*MULTITRACK_INCREMENTAL_SORT_FRACTION > num_orbits)) {
+		multitrack_merge_sorted_entries(listing, changed, num_changed);
+		listing->sort_keys_valid = true;
+	} else {
+		for (int i=0; i < num_changed; i++) {
+			multitrack_move_sorted_entry(listing, changed[i].index, &(changed[i].key));
+		}
+	}
+
+	for (int i=0; i < num_changed; i++) {
+		listing->sort_key_changed[changed[i].index] = false;
+	}
+	free(changed);
 }
 
 /**
- * Helper functions for category sorting of multitrack listing.
+ * Keep the selected index within the limits of the listing, and scroll the view so that the selected entry is shown.
+ *
+ * \param listing Satellite listing
  **/
-
-bool above_horizon(const multitrack_entry_t *entry)
+static void multitrack_scroll_to_selected(multitrack_listing_t *listing)
 {
-	return entry->above_horizon && !entry->decayed && entry->above_max_elevation_threshold;
-}
+	//adjust index according to limits
+	if (listing->selected_entry_index < 0) {
+		listing->selected_entry_index = 0;
+	}
 
-bool will_rise(const multitrack_entry_t *entry)
-{
-	return !(entry->above_horizon) && !(entry->never_visible) && !(entry->decayed) && entry->above_max_elevation_threshold;
-}
+	if (listing->selected_entry_index >= listing->num_entries) {
+		listing->selected_entry_index = listing->num_entries-1;
+	}
 
-bool below_threshold(const multitrack_entry_t *entry)
-{
-	return !entry->never_visible && !entry->above_max_elevation_threshold && !entry->decayed;
+	//check for scroll event
+	if (listing->selected_entry_index > listing->bottom_index) {
+		int diff = listing->selected_entry_index - listing->bottom_index;
+		listing->bottom_index += diff;
+		listing->top_index += diff;
+	}
+	if (listing->selected_entry_index < listing->top_index) {
+		int diff = listing->top_index - listing->selected_entry_index;
+		listing->bottom_index -= diff;
+		listing->top_index -= diff;
+	}
 }
 
-void multitrack_sort_listing(multitrack_listing_t *listing)
+void multitrack_update_whitelist(multitrack_listing_t *listing, struct tle_db *tle_db)
 {
-	int num_orbits = listing->num_entries;
+	//check whether the enabled satellites differ from the current entries
+	int num_enabled_tles = 0;
+	size_t names_size = 0;
+	bool changed = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (tle_db_entry_enabled(tle_db, i)) {
+			changed = changed || (num_enabled_tles >= listing->num_entries) || (listing->tle_db_mapping[num_enabled_tles] != i);
+			num_enabled_tles++;
+			names_size += strlen(tle_db_entry_name(tle_db, i)) + 1;
+		}
+	}
+	if (!changed && (num_enabled_tles == listing->num_entries)) {
+		return;
+	}
+	if (num_enabled_tles == 0) {
+		multitrack_refresh_tles(listing, tle_db);
+		return;
+	}
 
-	//those with elevation > 0 at the top
-	int above_horizon_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (above_horizon(listing->entries[i])) {
-			listing->sorted_index[above_horizon_counter] = i;
-			above_horizon_counter++;
+	//the previous arrays are kept until the remaining entries have been moved to the new arena
+	multitrack_listing_t previous = *listing;
+	char *names = multitrack_allocate_arena(listing, num_enabled_tles, names_size);
+	if (names == NULL) {
+		*listing = previous;
+		return;
+	}
+	listing->num_entries = num_enabled_tles;
+	listing->batch = batch_propagation_create(num_enabled_tles);
+
+	//new entry index of each previous entry, -1 for removed entries
+	int *new_indices = (int*)malloc(sizeof(int)*(previous.num_entries + 1));
+	int *added = (int*)malloc(sizeof(int)*num_enabled_tles);
+	int num_added = 0;
+	int k = 0;
+	int j = 0;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		bool was_enabled = (k < previous.num_entries) && (previous.tle_db_mapping[k] == i);
+		if (!tle_db_entry_enabled(tle_db, i)) {
+			if (was_enabled) {
+				tle_db_orbital_elements_release(&(previous.entry_details[k].orbital_elements));
+				new_indices[k++] = -1;
+			}
+			continue;
 		}
+
+		struct multitrack_entry_details *details = &(listing->entry_details[j]);
+		if (was_enabled) {
+			//keep AOS/LOS, sort key, display string and propagation state
+			listing->entries[j] = previous.entries[k];
+			*details = previous.entry_details[k];
+			listing->sort_keys[j] = previous.sort_keys[k];
+			batch_propagation_copy_satellite(listing->batch, j, previous.batch, k);
+			new_indices[k++] = j;
+		} else {
+			details->orbital_elements = tle_db_entry_get_orbital_elements(tle_db, i);
+			multitrack_init_entry(&(listing->entries[j]));
+			multitrack_classify_entry(&(listing->entries[j]), details->orbital_elements->elements, listing->qth);
+			batch_propagation_set_satellite(listing->batch, j, details->orbital_elements->elements);
+			multitrack_entry_sort_key(&(listing->entries[j]), listing->sort_option, &(listing->sort_keys[j]));
+			added[num_added++] = j;
+		}
+
+		size_t name_length = strlen(tle_db_entry_name(tle_db, i)) + 1;
+		memcpy(names, tle_db_entry_name(tle_db, i), name_length);
+		details->name = names;
+		names += name_length;
+		listing->tle_db_mapping[j] = i;
+		j++;
+	}
+	for (; k < previous.num_entries; k++) {
+		tle_db_orbital_elements_release(&(previous.entry_details[k].orbital_elements));
+		new_indices[k] = -1;
 	}
-	listing->num_above_horizon = above_horizon_counter;
 
-	//satellites that will eventually rise above the horizon
-	int below_horizon_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (will_rise(listing->entries[i])) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter] = i;
-			below_horizon_counter++;
+	//remaining entries keep their sorted order, and the added entries are merged in by their initial sort keys
+	int *kept = (int*)malloc(sizeof(int)*(previous.num_entries + 1));
+	int num_kept = 0;
+	for (int i=0; i < previous.num_entries; i++) {
+		int entry_index = new_indices[previous.sorted_index[i]];
+		if (entry_index >= 0) {
+			kept[num_kept++] = entry_index;
+		}
+	}
+	int a = 0;
+	int b = 0;
+	for (int position=0; position < listing->num_entries; position++) {
+		if ((b >= num_added) || ((a < num_kept) && (multitrack_compare_sort_keys(&(listing->sort_keys[kept[a]]), kept[a], &(listing->sort_keys[added[b]]), added[b]) < 0))) {
+			listing->sorted_index[position] = kept[a++];
+		} else {
+			listing->sorted_index[position] = added[b++];
 		}
 	}
-	listing->num_below_horizon = below_horizon_counter;
 
-	//satellites below max elevation threshold
-	int below_threshold_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (below_threshold(listing->entries[i])) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter + below_threshold_counter] = i;
-			below_threshold_counter++;
+	if (listing->sort_keys_valid) {
+		int counts[NUM_CATEGORIES] = {0};
+		for (int i=0; i < listing->num_entries; i++) {
+			counts[listing->sort_keys[i].category]++;
 		}
+		listing->num_above_horizon = counts[CATEGORY_ABOVE_HORIZON];
+		listing->num_below_horizon = counts[CATEGORY_WILL_RISE];
+		listing->num_below_threshold = counts[CATEGORY_BELOW_THRESHOLD];
+		listing->num_nevervisible = counts[CATEGORY_NEVER_VISIBLE];
+		listing->num_decayed = counts[CATEGORY_DECAYED];
 	}
-	listing->num_below_threshold = below_threshold_counter;
+	listing->should_sort = true;
 
-	//satellites that will never be visible, with decayed orbits last
-	int nevervisible_counter = 0;
-	int decayed_counter = 0;
-	for (int i=0; i < num_orbits; i++) {
-		if (listing->entries[i]->never_visible && !(listing->entries[i]->decayed)) {
-			listing->sorted_index[below_horizon_counter + above_horizon_counter + below_threshold_counter + nevervisible_counter] = i;
-			nevervisible_counter++;
-		} else if (listing->entries[i]->decayed) {
-			listing->sorted_index[num_orbits - 1 - decayed_counter] = i;
-			decayed_counter++;
+	//keep the selected satellite selected, or the same position if it was removed
+	if ((previous.num_entries > 0) && (previous.selected_entry_index >= 0) && (previous.selected_entry_index < previous.num_entries)) {
+		int selected = new_indices[previous.sorted_index[previous.selected_entry_index]];
+		for (int i=0; (selected >= 0) && (i < listing->num_entries); i++) {
+			if (listing->sorted_index[i] == selected) {
+				listing->selected_entry_index = i;
+				break;
+			}
 		}
 	}
-	listing->num_nevervisible = nevervisible_counter;
-	listing->num_decayed = decayed_counter;
+	multitrack_scroll_to_selected(listing);
+	multitrack_search_field_clear_matches(listing->search_field);
 
-	if (listing->sort_option == SORT_BY_AOS) {
-		//sort those with nonzero elevation according to max elevation
-		sort_satellites(listing->entries, above_horizon_counter, listing->sorted_index, SORT_BY_MAX_ELEVATION);
+	free(kept);
+	free(added);
+	free(new_indices);
+	free(previous.arena);
+	if (previous.batch != NULL) {
+		batch_propagation_destroy(&(previous.batch));
+	}
+}
 
-		//sort the rest according to AOS/LOS
-		sort_satellites(listing->entries, below_horizon_counter, listing->sorted_index + above_horizon_counter, SORT_BY_AOS);
-	} else if (listing->sort_option == SORT_BY_MAX_ELEVATION) {
-		//sort all according to max elevation
-		sort_satellites(listing->entries, above_horizon_counter + below_horizon_counter, listing->sorted_index, SORT_BY_MAX_ELEVATION);
+void multitrack_update_qth(multitrack_listing_t *listing)
+{
+	//orbit classes and propagation state are kept, the batch propagates all satellites again for the new observer
+	for (int i=0; i < listing->num_entries; i++) {
+		multitrack_entry_t *entry = &(listing->entries[i]);
+		multitrack_init_entry(entry);
+		multitrack_classify_entry(entry, listing->entry_details[i].orbital_elements->elements, listing->qth);
 	}
+	listing->sort_keys_valid = false;
+	listing->should_sort = true;
 
-	//sort satellites below threshold according to max elevation
-	sort_satellites(listing->entries, below_threshold_counter, listing->sorted_index + above_horizon_counter + below_horizon_counter, SORT_BY_MAX_ELEVATION);
+	//AOS/LOS of all entries are predicted again in the next update, with progress information
+	werase(listing->window);
+	listing->not_displayed = true;
 }
 
-void multitrack_display_entry(WINDOW *window, int row, int col, multitrack_entry_t *entry)
+void multitrack_display_entry(multitrack_listing_t *listing, int row, int col, int entry_index, bool selected)
 {
-	wattrset(window, entry->display_attributes);
-	mvwprintw(window, row, col, "%s", entry->display_string);
+	multitrack_format_entry(listing, entry_index);
+	struct multitrack_entry_details *details = &(listing->entry_details[entry_index]);
+	if (selected) {
+		wattrset(listing->window, MULTITRACK_SELECTED_ATTRIBUTE);
+		mvwprintw(listing->window, row, col, "%c%s", MULTITRACK_SELECTED_MARKER, details->display_string + 1);
+	} else {
+		wattrset(listing->window, details->display_values.attributes);
+		mvwprintw(listing->window, row, col, "%s", details->display_string);
+	}
 }
 
 void multitrack_print_scrollbar(multitrack_listing_t *listing)
@@ -834,15 +1570,12 @@ void multitrack_display_listing(multitrack_listing_t *listing)
 
 	//show entries
 	if (listing->num_entries > 0) {
-		int selected_index = listing->sorted_index[listing->selected_entry_index];
-		listing->entries[selected_index]->display_attributes = MULTITRACK_SELECTED_ATTRIBUTE;
-		listing->entries[selected_index]->display_string[0] = MULTITRACK_SELECTED_MARKER;
-
 		int line = 0;
 		int col = 1;
 
+		//only the entries within the viewport are formatted
 		for (int i=listing->top_index; ((i <= listing->bottom_index) && (i < listing->num_entries)); i++) {
-			multitrack_display_entry(listing->window, line++, col, listing->entries[listing->sorted_index[i]]);
+			multitrack_display_entry(listing, line++, col, listing->sorted_index[i], i == listing->selected_entry_index);
 		}
 
 		if (listing->num_entries > listing->displayed_entries_per_page) {
@@ -945,26 +1678,7 @@ bool multitrack_handle_listing(multitrack_listing_t *listing, int input_key)
 			break;
 		}
 
-		//adjust index according to limits
-		if (listing->selected_entry_index < 0) {
-			listing->selected_entry_index = 0;
-		}
-
-		if (listing->selected_entry_index >= listing->num_entries) {
-			listing->selected_entry_index = listing->num_entries-1;
-		}
-
-		//check for scroll event
-		if (listing->selected_entry_index > listing->bottom_index) {
-			int diff = listing->selected_entry_index - listing->bottom_index;
-			listing->bottom_index += diff;
-			listing->top_index += diff;
-		}
-		if (listing->selected_entry_index < listing->top_index) {
-			int diff = listing->top_index - listing->selected_entry_index;
-			listing->bottom_index -= diff;
-			listing->top_index -= diff;
-		}
+		multitrack_scroll_to_selected(listing);
 		return handled;
 	}
 	return false;
@@ -984,6 +1698,7 @@ int multitrack_selected_window_row(multitrack_listing_t *listing)
 void multitrack_destroy_listing(multitrack_listing_t **listing)
 {
 	multitrack_free_entries(*listing);
+	worker_pool_destroy(&((*listing)->worker_pool));
 	multitrack_option_selector_destroy(&((*listing)->option_selector));
 	multitrack_search_field_destroy(&((*listing)->search_field));
 	delwin((*listing)->header_window);
@@ -1620,14 +2335,12 @@ void multitrack_show_help()
 
 	wrefresh(help_window);
 
-	cbreak(); //turn off halfdelay mode so that getch blocks
 	getch();
 	delwin(help_window);
 }
 
 void multitrack_edit_settings(multitrack_listing_t *listing)
 {
-	cbreak(); //turn off halfdelay mode so that getch blocks
 	WINDOW *option_window = newwin(OPTION_WINDOW_HEIGHT, OPTION_WINDOW_WIDTH, OPTION_WINDOW_ROW, OPTION_WINDOW_COL);
 
 	int col = 1;
@@ -1780,7 +2493,8 @@ void multitrack_edit_settings(multitrack_listing_t *listing)
 	//write settings to file
 	multitrack_settings_to_file(listing);
 
-	//trigger resort
+	//trigger resort from scratch, since the sort option may have changed
+	listing->sort_keys_valid = false;
 	listing->should_sort = true;
 }
 
@@ -21,35 +21,108 @@ enum sort_options{SORT_BY_AOS, SORT_BY_MAX_ELEVATION};
  **/
 
 /**
- * Entry in satellite listing.
+ * Orbit class of a satellite, derived from its orbital elements.
+ **/
+enum orbit_class {
+	///Low earth orbit (orbital period below 128 minutes)
+	ORBIT_CLASS_LEO,
+	///Medium earth or highly elliptical orbit, between LEO and geosynchronous orbits
+	ORBIT_CLASS_MEO,
+	///Geosynchronous orbit, with a nearly fixed azimuth and elevation
+	ORBIT_CLASS_GEO
+};
+
+/**
+ * Values shown in a row of the satellite listing, rounded to the displayed precision. The row is formatted again
+ * only when these change.
+ **/
+struct multitrack_display_values {
+	///Formatting attributes (input to wattrset())
+	int attributes;
+	///Azimuth (tenths of degrees)
+	int azimuth;
+	///Elevation (tenths of degrees)
+	int elevation;
+	///Latitude of the sub-satellite point (degrees)
+	int latitude;
+	///Longitude of the sub-satellite point (degrees)
+	int longitude;
+	///Altitude (km)
+	int altitude;
+	///Range (km)
+	int range;
+	///Sun status: 'V' for visible, 'D' for daylight and 'N' for eclipsed
+	char sun_status;
+	///Range status: '/' for approaching, '\\' for receding and '=' otherwise
+	char range_status;
+	///Maximum elevation of the next or current pass (degrees)
+	int max_elevation;
+	///Format of the AOS/LOS field
+	int aoslos_format;
+	///Value shown in the AOS/LOS field, in the unit given by its format
+	long aoslos_value;
+	///Whether the satellite has decayed
+	bool decayed;
+};
+
+//Length of the display string of an entry in the satellite listing
+#define MULTITRACK_DISPLAY_STRING_LENGTH 128
+
+/**
+ * Entry in satellite listing, containing the state used when updating and sorting the listing. Entries are stored
+ * contiguously, and the data only needed when an entry is shown on screen is kept apart in struct multitrack_entry_details.
  **/
 typedef struct {
-	///Satellite name
-	char *name;
-	///Orbital elements for satellite
-	predict_orbital_elements_t *orbital_elements;
 	///Time for next AOS
 	double next_aos;
 	///Time for next LOS
 	double next_los;
 	///Maximum elevation of the next or current pass in degrees
 	double max_elevation;
+	///Orbit class, set by multitrack_classify_entry()
+	enum orbit_class orbit_class;
 	///Whether satellite currently is above horizon
 	bool above_horizon;
-	///Whether satellite is geostationary
-	bool geostationary;
+	///Whether the inclination and altitude of the orbit allow the satellite to rise above the horizon of the QTH, set by multitrack_classify_entry()
+	bool aos_happens;
+	///Whether passes can be predicted for the satellite, i.e. it can rise and is not geosynchronous. Set by multitrack_classify_entry()
+	bool can_predict;
 	///Whether satellite is never visible
 	bool never_visible;
 	///Whether satellite is above maximum elevation threshold
 	bool above_max_elevation_threshold;
 	///Whether satellite has decayed
 	bool decayed;
-	///String used for information displaying in the satellite listing
-	char display_string[MAX_NUM_CHARS];
-	///Formatting attributes (input to wattrset())
-	int display_attributes;
 } multitrack_entry_t;
 
+/**
+ * Data of an entry in the satellite listing used only for displaying the entry and for recalculating its AOS/LOS.
+ **/
+struct multitrack_entry_details {
+	///Satellite name, stored in the arena of the listing
+	char *name;
+	///Orbital elements for satellite, reference obtained from the TLE database
+	struct tle_db_orbital_elements *orbital_elements;
+	///Whether display_string has been formatted
+	bool display_string_valid;
+	///Values display_string was formatted from
+	struct multitrack_display_values display_values;
+	///String used for information displaying in the satellite listing, formatted only when the entry is shown on screen
+	char display_string[MULTITRACK_DISPLAY_STRING_LENGTH];
+};
+
+/**
+ * Sort key of an entry in the satellite listing. Entries are ordered by group, then by value, then by entry index.
+ **/
+struct multitrack_sort_key {
+	///Category of the entry (above horizon, will rise, below max elevation threshold, never visible or decayed)
+	int category;
+	///Group in display order: the category of the entry, with satellites above the horizon and satellites that will rise merged when sorting by max elevation
+	int group;
+	///Sort value within the group, in ascending order
+	double value;
+};
+
 /**
  * Submenu shown when pressing -> or ENTER on selected satellite in multitrack listing.
  **/
@@ -113,8 +186,12 @@ typedef struct {
 	bool not_displayed;
 	///Number of displayed satellites
 	int num_entries;
+	///Single allocation containing the entries and all arrays below with one element per entry, freed at once
+	void *arena;
 	///Displayed satellites
-	multitrack_entry_t **entries;
+	multitrack_entry_t *entries;
+	///Display data of the displayed satellites
+	struct multitrack_entry_details *entry_details;
 	///Index mapping from index corresponding to displayed entry in menu to index in `entries`-array
 	int *sorted_index;
 	///Currently selected index in menu
@@ -162,6 +239,26 @@ typedef struct {
 	double max_elevation_threshold;
 	///Whether listing should be sorted in multitrack_update_listing_data().
 	bool should_sort;
+	///Time of the last update in multitrack_update_listing_data()
+	predict_julian_date_t time;
+	///Sort key of each entry, as of the last sort. sorted_index is ordered by these keys
+	struct multitrack_sort_key *sort_keys;
+	///Whether sort_keys are valid. Cleared when the entries or the sort option change, so that the next sort starts from scratch
+	bool sort_keys_valid;
+	///Whether the sort key of each entry differs from sort_keys after the last update
+	bool *sort_key_changed;
+	///Orbital elements of the displayed satellites, propagated together in multitrack_update_listing_data()
+	struct batch_propagation *batch;
+	///Whether the AOS/LOS times of each entry changed in the last update
+	bool *aoslos_changed;
+	///Whether each entry is shown on screen, and has to be propagated even when it cannot be above the horizon
+	bool *propagation_required;
+	///Indices of the entries shown on screen that were skipped in the propagation, filled in multitrack_update_listing_data()
+	int *skipped_entries;
+	///Worker threads used for updating the entries in multitrack_update_listing_data()
+	struct worker_pool *worker_pool;
+	///Precomputed passes used instead of predicting AOS/LOS times on demand, owned by the caller. Can be NULL
+	struct pass_table *pass_table;
 } multitrack_listing_t;
 
 /**
@@ -182,13 +279,53 @@ multitrack_listing_t* multitrack_create_listing(predict_observer_t *observer, st
 void multitrack_refresh_tles(multitrack_listing_t *listing, struct tle_db *tle_db);
 
 /**
- * Update satellite listing data.
+ * Replace the orbital elements of the listing entries corresponding to updated TLE entries, and force recalculation
+ * of their next AOS/LOS. Unlike multitrack_refresh_tles(), the remaining entries are left untouched.
+ *
+ * \param listing Multitrack satellite listing
+ * \param tle_db TLE database
+ * \param updated_tles Flags for which TLE entries were updated, of tle_db->num_tles length
+ **/
+void multitrack_update_orbital_elements(multitrack_listing_t *listing, struct tle_db *tle_db, const bool *updated_tles);
+
+/**
+ * Add and remove entries according to the `enabled`-flag within the TLE database. Unlike multitrack_refresh_tles(),
+ * the entries of satellites that stay enabled keep their orbital elements, propagation state, AOS/LOS times and
+ * position in the sorted listing, so that only the passes of newly enabled satellites are predicted in the next update.
+ *
+ * \param listing Multitrack satellite listing
+ * \param tle_db TLE database
+ **/
+void multitrack_update_whitelist(multitrack_listing_t *listing, struct tle_db *tle_db);
+
+/**
+ * Invalidate the data depending on the QTH after the QTH coordinates of the listing have been changed in place. The
+ * orbital elements and propagation state of the entries are kept, while their AOS/LOS times and maximum elevations
+ * are predicted again in the next update.
+ *
+ * \param listing Multitrack satellite listing
+ **/
+void multitrack_update_qth(multitrack_listing_t *listing);
+
+/**
+ * Update satellite listing data. The entries are updated in parallel using the worker pool of the listing, and
+ * the results are merged before the listing is sorted.
  *
  * \param listing Multitrack satellite listing
  * \param time Time at which satellite listing should be calculated
  **/
 void multitrack_update_listing_data(multitrack_listing_t *listing, predict_julian_date_t time);
 
+/**
+ * Get the earliest upcoming AOS or LOS among the entries of the listing, at which the listing has to be updated. When
+ * the sorted index is up to date, only the first satellite that will rise is checked for its AOS.
+ *
+ * \param listing Multitrack satellite listing
+ * \param time Current time
+ * \return Time of the next AOS or LOS after the current time, or 0 if there is none
+ **/
+predict_julian_date_t multitrack_next_event(multitrack_listing_t *listing, predict_julian_date_t time);
+
 /**
  * Print satellite listing and refresh associated windows.
  *
@@ -0,0 +1,328 @@
+#include "pass_predictions.h"
+#include "prediction_output.h"
+#include <stdlib.h>
+#include <math.h>
+
+//time step used for starting the search for the next pass after a LOS (days)
+#define PASS_PREDICTIONS_TIME_STEP (1.0/86400.0)
+
+//initial number of allocated passes and steps per satellite
+#define PASS_PREDICTIONS_INITIAL_ALLOCATION 16
+
+/**
+ * Append pass to the passes of a satellite.
+ *
+ * \param satellite Satellite
+ * \param pass Pass events
+ **/
+static void pass_predictions_add_pass(struct pass_predictions_satellite *satellite, const struct pass_events *pass)
+{
+	if (satellite->num_passes >= satellite->max_passes) {
+		satellite->max_passes = (satellite->max_passes > 0) ? 2*satellite->max_passes : PASS_PREDICTIONS_INITIAL_ALLOCATION;
+		satellite->passes = (struct pass_prediction*)realloc(satellite->passes, sizeof(struct pass_prediction)*satellite->max_passes);
+	}
+
+	struct pass_prediction *prediction = &(satellite->passes[satellite->num_passes]);
+	prediction->tle_index = satellite->tle_index;
+	prediction->events = *pass;
+	prediction->first_step = 0;
+	prediction->num_steps = 0;
+	prediction->steps = NULL;
+	satellite->num_passes++;
+}
+
+/**
+ * Find the current or next pass using the AOS and LOS searches of libpredict. Used when the pass solver fails,
+ * e.g. for passes longer than it supports, in the same way as the pass table leaves such satellites to libpredict.
+ * A pass in progress at the given time is returned with AOS at the given time.
+ *
+ * \param observer Observer
+ * \param orbital_elements Orbital elements of satellite
+ * \param time Start of search
+ * \param ret_pass Returned pass
+ * \return True if a pass was found, false if the satellite has decayed
+ **/
+static bool pass_predictions_libpredict_pass(const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time, struct pass_events *ret_pass)
+{
+	struct predict_position orbit;
+	struct predict_observation aos;
+	predict_orbit(orbital_elements, &orbit, time);
+	predict_observe_orbit(observer, &orbit, &aos);
+	if (orbit.decayed) {
+		return false;
+	}
+	if (aos.elevation < 0) {
+		aos = predict_next_aos(observer, orbital_elements, time);
+	}
+	struct predict_observation los = predict_next_los(observer, orbital_elements, aos.time);
+	predict_orbit(orbital_elements, &orbit, los.time);
+	if (orbit.decayed || (los.time <= aos.time)) {
+		return false;
+	}
+	struct predict_observation max_elevation = predict_at_max_elevation(observer, orbital_elements, aos.time);
+
+	ret_pass->aos = aos.time;
+	ret_pass->aos_azimuth = aos.azimuth;
+	ret_pass->los = los.time;
+	ret_pass->los_azimuth = los.azimuth;
+	ret_pass->max_elevation_time = max_elevation.time;
+	ret_pass->max_elevation = max_elevation.elevation;
+	ret_pass->max_elevation_azimuth = max_elevation.azimuth;
+	return true;
+}
+
+/**
+ * Find all passes of a satellite between the start and the end of the predictions. Used as worker pool task.
+ *
+ * \param data Pass predictions
+ * \param index Satellite index
+ **/
+static void pass_predictions_find_passes(void *data, int index)
+{
+	struct pass_predictions *predictions = (struct pass_predictions*)data;
+	struct pass_predictions_satellite *satellite = &(predictions->satellites[index]);
+	const predict_orbital_elements_t *orbital_elements = satellite->orbital_elements->elements;
+
+	struct predict_position orbit;
+	predict_orbit(orbital_elements, &orbit, predictions->start_time);
+	if (predict_is_geosynchronous(orbital_elements) || !predict_aos_happens(orbital_elements, predictions->observer.latitude) || orbit.decayed) {
+		return;
+	}
+
+	predict_julian_date_t time = predictions->start_time;
+	while (time < predictions->end_time) {
+		struct pass_events pass;
+		enum pass_solver_status status = pass_solver_next_pass(&(predictions->observer), orbital_elements, time, predictions->end_time, &pass, NULL);
+		if (status == PASS_SOLVER_NO_PASS) {
+			break;
+		}
+		if ((status == PASS_SOLVER_FAILED) && !pass_predictions_libpredict_pass(&(predictions->observer), orbital_elements, time, &pass)) {
+			break;
+		}
+		if (pass.aos >= predictions->end_time) {
+			break;
+		}
+		if (pass.max_elevation >= predictions->min_elevation) {
+			pass_predictions_add_pass(satellite, &pass);
+		}
+		time = pass.los + PASS_PREDICTIONS_TIME_STEP;
+	}
+}
+
+/**
+ * Calculate and append a single step through a pass.
+ *
+ * \param satellite Satellite
+ * \param observer Observer
+ * \param time Time
+ * \param ret_orbit Returned orbit
+ * \return Appended step
+ **/
+static struct pass_prediction_step *pass_predictions_add_step(struct pass_predictions_satellite *satellite, const predict_observer_t *observer, predict_julian_date_t time, struct predict_position *ret_orbit)
+{
+	if (satellite->num_steps >= satellite->max_steps) {
+		satellite->max_steps = (satellite->max_steps > 0) ? 2*satellite->max_steps : PASS_PREDICTIONS_INITIAL_ALLOCATION;
+		satellite->steps = (struct pass_prediction_step*)realloc(satellite->steps, sizeof(struct pass_prediction_step)*satellite->max_steps);
+	}
+
+	struct predict_observation obs;
+	predict_orbit(satellite->orbital_elements->elements, ret_orbit, time);
+	predict_observe_orbit(observer, ret_orbit, &obs);
+
+	struct pass_prediction_step *step = &(satellite->steps[satellite->num_steps]);
+	step->time = time;
+	step->elevation = obs.elevation;
+	step->azimuth = obs.azimuth;
+	step->range = obs.range;
+	step->latitude = ret_orbit->latitude;
+	step->longitude = ret_orbit->longitude;
+	step->phase = ret_orbit->phase;
+	step->revolutions = ret_orbit->revolutions;
+	if (obs.visible) {
+		step->visibility = '+';
+	} else if (!(ret_orbit->eclipsed)) {
+		step->visibility = '*';
+	} else {
+		step->visibility = ' ';
+	}
+	satellite->num_steps++;
+	return step;
+}
+
+/**
+ * Calculate the steps through the passes of a satellite within the current window. Used as worker pool task.
+ *
+ * \param data Pass predictions
+ * \param index Satellite index
+ **/
+static void pass_predictions_calculate_steps(void *data, int index)
+{
+	struct pass_predictions *predictions = (struct pass_predictions*)data;
+	struct pass_predictions_satellite *satellite = &(predictions->satellites[index]);
+	satellite->num_steps = 0;
+
+	for (int i=satellite->window_begin; i < satellite->window_end; i++) {
+		struct pass_prediction *pass = &(satellite->passes[i]);
+		pass->first_step = satellite->num_steps;
+
+		//step from AOS using the same time step as the interactive pass schedule, and end exactly at LOS
+		predict_julian_date_t time = pass->events.aos;
+		while (true) {
+			struct predict_position orbit;
+			struct pass_prediction_step *step = pass_predictions_add_step(satellite, &(predictions->observer), time, &orbit);
+			if (time >= pass->events.los) {
+				break;
+			}
+			time += cos((step->elevation*180.0/M_PI-1.0)*M_PI/180.0)*sqrt(orbit.altitude)/25000.0;
+			if (time > pass->events.los) {
+				time = pass->events.los;
+			}
+		}
+		pass->num_steps = satellite->num_steps - pass->first_step;
+	}
+
+	//the step buffer is final only after all passes of the window have been stepped through
+	for (int i=satellite->window_begin; i < satellite->window_end; i++) {
+		satellite->passes[i].steps = satellite->steps + satellite->passes[i].first_step;
+	}
+}
+
+struct pass_predictions *pass_predictions_create(struct tle_db *tle_db, const predict_observer_t *observer, predict_julian_date_t start_time, predict_julian_date_t end_time, double min_elevation, int num_threads)
+{
+	struct pass_predictions *predictions = (struct pass_predictions*)calloc(1, sizeof(struct pass_predictions));
+	predictions->observer = *observer;
+	predictions->start_time = start_time;
+	predictions->end_time = end_time;
+	predictions->min_elevation = min_elevation;
+	predictions->worker_pool = worker_pool_create(num_threads);
+
+	//orbital elements are obtained here, since the TLE database cache is not thread safe
+	predictions->satellites = (struct pass_predictions_satellite*)calloc(tle_db->num_tles, sizeof(struct pass_predictions_satellite));
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (!tle_db_entry_enabled(tle_db, i)) {
+			continue;
+		}
+		struct tle_db_orbital_elements *orbital_elements = tle_db_entry_get_orbital_elements(tle_db, i);
+		if (orbital_elements == NULL) {
+			continue;
+		}
+		struct pass_predictions_satellite *satellite = &(predictions->satellites[predictions->num_satellites]);
+		satellite->tle_index = i;
+		satellite->orbital_elements = orbital_elements;
+		predictions->num_satellites++;
+	}
+
+	worker_pool_run(predictions->worker_pool, predictions->num_satellites, pass_predictions_find_passes, predictions);
+
+	int num_passes = 0;
+	for (int i=0; i < predictions->num_satellites; i++) {
+		num_passes += predictions->satellites[i].num_passes;
+	}
+	predictions->window_passes = (struct pass_prediction**)malloc(sizeof(struct pass_prediction*)*(num_passes > 0 ? num_passes : 1));
+	predictions->window_end = start_time;
+	return predictions;
+}
+
+void pass_predictions_destroy(struct pass_predictions **predictions)
+{
+	if (*predictions == NULL) {
+		return;
+	}
+
+	for (int i=0; i < (*predictions)->num_satellites; i++) {
+		struct pass_predictions_satellite *satellite = &((*predictions)->satellites[i]);
+		tle_db_orbital_elements_release(&(satellite->orbital_elements));
+		free(satellite->passes);
+		free(satellite->steps);
+	}
+	free((*predictions)->satellites);
+	free((*predictions)->window_passes);
+	worker_pool_destroy(&((*predictions)->worker_pool));
+	free(*predictions);
+	*predictions = NULL;
+}
+
+/**
+ * Compare passes by AOS, and by TLE database index for equal AOS. Used for qsort().
+ *
+ * \param a Pointer to pass
+ * \param b Pointer to pass
+ * \return -1, 0 or 1 when a is ordered before, equal to or after b
+ **/
+static int pass_predictions_compare(const void *a, const void *b)
+{
+	const struct pass_prediction *pass_a = *(const struct pass_prediction**)a;
+	const struct pass_prediction *pass_b = *(const struct pass_prediction**)b;
+
+	if (pass_a->events.aos != pass_b->events.aos) {
+		return (pass_a->events.aos < pass_b->events.aos) ? -1 : 1;
+	}
+	return (pass_a->tle_index > pass_b->tle_index) - (pass_a->tle_index < pass_b->tle_index);
+}
+
+/**
+ * Advance to the next window containing passes, calculate the steps through its passes and sort them by AOS.
+ *
+ * \param predictions Pass predictions
+ * \return True if a window with passes was found, false if all passes have been returned
+ **/
+static bool pass_predictions_next_window(struct pass_predictions *predictions)
+{
+	predictions->num_window_passes = 0;
+	predictions->next_window_pass = 0;
+
+	//skip ahead to the window of the earliest remaining pass, so that empty windows cost nothing
+	bool remaining = false;
+	predict_julian_date_t earliest_aos = 0;
+	for (int i=0; i < predictions->num_satellites; i++) {
+		struct pass_predictions_satellite *satellite = &(predictions->satellites[i]);
+		satellite->window_begin = satellite->window_end;
+		if (satellite->window_begin < satellite->num_passes) {
+			predict_julian_date_t aos = satellite->passes[satellite->window_begin].events.aos;
+			if (!remaining || (aos < earliest_aos)) {
+				earliest_aos = aos;
+			}
+			remaining = true;
+		}
+	}
+	if (!remaining) {
+		return false;
+	}
+	while (predictions->window_end <= earliest_aos) {
+		predictions->window_end += PASS_PREDICTIONS_WINDOW;
+	}
+
+	for (int i=0; i < predictions->num_satellites; i++) {
+		struct pass_predictions_satellite *satellite = &(predictions->satellites[i]);
+		while ((satellite->window_end < satellite->num_passes) && (satellite->passes[satellite->window_end].events.aos < predictions->window_end)) {
+			predictions->window_passes[predictions->num_window_passes++] = &(satellite->passes[satellite->window_end]);
+			satellite->window_end++;
+		}
+	}
+
+	worker_pool_run(predictions->worker_pool, predictions->num_satellites, pass_predictions_calculate_steps, predictions);
+	qsort(predictions->window_passes, predictions->num_window_passes, sizeof(struct pass_prediction*), pass_predictions_compare);
+	return true;
+}
+
+const struct pass_prediction *pass_predictions_next(struct pass_predictions *predictions)
+{
+	if (predictions->next_window_pass >= predictions->num_window_passes) {
+		if (!pass_predictions_next_window(predictions)) {
+			return NULL;
+		}
+	}
+
+	return predictions->window_passes[predictions->next_window_pass++];
+}
+
+int pass_predictions_write(struct prediction_output *output, struct pass_predictions *predictions, const struct tle_db *tle_db)
+{
+	int num_passes = 0;
+	const struct pass_prediction *pass;
+	while ((pass = pass_predictions_next(predictions)) != NULL) {
+		prediction_output_pass(output, tle_db_entry_name(tle_db, pass->tle_index), tle_db_entry_satellite_number(tle_db, pass->tle_index), pass);
+		num_passes++;
+	}
+	return num_passes;
+}
@@ -0,0 +1,157 @@
+#ifndef PASS_PREDICTIONS_H_DEFINED
+#define PASS_PREDICTIONS_H_DEFINED
+
+#include <predict/predict.h>
+#include "tle_db.h"
+#include "pass_solver.h"
+#include "worker_pool.h"
+
+/**
+ * Headless prediction of the passes of all enabled satellites over a time interval, without the curses UI.
+ *
+ * The passes of each satellite are found in parallel using the pass solver when the predictions are created,
+ * falling back to the AOS and LOS searches of libpredict for passes the solver fails on.
+ * The passes are then streamed in AOS order, over consecutive windows of PASS_PREDICTIONS_WINDOW. For each
+ * window, the steps through the passes starting within the window are calculated in parallel, one task per
+ * satellite, using the same time step as the interactive pass schedule. Only the steps of a single window are
+ * kept in memory.
+ **/
+
+//length of the windows over which the steps through the passes are calculated together (days)
+#define PASS_PREDICTIONS_WINDOW (1.0/8.0)
+
+/**
+ * Step through a pass, as shown in the interactive pass schedule.
+ **/
+struct pass_prediction_step {
+	///Time
+	predict_julian_date_t time;
+	///Elevation (radians)
+	double elevation;
+	///Azimuth (radians)
+	double azimuth;
+	///Range (km)
+	double range;
+	///Latitude of the sub-satellite point (radians)
+	double latitude;
+	///Longitude of the sub-satellite point (radians)
+	double longitude;
+	///Orbital phase (radians)
+	double phase;
+	///Revolution number
+	long revolutions;
+	///Visibility, '+' for visible to the naked eye, '*' for sunlit and ' ' for eclipsed
+	char visibility;
+};
+
+/**
+ * Single predicted pass.
+ **/
+struct pass_prediction {
+	///Index of the satellite in the TLE database
+	int tle_index;
+	///AOS, LOS and maximum elevation
+	struct pass_events events;
+	///Index of the first step in the step buffer of the satellite, valid while the window of the pass is streamed
+	int first_step;
+	///Number of steps
+	int num_steps;
+	///Steps from AOS to LOS, set when the window of the pass is streamed
+	const struct pass_prediction_step *steps;
+};
+
+/**
+ * Passes of a single satellite.
+ **/
+struct pass_predictions_satellite {
+	///Index of the satellite in the TLE database
+	int tle_index;
+	///Orbital elements, referenced from the TLE database
+	struct tle_db_orbital_elements *orbital_elements;
+	///Passes, in AOS order
+	struct pass_prediction *passes;
+	///Number of passes
+	int num_passes;
+	///Allocated number of passes
+	int max_passes;
+	///First pass of the current window
+	int window_begin;
+	///End of the passes of the current window
+	int window_end;
+	///Steps through the passes of the current window
+	struct pass_prediction_step *steps;
+	///Number of steps
+	int num_steps;
+	///Allocated number of steps
+	int max_steps;
+};
+
+/**
+ * Pass predictions of all enabled satellites.
+ **/
+struct pass_predictions {
+	///Observer
+	predict_observer_t observer;
+	///Start of predictions
+	predict_julian_date_t start_time;
+	///End of predictions. Passes with AOS before the end are included
+	predict_julian_date_t end_time;
+	///Minimum maximum elevation of included passes (radians)
+	double min_elevation;
+	///Worker pool
+	struct worker_pool *worker_pool;
+	///Satellites
+	struct pass_predictions_satellite *satellites;
+	///Number of satellites
+	int num_satellites;
+	///End of the current window
+	predict_julian_date_t window_end;
+	///Passes of the current window, in AOS order
+	struct pass_prediction **window_passes;
+	///Number of passes in the current window
+	int num_window_passes;
+	///Next pass to be returned from the current window
+	int next_window_pass;
+};
+
+/**
+ * Create pass predictions, finding the passes of all enabled satellites in parallel.
+ *
+ * \param tle_db TLE database
+ * \param observer Observer
+ * \param start_time Start of predictions. A pass in progress at the start is included
+ * \param end_time End of predictions
+ * \param min_elevation Minimum maximum elevation of included passes (radians)
+ * \param num_threads Number of threads to use. Set to 0 to use the number of online processors
+ * \return Pass predictions
+ **/
+struct pass_predictions *pass_predictions_create(struct tle_db *tle_db, const predict_observer_t *observer, predict_julian_date_t start_time, predict_julian_date_t end_time, double min_elevation, int num_threads);
+
+/**
+ * Free pass predictions.
+ *
+ * \param predictions Pass predictions
+ **/
+void pass_predictions_destroy(struct pass_predictions **predictions);
+
+/**
+ * Get next pass in AOS order, with its steps. Passes with the same AOS are ordered by TLE database index.
+ *
+ * \param predictions Pass predictions
+ * \return Next pass, valid until the next call. NULL when all passes have been returned
+ **/
+const struct pass_prediction *pass_predictions_next(struct pass_predictions *predictions);
+
+struct prediction_output;
+
+/**
+ * Write all passes in AOS order to an output sink.
+ *
+ * \param output Output sink
+ * \param predictions Pass predictions
+ * \param tle_db TLE database the predictions were created from
+ * \return Number of written passes
+ **/
+int pass_predictions_write(struct prediction_output *output, struct pass_predictions *predictions, const struct tle_db *tle_db);
+
+#endif
@@ -0,0 +1,336 @@
+#include "pass_solver.h"
+#include "root_finder.h"
+#include <math.h>
+#include <stdbool.h>
+
+//tolerance of the horizon crossing times (days, 0.1 seconds)
+#define PASS_SOLVER_CROSSING_TOLERANCE (0.1/86400.0)
+
+//tolerance of the time of maximum elevation (days, 1 second). The elevation is flat around the maximum, so that the maximum elevation itself is much more accurate
+#define PASS_SOLVER_MAXIMUM_TOLERANCE (1.0/86400.0)
+
+//maximum number of iterations in the refinement of the maximum elevation
+#define PASS_SOLVER_MAX_ITERATIONS 100
+
+//maximum duration of a pass before the search is abandoned (days)
+#define PASS_SOLVER_MAX_PASS_DURATION 1.0
+
+//maximum number of samples above the horizon kept for bracketing the maximum elevation
+#define PASS_SOLVER_MAX_SAMPLES 256
+
+//minimum time step between samples (days)
+#define PASS_SOLVER_MIN_STEP (1.0/86400.0)
+
+/**
+ * State of a single pass search.
+ **/
+struct pass_solver {
+	///Observer
+	const predict_observer_t *observer;
+	///Orbital elements of satellite
+	const predict_orbital_elements_t *orbital_elements;
+	///Number of propagations so far
+	int num_propagations;
+	///Time of last propagation
+	predict_julian_date_t time;
+	///Satellite position at last propagation
+	struct predict_position orbit;
+	///Observation at last propagation
+	struct predict_observation obs;
+};
+
+/**
+ * Propagate satellite and observe it from the observer.
+ *
+ * \param data Solver state, struct pass_solver. Last propagation is updated
+ * \param time Time
+ * \return Elevation (radians)
+ **/
+static double pass_solver_elevation(void *data, predict_julian_date_t time)
+{
+	struct pass_solver *solver = (struct pass_solver*)data;
+	predict_orbit(solver->orbital_elements, &(solver->orbit), time);
+	predict_observe_orbit(solver->observer, &(solver->orbit), &(solver->obs));
+	solver->time = time;
+	solver->num_propagations++;
+	return solver->obs.elevation;
+}
+
+/**
+ * Get observation at a time that has already been evaluated, propagating again only if it was not the last evaluation.
+ *
+ * \param solver Solver state
+ * \param time Time
+ * \return Observation
+ **/
+static const struct predict_observation *pass_solver_observation_at(struct pass_solver *solver, predict_julian_date_t time)
+{
+	if (solver->time != time) {
+		pass_solver_elevation(solver, time);
+	}
+	return &(solver->obs);
+}
+
+/**
+ * Get time step to the next coarse sample. Below the horizon, this is the step used in the AOS search of libpredict,
+ * which is large when the satellite is far below the horizon. Above the horizon, it is predict's time increment
+ * formula also used in the pass schedules.
+ *
+ * \param elevation Elevation at current sample (radians)
+ * \param altitude Altitude at current sample (km)
+ * \return Time step (days)
+ **/
+static double pass_solver_step(double elevation, double altitude)
+{
+	double elevation_degrees = elevation*180.0/M_PI;
+	double step;
+	if (elevation_degrees < 0) {
+		step = 0.00035*(-elevation_degrees*((altitude/8400.0)+0.46)+2.0);
+	} else {
+		step = cos((elevation_degrees-1.0)*M_PI/180.0)*sqrt(altitude)/25000.0;
+	}
+	if (step < PASS_SOLVER_MIN_STEP) {
+		step = PASS_SOLVER_MIN_STEP;
+	}
+	return step;
+}
+
+/**
+ * Refine time of maximum elevation using Brent's minimization method (parabolic interpolation and golden section search)
+ * on the negative elevation.
+ *
+ * \param solver Solver state
+ * \param a Start of bracket
+ * \param b End of bracket
+ * \param x Time of highest sample within the bracket
+ * \param elevation Elevation at x
+ * \return Time of maximum elevation
+ **/
+static predict_julian_date_t pass_solver_find_maximum(struct pass_solver *solver, double a, double b, double x, double elevation)
+{
+	const double golden_ratio = 0.3819660112501051;
+	double fx = -elevation;
+	double w = x;
+	double fw = fx;
+	double v = x;
+	double fv = fx;
+	double d = 0;
+	double e = 0;
+	for (int i=0; i < PASS_SOLVER_MAX_ITERATIONS; i++) {
+		double m = (a + b)/2.0;
+		double tol = PASS_SOLVER_MAXIMUM_TOLERANCE;
+		if (fabs(x - m) <= (2.0*tol - (b - a)/2.0)) {
+			break;
+		}
+
+		bool golden_section = true;
+		if (fabs(e) > tol) {
+			//fit parabola through x, v and w
+			double r = (x - w)*(fx - fv);
+			double q = (x - v)*(fx - fw);
+			double p = (x - v)*q - (x - w)*r;
+			q = 2.0*(q - r);
+			if (q > 0) {
+				p = -p;
+			}
+			q = fabs(q);
+			double prev_e = e;
+			e = d;
+			if ((fabs(p) < fabs(q*prev_e/2.0)) && (p > q*(a - x)) && (p < q*(b - x))) {
+				d = p/q;
+				double u = x + d;
+				if (((u - a) < 2.0*tol) || ((b - u) < 2.0*tol)) {
+					d = (m > x) ? tol : -tol;
+				}
+				golden_section = false;
+			}
+		}
+		if (golden_section) {
+			e = (x >= m) ? (a - x) : (b - x);
+			d = golden_ratio*e;
+		}
+
+		double u = x + ((fabs(d) >= tol) ? d : ((d > 0) ? tol : -tol));
+		double fu = -pass_solver_elevation(solver, u);
+		if (fu <= fx) {
+			if (u >= x) {
+				a = x;
+			} else {
+				b = x;
+			}
+			v = w;
+			fv = fw;
+			w = x;
+			fw = fx;
+			x = u;
+			fx = fu;
+		} else {
+			if (u < x) {
+				a = u;
+			} else {
+				b = u;
+			}
+			if ((fu <= fw) || (w == x)) {
+				v = w;
+				fv = fw;
+				w = u;
+				fw = fu;
+			} else if ((fu <= fv) || (v == x) || (v == w)) {
+				v = u;
+				fv = fu;
+			}
+		}
+	}
+	return x;
+}
+
+/**
+ * Find pass. See pass_solver_next_pass().
+ *
+ * \param solver Solver state
+ * \param start_time Start of search
+ * \param end_time End of AOS search
+ * \param ret_pass Returned pass
+ * \return Search status
+ **/
+static enum pass_solver_status pass_solver_find_pass(struct pass_solver *solver, predict_julian_date_t start_time, predict_julian_date_t end_time, struct pass_events *ret_pass)
+{
+	//samples above the horizon, in time order
+	double sample_time[PASS_SOLVER_MAX_SAMPLES];
+	double sample_elevation[PASS_SOLVER_MAX_SAMPLES];
+	int num_samples = 0;
+	bool samples_dropped = false;
+
+	predict_julian_date_t time = start_time;
+	double elevation = pass_solver_elevation(solver, time);
+	double altitude = solver->orbit.altitude;
+	predict_julian_date_t prev_time = time;
+	double prev_elevation = elevation;
+	predict_julian_date_t aos = time;
+
+	if (solver->orbit.decayed) {
+		return PASS_SOLVER_FAILED;
+	}
+
+	if (elevation >= 0) {
+		//pass in progress, step backwards to its AOS. Samples are stored in reverse order
+		sample_time[num_samples] = time;
+		sample_elevation[num_samples] = elevation;
+		num_samples++;
+		while (elevation >= 0) {
+			if (start_time - time > PASS_SOLVER_MAX_PASS_DURATION) {
+				return PASS_SOLVER_FAILED;
+			}
+			prev_time = time;
+			prev_elevation = elevation;
+			time -= pass_solver_step(elevation, solver->orbit.altitude);
+			elevation = pass_solver_elevation(solver, time);
+			if (elevation >= 0) {
+				if (num_samples < PASS_SOLVER_MAX_SAMPLES) {
+					sample_time[num_samples] = time;
+					sample_elevation[num_samples] = elevation;
+					num_samples++;
+				} else {
+					samples_dropped = true;
+				}
+			}
+		}
+		aos = root_finder_brent(pass_solver_elevation, solver, time, elevation, prev_time, prev_elevation, PASS_SOLVER_CROSSING_TOLERANCE);
+
+		for (int i=0; i < num_samples/2; i++) {
+			double temp_time = sample_time[i];
+			double temp_elevation = sample_elevation[i];
+			sample_time[i] = sample_time[num_samples-1-i];
+			sample_elevation[i] = sample_elevation[num_samples-1-i];
+			sample_time[num_samples-1-i] = temp_time;
+			sample_elevation[num_samples-1-i] = temp_elevation;
+		}
+		time = start_time;
+		elevation = sample_elevation[num_samples-1];
+	} else {
+		//step forward to AOS
+		while (elevation < 0) {
+			if (time > end_time) {
+				return PASS_SOLVER_NO_PASS;
+			}
+			prev_time = time;
+			prev_elevation = elevation;
+			time += pass_solver_step(elevation, solver->orbit.altitude);
+			elevation = pass_solver_elevation(solver, time);
+			if (solver->orbit.decayed) {
+				return PASS_SOLVER_FAILED;
+			}
+		}
+		altitude = solver->orbit.altitude;
+		sample_time[num_samples] = time;
+		sample_elevation[num_samples] = elevation;
+		num_samples++;
+		aos = root_finder_brent(pass_solver_elevation, solver, prev_time, prev_elevation, time, elevation, PASS_SOLVER_CROSSING_TOLERANCE);
+	}
+	ret_pass->aos = aos;
+	ret_pass->aos_azimuth = pass_solver_observation_at(solver, aos)->azimuth;
+
+	//step forward from the last sample to LOS
+	while (elevation >= 0) {
+		if (time - aos > PASS_SOLVER_MAX_PASS_DURATION) {
+			return PASS_SOLVER_FAILED;
+		}
+		prev_time = time;
+		prev_elevation = elevation;
+		time += pass_solver_step(elevation, altitude);
+		elevation = pass_solver_elevation(solver, time);
+		altitude = solver->orbit.altitude;
+		if (solver->orbit.decayed) {
+			return PASS_SOLVER_FAILED;
+		}
+		if (elevation >= 0) {
+			if (num_samples < PASS_SOLVER_MAX_SAMPLES) {
+				sample_time[num_samples] = time;
+				sample_elevation[num_samples] = elevation;
+				num_samples++;
+			} else {
+				samples_dropped = true;
+			}
+		}
+	}
+	predict_julian_date_t los = root_finder_brent(pass_solver_elevation, solver, prev_time, prev_elevation, time, elevation, PASS_SOLVER_CROSSING_TOLERANCE);
+	ret_pass->los = los;
+	ret_pass->los_azimuth = pass_solver_observation_at(solver, los)->azimuth;
+
+	//bracket maximum by the highest sample and its neighbours
+	int highest = 0;
+	for (int i=1; i < num_samples; i++) {
+		if (sample_elevation[i] > sample_elevation[highest]) {
+			highest = i;
+		}
+	}
+	double lower = aos;
+	double upper = los;
+	if (!samples_dropped) {
+		if (highest > 0) {
+			lower = sample_time[highest-1];
+		}
+		if (highest < num_samples-1) {
+			upper = sample_time[highest+1];
+		}
+	}
+	predict_julian_date_t max_elevation_time = pass_solver_find_maximum(solver, lower, upper, sample_time[highest], sample_elevation[highest]);
+	const struct predict_observation *max_elevation_obs = pass_solver_observation_at(solver, max_elevation_time);
+	ret_pass->max_elevation_time = max_elevation_time;
+	ret_pass->max_elevation = max_elevation_obs->elevation;
+	ret_pass->max_elevation_azimuth = max_elevation_obs->azimuth;
+	return PASS_SOLVER_PASS_FOUND;
+}
+
+enum pass_solver_status pass_solver_next_pass(const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct pass_events *ret_pass, int *ret_num_propagations)
+{
+	struct pass_solver solver = {0};
+	solver.observer = observer;
+	solver.orbital_elements = orbital_elements;
+
+	enum pass_solver_status status = pass_solver_find_pass(&solver, start_time, end_time, ret_pass);
+	if (ret_num_propagations != NULL) {
+		*ret_num_propagations = solver.num_propagations;
+	}
+	return status;
+}
@@ -0,0 +1,66 @@
+#ifndef PASS_SOLVER_H_DEFINED
+#define PASS_SOLVER_H_DEFINED
+
+#include <predict/predict.h>
+
+/**
+ * Solver for the events of a satellite pass (AOS, LOS and time of closest approach), found from a single sweep
+ * over the pass.
+ *
+ * The elevation is sampled in coarse steps, large when the satellite is far below the horizon and smaller
+ * above it. The horizon crossings are bracketed by consecutive samples on each side of the horizon, and the
+ * maximum elevation by the highest sample and its neighbours. Each bracket is then refined using Brent's
+ * method: root finding for the crossings, and parabolic interpolation/golden section search for the maximum.
+ * All samples are shared between the three events, unlike separate calls to predict_next_aos(),
+ * predict_next_los() and predict_at_max_elevation(), which each start their own search.
+ **/
+
+/**
+ * Events of a single satellite pass.
+ **/
+struct pass_events {
+	///Time of AOS
+	predict_julian_date_t aos;
+	///Time of LOS
+	predict_julian_date_t los;
+	///Time of closest approach (maximum elevation)
+	predict_julian_date_t max_elevation_time;
+	///Maximum elevation (radians)
+	double max_elevation;
+	///Azimuth at AOS (radians)
+	double aos_azimuth;
+	///Azimuth at LOS (radians)
+	double los_azimuth;
+	///Azimuth at maximum elevation (radians)
+	double max_elevation_azimuth;
+};
+
+/**
+ * Return values of pass_solver_next_pass().
+ **/
+enum pass_solver_status {
+	///Pass was found
+	PASS_SOLVER_PASS_FOUND,
+	///Satellite stays below the horizon until the end of the search
+	PASS_SOLVER_NO_PASS,
+	///Satellite decayed during the search, or the pass did not end within a day
+	PASS_SOLVER_FAILED
+};
+
+/**
+ * Find the current or next pass of a satellite, i.e. the first pass with LOS after the given time. When the
+ * satellite is above the horizon at the start time, the pass in progress is returned with its actual AOS,
+ * which is before the start time. The satellite should not be geosynchronous, and should be able to rise above
+ * the horizon of the observer (see predict_is_geosynchronous() and predict_aos_happens()).
+ *
+ * \param observer Observer
+ * \param orbital_elements Orbital elements of satellite
+ * \param start_time Start of search
+ * \param end_time Time after which the search for an AOS is abandoned
+ * \param ret_pass Returned pass
+ * \param ret_num_propagations Returned number of orbit propagations used in the search. Can be NULL
+ * \return PASS_SOLVER_PASS_FOUND if a pass was found and ret_pass was set, PASS_SOLVER_NO_PASS or PASS_SOLVER_FAILED otherwise
+ **/
+enum pass_solver_status pass_solver_next_pass(const predict_observer_t *observer, const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct pass_events *ret_pass, int *ret_num_propagations);
+
+#endif
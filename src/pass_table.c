@@ -0,0 +1,341 @@
+#include "pass_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//interval between extensions of the rolling window when there is nothing else to do (seconds)
+#define PASS_TABLE_UPDATE_INTERVAL 10
+
+//time step used for starting the search for the next pass after a LOS (days)
+#define PASS_TABLE_TIME_STEP (1.0/86400.0)
+
+/**
+ * Mark start of modification of an entry, invalidating concurrent reads.
+ *
+ * \param entry Pass table entry
+ **/
+static void pass_table_write_begin(struct pass_table_entry *entry)
+{
+	__atomic_store_n(&(entry->sequence), entry->sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * Mark end of modification of an entry.
+ *
+ * \param entry Pass table entry
+ **/
+static void pass_table_write_end(struct pass_table_entry *entry)
+{
+	__atomic_store_n(&(entry->sequence), entry->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Clear the passes of a satellite, so that they are recomputed from the current time.
+ *
+ * \param pass_table Pass table
+ * \param entry Pass table entry
+ * \param time Current time
+ **/
+static void pass_table_reset_entry(struct pass_table *pass_table, struct pass_table_entry *entry, predict_julian_date_t time)
+{
+	const predict_orbital_elements_t *orbital_elements = entry->orbital_elements;
+	bool can_predict = false;
+	if (orbital_elements != NULL) {
+		struct predict_position orbit;
+		predict_orbit(orbital_elements, &orbit, time);
+		can_predict = !predict_is_geosynchronous(orbital_elements) && predict_aos_happens(orbital_elements, pass_table->observer.latitude) && !(orbit.decayed);
+	}
+
+	pass_table_write_begin(entry);
+	entry->computed_update = entry->applied_update;
+	entry->computed_observer_update = pass_table->applied_observer_update;
+	entry->can_predict = can_predict;
+	entry->valid_from = time;
+	entry->valid_until = time;
+	entry->first_pass = 0;
+	entry->num_passes = 0;
+	pass_table_write_end(entry);
+
+	entry->reset = false;
+	entry->exhausted = !can_predict;
+}
+
+/**
+ * Drop passes that have ended.
+ *
+ * \param entry Pass table entry
+ * \param time Current time
+ **/
+static void pass_table_drop_passes(struct pass_table_entry *entry, predict_julian_date_t time)
+{
+	if ((entry->num_passes == 0) || (entry->passes[entry->first_pass].los >= time)) {
+		return;
+	}
+
+	pass_table_write_begin(entry);
+	while ((entry->num_passes > 0) && (entry->passes[entry->first_pass].los < time)) {
+		entry->valid_from = entry->passes[entry->first_pass].los;
+		entry->first_pass = (entry->first_pass + 1) % PASS_TABLE_MAX_PASSES;
+		entry->num_passes--;
+	}
+	pass_table_write_end(entry);
+}
+
+/**
+ * Append the next pass of a satellite, if the passes do not already cover the window. The first pass
+ * after a reset can be in progress.
+ *
+ * \param pass_table Pass table
+ * \param entry Pass table entry
+ * \param end End of window
+ * \return True if a pass was appended, false otherwise
+ **/
+static bool pass_table_extend_entry(struct pass_table *pass_table, struct pass_table_entry *entry, predict_julian_date_t end)
+{
+	if (entry->exhausted || (entry->valid_until >= end) || (entry->num_passes >= PASS_TABLE_MAX_PASSES)) {
+		return false;
+	}
+
+	struct pass_events pass;
+	enum pass_solver_status status = pass_solver_next_pass(&(pass_table->observer), entry->orbital_elements, entry->valid_until, end, &pass, NULL);
+	if (status == PASS_SOLVER_FAILED) {
+		//leave the remaining passes to libpredict
+		entry->exhausted = true;
+		return false;
+	}
+
+	pass_table_write_begin(entry);
+	if (status == PASS_SOLVER_PASS_FOUND) {
+		entry->passes[(entry->first_pass + entry->num_passes) % PASS_TABLE_MAX_PASSES] = pass;
+		entry->num_passes++;
+		entry->valid_until = pass.los + PASS_TABLE_TIME_STEP;
+	} else {
+		//no passes until the end of the window
+		entry->valid_until = end;
+	}
+	pass_table_write_end(entry);
+	return status == PASS_SOLVER_PASS_FOUND;
+}
+
+/**
+ * Pick up pending observer and orbital elements. Mutex must be locked.
+ *
+ * \param pass_table Pass table
+ **/
+static void pass_table_apply_pending(struct pass_table *pass_table)
+{
+	bool reset_all = false;
+	if (pass_table->pending_observer_changed) {
+		pass_table->observer = pass_table->pending_observer;
+		pass_table->pending_observer_changed = false;
+		pass_table->applied_observer_update = pass_table->requested_observer_update;
+		reset_all = true;
+	}
+
+	for (int i=0; i < pass_table->num_entries; i++) {
+		struct pass_table_entry *entry = &(pass_table->entries[i]);
+		if (entry->pending) {
+			if (entry->orbital_elements != NULL) {
+				predict_destroy_orbital_elements(entry->orbital_elements);
+			}
+			entry->orbital_elements = entry->pending_orbital_elements;
+			entry->pending_orbital_elements = NULL;
+			entry->pending = false;
+			entry->applied_update = entry->requested_update;
+			entry->reset = true;
+		}
+		if (reset_all) {
+			entry->reset = true;
+		}
+	}
+	__atomic_store_n(&(pass_table->has_pending), false, __ATOMIC_RELAXED);
+}
+
+/**
+ * Background thread maintaining the pass table.
+ *
+ * \param data Pass table
+ * \return NULL
+ **/
+static void *pass_table_thread(void *data)
+{
+	struct pass_table *pass_table = (struct pass_table*)data;
+
+	pthread_mutex_lock(&(pass_table->mutex));
+	while (!pass_table->shutdown) {
+		pass_table_apply_pending(pass_table);
+		pthread_mutex_unlock(&(pass_table->mutex));
+
+		predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+		for (int i=0; (i < pass_table->num_entries) && !__atomic_load_n(&(pass_table->has_pending), __ATOMIC_RELAXED); i++) {
+			if (pass_table->entries[i].reset) {
+				pass_table_reset_entry(pass_table, &(pass_table->entries[i]), curr_time);
+			}
+		}
+
+		//add one pass per satellite in each sweep, so that all satellites get their next pass first
+		bool extended = false;
+		for (int i=0; (i < pass_table->num_entries) && !__atomic_load_n(&(pass_table->has_pending), __ATOMIC_RELAXED); i++) {
+			struct pass_table_entry *entry = &(pass_table->entries[i]);
+			if (entry->reset) {
+				continue;
+			}
+			pass_table_drop_passes(entry, curr_time);
+			if (pass_table_extend_entry(pass_table, entry, curr_time + pass_table->window)) {
+				extended = true;
+			}
+		}
+
+		pthread_mutex_lock(&(pass_table->mutex));
+		if (!extended && !pass_table->has_pending && !pass_table->shutdown) {
+			struct timespec timeout;
+			clock_gettime(CLOCK_REALTIME, &timeout);
+			timeout.tv_sec += PASS_TABLE_UPDATE_INTERVAL;
+			pthread_cond_timedwait(&(pass_table->cond), &(pass_table->mutex), &timeout);
+		}
+	}
+	pthread_mutex_unlock(&(pass_table->mutex));
+	return NULL;
+}
+
+struct pass_table *pass_table_create(const predict_observer_t *observer, const struct tle_db *tle_db, double window)
+{
+	struct pass_table *pass_table = (struct pass_table*)calloc(1, sizeof(struct pass_table));
+	pass_table->num_entries = tle_db->num_tles;
+	pass_table->entries = (struct pass_table_entry*)calloc(tle_db->num_tles, sizeof(struct pass_table_entry));
+	pass_table->window = window;
+	pass_table->observer = *observer;
+	pthread_mutex_init(&(pass_table->mutex), NULL);
+	pthread_cond_init(&(pass_table->cond), NULL);
+
+	//process all entries once, so that disabled satellites are marked as such
+	for (int i=0; i < pass_table->num_entries; i++) {
+		pass_table->entries[i].pending = true;
+	}
+	pass_table_refresh(pass_table, tle_db);
+
+	pass_table->thread_running = (pthread_create(&(pass_table->thread), NULL, pass_table_thread, pass_table) == 0);
+	return pass_table;
+}
+
+void pass_table_destroy(struct pass_table **pass_table)
+{
+	pthread_mutex_lock(&((*pass_table)->mutex));
+	(*pass_table)->shutdown = true;
+	__atomic_store_n(&((*pass_table)->has_pending), true, __ATOMIC_RELAXED); //interrupt ongoing computations
+	pthread_cond_signal(&((*pass_table)->cond));
+	pthread_mutex_unlock(&((*pass_table)->mutex));
+	if ((*pass_table)->thread_running) {
+		pthread_join((*pass_table)->thread, NULL);
+	}
+
+	for (int i=0; i < (*pass_table)->num_entries; i++) {
+		struct pass_table_entry *entry = &((*pass_table)->entries[i]);
+		if (entry->orbital_elements != NULL) {
+			predict_destroy_orbital_elements(entry->orbital_elements);
+		}
+		if (entry->pending_orbital_elements != NULL) {
+			predict_destroy_orbital_elements(entry->pending_orbital_elements);
+		}
+	}
+	pthread_cond_destroy(&((*pass_table)->cond));
+	pthread_mutex_destroy(&((*pass_table)->mutex));
+	free((*pass_table)->entries);
+	free(*pass_table);
+	*pass_table = NULL;
+}
+
+/**
+ * Set pending orbital elements of entry. Mutex must be locked.
+ *
+ * \param entry Pass table entry
+ * \param orbital_elements New orbital elements, or NULL
+ **/
+static void pass_table_set_pending(struct pass_table_entry *entry, predict_orbital_elements_t *orbital_elements)
+{
+	if (entry->pending_orbital_elements != NULL) {
+		predict_destroy_orbital_elements(entry->pending_orbital_elements);
+	}
+	entry->pending_orbital_elements = orbital_elements;
+	entry->pending = true;
+	__atomic_store_n(&(entry->requested_update), entry->requested_update + 1, __ATOMIC_RELEASE);
+}
+
+void pass_table_refresh(struct pass_table *pass_table, const struct tle_db *tle_db)
+{
+	int num_entries = pass_table->num_entries;
+	if (tle_db->num_tles < num_entries) {
+		num_entries = tle_db->num_tles;
+	}
+
+	pthread_mutex_lock(&(pass_table->mutex));
+	for (int i=0; i < num_entries; i++) {
+		struct pass_table_entry *entry = &(pass_table->entries[i]);
+		const struct tle_db_entry *tle = tle_db_get_entry(tle_db, i);
+		bool enabled = tle_db_entry_enabled(tle_db, i);
+		bool was_enabled = (strlen(entry->line1) > 0);
+
+		if (enabled && (!was_enabled || (strcmp(entry->line1, tle->line1) != 0) || (strcmp(entry->line2, tle->line2) != 0))) {
+			memcpy(entry->line1, tle->line1, TLE_LINE_LENGTH);
+			memcpy(entry->line2, tle->line2, TLE_LINE_LENGTH);
+			entry->line1[TLE_LINE_LENGTH] = '\0';
+			entry->line2[TLE_LINE_LENGTH] = '\0';
+			pass_table_set_pending(entry, predict_parse_tle(tle->line1, tle->line2));
+		} else if (!enabled && was_enabled) {
+			entry->line1[0] = '\0';
+			entry->line2[0] = '\0';
+			pass_table_set_pending(entry, NULL);
+		}
+		if (entry->pending) {
+			__atomic_store_n(&(pass_table->has_pending), true, __ATOMIC_RELAXED);
+		}
+	}
+	if (pass_table->has_pending) {
+		pthread_cond_signal(&(pass_table->cond));
+	}
+	pthread_mutex_unlock(&(pass_table->mutex));
+}
+
+void pass_table_set_observer(struct pass_table *pass_table, const predict_observer_t *observer)
+{
+	pthread_mutex_lock(&(pass_table->mutex));
+	pass_table->pending_observer = *observer;
+	pass_table->pending_observer_changed = true;
+	__atomic_store_n(&(pass_table->requested_observer_update), pass_table->requested_observer_update + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&(pass_table->has_pending), true, __ATOMIC_RELAXED);
+	pthread_cond_signal(&(pass_table->cond));
+	pthread_mutex_unlock(&(pass_table->mutex));
+}
+
+enum pass_table_status pass_table_next_pass(struct pass_table *pass_table, int index, predict_julian_date_t time, struct pass_events *ret_pass)
+{
+	if ((index < 0) || (index >= pass_table->num_entries)) {
+		return PASS_TABLE_NOT_COMPUTED;
+	}
+
+	const struct pass_table_entry *entry = &(pass_table->entries[index]);
+	enum pass_table_status status = PASS_TABLE_NOT_COMPUTED;
+	unsigned int sequence;
+	do {
+		sequence = __atomic_load_n(&(entry->sequence), __ATOMIC_ACQUIRE);
+		status = PASS_TABLE_NOT_COMPUTED;
+		bool outdated = (entry->computed_update != __atomic_load_n(&(entry->requested_update), __ATOMIC_ACQUIRE)) || (entry->computed_observer_update != __atomic_load_n(&(pass_table->requested_observer_update), __ATOMIC_ACQUIRE));
+		if ((entry->valid_until == 0) || outdated) {
+			//not processed by the background thread yet
+		} else if (!entry->can_predict) {
+			status = PASS_TABLE_NO_PASSES;
+		} else if ((time >= entry->valid_from) && (time < entry->valid_until)) {
+			for (int i=0; i < entry->num_passes; i++) {
+				const struct pass_events *pass = &(entry->passes[(entry->first_pass + i) % PASS_TABLE_MAX_PASSES]);
+				if (pass->los > time) {
+					*ret_pass = *pass;
+					status = PASS_TABLE_PASS_FOUND;
+					break;
+				}
+			}
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while ((sequence & 1) || (__atomic_load_n(&(entry->sequence), __ATOMIC_RELAXED) != sequence));
+	return status;
+}
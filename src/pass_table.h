@@ -0,0 +1,160 @@
+#ifndef PASS_TABLE_H_DEFINED
+#define PASS_TABLE_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+#include <predict/predict.h>
+#include "tle_db.h"
+#include "pass_solver.h"
+
+/**
+ * Table of upcoming passes of all enabled satellites, maintained by a background thread.
+ *
+ * The background thread computes the passes of each satellite from the current time and over a rolling
+ * window using the pass solver, extending the table as time advances and dropping passes that have ended.
+ * Satellites are processed breadth-first, so that the next pass of every satellite is available before the
+ * table is extended further.
+ *
+ * The passes of each satellite are protected by a sequence counter. Readers copy the passes they need
+ * and retry if the background thread modified them in the meantime, so that reading never blocks.
+ **/
+
+///Maximum number of passes stored for each satellite. Limits the effective window for satellites with many passes.
+#define PASS_TABLE_MAX_PASSES 64
+
+/**
+ * Passes of a single satellite.
+ **/
+struct pass_table_entry {
+	///Sequence counter, odd while the fields below are being modified by the background thread
+	unsigned int sequence;
+	///Whether passes can be predicted for the satellite. False for disabled, geostationary, never rising and decayed satellites
+	bool can_predict;
+	///Time from which the passes are complete
+	predict_julian_date_t valid_from;
+	///Time until which the passes are complete
+	predict_julian_date_t valid_until;
+	///Index of the first pass in the ring buffer
+	int first_pass;
+	///Number of passes in the ring buffer
+	int num_passes;
+	///Ring buffer of passes, in time order
+	struct pass_events passes[PASS_TABLE_MAX_PASSES];
+	///Value of requested_update the passes were computed for
+	unsigned int computed_update;
+	///Value of the observer update counter of the table the passes were computed for
+	unsigned int computed_observer_update;
+
+	///Orbital elements used by the background thread
+	predict_orbital_elements_t *orbital_elements;
+	///Whether the passes should be recomputed from scratch. Only accessed by the background thread
+	bool reset;
+	///Whether no more passes can be found. Only accessed by the background thread
+	bool exhausted;
+	///Replacement orbital elements, NULL for disabling the satellite. Protected by the mutex
+	predict_orbital_elements_t *pending_orbital_elements;
+	///Whether the orbital elements should be replaced. Protected by the mutex
+	bool pending;
+	///Incremented for each replacement of the orbital elements, so that readers can ignore outdated passes. Modified under the mutex
+	unsigned int requested_update;
+	///Value of requested_update when the orbital elements were last picked up. Only accessed by the background thread
+	unsigned int applied_update;
+	///TLE lines the orbital elements were parsed from, used for detecting changes in the TLE database. Only accessed by the UI
+	char line1[TLE_LINE_LENGTH+1];
+	char line2[TLE_LINE_LENGTH+1];
+};
+
+/**
+ * Pass table.
+ **/
+struct pass_table {
+	///Number of satellites, corresponding to the entries in the TLE database
+	int num_entries;
+	///Passes of each satellite
+	struct pass_table_entry *entries;
+	///Length of the rolling window (days)
+	double window;
+	///Background thread
+	pthread_t thread;
+	///Whether the background thread is running
+	bool thread_running;
+	///Mutex protecting the pending changes
+	pthread_mutex_t mutex;
+	///Signalled when there are pending changes, or on shutdown
+	pthread_cond_t cond;
+	///Whether there are pending changes to be picked up by the background thread. Protected by the mutex, but polled without it
+	bool has_pending;
+	///Whether the background thread should exit
+	bool shutdown;
+	///Observer used by the background thread
+	predict_observer_t observer;
+	///Replacement observer. Protected by the mutex
+	predict_observer_t pending_observer;
+	///Whether the observer should be replaced. Protected by the mutex
+	bool pending_observer_changed;
+	///Incremented for each replacement of the observer, so that readers can ignore outdated passes. Modified under the mutex
+	unsigned int requested_observer_update;
+	///Value of requested_observer_update when the observer was last picked up. Only accessed by the background thread
+	unsigned int applied_observer_update;
+};
+
+/**
+ * Return values of pass_table_next_pass().
+ **/
+enum pass_table_status {
+	///Pass was found
+	PASS_TABLE_PASS_FOUND,
+	///Pass table does not cover the given time yet
+	PASS_TABLE_NOT_COMPUTED,
+	///Satellite has no predictable passes
+	PASS_TABLE_NO_PASSES
+};
+
+/**
+ * Create pass table for the enabled satellites in the TLE database, and start the background thread.
+ *
+ * \param observer Observer, copied into the table
+ * \param tle_db TLE database
+ * \param window Length of the rolling window (days)
+ * \return Pass table
+ **/
+struct pass_table *pass_table_create(const predict_observer_t *observer, const struct tle_db *tle_db, double window);
+
+/**
+ * Stop background thread and free pass table.
+ *
+ * \param pass_table Pass table
+ **/
+void pass_table_destroy(struct pass_table **pass_table);
+
+/**
+ * Pick up changes in the TLE database. Satellites that have been enabled, disabled or have changed TLEs
+ * are recomputed, the rest are left untouched.
+ *
+ * \param pass_table Pass table
+ * \param tle_db TLE database
+ **/
+void pass_table_refresh(struct pass_table *pass_table, const struct tle_db *tle_db);
+
+/**
+ * Replace the observer, and recompute all passes.
+ *
+ * \param pass_table Pass table
+ * \param observer Observer, copied into the table
+ **/
+void pass_table_set_observer(struct pass_table *pass_table, const predict_observer_t *observer);
+
+/**
+ * Get the current or next pass of a satellite, i.e. the first pass with LOS after the given time. Does not block.
+ * Passes computed for replaced orbital elements or observer are not returned.
+ *
+ * \param pass_table Pass table
+ * \param index Index of the satellite in the TLE database
+ * \param time Time
+ * \param ret_pass Returned pass
+ * \return PASS_TABLE_PASS_FOUND if ret_pass was set, otherwise PASS_TABLE_NOT_COMPUTED or PASS_TABLE_NO_PASSES.
+ * Passes have to be predicted using libpredict in both cases
+ **/
+enum pass_table_status pass_table_next_pass(struct pass_table *pass_table, int index, predict_julian_date_t time, struct pass_events *ret_pass);
+
+#endif
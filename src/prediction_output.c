@@ -0,0 +1,427 @@
+#include "prediction_output.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include "defines.h"
+
+//maximum length of iCalendar content lines, excluding the line break (octets)
+#define ICS_MAX_LINE_LENGTH 75
+
+/**
+ * Write buffered data to the output file.
+ *
+ * \param writer Buffered writer
+ **/
+static void buffered_writer_flush(struct buffered_writer *writer)
+{
+	if ((writer->length > 0) && (fwrite(writer->buffer, 1, writer->length, writer->file) != writer->length)) {
+		writer->failed = true;
+	}
+	writer->length = 0;
+}
+
+/**
+ * Append data to the buffer, flushing the buffer when full.
+ *
+ * \param writer Buffered writer
+ * \param data Data
+ * \param length Length of data
+ **/
+static void buffered_writer_write(struct buffered_writer *writer, const char *data, size_t length)
+{
+	if (writer->length + length > PREDICTION_OUTPUT_BUFFER_SIZE) {
+		buffered_writer_flush(writer);
+	}
+	if (length > PREDICTION_OUTPUT_BUFFER_SIZE) {
+		if (fwrite(data, 1, length, writer->file) != length) {
+			writer->failed = true;
+		}
+		return;
+	}
+	memcpy(writer->buffer + writer->length, data, length);
+	writer->length += length;
+}
+
+/**
+ * Format data directly into the buffer, flushing the buffer when the formatted data does not fit.
+ *
+ * \param writer Buffered writer
+ * \param format Format string, as in printf()
+ **/
+static void buffered_writer_printf(struct buffered_writer *writer, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	size_t remaining = PREDICTION_OUTPUT_BUFFER_SIZE - writer->length;
+	int length = vsnprintf(writer->buffer + writer->length, remaining, format, args);
+	va_end(args);
+	if (length < 0) {
+		writer->failed = true;
+		return;
+	}
+	if ((size_t)length < remaining) {
+		writer->length += length;
+		return;
+	}
+
+	//did not fit, retry in an empty buffer or write directly when larger than the buffer
+	buffered_writer_flush(writer);
+	va_start(args, format);
+	if ((size_t)length < PREDICTION_OUTPUT_BUFFER_SIZE) {
+		vsnprintf(writer->buffer, PREDICTION_OUTPUT_BUFFER_SIZE, format, args);
+		writer->length = length;
+	} else if (vfprintf(writer->file, format, args) < 0) {
+		writer->failed = true;
+	}
+	va_end(args);
+}
+
+bool prediction_output_format_from_string(const char *name, enum prediction_output_format *ret_format)
+{
+	if (strcmp(name, "text") == 0) {
+		*ret_format = PREDICTION_OUTPUT_TEXT;
+	} else if (strcmp(name, "csv") == 0) {
+		*ret_format = PREDICTION_OUTPUT_CSV;
+	} else if (strcmp(name, "jsonl") == 0) {
+		*ret_format = PREDICTION_OUTPUT_JSONL;
+	} else if (strcmp(name, "ics") == 0) {
+		*ret_format = PREDICTION_OUTPUT_ICS;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Format time as ISO 8601 in UTC with milliseconds, e.g. 2024-01-01T12:00:00.000Z.
+ *
+ * \param time Time
+ * \param ret_string Returned string, at least MAX_NUM_CHARS long
+ **/
+static void prediction_output_iso_time(predict_julian_date_t time, char *ret_string)
+{
+	long long milliseconds = llround((time*SECDAY + JULIAN_EPOCH_UNIX_TIME)*1000.0);
+	time_t epoch = milliseconds/1000;
+	struct tm utc;
+	gmtime_r(&epoch, &utc);
+	size_t length = strftime(ret_string, MAX_NUM_CHARS, "%Y-%m-%dT%H:%M:%S", &utc);
+	snprintf(ret_string + length, MAX_NUM_CHARS - length, ".%03dZ", (int)(milliseconds % 1000));
+}
+
+/**
+ * Format time as iCalendar UTC date-time, e.g. 20240101T120000Z.
+ *
+ * \param epoch Time
+ * \param ret_string Returned string, at least MAX_NUM_CHARS long
+ **/
+static void prediction_output_ics_time(time_t epoch, char *ret_string)
+{
+	struct tm utc;
+	gmtime_r(&epoch, &utc);
+	strftime(ret_string, MAX_NUM_CHARS, "%Y%m%dT%H%M%SZ", &utc);
+}
+
+/**
+ * Convert time to the nearest UNIX timestamp.
+ *
+ * \param time Time
+ * \return UNIX timestamp
+ **/
+static time_t prediction_output_epoch(predict_julian_date_t time)
+{
+	return (time_t)llround(time*SECDAY + JULIAN_EPOCH_UNIX_TIME);
+}
+
+/**
+ * Write string as CSV field, quoted when it contains separators, quotes or line breaks.
+ *
+ * \param writer Buffered writer
+ * \param string String
+ **/
+static void prediction_output_csv_string(struct buffered_writer *writer, const char *string)
+{
+	if (strpbrk(string, ",\"\r\n") == NULL) {
+		buffered_writer_write(writer, string, strlen(string));
+		return;
+	}
+
+	buffered_writer_write(writer, "\"", 1);
+	for (const char *c = string; *c != '\0'; c++) {
+		if (*c == '"') {
+			buffered_writer_write(writer, "\"", 1);
+		}
+		buffered_writer_write(writer, c, 1);
+	}
+	buffered_writer_write(writer, "\"", 1);
+}
+
+/**
+ * Write string as quoted JSON string.
+ *
+ * \param writer Buffered writer
+ * \param string String
+ **/
+static void prediction_output_json_string(struct buffered_writer *writer, const char *string)
+{
+	buffered_writer_write(writer, "\"", 1);
+	for (const char *c = string; *c != '\0'; c++) {
+		if ((*c == '"') || (*c == '\\')) {
+			buffered_writer_write(writer, "\\", 1);
+			buffered_writer_write(writer, c, 1);
+		} else if ((unsigned char)*c < 0x20) {
+			buffered_writer_printf(writer, "\\u%04x", (unsigned char)*c);
+		} else {
+			buffered_writer_write(writer, c, 1);
+		}
+	}
+	buffered_writer_write(writer, "\"", 1);
+}
+
+/**
+ * Write iCalendar content line, folded at ICS_MAX_LINE_LENGTH octets without splitting UTF-8 characters.
+ *
+ * \param writer Buffered writer
+ * \param format Format string, as in printf()
+ **/
+static void prediction_output_ics_line(struct buffered_writer *writer, const char *format, ...)
+{
+	char line[MAX_NUM_CHARS];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, MAX_NUM_CHARS, format, args);
+	va_end(args);
+
+	size_t length = strlen(line);
+	size_t start = 0;
+	int max_length = ICS_MAX_LINE_LENGTH;
+	while (length - start > max_length) {
+		size_t end = start + max_length;
+		while ((end > start + 1) && (((unsigned char)line[end] & 0xC0) == 0x80)) {
+			end--;
+		}
+		buffered_writer_write(writer, line + start, end - start);
+		buffered_writer_write(writer, "\r\n ", 3);
+		start = end;
+
+		//continuation lines start with a space
+		max_length = ICS_MAX_LINE_LENGTH - 1;
+	}
+	buffered_writer_write(writer, line + start, length - start);
+	buffered_writer_write(writer, "\r\n", 2);
+}
+
+/**
+ * Escape text for iCalendar TEXT values.
+ *
+ * \param string String
+ * \param ret_string Returned escaped string, at least MAX_NUM_CHARS long
+ **/
+static void prediction_output_ics_escape(const char *string, char *ret_string)
+{
+	size_t length = 0;
+	for (const char *c = string; (*c != '\0') && (length < MAX_NUM_CHARS - 3); c++) {
+		if ((*c == '\\') || (*c == ';') || (*c == ',')) {
+			ret_string[length++] = '\\';
+			ret_string[length++] = *c;
+		} else if (*c == '\n') {
+			ret_string[length++] = '\\';
+			ret_string[length++] = 'n';
+		} else {
+			ret_string[length++] = *c;
+		}
+	}
+	ret_string[length] = '\0';
+}
+
+/**
+ * Write the CSV header for the given record type if the previous record was of a different type.
+ *
+ * \param output Output sink
+ * \param record Record type
+ **/
+static void prediction_output_begin_record(struct prediction_output *output, enum prediction_output_record record)
+{
+	if ((output->format == PREDICTION_OUTPUT_CSV) && (output->last_record != record)) {
+		if (output->last_record != PREDICTION_OUTPUT_RECORD_NONE) {
+			buffered_writer_write(&(output->writer), "\n", 1);
+		}
+		if (record == PREDICTION_OUTPUT_RECORD_PASS) {
+			buffered_writer_printf(&(output->writer), "satellite,satellite_number,aos,los,max_elevation,time,elevation,azimuth,phase,latitude,longitude,range,revolutions,visibility\n");
+		} else {
+			buffered_writer_printf(&(output->writer), "body,event,time,azimuth,elevation\n");
+		}
+	}
+	output->last_record = record;
+}
+
+struct prediction_output *prediction_output_create(FILE *file, enum prediction_output_format format)
+{
+	struct prediction_output *output = (struct prediction_output*)calloc(1, sizeof(struct prediction_output));
+	output->format = format;
+	output->writer.file = file;
+	output->last_record = PREDICTION_OUTPUT_RECORD_NONE;
+	output->creation_time = time(NULL);
+
+	if (format == PREDICTION_OUTPUT_ICS) {
+		prediction_output_ics_line(&(output->writer), "BEGIN:VCALENDAR");
+		prediction_output_ics_line(&(output->writer), "VERSION:2.0");
+		prediction_output_ics_line(&(output->writer), "PRODID:-//flyby//Pass predictions//EN");
+		prediction_output_ics_line(&(output->writer), "CALSCALE:GREGORIAN");
+	}
+	return output;
+}
+
+bool prediction_output_destroy(struct prediction_output **output)
+{
+	if (*output == NULL) {
+		return true;
+	}
+
+	if ((*output)->format == PREDICTION_OUTPUT_ICS) {
+		prediction_output_ics_line(&((*output)->writer), "END:VCALENDAR");
+	}
+	buffered_writer_flush(&((*output)->writer));
+	bool success = !((*output)->writer.failed) && (fflush((*output)->writer.file) == 0);
+
+	free(*output);
+	*output = NULL;
+	return success;
+}
+
+/**
+ * Get name of the visibility of a pass step.
+ *
+ * \param visibility Visibility character of the step
+ * \return "visible", "sunlit" or "eclipsed"
+ **/
+static const char *prediction_output_visibility_name(char visibility)
+{
+	switch (visibility) {
+		case '+':
+			return "visible";
+		case '*':
+			return "sunlit";
+		default:
+			return "eclipsed";
+	}
+}
+
+void prediction_output_pass(struct prediction_output *output, const char *name, long satellite_number, const struct pass_prediction *pass)
+{
+	struct buffered_writer *writer = &(output->writer);
+	char aos_string[MAX_NUM_CHARS];
+	char los_string[MAX_NUM_CHARS];
+	char time_string[MAX_NUM_CHARS];
+	prediction_output_begin_record(output, PREDICTION_OUTPUT_RECORD_PASS);
+
+	switch (output->format) {
+		case PREDICTION_OUTPUT_TEXT: {
+			time_t epoch = predict_from_julian(pass->events.aos);
+			strftime(aos_string, MAX_NUM_CHARS, "%Y-%m-%dT%H:%M:%SZ", gmtime(&epoch));
+			epoch = predict_from_julian(pass->events.los);
+			strftime(los_string, MAX_NUM_CHARS, "%Y-%m-%dT%H:%M:%SZ", gmtime(&epoch));
+			buffered_writer_printf(writer, "%s (%ld)  AOS %s  LOS %s  Max elevation %.1f\n", name, satellite_number, aos_string, los_string, pass->events.max_elevation*180.0/M_PI);
+
+			for (int i=0; i < pass->num_steps; i++) {
+				const struct pass_prediction_step *step = &(pass->steps[i]);
+				epoch = predict_from_julian(step->time);
+				strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
+
+				//modulo 256 phase
+				int ma256 = (int)rint(256.0*(step->phase/(2*M_PI)));
+
+				buffered_writer_printf(writer, "      %s%4d %4d  %4d  %4d   %4d   %6ld  %6ld %c\n", time_string, (int)(step->elevation*180.0/M_PI), (int)(step->azimuth*180.0/M_PI), ma256, (int)(step->latitude*180.0/M_PI), (int)(step->longitude*180.0/M_PI), (long)(step->range), step->revolutions, step->visibility);
+			}
+			buffered_writer_write(writer, "\n", 1);
+			break;
+		}
+		case PREDICTION_OUTPUT_CSV:
+			prediction_output_iso_time(pass->events.aos, aos_string);
+			prediction_output_iso_time(pass->events.los, los_string);
+			for (int i=0; i < pass->num_steps; i++) {
+				const struct pass_prediction_step *step = &(pass->steps[i]);
+				prediction_output_iso_time(step->time, time_string);
+				prediction_output_csv_string(writer, name);
+				buffered_writer_printf(writer, ",%ld,%s,%s,%.3f,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%ld,%s\n", satellite_number, aos_string, los_string, pass->events.max_elevation*180.0/M_PI, time_string, step->elevation*180.0/M_PI, step->azimuth*180.0/M_PI, step->phase*180.0/M_PI, step->latitude*180.0/M_PI, step->longitude*180.0/M_PI, step->range, step->revolutions, prediction_output_visibility_name(step->visibility));
+			}
+			break;
+		case PREDICTION_OUTPUT_JSONL: {
+			char max_elevation_string[MAX_NUM_CHARS];
+			prediction_output_iso_time(pass->events.aos, aos_string);
+			prediction_output_iso_time(pass->events.los, los_string);
+			prediction_output_iso_time(pass->events.max_elevation_time, max_elevation_string);
+			buffered_writer_printf(writer, "{\"satellite\":");
+			prediction_output_json_string(writer, name);
+			buffered_writer_printf(writer, ",\"satellite_number\":%ld,\"aos\":\"%s\",\"aos_azimuth\":%.3f,\"max_elevation_time\":\"%s\",\"max_elevation\":%.3f,\"max_elevation_azimuth\":%.3f,\"los\":\"%s\",\"los_azimuth\":%.3f,\"steps\":[", satellite_number, aos_string, pass->events.aos_azimuth*180.0/M_PI, max_elevation_string, pass->events.max_elevation*180.0/M_PI, pass->events.max_elevation_azimuth*180.0/M_PI, los_string, pass->events.los_azimuth*180.0/M_PI);
+			for (int i=0; i < pass->num_steps; i++) {
+				const struct pass_prediction_step *step = &(pass->steps[i]);
+				prediction_output_iso_time(step->time, time_string);
+				buffered_writer_printf(writer, "%s{\"time\":\"%s\",\"elevation\":%.3f,\"azimuth\":%.3f,\"phase\":%.3f,\"latitude\":%.3f,\"longitude\":%.3f,\"range\":%.3f,\"revolutions\":%ld,\"visibility\":\"%s\"}", (i > 0) ? "," : "", time_string, step->elevation*180.0/M_PI, step->azimuth*180.0/M_PI, step->phase*180.0/M_PI, step->latitude*180.0/M_PI, step->longitude*180.0/M_PI, step->range, step->revolutions, prediction_output_visibility_name(step->visibility));
+			}
+			buffered_writer_printf(writer, "]}\n");
+			break;
+		}
+		case PREDICTION_OUTPUT_ICS: {
+			char escaped_name[MAX_NUM_CHARS];
+			char dtstamp_string[MAX_NUM_CHARS];
+			time_t aos_epoch = prediction_output_epoch(pass->events.aos);
+			prediction_output_ics_escape(name, escaped_name);
+			prediction_output_ics_time(output->creation_time, dtstamp_string);
+			prediction_output_ics_time(aos_epoch, aos_string);
+			prediction_output_ics_time(prediction_output_epoch(pass->events.los), los_string);
+			prediction_output_ics_line(writer, "BEGIN:VEVENT");
+			prediction_output_ics_line(writer, "UID:%ld-%lld@flyby", satellite_number, (long long)aos_epoch);
+			prediction_output_ics_line(writer, "DTSTAMP:%s", dtstamp_string);
+			prediction_output_ics_line(writer, "DTSTART:%s", aos_string);
+			prediction_output_ics_line(writer, "DTEND:%s", los_string);
+			prediction_output_ics_line(writer, "SUMMARY:%s pass\\, max elevation %.0f deg", escaped_name, pass->events.max_elevation*180.0/M_PI);
+			prediction_output_ics_line(writer, "DESCRIPTION:AOS azimuth %.0f deg\\, max elevation %.1f deg at azimuth %.0f deg\\, LOS azimuth %.0f deg", pass->events.aos_azimuth*180.0/M_PI, pass->events.max_elevation*180.0/M_PI, pass->events.max_elevation_azimuth*180.0/M_PI, pass->events.los_azimuth*180.0/M_PI);
+			prediction_output_ics_line(writer, "END:VEVENT");
+			break;
+		}
+	}
+}
+
+void prediction_output_event(struct prediction_output *output, const char *body_name, const char *event_name, const struct astronomical_body_event *event)
+{
+	struct buffered_writer *writer = &(output->writer);
+	char time_string[MAX_NUM_CHARS];
+	prediction_output_begin_record(output, PREDICTION_OUTPUT_RECORD_EVENT);
+
+	switch (output->format) {
+		case PREDICTION_OUTPUT_TEXT: {
+			time_t epoch = predict_from_julian(event->time);
+			strftime(time_string, MAX_NUM_CHARS, "%Y-%m-%dT%H:%M:%SZ", gmtime(&epoch));
+			buffered_writer_printf(writer, "%s %-4s %-7s %6.2f %+6.2f\n", time_string, body_name, event_name, event->azimuth*180.0/M_PI, event->elevation*180.0/M_PI);
+			break;
+		}
+		case PREDICTION_OUTPUT_CSV:
+			prediction_output_iso_time(event->time, time_string);
+			prediction_output_csv_string(writer, body_name);
+			buffered_writer_printf(writer, ",%s,%s,%.3f,%.3f\n", event_name, time_string, event->azimuth*180.0/M_PI, event->elevation*180.0/M_PI);
+			break;
+		case PREDICTION_OUTPUT_JSONL:
+			prediction_output_iso_time(event->time, time_string);
+			buffered_writer_printf(writer, "{\"body\":");
+			prediction_output_json_string(writer, body_name);
+			buffered_writer_printf(writer, ",\"event\":\"%s\",\"time\":\"%s\",\"azimuth\":%.3f,\"elevation\":%.3f}\n", event_name, time_string, event->azimuth*180.0/M_PI, event->elevation*180.0/M_PI);
+			break;
+		case PREDICTION_OUTPUT_ICS: {
+			char escaped_name[MAX_NUM_CHARS];
+			char dtstamp_string[MAX_NUM_CHARS];
+			time_t epoch = prediction_output_epoch(event->time);
+			prediction_output_ics_escape(body_name, escaped_name);
+			prediction_output_ics_time(output->creation_time, dtstamp_string);
+			prediction_output_ics_time(epoch, time_string);
+			prediction_output_ics_line(writer, "BEGIN:VEVENT");
+			prediction_output_ics_line(writer, "UID:%s-%s-%lld@flyby", body_name, event_name, (long long)epoch);
+			prediction_output_ics_line(writer, "DTSTAMP:%s", dtstamp_string);
+			prediction_output_ics_line(writer, "DTSTART:%s", time_string);
+			prediction_output_ics_line(writer, "SUMMARY:%s %s", escaped_name, event_name);
+			prediction_output_ics_line(writer, "DESCRIPTION:Azimuth %.0f deg\\, elevation %.1f deg", event->azimuth*180.0/M_PI, event->elevation*180.0/M_PI);
+			prediction_output_ics_line(writer, "END:VEVENT");
+			break;
+		}
+	}
+}
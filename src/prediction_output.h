@@ -0,0 +1,122 @@
+#ifndef PREDICTION_OUTPUT_H_DEFINED
+#define PREDICTION_OUTPUT_H_DEFINED
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <predict/predict.h>
+#include "pass_predictions.h"
+#include "track_astronomical_bodies.h"
+
+/**
+ * Output sinks for headless predictions.
+ *
+ * Passes and astronomical body events are written one record at a time in the selected format, through a
+ * fixed-size buffer which is flushed to the output file when full. Memory use is independent of the number of
+ * records, so that predictions of any length can be streamed to a file or a pipe.
+ **/
+
+//size of the output buffer (bytes)
+#define PREDICTION_OUTPUT_BUFFER_SIZE 65536
+
+/**
+ * Output formats.
+ **/
+enum prediction_output_format {
+	///Plain text, as in the interactive schedules
+	PREDICTION_OUTPUT_TEXT,
+	///Comma-separated values, one row per step through a pass or per event
+	PREDICTION_OUTPUT_CSV,
+	///JSON Lines, one object per pass or per event
+	PREDICTION_OUTPUT_JSONL,
+	///iCalendar, one VEVENT per pass or per event
+	PREDICTION_OUTPUT_ICS
+};
+
+/**
+ * Type of the records written to the output, for writing the CSV header when the record type changes.
+ **/
+enum prediction_output_record {
+	///Nothing written yet
+	PREDICTION_OUTPUT_RECORD_NONE,
+	///Satellite passes
+	PREDICTION_OUTPUT_RECORD_PASS,
+	///Astronomical body events
+	PREDICTION_OUTPUT_RECORD_EVENT
+};
+
+/**
+ * Buffered writer.
+ **/
+struct buffered_writer {
+	///Output file
+	FILE *file;
+	///Buffered data
+	char buffer[PREDICTION_OUTPUT_BUFFER_SIZE];
+	///Number of bytes in the buffer
+	size_t length;
+	///Whether writing to the file has failed
+	bool failed;
+};
+
+/**
+ * Output sink.
+ **/
+struct prediction_output {
+	///Output format
+	enum prediction_output_format format;
+	///Buffered writer
+	struct buffered_writer writer;
+	///Type of the last written record
+	enum prediction_output_record last_record;
+	///Time the output was created, used as DTSTAMP in iCalendar output
+	time_t creation_time;
+};
+
+/**
+ * Get output format from its name.
+ *
+ * \param name Name of format, "text", "csv", "jsonl" or "ics"
+ * \param ret_format Returned format
+ * \return True if the name was recognized, false otherwise
+ **/
+bool prediction_output_format_from_string(const char *name, enum prediction_output_format *ret_format);
+
+/**
+ * Create output sink. Any header of the format is written immediately.
+ *
+ * \param file Output file. Not closed by prediction_output_destroy()
+ * \param format Output format
+ * \return Output sink
+ **/
+struct prediction_output *prediction_output_create(FILE *file, enum prediction_output_format format);
+
+/**
+ * Write any trailer of the format, flush buffered data to the output file and free the output sink.
+ *
+ * \param output Output sink
+ * \return True if all data was written successfully, false otherwise
+ **/
+bool prediction_output_destroy(struct prediction_output **output);
+
+/**
+ * Write satellite pass, with its steps from AOS to LOS.
+ *
+ * \param output Output sink
+ * \param name Satellite name
+ * \param satellite_number Satellite number
+ * \param pass Pass
+ **/
+void prediction_output_pass(struct prediction_output *output, const char *name, long satellite_number, const struct pass_prediction *pass);
+
+/**
+ * Write rise, transit or set of an astronomical body.
+ *
+ * \param output Output sink
+ * \param body_name Name of astronomical body
+ * \param event_name Name of event type
+ * \param event Event
+ **/
+void prediction_output_event(struct prediction_output *output, const char *body_name, const char *event_name, const struct astronomical_body_event *event);
+
+#endif
@@ -1,4 +1,5 @@
 #include "prediction_schedules.h"
+#include "eclipse_solver.h"
 #include "ui.h"
 #include <math.h>
 
@@ -183,7 +184,6 @@ int schedule_print(const char *title, const char *string, char mode)
 	char type[20], head2[81];
 	int key, ans=0;
 	static char buffer[5000], lines, quit;
-	static FILE *fd;
 
 	/* Pass a NULL string to initialize the buffer, counter, and flags */
 
@@ -191,7 +191,6 @@ int schedule_print(const char *title, const char *string, char mode)
 		lines=0;
 		quit=0;
 		buffer[0]=0;
-		fd=NULL;
 	} else {
 		if (mode=='p')
 			strcpy(type,"Satellite Passes");
@@ -246,11 +245,6 @@ int schedule_print(const char *title, const char *string, char mode)
 			if (buffer[0]=='\n')
                               printw("\n");
 
-			if (fd==NULL)
-				mvprintw(LINES-2,63,"        ");
-			else
-				mvprintw(LINES-2,63,"Log = ON");
-
 			mvprintw(LINES-2,6,"More? [y/n] >> ");
 			curs_set(1);
 			refresh();
@@ -346,7 +340,40 @@ int visible_schedule_print(const char *title, const char *string)
 	return quit;
 }
 
-void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, char mode)
+/**
+ * Get AOS and LOS of the next pass starting after the given time, using the pass table when it covers the given time.
+ *
+ * \param orbital_elements Orbital elements of satellite
+ * \param qth QTH
+ * \param pass_table Pass table, can be NULL
+ * \param satellite_index Index of the satellite in the pass table
+ * \param time Time
+ * \param ret_aos Returned AOS time
+ * \param ret_los Returned LOS time
+ **/
+static void satellite_next_pass(predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, struct pass_table *pass_table, int satellite_index, predict_julian_date_t time, predict_julian_date_t *ret_aos, predict_julian_date_t *ret_los)
+{
+	struct pass_events pass;
+	enum pass_table_status status = PASS_TABLE_NOT_COMPUTED;
+	if (pass_table != NULL) {
+		status = pass_table_next_pass(pass_table, satellite_index, time, &pass);
+
+		//skip pass in progress
+		if ((status == PASS_TABLE_PASS_FOUND) && (pass.aos <= time)) {
+			status = pass_table_next_pass(pass_table, satellite_index, pass.los, &pass);
+		}
+	}
+
+	if (status == PASS_TABLE_PASS_FOUND) {
+		*ret_aos = pass.aos;
+		*ret_los = pass.los;
+	} else {
+		*ret_aos = predict_next_aos(qth, orbital_elements, time).time;
+		*ret_los = predict_next_los(qth, orbital_elements, *ret_aos).time;
+	}
+}
+
+void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, struct pass_table *pass_table, int satellite_index, char mode)
 {
 	schedule_print("","",0);
 	visible_schedule_print("","");
@@ -366,8 +393,8 @@ void satellite_pass_display_schedule(const char *name, predict_orbital_elements_
 
 	if (predict_aos_happens(orbital_elements, qth->latitude) && !predict_is_geosynchronous(orbital_elements) && !(orbit.decayed)) {
 		do {
-			predict_julian_date_t next_aos = predict_next_aos(qth, orbital_elements, curr_time).time;
-			predict_julian_date_t next_los = predict_next_los(qth, orbital_elements, next_aos).time;
+			predict_julian_date_t next_aos, next_los;
+			satellite_next_pass(orbital_elements, qth, pass_table, satellite_index, curr_time, &next_aos, &next_los);
 			curr_time = next_aos;
 
 			struct predict_observation obs;
@@ -502,6 +529,36 @@ void ra_dec_gha_astronomical_body(enum astronomical_body type, predict_julian_da
 }
 
 
+//duration of the search for the next rise of the sun or moon (days)
+#define SUN_MOON_PASS_SEARCH_DURATION 366.0
+
+/**
+ * Print a line of the sun or moon pass schedule.
+ *
+ * \param object Sun or moon
+ * \param qth Point of observation
+ * \param daynum Time
+ * \param print_mode Print mode of schedule_print()
+ * \param ret_obs Returned observation at the given time
+ * \return 1 if user wants to quit, 0 otherwise
+ **/
+static int sun_moon_pass_print(enum astronomical_body object, predict_observer_t *qth, predict_julian_date_t daynum, char print_mode, struct predict_observation *ret_obs)
+{
+	char string[MAX_NUM_CHARS];
+	char time_string[MAX_NUM_CHARS];
+	struct ra_dec_gha ra_dec_gha = {0};
+
+	observe_astronomical_body(object, qth, daynum, ret_obs);
+	ra_dec_gha_astronomical_body(object, daynum, &ra_dec_gha);
+	int iaz=(int)rint(ret_obs->azimuth*180.0/M_PI);
+	int iel=(int)rint(ret_obs->elevation*180.0/M_PI);
+
+	time_t epoch = predict_from_julian(daynum);
+	strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
+	sprintf(string,"      %s%4d %4d  %5.1f  %5.1f  %5.1f  %6.1f%7.3f\n",time_string, iel, iaz, ra_dec_gha.ra, ra_dec_gha.dec, ra_dec_gha.gha, ret_obs->range_rate, ret_obs->range);
+	return schedule_print("",string,print_mode);
+}
+
 void sun_moon_pass_display_schedule(enum astronomical_body object, predict_observer_t *qth)
 {
 	char print_mode;
@@ -520,98 +577,53 @@ void sun_moon_pass_display_schedule(enum astronomical_body object, predict_obser
 	}
 	schedule_print("","",0);
 
-	int iaz, iel, lastel=0;
 	char string[MAX_NUM_CHARS], quit=0;
-	double lastdaynum, rise=0.0;
 	char time_string[MAX_NUM_CHARS];
 
 	predict_julian_date_t daynum = prompt_user_for_time(name_str);
 	clear();
 	struct predict_observation obs = {0};
-	struct ra_dec_gha ra_dec_gha = {0};
-
-	const double HORIZON_THRESHOLD = 0.03;
-	const double REDUCTION_FACTOR = 0.004;
+	struct astronomical_body_pass pass;
 
 	do {
-		//determine sun- or moonrise
-		observe_astronomical_body(object, qth, daynum, &obs);
-
-		while (rise==0.0) {
-			if (fabs(obs.elevation*180.0/M_PI)<HORIZON_THRESHOLD) {
-				rise=daynum;
-			} else {
-				daynum-=(REDUCTION_FACTOR*obs.elevation*180.0/M_PI);
-				observe_astronomical_body(object, qth, daynum, &obs);
-			}
-		}
-
-		observe_astronomical_body(object, qth, rise, &obs);
-		ra_dec_gha_astronomical_body(object, rise, &ra_dec_gha);
-
-		daynum=rise;
-
-		iaz=(int)rint(obs.azimuth*180.0/M_PI);
-		iel=(int)rint(obs.elevation*180.0/M_PI);
-
-		//display pass of sun or moon from rise
-		do {
-			//display data
+		//determine sun- or moonrise, transit and set
+		if (!astronomical_body_next_pass(object, qth, daynum, daynum + SUN_MOON_PASS_SEARCH_DURATION, &pass)) {
 			time_t epoch = predict_from_julian(daynum);
-			strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
-			sprintf(string,"      %s%4d %4d  %5.1f  %5.1f  %5.1f  %6.1f%7.3f\n",time_string, iel, iaz, ra_dec_gha.ra, ra_dec_gha.dec, ra_dec_gha.gha, obs.range_rate, obs.range);
+			strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y", gmtime(&epoch));
+			snprintf(string, MAX_NUM_CHARS, "      No rise of %s within a year from %s\n", name_str, time_string);
 			quit=schedule_print("",string,print_mode);
-			lastel=iel;
-			lastdaynum=daynum;
+			daynum+=SUN_MOON_PASS_SEARCH_DURATION;
+			continue;
+		}
 
-			//calculate data
+		//display pass of sun or moon from rise, ending at the exact set
+		daynum=pass.rise;
+		while ((daynum<pass.set) && (quit==0)) {
+			quit=sun_moon_pass_print(object, qth, daynum, print_mode, &obs);
 			daynum+=0.04*(cos(M_PI/180.0*(obs.elevation*180.0/M_PI+0.5)));
-			observe_astronomical_body(object, qth, daynum, &obs);
-			ra_dec_gha_astronomical_body(object, daynum, &ra_dec_gha);
-			iaz=(int)rint(obs.azimuth*180.0/M_PI);
-			iel=(int)rint(obs.elevation*180.0/M_PI);
-		} while (iel>3 && quit==0);
-
-		//end the pass
-		while (lastel!=0 && quit==0) {
-			daynum=lastdaynum;
-
-			//find sun/moon set
-			do {
-				daynum+=0.004*(sin(M_PI/180.0*(obs.elevation*180.0/M_PI+0.5)));
-				observe_astronomical_body(object, qth, daynum, &obs);
-				iaz=(int)rint(obs.azimuth*180.0/M_PI);
-				iel=(int)rint(obs.elevation*180.0/M_PI);
-			} while (iel>0);
-
-			time_t epoch = predict_from_julian(daynum);
-			strftime(time_string, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
-			ra_dec_gha_astronomical_body(object, daynum, &ra_dec_gha);
-
-			sprintf(string,"      %s%4d %4d  %5.1f  %5.1f  %5.1f  %6.1f%7.3f\n",time_string, iel, iaz, ra_dec_gha.ra, ra_dec_gha.dec, ra_dec_gha.gha, obs.range_rate, obs.range);
-			quit=schedule_print("",string,print_mode);
-			lastel=iel;
-		} //will continue until we have elevation 0 at the end of the pass
+		}
+		if (quit==0) {
+			quit=sun_moon_pass_print(object, qth, pass.set, print_mode, &obs);
+		}
 
-		quit=schedule_print("","\n",'o');
-		daynum+=0.4;
-		rise=0.0;
+		if (quit==0) {
+			quit=schedule_print("","\n",'o');
+		}
+		daynum=pass.set;
 
 	} while (quit==0);
 }
 
 void solar_illumination_display_predictions(const char *name, predict_orbital_elements_t *orbital_elements)
 {
-	double startday, oneminute, sunpercent;
-	int eclipses, minutes, quit, breakout=0, count;
+	double startday, sunpercent, eclipsed_time;
+	int sunlit_minutes, quit, breakout=0, count;
+	bool decayed=false;
 	char string1[MAX_NUM_CHARS], string[MAX_NUM_CHARS], datestring[MAX_NUM_CHARS];
 
 	schedule_print("","",0);
 
-	oneminute=1.0/(24.0*60.0);
-
-	predict_julian_date_t daynum = floor(prompt_user_for_time(name));
-	startday=daynum;
+	startday=floor(prompt_user_for_time(name));
 	count=0;
 
 	curs_set(0);
@@ -619,37 +631,27 @@ void solar_illumination_display_predictions(const char *name, predict_orbital_el
 
 	const int NUM_MINUTES = 1440;
 
-	struct predict_position orbit;
-
-
 	do {
 		attrset(COLOR_PAIR(4));
 		mvprintw(LINES - 2,6,"                 Calculating... Press [ESC] To Quit");
 		refresh();
 
 		count++;
-		daynum=startday;
 
 		mvprintw(1,60, "%s (%d)", name, orbital_elements->satellite_number);
 
-		for (minutes=0, eclipses=0; minutes<NUM_MINUTES; minutes++) {
-			predict_orbit(orbital_elements, &orbit, daynum);
-
-			if (orbit.eclipsed) {
-				eclipses++;
-			}
-
-			daynum=startday+(oneminute*(double)minutes);
+		//illuminated time from the shadow entry and exit times within the day
+		if (!eclipse_solver_eclipsed_time(orbital_elements, startday, startday+1.0, &eclipsed_time, NULL)) {
+			decayed=true;
 		}
-
-		sunpercent=((double)eclipses)/((double)minutes);
-		sunpercent=100.0-(sunpercent*100.0);
+		sunpercent=100.0-(eclipsed_time*100.0);
+		sunlit_minutes=(int)round(NUM_MINUTES*(1.0-eclipsed_time));
 
 		time_t epoch = predict_from_julian(startday);
 		strftime(datestring, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
 		datestring[11]=0;
 
-		sprintf(string1,"      %s    %4d    %6.2f%c",datestring,NUM_MINUTES-eclipses,sunpercent,37);
+		sprintf(string1,"      %s    %4d    %6.2f%c",datestring,sunlit_minutes,sunpercent,37);
 
 		/* Allow a quick way out */
 
@@ -662,26 +664,18 @@ void solar_illumination_display_predictions(const char *name, predict_orbital_el
 
 		startday+= (LINES-8);
 
-		daynum=startday;
-
-		for (minutes=0, eclipses=0; minutes<NUM_MINUTES; minutes++) {
-			predict_orbit(orbital_elements, &orbit, daynum);
-
-			if (orbit.eclipsed) {
-				eclipses++;
-			}
-
-			daynum=startday+(oneminute*(double)minutes);
+		//illuminated time from the shadow entry and exit times within the day
+		if (!eclipse_solver_eclipsed_time(orbital_elements, startday, startday+1.0, &eclipsed_time, NULL)) {
+			decayed=true;
 		}
-
-		sunpercent=((double)eclipses)/((double)minutes);
-		sunpercent=100.0-(sunpercent*100.0);
+		sunpercent=100.0-(eclipsed_time*100.0);
+		sunlit_minutes=(int)round(NUM_MINUTES*(1.0-eclipsed_time));
 
 		epoch = predict_from_julian(startday);
 		strftime(datestring, MAX_NUM_CHARS, "%a %d%b%y %H:%M:%S", gmtime(&epoch));
 
 		datestring[11]=0;
-		sprintf(string,"%s\t %s    %4d    %6.2f%c\n",string1,datestring,1440-eclipses,sunpercent,37);
+		sprintf(string,"%s\t %s    %4d    %6.2f%c\n",string1,datestring,sunlit_minutes,sunpercent,37);
 
 		char title[MAX_NUM_CHARS] = {0};
 		sprintf(title, "%s (%d)", name, orbital_elements->satellite_number);
@@ -704,5 +698,5 @@ void solar_illumination_display_predictions(const char *name, predict_orbital_el
 			startday+=1.0;
 		}
 	}
-	while (quit!=1 && breakout!=1 && !(orbit.decayed));
+	while (quit!=1 && breakout!=1 && !decayed);
 }
@@ -1,14 +1,17 @@
 #include <predict/predict.h>
 #include "track_astronomical_bodies.h"
+#include "pass_table.h"
 
 /* This function predicts satellite passes.
  *
  * \param name Name of satellite
  * \param orbital_elements Orbital elements of satellite
  * \param qth QTH at which satellite is to be observed
+ * \param pass_table Precomputed passes, used for finding the passes when available. Can be NULL
+ * \param satellite_index Index of the satellite in the TLE database
  * \param mode 'p' for all passes, 'v' for visible passes only
  **/
-void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, char mode);
+void satellite_pass_display_schedule(const char *name, predict_orbital_elements_t *orbital_elements, predict_observer_t *qth, struct pass_table *pass_table, int satellite_index, char mode);
 
 /**
  * Display solar illumination predictions.
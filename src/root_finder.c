@@ -0,0 +1,103 @@
+#include "root_finder.h"
+#include <math.h>
+
+//maximum number of iterations in the refinement of a bracket
+#define ROOT_FINDER_MAX_ITERATIONS 100
+
+double root_finder_brent(root_finder_function_t function, void *data, double a, double fa, double b, double fb, double tolerance)
+{
+	double c = a;
+	double fc = fa;
+	double d = b - a;
+	double e = d;
+	for (int i=0; i < ROOT_FINDER_MAX_ITERATIONS; i++) {
+		//keep root between b and c, with b the best estimate
+		if ((fb > 0) == (fc > 0)) {
+			c = a;
+			fc = fa;
+			d = b - a;
+			e = d;
+		}
+		if (fabs(fc) < fabs(fb)) {
+			a = b;
+			b = c;
+			c = a;
+			fa = fb;
+			fb = fc;
+			fc = fa;
+		}
+
+		double tol = tolerance/2.0;
+		double m = (c - b)/2.0;
+		if ((fabs(m) <= tol) || (fb == 0)) {
+			break;
+		}
+
+		if ((fabs(e) >= tol) && (fabs(fa) > fabs(fb))) {
+			//secant or inverse quadratic interpolation
+			double p, q;
+			double s = fb/fa;
+			if (a == c) {
+				p = 2.0*m*s;
+				q = 1.0 - s;
+			} else {
+				double r = fb/fc;
+				q = fa/fc;
+				p = s*(2.0*m*q*(q - r) - (b - a)*(r - 1.0));
+				q = (q - 1.0)*(r - 1.0)*(s - 1.0);
+			}
+			if (p > 0) {
+				q = -q;
+			} else {
+				p = -p;
+			}
+
+			if ((2.0*p < 3.0*m*q - fabs(tol*q)) && (p < fabs(e*q/2.0))) {
+				e = d;
+				d = p/q;
+			} else {
+				//interpolation failed, bisect
+				d = m;
+				e = m;
+			}
+		} else {
+			//bounds decreasing too slowly, bisect
+			d = m;
+			e = m;
+		}
+
+		a = b;
+		fa = fb;
+		if (fabs(d) > tol) {
+			b += d;
+		} else {
+			b += (m > 0) ? tol : -tol;
+		}
+		fb = function(data, b);
+	}
+	return b;
+}
+
+bool root_finder_first_crossing(root_finder_function_t function, void *data, double max_rate, double min_interval, double tolerance, double a, double fa, double b, double fb, double *ret_root, double *ret_x, double *ret_fx)
+{
+	if (isnan(fa) || isnan(fb)) {
+		return false;
+	}
+	if ((fa > 0) != (fb > 0)) {
+		*ret_root = root_finder_brent(function, data, a, fa, b, fb, tolerance);
+		*ret_x = b;
+		*ret_fx = fb;
+		return true;
+	}
+
+	double interval = fabs(b - a);
+	if ((fabs(fa) + fabs(fb) > max_rate*interval) || (interval < min_interval)) {
+		return false;
+	}
+
+	//sample where the bounds from both samples meet, i.e. where the function could come closest to zero
+	double m = (a + b)/2.0 + ((b > a) ? 1.0 : -1.0)*(fabs(fa) - fabs(fb))/(2.0*max_rate);
+	double fm = function(data, m);
+	return root_finder_first_crossing(function, data, max_rate, min_interval, tolerance, a, fa, m, fm, ret_root, ret_x, ret_fx) ||
+	       root_finder_first_crossing(function, data, max_rate, min_interval, tolerance, m, fm, b, fb, ret_root, ret_x, ret_fx);
+}
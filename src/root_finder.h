@@ -0,0 +1,57 @@
+#ifndef ROOT_FINDER_H_DEFINED
+#define ROOT_FINDER_H_DEFINED
+
+#include <stdbool.h>
+
+/**
+ * Root finding shared between the event solvers (passes, eclipses and rise/set of the sun and the moon).
+ *
+ * The solvers sample a function of time in coarse steps. A root is bracketed by two samples of opposite sign,
+ * and refined using Brent's method. Two samples of the same sign are subdivided when the function could reach
+ * zero between them, given an upper bound on its rate of change, so that short excursions past zero are not missed.
+ **/
+
+/**
+ * Function of which roots are searched for.
+ *
+ * \param data User data passed through from the root finder
+ * \param x Argument, usually time
+ * \return Function value. NAN stops the search in root_finder_first_crossing()
+ **/
+typedef double (*root_finder_function_t)(void *data, double x);
+
+/**
+ * Refine root using Brent's root finding method.
+ *
+ * \param function Function
+ * \param data User data passed to the function
+ * \param a Start of bracket
+ * \param fa Function value at start of bracket
+ * \param b End of bracket
+ * \param fb Function value at end of bracket, of opposite sign of fa
+ * \param tolerance Tolerance of the root
+ * \return Root
+ **/
+double root_finder_brent(root_finder_function_t function, void *data, double a, double fa, double b, double fb, double tolerance);
+
+/**
+ * Find the first root between two samples. Samples of the same sign are subdivided when the function could reach
+ * zero between them, until the interval is shorter than min_interval.
+ *
+ * \param function Function
+ * \param data User data passed to the function
+ * \param max_rate Upper bound of the absolute rate of change of the function
+ * \param min_interval Shortest interval that is subdivided
+ * \param tolerance Tolerance of the root
+ * \param a First sample
+ * \param fa Function value at first sample
+ * \param b Second sample, before or after the first sample
+ * \param fb Function value at second sample
+ * \param ret_root Returned root
+ * \param ret_x Returned sample right after the root, in the direction from a to b
+ * \param ret_fx Returned function value at ret_x
+ * \return True if a root was found, false if no root was found or the function returned NAN
+ **/
+bool root_finder_first_crossing(root_finder_function_t function, void *data, double max_rate, double min_interval, double tolerance, double a, double fa, double b, double fb, double *ret_root, double *ret_x, double *ret_fx);
+
+#endif
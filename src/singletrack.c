@@ -17,7 +17,10 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "ui.h"
+#include "ephemeris_cache.h"
+#include <unistd.h>
 
 /**
  * Get next enabled entry within the TLE database. Used for navigating between enabled satellites within singletrack().
@@ -37,6 +40,9 @@ void singletrack_help();
 ///Height of main menu shown on bottom
 #define SINGLETRACK_MAIN_MENU_HEIGHT 1
 
+///Interval between updates while commands are sent to rigctld or rotctld (seconds)
+#define SINGLETRACK_HAMLIB_TICK_INTERVAL 0.5
+
 /**
  * Print major keybindings at the bottom of the window, htop style.
  *
@@ -142,28 +148,29 @@ void singletrack_handle_transponder_key(struct singletrack_link *link_status, in
  * \param satellite_name Satellite name
  * \param qth Ground station
  * \param orbital_elements Orbital elements for tracked satellite
+ * \param pass_table Precomputed passes, used instead of predicting the pass information on demand when available. Can be NULL
+ * \param satellite_index Index of the satellite in the TLE database, used for looking up the satellite in the pass table
  * \param satellite_transponders Satellite transponders
  * \param rotctld Rotctld connection
  * \param downlink_info Downlink rigctld connection
  * \param uplink_info Uplink rigctld connection
  **/
-int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
+int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct pass_table *pass_table, int satellite_index, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info);
 
-void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *sat_db, struct tle_db *tle_db, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
+void singletrack(int orbit_ind, predict_observer_t *qth, struct transponder_db *sat_db, struct tle_db *tle_db, struct pass_table *pass_table, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
 {
 	struct sat_db_entry *sat_db_entries = sat_db->sats;
-	struct tle_db_entry *tle_db_entries = tle_db->tles;
 
 	int     input_key;
 
 	while (true) {
-		predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, orbit_ind);
-		const char *satellite_name = tle_db_entries[orbit_ind].name;
+		struct tle_db_orbital_elements *orbital_elements = tle_db_entry_get_orbital_elements(tle_db, orbit_ind);
+		const char *satellite_name = tle_db_entry_name(tle_db, orbit_ind);
 		struct sat_db_entry satellite_transponders = sat_db_entries[orbit_ind];
 
 		//track satellite until keyboard input breaks the loop
-		input_key = singletrack_track_satellite(satellite_name, qth, orbital_elements, satellite_transponders, rotctld, downlink_info, uplink_info);
-		predict_destroy_orbital_elements(orbital_elements);
+		input_key = singletrack_track_satellite(satellite_name, qth, orbital_elements->elements, pass_table, orbit_ind, satellite_transponders, rotctld, downlink_info, uplink_info);
+		tle_db_orbital_elements_release(&orbital_elements);
 
 		//handle keyboard input not handled by singletrack_track_satellite(...):
 		//track next satellite
@@ -295,7 +302,6 @@ void singletrack_help()
 	box(help_window, 0, 0);
 	wrefresh(help_window);
 
-	cbreak(); //turn off halfdelay mode so that getch blocks
 	getch();
 
 	delwin(help_window);
@@ -699,6 +705,46 @@ void singletrack_handle_transponder_key(struct singletrack_link *link_status, in
 //column for sun
 #define SUN_COLUMN 46
 
+/**
+ * Get pass information from the pass table.
+ *
+ * \param pass_table Pass table
+ * \param satellite_index Index of the satellite in the TLE database
+ * \param time Current time
+ * \param ret_aos Returned AOS of next pass
+ * \param ret_los Returned LOS of current or next pass
+ * \param ret_max_elevation Returned maximum elevation of current or next pass
+ * \return True if the pass information was found in the pass table, false if it has to be predicted using libpredict
+ **/
+static bool singletrack_pass_information_from_table(struct pass_table *pass_table, int satellite_index, predict_julian_date_t time, struct predict_observation *ret_aos, struct predict_observation *ret_los, struct predict_observation *ret_max_elevation)
+{
+	if (pass_table == NULL) {
+		return false;
+	}
+
+	struct pass_events pass;
+	if (pass_table_next_pass(pass_table, satellite_index, time, &pass) != PASS_TABLE_PASS_FOUND) {
+		return false;
+	}
+
+	//AOS of next pass is found in the pass after the current one when the satellite is above the horizon
+	struct pass_events next_pass = pass;
+	if ((pass.aos <= time) && (pass_table_next_pass(pass_table, satellite_index, pass.los, &next_pass) != PASS_TABLE_PASS_FOUND)) {
+		return false;
+	}
+
+	ret_aos->time = next_pass.aos;
+	ret_aos->azimuth = next_pass.aos_azimuth;
+	ret_aos->elevation = 0;
+	ret_los->time = pass.los;
+	ret_los->azimuth = pass.los_azimuth;
+	ret_los->elevation = 0;
+	ret_max_elevation->time = pass.max_elevation_time;
+	ret_max_elevation->azimuth = pass.max_elevation_azimuth;
+	ret_max_elevation->elevation = pass.max_elevation;
+	return true;
+}
+
 //column for moon
 #define MOON_COLUMN (SUN_COLUMN + SUN_MOON_COLUMN_DIFF)
 
@@ -708,7 +754,27 @@ void singletrack_handle_transponder_key(struct singletrack_link *link_status, in
 //column for QTH box
 #define QTH_COLUMN (MOON_COLUMN + SUN_MOON_COLUMN_DIFF)
 
-int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
+/**
+ * Observe satellite at the current time with sub-second resolution, for doppler correction and rotator control.
+ * Falls back to libpredict when the satellite decays within the cached window.
+ *
+ * \param ephemeris Ephemeris cache of the satellite
+ * \param qth QTH
+ * \param ret_obs Returned observation
+ **/
+static void singletrack_observe_now(struct ephemeris_cache *ephemeris, const predict_observer_t *qth, struct predict_observation *ret_obs)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	predict_julian_date_t time = predict_to_julian(now.tv_sec) + now.tv_nsec*1.0e-9/86400.0;
+	if (!ephemeris_cache_observe(ephemeris, qth, time, ret_obs)) {
+		struct predict_position orbit;
+		predict_orbit(ephemeris->orbital_elements, &orbit, time);
+		predict_observe_orbit(qth, &orbit, ret_obs);
+	}
+}
+
+int singletrack_track_satellite(const char *satellite_name, predict_observer_t *qth, const predict_orbital_elements_t *orbital_elements, struct pass_table *pass_table, int satellite_index, struct sat_db_entry satellite_transponders, rotctld_info_t *rotctld, rigctld_info_t *downlink_info, rigctld_info_t *uplink_info)
 {
 	int input_key;
 	int    transponder_index=0;
@@ -755,7 +821,10 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 	predict_orbit(orbital_elements, &orbit, daynum);
 	bool decayed = orbit.decayed;
 
-	halfdelay(HALF_DELAY_TIME);
+	//positions for the commands sent to rigctld and rotctld
+	struct ephemeris_cache *ephemeris = ephemeris_cache_create(orbital_elements, EPHEMERIS_CACHE_DEFAULT_WINDOW);
+
+	struct event_loop *event_loop = event_loop_create(STDIN_FILENO, UI_TICK_INTERVAL);
 
 	//print static description fields
 	singletrack_print_headers(satellite_name, orbital_elements->satellite_number);
@@ -782,7 +851,7 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 		double squint = predict_squint_angle(qth, &orbit, satellite_transponders.alon, satellite_transponders.alat);
 
 		//update pass information
-		if (!decayed && aos_happens && !geosynchronous && (daynum > los.time)) {
+		if (!decayed && aos_happens && !geosynchronous && (daynum > los.time) && !singletrack_pass_information_from_table(pass_table, satellite_index, daynum, &aos, &los, &max_elevation)) {
 			//aos of next pass
 			aos = predict_next_aos(qth, orbital_elements, daynum);
 
@@ -867,12 +936,19 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 				mvprintw(TRANSPONDER_UPLINK_ROW, TRANSPONDER_VFO_COL, "(%s)", uplink_info->vfo_name);
 			}
 
-			//set doppler-shifted downlink/uplink to rig
-			if (link_status.in_range && downlink_info->connected && link_status.downlink_update && (link_status.downlink != 0.0)) {
-				rigctld_fail_on_errors(rigctld_set_frequency(downlink_info, link_status.downlink_doppler));
-			}
-			if (link_status.in_range && uplink_info->connected && link_status.uplink_update && (link_status.uplink != 0.0)) {
-				rigctld_fail_on_errors(rigctld_set_frequency(uplink_info, link_status.uplink_doppler));
+			//set doppler-shifted downlink/uplink to rig, corrected for the time at which the frequencies are sent
+			if (link_status.in_range && (downlink_info->connected || uplink_info->connected)) {
+				struct predict_observation command_obs;
+				singletrack_observe_now(ephemeris, qth, &command_obs);
+				struct singletrack_link command_link = link_status;
+				singletrack_update_link_information(&command_obs, &command_link);
+
+				if (downlink_info->connected && link_status.downlink_update && (link_status.downlink != 0.0)) {
+					rigctld_fail_on_errors(rigctld_set_frequency(downlink_info, command_link.downlink_doppler));
+				}
+				if (uplink_info->connected && link_status.uplink_update && (link_status.uplink != 0.0)) {
+					rigctld_fail_on_errors(rigctld_set_frequency(uplink_info, command_link.uplink_doppler));
+				}
 			}
 		}
 
@@ -888,13 +964,24 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 
 		//send data to rotctld
 		if ((obs.elevation*180.0/M_PI >= rotctld->tracking_horizon) && rotctld->connected) {
-			rotctld_fail_on_errors(rotctld_track(rotctld, obs.azimuth*180.0/M_PI, obs.elevation*180.0/M_PI));
+			struct predict_observation command_obs;
+			singletrack_observe_now(ephemeris, qth, &command_obs);
+			rotctld_fail_on_errors(rotctld_track(rotctld, command_obs.azimuth*180.0/M_PI, command_obs.elevation*180.0/M_PI));
 		}
 
 		singletrack_print_main_menu(main_menu_win);
 
-		//handle keyboard input
-		input_key=getch();
+		//sleep until keyboard input, the next clock tick or the next AOS/LOS, and update more often while controlling rig or rotor
+		bool rotor_active = rotctld->connected && (obs.elevation*180.0/M_PI >= rotctld->tracking_horizon);
+		bool rig_active = comsat && link_status.in_range && (downlink_info->connected || uplink_info->connected);
+		event_loop->tick_interval = (rotor_active || rig_active) ? SINGLETRACK_HAMLIB_TICK_INTERVAL : UI_TICK_INTERVAL;
+		if (!decayed && aos_happens && !geosynchronous) {
+			predict_julian_date_t next_event = (obs.elevation >= 0.0) ? los.time : aos.time;
+			if (next_event > daynum) {
+				event_loop_schedule(event_loop, next_event);
+			}
+		}
+		input_key = wait_for_input(event_loop);
 
 		//move antenna towards AOS position
 		if ((input_key == 'A') && (obs.elevation*180.0/M_PI < rotctld->tracking_horizon) && rotctld->connected) {
@@ -951,8 +1038,6 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 			hamlib_status(rotctld, downlink_info, uplink_info, HAMLIB_STATUS_CLEAR_BACKGROUND);
 		}
 
-		halfdelay(HALF_DELAY_TIME);
-
 		//quit function and return input key
 		if ((input_key=='q')
 			|| (input_key == 'Q')
@@ -967,6 +1052,8 @@ int singletrack_track_satellite(const char *satellite_name, predict_observer_t *
 		}
 	}
 	delwin(main_menu_win);
+	event_loop_destroy(&event_loop);
+	ephemeris_cache_destroy(&ephemeris);
 	return input_key;
 
 }
@@ -0,0 +1,119 @@
+#include "solar_system.h"
+#include "defines.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+//astronomical unit (km), as in libpredict
+#define ASTRONOMICAL_UNIT 1.49597870691E8
+
+/**
+ * Memoized observation of the sun or the moon.
+ **/
+struct solar_system_memo {
+	///Whether the memo has been set
+	bool valid;
+	///Time of the observation
+	predict_julian_date_t time;
+	///Latitude, longitude and altitude of the observer
+	double observer[3];
+	///Observation
+	struct predict_observation observation;
+};
+
+///Protects the memoized values below
+static pthread_mutex_t solar_system_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+///Whether the sun position has been calculated
+static bool sun_position_valid = false;
+
+///Time of the last sun position
+static predict_julian_date_t sun_position_time;
+
+///Last sun position (km)
+static double sun_position[3];
+
+///Last sun observation
+static struct solar_system_memo sun_memo = {0};
+
+///Last moon observation
+static struct solar_system_memo moon_memo = {0};
+
+/**
+ * Modulus of 2*pi, as FMod2p() in libpredict.
+ *
+ * \param x Angle
+ * \return Angle within [0, 2*pi)
+ **/
+static double solar_system_fmod2p(double x)
+{
+	double ret_val = fmod(x, TWOPI);
+	if (ret_val < 0.0) {
+		ret_val += TWOPI;
+	}
+	return ret_val;
+}
+
+void solar_system_sun_position(predict_julian_date_t time, double ret_position[3])
+{
+	pthread_mutex_lock(&solar_system_mutex);
+	if (!sun_position_valid || (sun_position_time != time)) {
+		//as sun_predict() in libpredict
+		double mjd = time + JULIAN_TIME_DIFF - 2415020.0;
+		double year = 1900 + mjd/365.25;
+		double delta_et = 26.465 + 0.747622*(year - 1950) + 1.886913*sin(TWOPI*(year - 1975)/33);
+		double t = (mjd + delta_et/SECDAY)/36525.0;
+		double m = fmod(358.47583 + fmod(35999.04975*t, 360.0) - (0.000150 + 0.0000033*t)*t*t, 360.0)*M_PI/180.0;
+		double l = fmod(279.69668 + fmod(36000.76892*t, 360.0) + 0.0003025*t*t, 360.0)*M_PI/180.0;
+		double e = 0.01675104 - (0.0000418 + 0.000000126*t)*t;
+		double c = ((1.919460 - (0.004789 + 0.000014*t)*t)*sin(m) + (0.020094 - 0.000100*t)*sin(2*m) + 0.000293*sin(3*m))*M_PI/180.0;
+		double o = fmod(259.18 - 1934.142*t, 360.0)*M_PI/180.0;
+		double lsa = solar_system_fmod2p(l + c - (0.00569 - 0.00479*sin(o))*M_PI/180.0);
+		double nu = solar_system_fmod2p(m + c);
+		double r = 1.0000002*(1 - e*e)/(1 + e*cos(nu));
+		double eps = (23.452294 - (0.0130125 + (0.00000164 - 0.000000503*t)*t)*t + 0.00256*cos(o))*M_PI/180.0;
+		r = ASTRONOMICAL_UNIT*r;
+		sun_position[0] = r*cos(lsa);
+		sun_position[1] = r*sin(lsa)*cos(eps);
+		sun_position[2] = r*sin(lsa)*sin(eps);
+		sun_position_time = time;
+		sun_position_valid = true;
+	}
+	memcpy(ret_position, sun_position, sizeof(sun_position));
+	pthread_mutex_unlock(&solar_system_mutex);
+}
+
+/**
+ * Get memoized observation, or observe and memoize it if the time or the observer differ.
+ *
+ * \param memo Memoized observation
+ * \param observe Function calculating the observation
+ * \param observer Observer
+ * \param time Time
+ * \param ret_obs Returned observation
+ **/
+static void solar_system_observe(struct solar_system_memo *memo, void (*observe)(const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *obs), const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs)
+{
+	double observer_coordinates[3] = {observer->latitude, observer->longitude, observer->altitude};
+
+	pthread_mutex_lock(&solar_system_mutex);
+	if (!memo->valid || (memo->time != time) || (memcmp(memo->observer, observer_coordinates, sizeof(observer_coordinates)) != 0)) {
+		observe(observer, time, &(memo->observation));
+		memo->time = time;
+		memcpy(memo->observer, observer_coordinates, sizeof(observer_coordinates));
+		memo->valid = true;
+	}
+	*ret_obs = memo->observation;
+	pthread_mutex_unlock(&solar_system_mutex);
+}
+
+void solar_system_observe_sun(const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs)
+{
+	solar_system_observe(&sun_memo, predict_observe_sun, observer, time, ret_obs);
+}
+
+void solar_system_observe_moon(const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs)
+{
+	solar_system_observe(&moon_memo, predict_observe_moon, observer, time, ret_obs);
+}
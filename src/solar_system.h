@@ -0,0 +1,41 @@
+#ifndef SOLAR_SYSTEM_H_DEFINED
+#define SOLAR_SYSTEM_H_DEFINED
+
+#include <predict/predict.h>
+
+/**
+ * Sun and moon ephemeris shared by everything that needs it within a UI tick: the sun and moon boxes, the
+ * tracking of astronomical bodies, and the eclipse and visibility calculations of the batch propagation.
+ *
+ * The last sun position and the last sun and moon observations are memoized together with their time and
+ * observer, and reused when the same time is requested again. The UI works with whole-second timestamps,
+ * so the sun and moon are calculated once per second. The functions can be called from any thread.
+ **/
+
+/**
+ * Get ECI position of the sun, as calculated by libpredict for the eclipse calculations in predict_orbit().
+ *
+ * \param time Time
+ * \param ret_position Returned sun position (km)
+ **/
+void solar_system_sun_position(predict_julian_date_t time, double ret_position[3]);
+
+/**
+ * Observe the sun, as predict_observe_sun().
+ *
+ * \param observer Observer
+ * \param time Time
+ * \param ret_obs Returned observation
+ **/
+void solar_system_observe_sun(const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs);
+
+/**
+ * Observe the moon, as predict_observe_moon().
+ *
+ * \param observer Observer
+ * \param time Time
+ * \param ret_obs Returned observation
+ **/
+void solar_system_observe_moon(const predict_observer_t *observer, predict_julian_date_t time, struct predict_observation *ret_obs);
+
+#endif
@@ -84,3 +84,22 @@ int string_array_find(string_array_t *string_array, const char *string)
 	}
 	return -1;
 }
+
+/**
+ * Compare two strings in string array, for use with qsort().
+ *
+ * \param a Pointer to first string
+ * \param b Pointer to second string
+ * \return Comparison of strings as returned by strcmp()
+ **/
+static int string_array_compare(const void *a, const void *b)
+{
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+void string_array_sort(string_array_t *string_array)
+{
+	if (string_array->num_strings > 1) {
+		qsort(string_array->strings, string_array->num_strings, sizeof(char*), string_array_compare);
+	}
+}
@@ -69,4 +69,11 @@ void stringsplit(const char *string_list, string_array_t *ret_string_list);
  **/
 void string_array_set(string_array_t *string_array, int i, const char *string);
 
+/**
+ * Sort strings in string array in ascending order, as defined by strcmp().
+ *
+ * \param string_array String array
+ **/
+void string_array_sort(string_array_t *string_array);
+
 #endif
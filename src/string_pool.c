@@ -0,0 +1,153 @@
+#include "string_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+//default size of a storage block in the string pool
+#define STRING_POOL_BLOCK_SIZE (64*1024)
+
+//initial number of slots in the hash table
+#define STRING_POOL_INITIAL_HASH_SIZE 64
+
+/**
+ * FNV-1a hash of string.
+ *
+ * \param string String
+ * \return Hash value
+ **/
+static uint64_t string_pool_hash(const char *string)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (const unsigned char *c = (const unsigned char*)string; *c != '\0'; c++) {
+		hash ^= *c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * Find slot for string in hash table. Returns either the slot containing the string or the first empty slot.
+ *
+ * \param hash_table Hash table
+ * \param hash_table_size Number of slots in hash table, power of two
+ * \param string String to look up
+ * \return Slot index
+ **/
+static size_t string_pool_slot(const char **hash_table, size_t hash_table_size, const char *string)
+{
+	size_t slot = string_pool_hash(string) & (hash_table_size-1);
+	while ((hash_table[slot] != NULL) && (strcmp(hash_table[slot], string) != 0)) {
+		slot = (slot + 1) & (hash_table_size-1);
+	}
+	return slot;
+}
+
+/**
+ * Resize hash table to new size and rehash existing strings.
+ *
+ * \param string_pool String pool
+ * \param new_size New number of slots, power of two
+ * \return 0 on success, -1 on failure
+ **/
+static int string_pool_resize_hash_table(string_pool_t *string_pool, size_t new_size)
+{
+	const char **new_table = (const char**)calloc(new_size, sizeof(const char*));
+	if (new_table == NULL) {
+		return -1;
+	}
+
+	for (size_t i=0; i < string_pool->hash_table_size; i++) {
+		const char *string = string_pool->hash_table[i];
+		if (string != NULL) {
+			new_table[string_pool_slot(new_table, new_size, string)] = string;
+		}
+	}
+
+	free(string_pool->hash_table);
+	string_pool->hash_table = new_table;
+	string_pool->hash_table_size = new_size;
+	return 0;
+}
+
+/**
+ * Copy string into the storage blocks of the string pool. Allocates a new block when the current one is full.
+ *
+ * \param string_pool String pool
+ * \param string String to copy
+ * \return Pointer to stored copy, NULL on failure
+ **/
+static const char *string_pool_store(string_pool_t *string_pool, const char *string)
+{
+	size_t length = strlen(string)+1;
+	struct string_pool_block *block = string_pool->blocks;
+
+	if ((block == NULL) || (block->used_size + length > block->available_size)) {
+		size_t block_size = STRING_POOL_BLOCK_SIZE;
+		if (length > block_size) {
+			block_size = length;
+		}
+		block = (struct string_pool_block*)malloc(sizeof(struct string_pool_block) + block_size);
+		if (block == NULL) {
+			return NULL;
+		}
+		block->available_size = block_size;
+		block->used_size = 0;
+		block->next = string_pool->blocks;
+		string_pool->blocks = block;
+	}
+
+	char *ret_string = block->data + block->used_size;
+	memcpy(ret_string, string, length);
+	block->used_size += length;
+	return ret_string;
+}
+
+const char *string_pool_intern(string_pool_t *string_pool, const char *string)
+{
+	if (string == NULL) {
+		string = "";
+	}
+
+	//keep load factor below 1/2
+	if ((string_pool->num_strings+1)*2 > string_pool->hash_table_size) {
+		size_t new_size = STRING_POOL_INITIAL_HASH_SIZE;
+		if (string_pool->hash_table_size > 0) {
+			new_size = string_pool->hash_table_size*2;
+		}
+		if (string_pool_resize_hash_table(string_pool, new_size) != 0) {
+			return NULL;
+		}
+	}
+
+	size_t slot = string_pool_slot(string_pool->hash_table, string_pool->hash_table_size, string);
+	if (string_pool->hash_table[slot] == NULL) {
+		const char *stored_string = string_pool_store(string_pool, string);
+		if (stored_string == NULL) {
+			return NULL;
+		}
+		string_pool->hash_table[slot] = stored_string;
+		string_pool->num_strings++;
+	}
+	return string_pool->hash_table[slot];
+}
+
+size_t string_pool_size(const string_pool_t *string_pool)
+{
+	return string_pool->num_strings;
+}
+
+void string_pool_free(string_pool_t *string_pool)
+{
+	struct string_pool_block *block = string_pool->blocks;
+	while (block != NULL) {
+		struct string_pool_block *next = block->next;
+		free(block);
+		block = next;
+	}
+	free(string_pool->hash_table);
+
+	string_pool->blocks = NULL;
+	string_pool->hash_table = NULL;
+	string_pool->hash_table_size = 0;
+	string_pool->num_strings = 0;
+}
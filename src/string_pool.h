@@ -0,0 +1,60 @@
+#ifndef STRING_POOL_H_DEFINED
+#define STRING_POOL_H_DEFINED
+
+#include <stddef.h>
+
+/**
+ * Block of string storage in the string pool.
+ **/
+struct string_pool_block {
+	///Allocated size of the block
+	size_t available_size;
+	///Number of bytes used in the block
+	size_t used_size;
+	///Next block in list
+	struct string_pool_block *next;
+	///String data
+	char data[];
+};
+
+/**
+ * Pool of interned strings. Each distinct string is stored once, and returned pointers stay valid
+ * until the pool is freed. Used for satellite names and TLE filenames in the TLE database, where
+ * the same filename is shared between a large number of entries.
+ **/
+typedef struct {
+	///Linked list of storage blocks, most recently allocated block first
+	struct string_pool_block *blocks;
+	///Open addressing hash table over the stored strings, used for deduplication
+	const char **hash_table;
+	///Number of slots in the hash table
+	size_t hash_table_size;
+	///Number of distinct strings in the pool
+	size_t num_strings;
+} string_pool_t;
+
+/**
+ * Add string to string pool, or find the existing copy if it already has been added.
+ *
+ * \param string_pool String pool
+ * \param string String to add. NULL is treated as an empty string
+ * \return Pointer to the pooled copy of the string, NULL on allocation failure
+ **/
+const char *string_pool_intern(string_pool_t *string_pool, const char *string);
+
+/**
+ * Get number of distinct strings in the string pool.
+ *
+ * \param string_pool String pool
+ * \return Number of strings
+ **/
+size_t string_pool_size(const string_pool_t *string_pool);
+
+/**
+ * Free memory allocated in string pool. All pointers returned by string_pool_intern() are invalidated.
+ *
+ * \param string_pool String pool to free
+ **/
+void string_pool_free(string_pool_t *string_pool);
+
+#endif
@@ -11,6 +11,11 @@
 #include <unistd.h>
 #include "string_array.h"
 #include <ctype.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <pthread.h>
 
 struct tle_db *tle_db_create()
 {
@@ -19,51 +24,237 @@ struct tle_db *tle_db_create()
 	return tle_db;
 }
 
+void tle_db_orbital_elements_release(struct tle_db_orbital_elements **orbital_elements)
+{
+	if (*orbital_elements == NULL) {
+		return;
+	}
+
+	(*orbital_elements)->refcount--;
+	if ((*orbital_elements)->refcount == 0) {
+		predict_destroy_orbital_elements((*orbital_elements)->elements);
+		free(*orbital_elements);
+	}
+	*orbital_elements = NULL;
+}
+
+/**
+ * Drop the references to the orbital elements cached for the TLE database entries.
+ *
+ * \param tle_db TLE database
+ **/
+static void tle_db_clear_orbital_elements(struct tle_db *tle_db)
+{
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_orbital_elements_release(&(tle_db->tles[i].orbital_elements));
+	}
+}
+
 void tle_db_destroy(struct tle_db **tle_db)
 {
+	tle_db_clear_orbital_elements(*tle_db);
 	if ((*tle_db)->tles != NULL) {
 		free((*tle_db)->tles);
 	}
+	string_pool_free(&((*tle_db)->strings));
+	free((*tle_db)->index_table);
 	free(*tle_db);
 	*tle_db = NULL;
 }
 
 /**
- * Check if tle_1 is more recent than tle_2.
+ * Parse integer from fixed columns in TLE line.
  *
- * \param tle_1 First NORAD TLE
- * \param tle_2 Second NORAD TLE
- * \return True if tle_1 is newer than tle_2, false otherwise
+ * \param line TLE line
+ * \param start Start column, zero-indexed
+ * \param length Number of columns
+ * \return Parsed number
  **/
-bool tle_is_newer_than(char *tle_1[2], char *tle_2[2])
+static long tle_column_long(const char *line, int start, int length)
+{
+	char field[TLE_LINE_LENGTH+1] = {0};
+	memcpy(field, line + start, length);
+	return strtol(field, NULL, 10);
+}
+
+predict_julian_date_t tle_db_epoch(int epoch_year, double epoch_day)
 {
-	predict_orbital_elements_t *orbele_1 = predict_parse_tle(tle_1[0], tle_1[1]);
-	predict_orbital_elements_t *orbele_2 = predict_parse_tle(tle_2[0], tle_1[1]);
+	if (epoch_year < 57) {
+		epoch_year += 2000;
+	} else if (epoch_year < 100) {
+		epoch_year += 1900;
+	}
 
-	double epoch_1 = orbele_1->epoch_year*1000.0 + orbele_1->epoch_day;
-	double epoch_2 = orbele_2->epoch_year*1000.0 + orbele_2->epoch_day;
+	//days from 1601-01-01 to the start of the epoch year and to the UNIX epoch, start of a 400-year leap year cycle
+	long years = epoch_year - 1601;
+	long days_to_year_start = years*365 + years/4 - years/100 + years/400;
+	years = 1970 - 1601;
+	long days_to_unix_epoch = years*365 + years/4 - years/100 + years/400;
 
-	predict_destroy_orbital_elements(orbele_1);
-	predict_destroy_orbital_elements(orbele_2);
+	time_t year_start = (days_to_year_start - days_to_unix_epoch)*SECDAY;
+	return predict_to_julian(year_start) + epoch_day - 1.0;
+}
 
-	return epoch_1 > epoch_2;
+/**
+ * Get epoch of TLE directly from the epoch year (columns 19-20) and epoch day (columns 21-32) of TLE line 1.
+ *
+ * \param line1 TLE line 1
+ * \return Epoch as Julian date, 0 if line is too short to contain the epoch
+ **/
+static predict_julian_date_t tle_epoch(const char *line1)
+{
+	if (strlen(line1) < 32) {
+		return 0;
+	}
+
+	char day_field[13] = {0};
+	memcpy(day_field, line1 + 20, 12);
+	return tle_db_epoch(tle_column_long(line1, 18, 2), strtod(day_field, NULL));
 }
 
 bool tle_db_entry_is_newer_than(struct tle_db_entry tle_entry_1, struct tle_db_entry tle_entry_2)
 {
-	char *tle_1[2] = {tle_entry_1.line1, tle_entry_1.line2};
-	char *tle_2[2] = {tle_entry_2.line1, tle_entry_2.line2};
-	return tle_is_newer_than(tle_1, tle_2);
+	//entries constructed outside of a TLE database have no extracted epoch
+	predict_julian_date_t epoch_1 = (tle_entry_1.epoch != 0) ? tle_entry_1.epoch : tle_epoch(tle_entry_1.line1);
+	predict_julian_date_t epoch_2 = (tle_entry_2.epoch != 0) ? tle_entry_2.epoch : tle_epoch(tle_entry_2.line1);
+	return epoch_1 > epoch_2;
+}
+
+//initial number of slots in the satellite number hash index
+#define TLE_DB_INITIAL_INDEX_SIZE 64
+
+/**
+ * Hash satellite number into slot in the satellite number hash index.
+ *
+ * \param satellite_number Satellite number
+ * \param table_size Number of slots in hash table, power of two
+ * \return Initial probe slot
+ **/
+static size_t tle_db_index_hash(long satellite_number, size_t table_size)
+{
+	uint64_t hash = (uint64_t)satellite_number * 0x9E3779B97F4A7C15ULL;
+	return (hash ^ (hash >> 32)) & (table_size-1);
+}
+
+/**
+ * Find slot in satellite number hash index. Returns either the slot pointing to a TLE entry with the given satellite number,
+ * or the empty slot where it would be inserted.
+ *
+ * \param tle_db TLE database
+ * \param satellite_number Satellite number
+ * \return Slot index
+ **/
+static size_t tle_db_index_slot(const struct tle_db *tle_db, long satellite_number)
+{
+	size_t mask = tle_db->index_table_size-1;
+	size_t slot = tle_db_index_hash(satellite_number, tle_db->index_table_size);
+	while (tle_db->index_table[slot] != 0) {
+		if (tle_db->tles[tle_db->index_table[slot]-1].satellite_number == satellite_number) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+/**
+ * Insert TLE entry into satellite number hash index. Entries with a satellite number that already is indexed
+ * are only indexed if they precede the existing entry in the TLE array.
+ *
+ * \param tle_db TLE database
+ * \param entry_index Index of entry in TLE array
+ **/
+static void tle_db_index_insert(struct tle_db *tle_db, int entry_index)
+{
+	size_t slot = tle_db_index_slot(tle_db, tle_db->tles[entry_index].satellite_number);
+	if ((tle_db->index_table[slot] == 0) || (tle_db->index_table[slot]-1 > entry_index)) {
+		tle_db->index_table[slot] = entry_index+1;
+	}
+}
+
+/**
+ * Rebuild satellite number hash index from the TLE entries.
+ *
+ * \param tle_db TLE database
+ * \param table_size Number of slots in the new hash table, power of two
+ * \return 0 on success, -1 on allocation failure
+ **/
+static int tle_db_index_rebuild(struct tle_db *tle_db, size_t table_size)
+{
+	int *new_table = (int*)calloc(table_size, sizeof(int));
+	if (new_table == NULL) {
+		return -1;
+	}
+	free(tle_db->index_table);
+	tle_db->index_table = new_table;
+	tle_db->index_table_size = table_size;
+
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_index_insert(tle_db, i);
+	}
+	return 0;
+}
+
+/**
+ * Remove TLE entry from satellite number hash index, using backward shift deletion to keep the
+ * probe sequences intact. If another entry has the same satellite number, it is indexed instead.
+ *
+ * \param tle_db TLE database
+ * \param entry_index Index of entry in TLE array
+ **/
+static void tle_db_index_remove(struct tle_db *tle_db, int entry_index)
+{
+	long satellite_number = tle_db->tles[entry_index].satellite_number;
+	size_t slot = tle_db_index_slot(tle_db, satellite_number);
+	if (tle_db->index_table[slot] != entry_index+1) {
+		return;
+	}
+
+	size_t mask = tle_db->index_table_size-1;
+	size_t empty_slot = slot;
+	size_t next_slot = (slot + 1) & mask;
+	while (tle_db->index_table[next_slot] != 0) {
+		long next_satellite_number = tle_db->tles[tle_db->index_table[next_slot]-1].satellite_number;
+		size_t home_slot = tle_db_index_hash(next_satellite_number, tle_db->index_table_size);
+
+		//move entry back if its home slot does not lie cyclically within (empty_slot, next_slot]
+		if (((next_slot - home_slot) & mask) >= ((next_slot - empty_slot) & mask)) {
+			tle_db->index_table[empty_slot] = tle_db->index_table[next_slot];
+			empty_slot = next_slot;
+		}
+		next_slot = (next_slot + 1) & mask;
+	}
+	tle_db->index_table[empty_slot] = 0;
+
+	//index any duplicate definition of the same satellite number
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if ((i != entry_index) && (tle_db->tles[i].satellite_number == satellite_number)) {
+			tle_db_index_insert(tle_db, i);
+			break;
+		}
+	}
 }
 
 void tle_db_overwrite_entry(int entry_index, struct tle_db *tle_db, const struct tle_db_entry *new_entry)
 {
 	if (entry_index < tle_db->num_tles) {
-		tle_db->tles[entry_index].satellite_number = new_entry->satellite_number;
-		strncpy(tle_db->tles[entry_index].name, new_entry->name, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].line1, new_entry->line1, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].line2, new_entry->line2, MAX_NUM_CHARS);
-		strncpy(tle_db->tles[entry_index].filename, new_entry->filename, MAX_NUM_CHARS);
+		struct tle_db_entry *entry = &(tle_db->tles[entry_index]);
+		bool satellite_number_changed = (entry->satellite_number != new_entry->satellite_number);
+		if (satellite_number_changed) {
+			tle_db_index_remove(tle_db, entry_index);
+		}
+		entry->satellite_number = new_entry->satellite_number;
+		if (satellite_number_changed) {
+			tle_db_index_insert(tle_db, entry_index);
+		}
+		entry->name = string_pool_intern(&(tle_db->strings), new_entry->name);
+		entry->filename = string_pool_intern(&(tle_db->strings), new_entry->filename);
+		memcpy(entry->line1, new_entry->line1, sizeof(entry->line1));
+		memcpy(entry->line2, new_entry->line2, sizeof(entry->line2));
+		entry->line1[TLE_LINE_LENGTH] = '\0';
+		entry->line2[TLE_LINE_LENGTH] = '\0';
+		entry->epoch = tle_epoch(entry->line1);
+		tle_db_orbital_elements_release(&(entry->orbital_elements));
 	}
 }
 
@@ -87,27 +278,36 @@ void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry)
 		tle_db->tles = temp;
 	}
 
+	//keep load factor of the satellite number index below 1/2
+	if ((tle_db->num_tles+1)*2 > tle_db->index_table_size) {
+		size_t new_size = TLE_DB_INITIAL_INDEX_SIZE;
+		if (tle_db->index_table_size > 0) {
+			new_size = tle_db->index_table_size*2;
+		}
+		if (tle_db_index_rebuild(tle_db, new_size) != 0) {
+			return;
+		}
+	}
+
 	tle_db->num_tles++;
+	struct tle_db_entry *new_entry = &(tle_db->tles[tle_db->num_tles-1]);
+	memset(new_entry, 0, sizeof(struct tle_db_entry));
+	new_entry->satellite_number = entry->satellite_number;
+	tle_db_index_insert(tle_db, tle_db->num_tles-1);
 	tle_db_overwrite_entry(tle_db->num_tles-1, tle_db, entry);
 }
 
 void tle_db_merge(struct tle_db *new_db, struct tle_db *main_db, enum tle_merge_behavior merge_opt)
 {
 	for (int i=0; i < new_db->num_tles; i++) {
-		bool tle_exists = false;
-		for (int j=0; j < main_db->num_tles; j++) {
-			//check whether TLE already exists in the database
-			if (new_db->tles[i].satellite_number == main_db->tles[j].satellite_number) {
-				tle_exists = true;
-
-				if ((merge_opt == TLE_OVERWRITE_OLD) && tle_db_entry_is_newer_than(new_db->tles[i], main_db->tles[j])) {
-					tle_db_overwrite_entry(j, main_db, &(new_db->tles[i]));
-				}
+		//check whether TLE already exists in the database
+		int j = tle_db_find_entry(main_db, new_db->tles[i].satellite_number);
+		if (j != -1) {
+			if ((merge_opt == TLE_OVERWRITE_OLD) && tle_db_entry_is_newer_than(new_db->tles[i], main_db->tles[j])) {
+				tle_db_overwrite_entry(j, main_db, &(new_db->tles[i]));
 			}
-		}
-
-		//append TLE entry to main TLE database
-		if (!tle_exists) {
+		} else {
+			//append TLE entry to main TLE database
 			tle_db_add_entry(main_db, &(new_db->tles[i]));
 		}
 	}
@@ -115,12 +315,50 @@ void tle_db_merge(struct tle_db *new_db, struct tle_db *main_db, enum tle_merge_
 
 int tle_db_find_entry(const struct tle_db *tle_db, long satellite_number)
 {
-	for (int i=0; i < tle_db->num_tles; i++) {
-		if (tle_db->tles[i].satellite_number == satellite_number) {
-			return i;
+	if ((tle_db->num_tles == 0) || (tle_db->index_table_size == 0)) {
+		return -1;
+	}
+	size_t slot = tle_db_index_slot(tle_db, satellite_number);
+	return tle_db->index_table[slot]-1;
+}
+
+//maximum number of threads used for reading the TLE files of a directory in parallel
+#define TLE_DB_MAX_LOADER_THREADS 8
+
+/**
+ * Shared state of the threads reading TLE files in tle_db_from_directory().
+ **/
+struct tle_db_loader {
+	///Paths to TLE files
+	string_array_t *filepaths;
+	///Returned TLE databases, one for each file
+	struct tle_db **file_dbs;
+	///Index of next file to read
+	int next_file;
+	///Mutex protecting next_file
+	pthread_mutex_t mutex;
+};
+
+/**
+ * Thread function for reading TLE files. Picks files from the shared list until all files are read.
+ *
+ * \param data Loader state, struct tle_db_loader
+ * \return NULL
+ **/
+static void *tle_db_loader_thread(void *data)
+{
+	struct tle_db_loader *loader = (struct tle_db_loader*)data;
+	while (true) {
+		pthread_mutex_lock(&(loader->mutex));
+		int file_index = loader->next_file++;
+		pthread_mutex_unlock(&(loader->mutex));
+
+		if (file_index >= string_array_size(loader->filepaths)) {
+			break;
 		}
+		tle_db_from_file(string_array_get(loader->filepaths, file_index), loader->file_dbs[file_index]);
 	}
-	return -1;
+	return NULL;
 }
 
 void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
@@ -133,31 +371,155 @@ void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
 		dirpath_ext = (char*)malloc(sizeof(char)*(strlen(dirpath)+2));
 		strcpy(dirpath_ext, dirpath);
 		dirpath_ext[strlen(dirpath)] = '/';
-		dirpath_ext[strlen(dirpath_ext)] = '\0';
+		dirpath_ext[strlen(dirpath)+1] = '\0';
 	} else {
 		dirpath_ext = strdup(dirpath);
 	}
 
+	//collect TLE files in directory, sorted by filename so that the merge order is independent of the directory order
+	string_array_t filepaths = {0};
 	d = opendir(dirpath_ext);
 	if (d) {
 		while ((file = readdir(d)) != NULL) {
 			if (file->d_type == DT_REG) {
-				int pathsize = strlen(file->d_name) + strlen(dirpath_ext) + 1;
-				char *full_path = (char*)malloc(sizeof(char)*pathsize);
-				snprintf(full_path, pathsize, "%s%s", dirpath_ext, file->d_name);
-
-				//read into empty TLE db
-				struct tle_db temp_db = {0};
-				tle_db_from_file(full_path, &temp_db);
-				free(full_path);
-
-				//merge with existing TLE db
-				tle_db_merge(&temp_db, ret_tle_db, TLE_OVERWRITE_OLD); //overwrite only entries with older epochs
+				char full_path[MAX_NUM_CHARS];
+				snprintf(full_path, MAX_NUM_CHARS, "%s%s", dirpath_ext, file->d_name);
+				string_array_add(&filepaths, full_path);
 			}
 		}
 		closedir(d);
 	}
 	free(dirpath_ext);
+	string_array_sort(&filepaths);
+
+	int num_files = string_array_size(&filepaths);
+	if (num_files == 0) {
+		return;
+	}
+
+	//read files into separate TLE databases in parallel
+	struct tle_db_loader loader = {0};
+	loader.filepaths = &filepaths;
+	loader.file_dbs = (struct tle_db**)malloc(sizeof(struct tle_db*)*num_files);
+	for (int i=0; i < num_files; i++) {
+		loader.file_dbs[i] = tle_db_create();
+	}
+	pthread_mutex_init(&(loader.mutex), NULL);
+
+	int num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > TLE_DB_MAX_LOADER_THREADS) {
+		num_threads = TLE_DB_MAX_LOADER_THREADS;
+	}
+	if (num_threads > num_files) {
+		num_threads = num_files;
+	}
+
+	pthread_t threads[TLE_DB_MAX_LOADER_THREADS];
+	int num_started_threads = 0;
+	for (int i=1; i < num_threads; i++) {
+		if (pthread_create(&(threads[num_started_threads]), NULL, tle_db_loader_thread, &loader) == 0) {
+			num_started_threads++;
+		}
+	}
+	tle_db_loader_thread(&loader); //read files in this thread as well
+	for (int i=0; i < num_started_threads; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&(loader.mutex));
+
+	//merge with existing TLE db in filename order
+	for (int i=0; i < num_files; i++) {
+		tle_db_merge(loader.file_dbs[i], ret_tle_db, TLE_OVERWRITE_OLD); //overwrite only entries with older epochs
+		tle_db_destroy(&(loader.file_dbs[i]));
+	}
+	free(loader.file_dbs);
+	string_array_free(&filepaths);
+}
+
+//number of characters of a TLE line included in its checksum, followed by the checksum digit
+#define TLE_CHECKSUM_LENGTH 68
+
+//byte patterns used for checking eight characters at a time
+#define TLE_BYTES(x) (UINT64_C(0x0101010101010101)*(x))
+
+/**
+ * Calculate the checksum value of a TLE line: the sum of its first 68 characters, where digits count as their value,
+ * '-' as 1 and everything else as 0.
+ *
+ * The characters are processed eight at a time within a 64 bit word (SWAR), without a table lookup per character,
+ * so that the calculation is fast also in builds without optimization. Characters outside ASCII count as 0.
+ *
+ * \param line TLE line, at least TLE_LINE_LENGTH characters
+ * \return Sum of checksum values, not reduced modulo 10
+ **/
+static unsigned tle_line_checksum(const char *line)
+{
+	//each byte of the accumulator stays below 8*9, since each byte contributes at most 9 per word
+	uint64_t sums = 0;
+	for (int offset=0; offset + 8 <= TLE_CHECKSUM_LENGTH; offset += 8) {
+		uint64_t word;
+		memcpy(&word, line + offset, sizeof(word));
+		uint64_t ascii = ~word & TLE_BYTES(0x80);
+		uint64_t low = word & TLE_BYTES(0x7f);
+
+		//high bit of each byte set for '0' <= c <= '9', without borrows between the bytes
+		uint64_t above_zero = (low | TLE_BYTES(0x80)) - TLE_BYTES('0');
+		uint64_t below_nine = TLE_BYTES(0x80 | '9') - low;
+		uint64_t digit = above_zero & below_nine & ascii;
+		uint64_t digit_mask = (digit >> 7)*0xff;
+
+		//high bit of each byte set for '-'
+		uint64_t difference = word ^ TLE_BYTES('-');
+		uint64_t minus = ~(((difference & TLE_BYTES(0x7f)) + TLE_BYTES(0x7f)) | difference) & TLE_BYTES(0x80);
+
+		sums += (above_zero & TLE_BYTES(0x7f) & digit_mask) + (minus >> 7);
+	}
+
+	//add the bytes of the accumulator in 16 bit lanes
+	uint64_t pairs = (sums & UINT64_C(0x00ff00ff00ff00ff)) + ((sums >> 8) & UINT64_C(0x00ff00ff00ff00ff));
+	unsigned sum = (pairs*UINT64_C(0x0001000100010001)) >> 48;
+
+	//remaining characters
+	for (int x=TLE_CHECKSUM_LENGTH - TLE_CHECKSUM_LENGTH % 8; x < TLE_CHECKSUM_LENGTH; x++) {
+		unsigned char c = line[x];
+		sum += isdigit(c) ? c - '0' : (c == '-');
+	}
+	return sum;
+}
+
+/**
+ * Check the fixed columns and the checksum digits of a TLE, given the checksum values of its lines.
+ *
+ * \param line1 Line 1 of TLE, at least TLE_LINE_LENGTH characters
+ * \param sum1 Checksum value of line 1, as returned by tle_line_checksum()
+ * \param line2 Line 2 of TLE, at least TLE_LINE_LENGTH characters
+ * \param sum2 Checksum value of line 2, as returned by tle_line_checksum()
+ * \return True if valid, false otherwise
+ **/
+static bool tle_lines_valid(const char *line1, unsigned sum1, const char *line2, unsigned sum2)
+{
+	const unsigned char *l1 = (const unsigned char*)line1;
+	const unsigned char *l2 = (const unsigned char*)line2;
+
+	/* Perform a "torture test" on the data */
+
+	int x=(!isdigit(l1[68]) || ((unsigned)(l1[68]-'0') != sum1%10)) |
+	  (!isdigit(l2[68]) || ((unsigned)(l2[68]-'0') != sum2%10)) |
+	  (l1[0]^'1')  | (l1[1]^' ')  | (l1[7]^'U')  |
+	  (l1[8]^' ')  | (l1[17]^' ') | (l1[23]^'.') |
+	  (l1[32]^' ') | (l1[34]^'.') | (l1[43]^' ') |
+	  (l1[52]^' ') | (l1[61]^' ') | (l1[62]^'0') |
+	  (l1[63]^' ') | (l2[0]^'2')  | (l2[1]^' ')  |
+	  (l2[7]^' ')  | (l2[11]^'.') | (l2[16]^' ') |
+	  (l2[20]^'.') | (l2[25]^' ') | (l2[33]^' ') |
+	  (l2[37]^'.') | (l2[42]^' ') | (l2[46]^'.') |
+	  (l2[51]^' ') | (l2[54]^'.') | (l1[2]^l2[2]) |
+	  (l1[3]^l2[3]) | (l1[4]^l2[4]) |
+	  (l1[5]^l2[5]) | (l1[6]^l2[6]) |
+	  (isdigit(l1[18]) ? 0 : 1) | (isdigit(l1[19]) ? 0 : 1) |
+	  (isdigit(l2[31]) ? 0 : 1) | (isdigit(l2[32]) ? 0 : 1);
+
+	return !x;
 }
 
 /* This function scans line 1 and line 2 of a NASA 2-Line element
@@ -167,112 +529,287 @@ void tle_db_from_directory(const char *dirpath, struct tle_db *ret_tle_db)
  * element set and not just some random text that might pass
  * as orbital data based on a simple checksum calculation alone.
  *
- * \param line1 Line 1 of TLE
- * \param line2 Line 2 of TLE
+ * \param line1 Line 1 of TLE, at least TLE_LINE_LENGTH characters
+ * \param line2 Line 2 of TLE, at least TLE_LINE_LENGTH characters
  * \return 1 if valid, 0 if not
  **/
 char KepCheck(const char *line1, const char *line2)
 {
-	int x;
-	unsigned sum1, sum2;
+	return tle_lines_valid(line1, tle_line_checksum(line1), line2, tle_line_checksum(line2));
+}
 
-	unsigned char val[256];
+/**
+ * TLE record located within a memory mapped TLE file. Pointers refer directly to the mapped file contents.
+ **/
+struct tle_record {
+	///Start of name line
+	const char *name;
+	///Length of name line, excluding line endings
+	size_t name_length;
+	///Start of TLE line 1
+	const char *line1;
+	///Length of TLE line 1, excluding line endings
+	size_t line1_length;
+	///Start of TLE line 2
+	const char *line2;
+	///Length of TLE line 2, excluding line endings
+	size_t line2_length;
+};
+
+//number of TLE records that are collected before they are validated and added to the database
+#define TLE_PARSE_BATCH_SIZE 256
 
-	/* Set up translation table for computing TLE checksums */
+/**
+ * Validate a batch of TLE records. Records with too short lines are rejected first, then the checksums of all
+ * remaining lines in the batch are calculated in one pass, and finally the records are checked as in KepCheck().
+ *
+ * \param num_records Number of records, at most TLE_PARSE_BATCH_SIZE
+ * \param records TLE records
+ * \param ret_valid Returned validity of each record
+ **/
+static void tle_records_validate(int num_records, const struct tle_record *records, bool *ret_valid)
+{
+	for (int i=0; i < num_records; i++) {
+		ret_valid[i] = (records[i].line1_length >= TLE_LINE_LENGTH) && (records[i].line2_length >= TLE_LINE_LENGTH);
+	}
 
-	for (x=0; x<=255; val[x]=0, x++);
-	for (x='0'; x<='9'; val[x]=x-'0', x++);
+	unsigned sums[TLE_PARSE_BATCH_SIZE][2] = {{0}};
+	for (int i=0; i < num_records; i++) {
+		if (ret_valid[i]) {
+			sums[i][0] = tle_line_checksum(records[i].line1);
+			sums[i][1] = tle_line_checksum(records[i].line2);
+		}
+	}
 
-	val['-']=1;
+	for (int i=0; i < num_records; i++) {
+		if (ret_valid[i]) {
+			ret_valid[i] = tle_lines_valid(records[i].line1, sums[i][0], records[i].line2, sums[i][1]);
+		}
+	}
+}
 
-	/* Compute checksum for each line */
+/**
+ * Add validated batch of TLE records to TLE database. Satellite number is read directly from columns 3-7 in line 1,
+ * and the epoch is extracted from line 1 by tle_db_add_entry().
+ *
+ * \param num_records Number of records
+ * \param records TLE records
+ * \param valid Validity of each record, as returned by tle_records_validate()
+ * \param tle_file Filename the records were read from
+ * \param ret_db TLE database to which records are added
+ **/
+static void tle_records_add(int num_records, const struct tle_record *records, const bool *valid, const char *tle_file, struct tle_db *ret_db)
+{
+	for (int i=0; i < num_records; i++) {
+		if (!valid[i]) {
+			continue;
+		}
 
-	for (x=0, sum1=0, sum2=0; x<=67; sum1+=val[(int)line1[x]], sum2+=val[(int)line2[x]], x++);
+		/* Some TLE sources left justify the sat
+		   name in a 24-byte field that is padded
+		   with blanks. Cut out the blanks. */
 
-	/* Perform a "torture test" on the data */
+		char name[TLE_NAME_LENGTH+1] = {0};
+		size_t name_length = records[i].name_length;
+		while ((name_length > 0) && (records[i].name[name_length-1] == ' ')) {
+			name_length--;
+		}
+		if (name_length > TLE_NAME_LENGTH) {
+			name_length = TLE_NAME_LENGTH;
+		}
+		memcpy(name, records[i].name, name_length);
 
-	x=(val[(int)line1[68]]^(sum1%10)) | (val[(int)line2[68]]^(sum2%10)) |
-	  (line1[0]^'1')  | (line1[1]^' ')  | (line1[7]^'U')  |
-	  (line1[8]^' ')  | (line1[17]^' ') | (line1[23]^'.') |
-	  (line1[32]^' ') | (line1[34]^'.') | (line1[43]^' ') |
-	  (line1[52]^' ') | (line1[61]^' ') | (line1[62]^'0') |
-	  (line1[63]^' ') | (line2[0]^'2')  | (line2[1]^' ')  |
-	  (line2[7]^' ')  | (line2[11]^'.') | (line2[16]^' ') |
-	  (line2[20]^'.') | (line2[25]^' ') | (line2[33]^' ') |
-	  (line2[37]^'.') | (line2[42]^' ') | (line2[46]^'.') |
-	  (line2[51]^' ') | (line2[54]^'.') | (line1[2]^line2[2]) |
-	  (line1[3]^line2[3]) | (line1[4]^line2[4]) |
-	  (line1[5]^line2[5]) | (line1[6]^line2[6]) |
-	  (isdigit(line1[68]) ? 0 : 1) | (isdigit(line2[68]) ? 0 : 1) |
-	  (isdigit(line1[18]) ? 0 : 1) | (isdigit(line1[19]) ? 0 : 1) |
-	  (isdigit(line2[31]) ? 0 : 1) | (isdigit(line2[32]) ? 0 : 1);
+		struct tle_db_entry entry = {0};
+		entry.name = name;
+		entry.filename = tle_file;
+		memcpy(entry.line1, records[i].line1, TLE_LINE_LENGTH);
+		memcpy(entry.line2, records[i].line2, TLE_LINE_LENGTH);
+		entry.satellite_number = tle_column_long(entry.line1, 2, 5);
 
-	return (x ? 0 : 1);
+		tle_db_add_entry(ret_db, &entry);
+	}
 }
 
-#define NUM_CHARS_IN_TLE 80
-
-int tle_db_from_file(const char *tle_file, struct tle_db *ret_db)
+/**
+ * Get next line in buffer.
+ *
+ * \param pos Current position in buffer. Is set to the start of the following line
+ * \param end End of buffer
+ * \param ret_length Returned length of the line, excluding line endings
+ * \return Start of line, NULL if there are no more lines
+ **/
+static const char *tle_next_line(const char **pos, const char *end, size_t *ret_length)
 {
-	//copied from ReadDataFiles().
+	const char *line = *pos;
+	if (line >= end) {
+		return NULL;
+	}
 
-	ret_db->num_tles = 0;
-	int y = 0;
+	const char *newline = memchr(line, '\n', end - line);
+	if (newline == NULL) {
+		newline = end;
+		*pos = end;
+	} else {
+		*pos = newline + 1;
+	}
 
-	FILE *fd=fopen(tle_file,"r");
-	if (fd!=NULL) {
-		while (feof(fd)==0) {
-			/* Initialize variables */
-			char name[NUM_CHARS_IN_TLE] = {0};
-			char line1[NUM_CHARS_IN_TLE] = {0};
-			char line2[NUM_CHARS_IN_TLE] = {0};
+	size_t length = newline - line;
+	if ((length > 0) && (line[length-1] == '\r')) {
+		length--;
+	}
+	*ret_length = length;
+	return line;
+}
 
-			/* Read element set */
+/**
+ * Parse TLE records from a buffer containing the contents of a TLE file, and add the valid records to the database.
+ *
+ * \param buffer File contents
+ * \param size Size of the file contents
+ * \param tle_file Filename the contents were read from
+ * \param ret_db TLE database
+ **/
+static void tle_db_from_buffer(const char *buffer, size_t size, const char *tle_file, struct tle_db *ret_db)
+{
+	const char *pos = buffer;
+	const char *end = buffer + size;
 
-			if (fgets(name, NUM_CHARS_IN_TLE, fd) == NULL) break;
-			if (fgets(line1, NUM_CHARS_IN_TLE, fd) == NULL) break;
-			if (fgets(line2, NUM_CHARS_IN_TLE, fd) == NULL) break;
+	//collect records in batches, validate the batch and add valid records to database
+	struct tle_record records[TLE_PARSE_BATCH_SIZE];
+	bool valid[TLE_PARSE_BATCH_SIZE];
+	int num_records = 0;
+	while (true) {
+		struct tle_record *record = &(records[num_records]);
+		record->name = tle_next_line(&pos, end, &(record->name_length));
+		record->line1 = tle_next_line(&pos, end, &(record->line1_length));
+		record->line2 = tle_next_line(&pos, end, &(record->line2_length));
+		bool complete_record = (record->line2 != NULL);
+		if (complete_record) {
+			num_records++;
+		}
 
-			if (KepCheck(line1,line2) && (feof(fd)==0)) {
-				/* We found a valid TLE! */
+		if ((num_records == TLE_PARSE_BATCH_SIZE) || (!complete_record && (num_records > 0))) {
+			tle_records_validate(num_records, records, valid);
+			tle_records_add(num_records, records, valid, tle_file, ret_db);
+			num_records = 0;
+		}
 
-				/* Some TLE sources left justify the sat
-				   name in a 24-byte field that is padded
-				   with blanks.  The following lines cut
-				   out the blanks as well as the line feed
-				   character read by the fgets() function. */
+		if (!complete_record) {
+			break;
+		}
+	}
+}
 
-				y=strlen(name);
+/**
+ * Clear the entries of a TLE database before it is read from file.
+ *
+ * \param ret_db TLE database
+ **/
+static void tle_db_clear_entries(struct tle_db *ret_db)
+{
+	tle_db_clear_orbital_elements(ret_db);
+	ret_db->num_tles = 0;
+	if (ret_db->index_table != NULL) {
+		memset(ret_db->index_table, 0, sizeof(int)*ret_db->index_table_size);
+	}
+}
 
-				while (name[y]==32 || name[y]==0 || name[y]==10 || name[y]==13 || y==0) {
-					name[y]=0;
-					y--;
-				}
+/**
+ * Open a regular file for reading.
+ *
+ * \param filename Filename
+ * \param ret_size Returned file size
+ * \return File descriptor, -1 if the file could not be opened or is not a regular file
+ **/
+static int tle_db_open_file(const char *filename, size_t *ret_size)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		return -1;
+	}
+
+	struct stat file_stat;
+	if ((fstat(fd, &file_stat) == -1) || !S_ISREG(file_stat.st_mode)) {
+		close(fd);
+		return -1;
+	}
+	*ret_size = file_stat.st_size;
+	return fd;
+}
 
-				/* Copy TLE data into the sat data structure */
+int tle_db_from_file(const char *tle_file, struct tle_db *ret_db)
+{
+	tle_db_clear_entries(ret_db);
 
-				struct tle_db_entry entry = {0};
+	size_t size;
+	int fd = tle_db_open_file(tle_file, &size);
+	if (fd == -1) {
+		return -1;
+	}
+	if (size == 0) {
+		close(fd);
+		return 0;
+	}
+
+	const char *buffer = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buffer == MAP_FAILED) {
+		return -1;
+	}
 
-				strncpy(entry.name,name,24);
-				strncpy(entry.line1,line1,69);
-				strncpy(entry.line2,line2,69);
+	tle_db_from_buffer(buffer, size, tle_file, ret_db);
+	munmap((void*)buffer, size);
+	return 0;
+}
 
-				/* Get satellite number, so that the satellite database can be parsed. */
+//initial size of the buffer in tle_db_from_changing_file() when the file is empty (bytes)
+#define TLE_DB_READ_BUFFER_SIZE 4096
 
-				predict_orbital_elements_t *temp_elements = predict_parse_tle(entry.line1, entry.line2);
-				entry.satellite_number = temp_elements->satellite_number;
-				predict_destroy_orbital_elements(temp_elements);
+int tle_db_from_changing_file(const char *tle_file, struct tle_db *ret_db)
+{
+	tle_db_clear_entries(ret_db);
 
-				strncpy(entry.filename, tle_file, MAX_NUM_CHARS);
+	size_t capacity;
+	int fd = tle_db_open_file(tle_file, &capacity);
+	if (fd == -1) {
+		return -1;
+	}
 
-				tle_db_add_entry(ret_db, &entry);
+	//read until end of file, since the file can grow or shrink after it was stat-ed
+	capacity = (capacity > 0) ? capacity + 1 : TLE_DB_READ_BUFFER_SIZE;
+	char *buffer = (char*)malloc(capacity);
+	size_t size = 0;
+	while (buffer != NULL) {
+		if (size == capacity) {
+			capacity *= 2;
+			char *larger_buffer = (char*)realloc(buffer, capacity);
+			if (larger_buffer == NULL) {
+				free(buffer);
+				buffer = NULL;
+				break;
 			}
+			buffer = larger_buffer;
 		}
 
-		fclose(fd);
-	} else {
+		ssize_t length = read(fd, buffer + size, capacity - size);
+		if ((length == -1) && (errno == EINTR)) {
+			continue;
+		} else if (length == -1) {
+			free(buffer);
+			buffer = NULL;
+		} else if (length == 0) {
+			break;
+		} else {
+			size += length;
+		}
+	}
+	close(fd);
+	if (buffer == NULL) {
 		return -1;
 	}
+
+	tle_db_from_buffer(buffer, size, tle_file, ret_db);
+	free(buffer);
 	return 0;
 }
 
@@ -328,110 +865,146 @@ char *tle_db_updatefile_writepath()
 }
 
 /**
- * Write the parts of the TLE database that are read from the supplied filename to file again. Used for updating
- * the TLE files with new information, if any.
+ * Write a subset of the TLE database to file. Used for rewriting a TLE file with updated entries.
  *
- * \param tle_filename Filename to which corresponding entries are found and written
+ * \param tle_filename Filename
  * \param tle_db TLE database
+ * \param tle_indices Indices of the TLE entries to write
+ * \param num_indices Number of indices
+ * \return 0 on success, -1 otherwise
  **/
-void tle_db_update_file(const char *tle_filename, struct tle_db *tle_db)
+static int tle_db_subset_to_file(const char *tle_filename, struct tle_db *tle_db, const int *tle_indices, int num_indices)
 {
 	struct tle_db *subset_db = tle_db_create();
-	for (int i=0; i < tle_db->num_tles; i++) {
-		if (strcmp(tle_db->tles[i].filename, tle_filename) == 0) {
-			tle_db_add_entry(subset_db, &(tle_db->tles[i]));
-		}
+	for (int i=0; i < num_indices; i++) {
+		tle_db_add_entry(subset_db, &(tle_db->tles[tle_indices[i]]));
 	}
-	tle_db_to_file(tle_filename, subset_db);
+	int retval = tle_db_to_file(tle_filename, subset_db);
 	tle_db_destroy(&subset_db);
+	return retval;
 }
 
-void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status)
+/**
+ * Find index of filename in list of filenames. Filenames are interned in the string pool of the TLE database,
+ * and are compared by pointer.
+ *
+ * \param filenames List of interned filenames
+ * \param num_filenames Number of filenames
+ * \param filename Interned filename to look up
+ * \return Index in list, -1 if not found
+ **/
+static int tle_db_filename_index(const char **filenames, int num_filenames, const char *filename)
 {
-	struct tle_db *new_db = tle_db_create();
-	int retval = tle_db_from_file(filename, new_db);
-	if (retval != 0) {
-		tle_db_destroy(&new_db);
-		return;
+	for (int i=0; i < num_filenames; i++) {
+		if (filenames[i] == filename) {
+			return i;
+		}
 	}
+	return -1;
+}
+
+void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status)
+{
+	string_array_t filenames = {0};
+	string_array_add(&filenames, filename);
+	tle_db_update_from_files(&filenames, tle_db, update_status);
+	string_array_free(&filenames);
+}
 
+void tle_db_update_from_files(string_array_t *filenames, struct tle_db *tle_db, int *update_status)
+{
 	if (update_status != NULL) {
 		for (int i=0; i < tle_db->num_tles; i++) {
 			update_status[i] = 0;
 		}
 	}
 
-	int num_tles_to_update = 0;
-	int *newer_tle_indices = (int*)malloc(sizeof(int)*new_db->num_tles); //indices in new TLE db that should be used to update internal db
-	int *tle_indices_to_update = (int*)malloc(sizeof(int)*new_db->num_tles); //indices in internal db that should be updated
+	//merge all update files, keeping the most recent TLE for each satellite
+	struct tle_db *new_db = tle_db_create();
+	for (int i=0; i < string_array_size(filenames); i++) {
+		struct tle_db *file_db = tle_db_create();
+		if (tle_db_from_file(string_array_get(filenames, i), file_db) == 0) {
+			tle_db_merge(file_db, new_db, TLE_OVERWRITE_OLD);
+		}
+		tle_db_destroy(&file_db);
+	}
 
-	//find more recent entries
+	//update internal db with more recent entries, and collect the TLE files they belong to
+	bool *entry_updated = (bool*)calloc(tle_db->num_tles, sizeof(bool));
+	const char **updated_files = (const char**)malloc(sizeof(const char*)*(new_db->num_tles+1));
+	int num_updated_files = 0;
 	for (int i=0; i < new_db->num_tles; i++) {
-		int index = tle_db_find_entry(tle_db, new_db->tles[i].satellite_number);
-		if (index != -1) {
-			if (tle_db_entry_is_newer_than(new_db->tles[i], tle_db->tles[index])) {
-				newer_tle_indices[num_tles_to_update] = i;
-				tle_indices_to_update[num_tles_to_update] = index;
-				num_tles_to_update++;
-			}
+		int tle_index = tle_db_find_entry(tle_db, new_db->tles[i].satellite_number);
+		if ((tle_index == -1) || !tle_db_entry_is_newer_than(new_db->tles[i], tle_db->tles[tle_index])) {
+			continue;
+		}
+
+		//update tle db entry with new entry, keep old filename and name
+		struct tle_db_entry *tle_entry = &(tle_db->tles[tle_index]);
+		struct tle_db_entry updated_entry = new_db->tles[i];
+		updated_entry.filename = tle_entry->filename;
+		updated_entry.name = tle_entry->name;
+		tle_db_overwrite_entry(tle_index, tle_db, &updated_entry);
+		entry_updated[tle_index] = true;
+		if (update_status != NULL) {
+			update_status[tle_index] |= TLE_DB_UPDATED;
+		}
+
+		if (tle_db_filename_index(updated_files, num_updated_files, tle_entry->filename) == -1) {
+			updated_files[num_updated_files++] = tle_entry->filename;
 		}
 	}
+	tle_db_destroy(&new_db);
 
-	if (num_tles_to_update <= 0) {
-		tle_db_destroy(&new_db);
-		return;
+	//bucket all entries of the affected files by file in a single pass, keeping the database order within each file
+	int *file_of_entry = (int*)malloc(sizeof(int)*(tle_db->num_tles+1));
+	int *bucket_start = (int*)calloc(num_updated_files+1, sizeof(int));
+	int *bucket_size = (int*)calloc(num_updated_files+1, sizeof(int));
+	int last_file = -1;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		//entries from the same file are usually adjacent
+		if ((last_file == -1) || (updated_files[last_file] != tle_db->tles[i].filename)) {
+			last_file = tle_db_filename_index(updated_files, num_updated_files, tle_db->tles[i].filename);
+		}
+		file_of_entry[i] = last_file;
+		if (last_file != -1) {
+			bucket_size[last_file]++;
+		}
+	}
+	for (int i=1; i <= num_updated_files; i++) {
+		bucket_start[i] = bucket_start[i-1] + bucket_size[i-1];
+	}
+	int *bucketed_entries = (int*)malloc(sizeof(int)*(bucket_start[num_updated_files]+1));
+	memset(bucket_size, 0, sizeof(int)*(num_updated_files+1));
+	for (int i=0; i < tle_db->num_tles; i++) {
+		int file = file_of_entry[i];
+		if (file != -1) {
+			bucketed_entries[bucket_start[file] + bucket_size[file]] = i;
+			bucket_size[file]++;
+		}
 	}
 
+	//rewrite each affected file once, collect updated entries that cannot be written to their original file
 	int num_unwritable = 0;
-	int *unwritable_tles = (int*)malloc(sizeof(int)*num_tles_to_update); //indices in the internal db that were updated, but cannot be written to the current file.
-
-	//go over tles to update, collect tles belonging to one file in one update, update the file if possible, add to above array if not. Update internal db with new TLE information.
-	for (int i=0; i < num_tles_to_update; i++) {
-		if (newer_tle_indices[i] != -1) {
-			char *tle_filename = tle_db->tles[tle_indices_to_update[i]].filename; //filename to be updated
-			bool file_is_writable = access(tle_filename, W_OK) == 0;
-
-			//find entries in tle database with corresponding filenames
-			for (int j=i; j < num_tles_to_update; j++) {
-				if (newer_tle_indices[j] != -1) {
-					int tle_index = tle_indices_to_update[j];
-					struct tle_db_entry *tle_update_entry = &(new_db->tles[newer_tle_indices[j]]);
-					struct tle_db_entry *tle_entry = &(tle_db->tles[tle_index]);
-					if (strcmp(tle_filename, tle_entry->filename) == 0) {
-						//update tle db entry with new entry
-						char keep_filename[MAX_NUM_CHARS];
-						char keep_name[MAX_NUM_CHARS];
-						strncpy(keep_filename, tle_entry->filename, MAX_NUM_CHARS);
-						strncpy(keep_name, tle_entry->name, MAX_NUM_CHARS);
-
-						tle_db_overwrite_entry(tle_index, tle_db, tle_update_entry);
-
-						//keep old filename and name
-						strncpy(tle_entry->filename, keep_filename, MAX_NUM_CHARS);
-						strncpy(tle_entry->name, keep_name, MAX_NUM_CHARS);
-
-						//set db indices to update to -1 in order to ignore them on the next update
-						newer_tle_indices[j] = -1;
-
-						if (update_status != NULL) {
-							update_status[tle_index] |= TLE_DB_UPDATED;
-							if (file_is_writable) {
-								update_status[tle_index] |= TLE_FILE_UPDATED;
-							}
-						}
-
-						if (!file_is_writable) {
-							//add to list over unwritable TLE filenames
-							unwritable_tles[num_unwritable] = tle_index;
-							num_unwritable++;
-						}
-					}
-				}
-			}
+	int *unwritable_tles = (int*)malloc(sizeof(int)*(tle_db->num_tles+1)); //indices in the internal db that were updated, but cannot be written to the current file.
+	for (int i=0; i < num_updated_files; i++) {
+		const int *entries = bucketed_entries + bucket_start[i];
+		bool file_is_writable = access(updated_files[i], W_OK) == 0;
+		if (file_is_writable) {
+			tle_db_subset_to_file(updated_files[i], tle_db, entries, bucket_size[i]);
+		}
 
-			//write updated TLE entries to file
+		for (int j=0; j < bucket_size[i]; j++) {
+			int tle_index = entries[j];
+			if (!entry_updated[tle_index]) {
+				continue;
+			}
 			if (file_is_writable) {
-				tle_db_update_file(tle_filename, tle_db);
+				if (update_status != NULL) {
+					update_status[tle_index] |= TLE_FILE_UPDATED;
+				}
+			} else {
+				unwritable_tles[num_unwritable++] = tle_index;
 			}
 		}
 	}
@@ -440,26 +1013,26 @@ void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_stat
 		//write unwritable TLEs to new file
 		char *new_tle_filename = tle_db_updatefile_writepath();
 
-		struct tle_db unwritable_db = {0};
+		const char *pooled_tle_filename = string_pool_intern(&(tle_db->strings), new_tle_filename);
 		for (int i=0; i < num_unwritable; i++) {
-			int tle_ind = unwritable_tles[i];
-			tle_db_add_entry(&unwritable_db, &(tle_db->tles[tle_ind]));
-			strncpy(tle_db->tles[tle_ind].filename, new_tle_filename, MAX_NUM_CHARS);
+			tle_db->tles[unwritable_tles[i]].filename = pooled_tle_filename;
 		}
-		int retval = tle_db_to_file(new_tle_filename, &unwritable_db);
+		int retval = tle_db_subset_to_file(new_tle_filename, tle_db, unwritable_tles, num_unwritable);
 		if ((update_status != NULL) && (retval != -1)) {
 			for (int i=0; i < num_unwritable; i++) {
-				int tle_ind = unwritable_tles[i];
-				update_status[tle_ind] |= TLE_IN_NEW_FILE;
+				update_status[unwritable_tles[i]] |= TLE_IN_NEW_FILE;
 			}
 		}
 		free(new_tle_filename);
 	}
 
-	free(newer_tle_indices);
-	free(tle_indices_to_update);
+	free(entry_updated);
+	free(updated_files);
+	free(file_of_entry);
+	free(bucket_start);
+	free(bucket_size);
+	free(bucketed_entries);
 	free(unwritable_tles);
-	tle_db_destroy(&new_db);
 }
 
 void tle_db_from_search_paths(struct tle_db *ret_tle_db)
@@ -506,14 +1079,25 @@ bool tle_db_entry_enabled(const struct tle_db *db, int tle_index)
 	return false;
 }
 
-predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db *db, int tle_index)
+struct tle_db_orbital_elements *tle_db_entry_get_orbital_elements(struct tle_db *db, int tle_index)
 {
-	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
-		const struct tle_db_entry *entry = &(db->tles[tle_index]);
-		return predict_parse_tle(entry->line1, entry->line2);
-	} else {
+	if ((tle_index >= db->num_tles) || (tle_index < 0)) {
 		return NULL;
 	}
+
+	struct tle_db_entry *entry = &(db->tles[tle_index]);
+	if (entry->orbital_elements == NULL) {
+		predict_orbital_elements_t *elements = predict_parse_tle(entry->line1, entry->line2);
+		if (elements == NULL) {
+			return NULL;
+		}
+		entry->orbital_elements = (struct tle_db_orbital_elements*)malloc(sizeof(struct tle_db_orbital_elements));
+		entry->orbital_elements->elements = elements;
+		entry->orbital_elements->refcount = 1; //reference held by the TLE database
+	}
+
+	entry->orbital_elements->refcount++;
+	return entry->orbital_elements;
 }
 
 const char *tle_db_entry_name(const struct tle_db *db, int tle_index)
@@ -524,6 +1108,30 @@ const char *tle_db_entry_name(const struct tle_db *db, int tle_index)
 	return NULL;
 }
 
+long tle_db_entry_satellite_number(const struct tle_db *db, int tle_index)
+{
+	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
+		return db->tles[tle_index].satellite_number;
+	}
+	return -1;
+}
+
+const char *tle_db_entry_filename(const struct tle_db *db, int tle_index)
+{
+	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
+		return db->tles[tle_index].filename;
+	}
+	return NULL;
+}
+
+const struct tle_db_entry *tle_db_get_entry(const struct tle_db *db, int tle_index)
+{
+	if ((tle_index < db->num_tles) && (tle_index >= 0)) {
+		return &(db->tles[tle_index]);
+	}
+	return NULL;
+}
+
 void whitelist_from_file(const char *file, struct tle_db *db)
 {
 	for (int i=0; i < db->num_tles; i++) {
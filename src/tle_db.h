@@ -3,25 +3,51 @@
 
 #include <stdbool.h>
 #include "string_array.h"
+#include "string_pool.h"
 #include "defines.h"
 #include <predict/predict.h>
 
+///Number of characters in a NORAD TLE line, excluding line endings
+#define TLE_LINE_LENGTH 69
+
+///Maximum number of characters in satellite name, as defined by the 24 character name field in TLE files
+#define TLE_NAME_LENGTH 24
+
+/**
+ * Reference counted orbital elements, parsed from the TLE lines of a TLE database entry. Shared between the TLE
+ * database, which keeps the parsed elements of each entry cached until the entry is overwritten, and any number of users.
+ **/
+struct tle_db_orbital_elements {
+	///Parsed orbital elements
+	predict_orbital_elements_t *elements;
+	///Number of holders of a reference, including the TLE database
+	int refcount;
+};
+
 /**
  * Entry in TLE database.
+ *
+ * Name and filename point to strings owned by the string pool of the TLE database the entry belongs to. Entries
+ * constructed outside of a database can point to any string, which will be copied into the pool of the database
+ * on tle_db_add_entry() or tle_db_overwrite_entry().
  **/
 struct tle_db_entry {
 	///satellite number, parsed from TLE line 1
 	long satellite_number;
 	///satellite name, defined in TLE file
-	char name[MAX_NUM_CHARS];
+	const char *name;
+	///Filename from which the TLE has been read
+	const char *filename;
 	///line 1 in NORAD TLE
-	char line1[MAX_NUM_CHARS];
+	char line1[TLE_LINE_LENGTH+1];
 	///line 2 in NORAD TLE
-	char line2[MAX_NUM_CHARS];
-	///Filename from which the TLE has been read
-	char filename[MAX_NUM_CHARS];
+	char line2[TLE_LINE_LENGTH+1];
+	///Epoch of TLE, extracted from line 1 when the entry is added to a TLE database
+	predict_julian_date_t epoch;
 	///Whether TLE entry is enabled for display
 	bool enabled;
+	///Cached orbital elements, parsed on first use through tle_db_entry_get_orbital_elements(). Owned by the TLE database and never copied with the entry
+	struct tle_db_orbital_elements *orbital_elements;
 };
 
 /**
@@ -36,6 +62,12 @@ struct tle_db {
 	size_t available_size;
 	///Whether TLE database was read from XDG standard paths or supplied on command line
 	bool read_from_xdg;
+	///Storage for satellite names and filenames of the TLE entries
+	string_pool_t strings;
+	///Open addressing hash table from satellite number to index in the TLE array. Slots contain index+1, 0 marks an empty slot
+	int *index_table;
+	///Number of slots in the hash table
+	size_t index_table_size;
 };
 
 /**
@@ -90,9 +122,25 @@ enum tle_db_update_status {
  **/
 void tle_db_update(const char *filename, struct tle_db *tle_db, int *update_status);
 
+/**
+ * Update internal TLE database with newer TLE entries located within any of the supplied files, following the same rules as tle_db_update().
+ * For satellites defined in multiple update files, the TLE with the most recent epoch is used.
+ *
+ * The updates are grouped by the TLE file the updated entries originally were read from, so that each affected file is written only once.
+ *
+ * \param filenames TLE files to read
+ * \param tle_db TLE database
+ * \param update_status Update status. Combines members in tle_db_update_status according to how each entry is treated
+ **/
+void tle_db_update_from_files(string_array_t *filenames, struct tle_db *tle_db, int *update_status);
+
 /**
  * Read TLEs from files in specified directory. When TLE entries are multiply defined
- * across TLE files, the TLE entry with the most recent epoch is chosen.
+ * across TLE files, the TLE entry with the most recent epoch is chosen. For entries with
+ * equal epochs, the entry from the file that comes first in filename order is chosen.
+ *
+ * Files are parsed in parallel and merged in filename order, so the result does not depend
+ * on the order in which the files are parsed or listed in the directory.
  *
  * \param dirpath Directory from which files are to be read
  * \param ret_tle_db Returned TLE database
@@ -116,6 +164,17 @@ string_array_t tle_db_filenames(const struct tle_db *db);
  **/
 int tle_db_from_file(const char *tle_file, struct tle_db *ret_db);
 
+/**
+ * Read TLE database from a file that can be modified while it is read, as tle_db_from_file(). The file is copied into
+ * memory using read() instead of being memory mapped, so that a file truncated by another process during the parse
+ * does not raise SIGBUS.
+ *
+ * \param tle_file TLE database file
+ * \param ret_db Returned TLE database
+ * \return 0 on success, -1 otherwise
+ **/
+int tle_db_from_changing_file(const char *tle_file, struct tle_db *ret_db);
+
 /**
  * Write contents of TLE database to file.
  *
@@ -145,7 +204,18 @@ enum tle_merge_behavior {
 void tle_db_merge(struct tle_db *new_db, struct tle_db *main_db, enum tle_merge_behavior merge_opt);
 
 /**
- * Check internal TLE lines within tle entries to see whether one is more recent than the other.
+ * Get epoch of a TLE from its epoch year and day, as in libpredict. Two-digit years from 57 and upwards are
+ * interpreted as 19xx, as in the TLE format definition.
+ *
+ * \param epoch_year Epoch year, two digits or full
+ * \param epoch_day Epoch day of year, starting at 1.0 at january 1st 00:00
+ * \return Epoch
+ **/
+predict_julian_date_t tle_db_epoch(int epoch_year, double epoch_day);
+
+/**
+ * Check epochs of TLE entries to see whether one is more recent than the other. Uses the epoch
+ * field of the entries, or the epoch in TLE line 1 for entries that are not part of a TLE database.
  *
  * \param tle_entry_1 TLE entry 1
  * \param tle_entry_2 TLE entry 2
@@ -166,12 +236,13 @@ void tle_db_overwrite_entry(int entry_index, struct tle_db *tle_db, const struct
  * Add TLE entry to database.
  *
  * \param tle_db TLE database
- * \param entry TLE database entry to add
+ * \param entry TLE database entry to add. Name and filename are copied into the TLE database
  **/
 void tle_db_add_entry(struct tle_db *tle_db, const struct tle_db_entry *entry);
 
 /**
- * Find TLE entry within TLE database. Searches with respect to the satellite number.
+ * Find TLE entry within TLE database. Searches with respect to the satellite number, using the hash index
+ * of the TLE database. If the satellite number is defined multiple times, the first entry is returned.
  *
  * \param tle_db TLE database
  * \param satellite_number Lookup satellite number
@@ -198,13 +269,24 @@ void tle_db_entry_set_enabled(struct tle_db *db, int tle_index, bool enabled);
 bool tle_db_entry_enabled(const struct tle_db *db, int tle_index);
 
 /**
- * Parse TLE database entry as an orbital elements struct.
+ * Get orbital elements of TLE database entry. The TLE is parsed on first use and cached in the TLE database
+ * until the entry is overwritten, so that repeated calls return the same orbital elements. The returned
+ * reference stays valid after the entry is overwritten or the database is destroyed, and has to be released
+ * using tle_db_orbital_elements_release().
  *
  * \param db TLE database
  * \param tle_index Index in TLE database
- * \return Orbital elements of TLE database entry
+ * \return Reference to orbital elements of TLE database entry, NULL if index is out of bounds or TLE could not be parsed
+ **/
+struct tle_db_orbital_elements *tle_db_entry_get_orbital_elements(struct tle_db *db, int tle_index);
+
+/**
+ * Release reference to orbital elements obtained from tle_db_entry_get_orbital_elements(). The orbital elements are freed
+ * when the last reference is released.
+ *
+ * \param orbital_elements Orbital elements to release, set to NULL
  **/
-predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db *db, int tle_index);
+void tle_db_orbital_elements_release(struct tle_db_orbital_elements **orbital_elements);
 
 /**
  * Get name of satellite corresponding to defined TLE entry.
@@ -215,6 +297,33 @@ predict_orbital_elements_t *tle_db_entry_to_orbital_elements(const struct tle_db
  **/
 const char *tle_db_entry_name(const struct tle_db *db, int tle_index);
 
+/**
+ * Get satellite number of defined TLE entry.
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \return Satellite number, -1 if index is out of bounds
+ **/
+long tle_db_entry_satellite_number(const struct tle_db *db, int tle_index);
+
+/**
+ * Get filename from which the defined TLE entry was read.
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \return Filename
+ **/
+const char *tle_db_entry_filename(const struct tle_db *db, int tle_index);
+
+/**
+ * Get TLE entry at specified index.
+ *
+ * \param db TLE database
+ * \param tle_index Index in TLE database
+ * \return TLE entry, NULL if index is out of bounds
+ **/
+const struct tle_db_entry *tle_db_get_entry(const struct tle_db *db, int tle_index);
+
 /**
  * Set TLE database entries to enabled according to whitelist file in search paths. Default is to let
  * TLE entry be disabled.
@@ -6,11 +6,16 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include "ui.h"
 #include "xdg_basedirs.h"
 
 #include "singletrack.h"
 #include "track_astronomical_bodies.h"
+#include "solar_system.h"
+#include "prediction_output.h"
+#include "root_finder.h"
 
 /**
  * Get name of astronomical body as string.
@@ -46,11 +51,11 @@ void observe_astronomical_body(enum astronomical_body type, predict_observer_t *
 {
 	switch (type) {
 		case PREDICT_SUN:
-			predict_observe_sun(qth, day, observation);
+			solar_system_observe_sun(qth, day, observation);
 			break;
 
 		case PREDICT_MOON:
-			predict_observe_moon(qth, day, observation);
+			solar_system_observe_moon(qth, day, observation);
 			break;
 
 		default:
@@ -60,6 +65,214 @@ void observe_astronomical_body(enum astronomical_body type, predict_observer_t *
 	}
 }
 
+//time step between samples in the search for rise, transit and set (days)
+#define ASTRONOMICAL_BODY_EVENT_STEP (1.0/24.0)
+
+//time offset on each side used for calculating the elevation rate (days)
+#define ASTRONOMICAL_BODY_RATE_OFFSET (10.0/86400.0)
+
+//rotation rate of the earth (radians/day)
+#define ASTRONOMICAL_BODY_EARTH_ROTATION_RATE (2.0*M_PI*1.00273790934)
+
+//upper bound for the change in elevation from the motion of the sun and moon on the sky, including the parallax of the moon (radians/day)
+#define ASTRONOMICAL_BODY_MAX_MOTION_RATE 0.3
+
+//maximum duration of a pass before the search for the set is abandoned, longer than the polar day (days)
+#define ASTRONOMICAL_BODY_MAX_PASS_DURATION 200.0
+
+/**
+ * State of a search for rise, transit and set.
+ **/
+struct astronomical_body_search {
+	///Type of astronomical body
+	enum astronomical_body type;
+	///Ground station
+	predict_observer_t *qth;
+	///Upper bound of the rate of change of the elevation (radians/day)
+	double max_elevation_rate;
+};
+
+/**
+ * Get elevation of astronomical body.
+ *
+ * \param data Search state, struct astronomical_body_search
+ * \param time Time
+ * \return Elevation (radians)
+ **/
+static double astronomical_body_elevation(void *data, predict_julian_date_t time)
+{
+	struct astronomical_body_search *search = (struct astronomical_body_search*)data;
+
+	//observed directly, since every sample would replace the single memoized observation in solar_system.c
+	struct predict_observation obs;
+	switch (search->type) {
+		case PREDICT_SUN:
+			predict_observe_sun(search->qth, time, &obs);
+			break;
+
+		case PREDICT_MOON:
+			predict_observe_moon(search->qth, time, &obs);
+			break;
+
+		default:
+			obs.elevation = NAN;
+			break;
+	}
+	return obs.elevation;
+}
+
+/**
+ * Get rate of change of the elevation of astronomical body, from a central difference.
+ *
+ * \param data Search state, struct astronomical_body_search
+ * \param time Time
+ * \return Elevation rate (radians/day)
+ **/
+static double astronomical_body_elevation_rate(void *data, predict_julian_date_t time)
+{
+	double elevation_after = astronomical_body_elevation(data, time + ASTRONOMICAL_BODY_RATE_OFFSET);
+	double elevation_before = astronomical_body_elevation(data, time - ASTRONOMICAL_BODY_RATE_OFFSET);
+	return (elevation_after - elevation_before)/(2.0*ASTRONOMICAL_BODY_RATE_OFFSET);
+}
+
+bool astronomical_body_next_event(enum astronomical_body type, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time, struct astronomical_body_event *ret_event)
+{
+	struct astronomical_body_search search = {.type = type, .qth = qth};
+	search.max_elevation_rate = ASTRONOMICAL_BODY_EARTH_ROTATION_RATE*cos(qth->latitude) + ASTRONOMICAL_BODY_MAX_MOTION_RATE;
+
+	predict_julian_date_t time = start_time + 2.0*ASTRONOMICAL_BODY_EVENT_TOLERANCE;
+	double elevation = astronomical_body_elevation(&search, time);
+	double elevation_rate = astronomical_body_elevation_rate(&search, time);
+	while (time < end_time) {
+		predict_julian_date_t next_time = fmin(time + ASTRONOMICAL_BODY_EVENT_STEP, end_time);
+		double next_elevation = astronomical_body_elevation(&search, next_time);
+		double next_elevation_rate = astronomical_body_elevation_rate(&search, next_time);
+
+		//rise or set, and transit where the elevation rate changes sign. The earliest one is returned
+		bool found = false;
+		predict_julian_date_t crossing = time;
+		double crossing_sample_time = next_time;
+		double crossing_sample_elevation = next_elevation;
+		if (root_finder_first_crossing(astronomical_body_elevation, &search, search.max_elevation_rate, 2.0*ASTRONOMICAL_BODY_EVENT_TOLERANCE, ASTRONOMICAL_BODY_EVENT_TOLERANCE, time, elevation, next_time, next_elevation, &crossing, &crossing_sample_time, &crossing_sample_elevation)) {
+			found = true;
+			ret_event->type = (crossing_sample_elevation > 0) ? ASTRONOMICAL_BODY_RISE : ASTRONOMICAL_BODY_SET;
+			ret_event->time = crossing;
+		}
+		if ((elevation_rate > 0) && (next_elevation_rate <= 0)) {
+			predict_julian_date_t transit = root_finder_brent(astronomical_body_elevation_rate, &search, time, elevation_rate, next_time, next_elevation_rate, ASTRONOMICAL_BODY_EVENT_TOLERANCE);
+			if (!found || (transit < ret_event->time)) {
+				found = true;
+				ret_event->type = ASTRONOMICAL_BODY_TRANSIT;
+				ret_event->time = transit;
+			}
+		}
+
+		if (found) {
+			struct predict_observation obs;
+			observe_astronomical_body(type, qth, ret_event->time, &obs);
+			ret_event->azimuth = obs.azimuth;
+			ret_event->elevation = obs.elevation;
+			return true;
+		}
+
+		time = next_time;
+		elevation = next_elevation;
+		elevation_rate = next_elevation_rate;
+	}
+	return false;
+}
+
+bool astronomical_body_next_pass(enum astronomical_body type, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time, struct astronomical_body_pass *ret_pass)
+{
+	//pass in progress, step backwards to before its rise
+	struct astronomical_body_search search = {.type = type, .qth = qth};
+	predict_julian_date_t time = start_time;
+	if (astronomical_body_elevation(&search, start_time + 2.0*ASTRONOMICAL_BODY_EVENT_TOLERANCE) >= 0) {
+		while ((astronomical_body_elevation(&search, time) >= 0) && (start_time - time < ASTRONOMICAL_BODY_MAX_PASS_DURATION)) {
+			time -= ASTRONOMICAL_BODY_EVENT_STEP;
+		}
+	}
+
+	//brief sets close to the poles can end passes before the start time
+	struct astronomical_body_event event;
+	do {
+		//find rise
+		do {
+			if (!astronomical_body_next_event(type, qth, time, end_time, &event)) {
+				return false;
+			}
+			time = event.time;
+		} while (event.type != ASTRONOMICAL_BODY_RISE);
+		ret_pass->rise = event.time;
+		ret_pass->rise_azimuth = event.azimuth;
+		ret_pass->transit = event.time;
+		ret_pass->transit_azimuth = event.azimuth;
+		ret_pass->transit_elevation = event.elevation;
+
+		//find highest transit and set
+		do {
+			if (!astronomical_body_next_event(type, qth, time, ret_pass->rise + ASTRONOMICAL_BODY_MAX_PASS_DURATION, &event)) {
+				return false;
+			}
+			time = event.time;
+			if ((event.type == ASTRONOMICAL_BODY_TRANSIT) && (event.elevation > ret_pass->transit_elevation)) {
+				ret_pass->transit = event.time;
+				ret_pass->transit_azimuth = event.azimuth;
+				ret_pass->transit_elevation = event.elevation;
+			}
+		} while (event.type != ASTRONOMICAL_BODY_SET);
+		ret_pass->set = event.time;
+		ret_pass->set_azimuth = event.azimuth;
+	} while (ret_pass->set <= start_time);
+	return true;
+}
+
+/**
+ * Get name of astronomical body event as string.
+ *
+ * \param type Type of event
+ * \return Name of event, e.g. "rise" for ASTRONOMICAL_BODY_RISE
+ **/
+static const char *astronomical_body_event_to_name(enum astronomical_body_event_type type)
+{
+	switch (type) {
+		case ASTRONOMICAL_BODY_RISE:
+			return "rise";
+		case ASTRONOMICAL_BODY_TRANSIT:
+			return "transit";
+		case ASTRONOMICAL_BODY_SET:
+			return "set";
+		default:
+			return "unknown";
+	}
+}
+
+void astronomical_body_write_events(struct prediction_output *output, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time)
+{
+	//next event of each body, merged in time order
+	struct astronomical_body_event events[NUM_ASTRONOMICAL_BODIES];
+	bool has_event[NUM_ASTRONOMICAL_BODIES];
+	for (int i=0; i < NUM_ASTRONOMICAL_BODIES; i++) {
+		has_event[i] = astronomical_body_next_event(i, qth, start_time, end_time, &events[i]);
+	}
+
+	while (true) {
+		int next = -1;
+		for (int i=0; i < NUM_ASTRONOMICAL_BODIES; i++) {
+			if (has_event[i] && ((next == -1) || (events[i].time < events[next].time))) {
+				next = i;
+			}
+		}
+		if (next == -1) {
+			break;
+		}
+
+		prediction_output_event(output, astronomical_body_to_name(next), astronomical_body_event_to_name(events[next].type), &events[next]);
+
+		has_event[next] = astronomical_body_next_event(next, qth, events[next].time, end_time, &events[next]);
+	}
+}
+
 /**
  * Form structure for displaying astronomical body properties.
  **/
@@ -414,7 +627,7 @@ void track_astronomical_body(predict_observer_t *qth, rotctld_info_t *rotctld)
 		astronomical_bodies[i] = astronomical_body_form_create(FORM_START_ROW + FORM_SPACING*i, i);
 	}
 
-	halfdelay(HALF_DELAY_TIME);
+	struct event_loop *event_loop = event_loop_create(STDIN_FILENO, UI_TICK_INTERVAL);
 
 	//print window header
 	attrset(HEADER_ATTRIBUTES);
@@ -477,7 +690,7 @@ void track_astronomical_body(predict_observer_t *qth, rotctld_info_t *rotctld)
 		}
 
 		//handle keyboard input
-		int input_key=getch();
+		int input_key = wait_for_input(event_loop);
 		switch (tolower(input_key)) {
 			//navigation
 			case KEY_UP:
@@ -511,6 +724,7 @@ void track_astronomical_body(predict_observer_t *qth, rotctld_info_t *rotctld)
 	}
 
 	//cleanup
+	event_loop_destroy(&event_loop);
 	tracking_info_free(&tracking_info);
 	for (int i=0; i < NUM_ASTRONOMICAL_BODIES; i++) {
 		astronomical_body_form_free(&astronomical_bodies[i]);
@@ -2,6 +2,8 @@
 #define TRACK_ASTRONOMICAL_BODIES_H_DEFINED
 
 #include "hamlib.h"
+#include <predict/predict.h>
+#include <stdbool.h>
 
 /**
  * Display UI for tracking various astronomical bodies through rotctld.
@@ -45,4 +47,97 @@ enum astronomical_body {
  **/
 void observe_astronomical_body(enum astronomical_body type, predict_observer_t *qth, predict_julian_date_t day, struct predict_observation *observation);
 
+//tolerance of the rise, transit and set times (days, 1 second)
+#define ASTRONOMICAL_BODY_EVENT_TOLERANCE (1.0/86400.0)
+
+/**
+ * Type of event in the daily motion of an astronomical body.
+ **/
+enum astronomical_body_event_type {
+	///Body rises above the horizon
+	ASTRONOMICAL_BODY_RISE,
+	///Body transits, i.e. reaches its maximum elevation
+	ASTRONOMICAL_BODY_TRANSIT,
+	///Body sets below the horizon
+	ASTRONOMICAL_BODY_SET
+};
+
+/**
+ * Rise, transit or set of an astronomical body.
+ **/
+struct astronomical_body_event {
+	///Type of event
+	enum astronomical_body_event_type type;
+	///Time of event
+	predict_julian_date_t time;
+	///Azimuth at event (radians)
+	double azimuth;
+	///Elevation at event (radians)
+	double elevation;
+};
+
+/**
+ * Rise, transit and set of a single pass of an astronomical body.
+ **/
+struct astronomical_body_pass {
+	///Time of rise
+	predict_julian_date_t rise;
+	///Azimuth at rise (radians)
+	double rise_azimuth;
+	///Time of transit
+	predict_julian_date_t transit;
+	///Azimuth at transit (radians)
+	double transit_azimuth;
+	///Elevation at transit (radians)
+	double transit_elevation;
+	///Time of set
+	predict_julian_date_t set;
+	///Azimuth at set (radians)
+	double set_azimuth;
+};
+
+/**
+ * Find the next rise, transit or set of an astronomical body.
+ *
+ * The elevation is sampled in steps of an hour. Rise and set are bracketed by samples on each side of the
+ * horizon, and transits by samples on each side of a sign change in the elevation rate, and are refined using
+ * Brent's root finding method. Samples on the same side of the horizon are subdivided when the elevation could
+ * reach the horizon between them, as bounded by the rotation of the earth and the motion of the body, so that
+ * brief rises and sets close to the poles are not missed.
+ *
+ * \param type Type of astronomical body
+ * \param qth Ground station
+ * \param start_time Start of search. Events within ASTRONOMICAL_BODY_EVENT_TOLERANCE of the start are skipped, so that the time of the previous event can be used directly
+ * \param end_time End of search
+ * \param ret_event Returned event
+ * \return True if an event was found before the end of the search, false otherwise
+ **/
+bool astronomical_body_next_event(enum astronomical_body type, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time, struct astronomical_body_event *ret_event);
+
+/**
+ * Find the pass of an astronomical body in progress at the given time, or the next rise after the given time,
+ * and the following transit and set. The transit is the highest transit of the pass, for passes lasting several
+ * days close to the poles.
+ *
+ * \param type Type of astronomical body
+ * \param qth Ground station
+ * \param start_time Start of search. A set within ASTRONOMICAL_BODY_EVENT_TOLERANCE of the start ends the previous pass, so that the set of the previous pass can be used directly
+ * \param end_time Time after which the search for a rise is abandoned
+ * \param ret_pass Returned pass
+ * \return True if a pass was found, false if the body does not rise before the end of the search
+ **/
+bool astronomical_body_next_pass(enum astronomical_body type, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time, struct astronomical_body_pass *ret_pass);
+
+struct prediction_output;
+
+/**
+ * Write rise, transit and set of the sun and the moon within a time interval to an output sink, in time order.
+ *
+ * \param output Output sink
+ * \param qth Ground station
+ * \param start_time Start of interval
+ * \param end_time End of interval
+ **/
+void astronomical_body_write_events(struct prediction_output *output, predict_observer_t *qth, predict_julian_date_t start_time, predict_julian_date_t end_time);
+
 #endif
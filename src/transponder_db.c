@@ -21,10 +21,9 @@ struct transponder_db *transponder_db_create(struct tle_db *tle_db)
 
 	int num_satellites = tle_db->num_tles;
 	if (num_satellites > 0) {
+		//calloc leaves all entries empty (squintflag false, no transponders, LOCATION_NONE) without touching the memory of each entry
 		transponder_db->sats = (struct sat_db_entry *)calloc(num_satellites, sizeof(struct sat_db_entry));
 		transponder_db->num_sats = num_satellites;
-
-		transponder_db_initialize(transponder_db);
 	}
 	return transponder_db;
 }
@@ -190,8 +189,8 @@ void transponder_db_to_file(const char *filename, struct tle_db *tle_db, struct
 		for (int i=0; i < transponder_db->num_sats; i++) {
 			if (should_write[i]) {
 				struct sat_db_entry *entry = &(transponder_db->sats[i]);
-				fprintf(fd, "%s\n", tle_db->tles[i].name);
-				fprintf(fd, "%ld\n", tle_db->tles[i].satellite_number);
+				fprintf(fd, "%s\n", tle_db_entry_name(tle_db, i));
+				fprintf(fd, "%ld\n", tle_db_entry_satellite_number(tle_db, i));
 
 				//squint properties
 				if (entry->squintflag) {
@@ -521,7 +521,7 @@ void transponder_form_sysdefault(struct transponder_form *transponder_form, stru
 {
 	//create dummy TLE database with a single entry corresponding to the satellite number
 	struct tle_db *dummy_tle_db = tle_db_create();
-	struct tle_db_entry dummy_entry;
+	struct tle_db_entry dummy_entry = {0};
 	dummy_entry.satellite_number = transponder_form->satellite_number;
 	tle_db_add_entry(dummy_tle_db, &dummy_entry);
 	struct transponder_db *dummy_transponder_db = transponder_db_create(dummy_tle_db);
@@ -894,7 +894,7 @@ void transponder_database_editor(int start_index, struct tle_db *tle_db, struct
 
 	if (menu.num_displayed_entries > 0) {
 		int tle_index = start_index;
-		transponder_database_entry_displayer(tle_db->tles[tle_index].name, &(sat_db->sats[tle_index]), display_win);
+		transponder_database_entry_displayer(tle_db_entry_name(tle_db, tle_index), &(sat_db->sats[tle_index]), display_win);
 	}
 
 	filtered_menu_select_index(&menu, start_index);
@@ -913,7 +913,7 @@ void transponder_database_editor(int start_index, struct tle_db *tle_db, struct
 		int menu_index = filtered_menu_current_index(&menu);
 
 		if ((c == 10) && (menu.num_displayed_entries > 0)) { //enter
-			transponder_database_entry_editor(&(tle_db->tles[menu_index]), editor_win, &(sat_db->sats[menu_index]));
+			transponder_database_entry_editor(tle_db_get_entry(tle_db, menu_index), editor_win, &(sat_db->sats[menu_index]));
 
 			//clear leftovers from transponder editor
 			wclear(main_win);
@@ -933,7 +933,7 @@ void transponder_database_editor(int start_index, struct tle_db *tle_db, struct
 
 		//display/refresh transponder entry displayer
 		if (menu.num_displayed_entries > 0) {
-			transponder_database_entry_displayer(tle_db->tles[menu_index].name, &(sat_db->sats[menu_index]), display_win);
+			transponder_database_entry_displayer(tle_db_entry_name(tle_db, menu_index), &(sat_db->sats[menu_index]), display_win);
 		}
 		wrefresh(display_win);
 	}
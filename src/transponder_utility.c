@@ -103,16 +103,16 @@ int main(int argc, char **argv)
 			if (!transponder_db_entry_empty(new_db_entry) && !transponder_db_entry_equal(old_db_entry, new_db_entry)) {
 				if (transponder_db_entry_empty(old_db_entry)) {
 					//add new entry
-					if (!silent_mode) fprintf(stderr, "Adding new transponder entries to %s\n", tle_db->tles[j].name);
+					if (!silent_mode) fprintf(stderr, "Adding new transponder entries to %s\n", tle_db_entry_name(tle_db, j));
 					transponder_db_entry_copy(old_db_entry, new_db_entry);
 				} else if (!ignore_changes) {
 					//update existing entry
-					if (!silent_mode) fprintf(stderr, "Updating transponder entries for %s:\n", tle_db->tles[j].name);
+					if (!silent_mode) fprintf(stderr, "Updating transponder entries for %s:\n", tle_db_entry_name(tle_db, j));
 					bool do_update = false;
 					if (!force_changes) {
 						//prompt user for acceptance
 						print_transponder_entry_differences(old_db_entry, new_db_entry);
-						fprintf(stderr, "Accept change for %s? (y/n) ", tle_db->tles[j].name);
+						fprintf(stderr, "Accept change for %s? (y/n) ", tle_db_entry_name(tle_db, j));
 						while (true) {
 							int c = getchar();
 							if (c == 'y') {
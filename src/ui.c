@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
 #include "filtered_menu.h"
 #include "ui.h"
 #include "qth_config.h"
@@ -15,6 +16,9 @@
 #include "multitrack.h"
 #include "locator.h"
 #include "hamlib_status.h"
+#include "db_watcher.h"
+#include "pass_table.h"
+#include "solar_system.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Leftovers from old predict.c-file not sorted elsewhere. Mainly contains run_flyby_curses_ui(), which               //
@@ -60,6 +64,28 @@ void any_key()
 	getch();
 }
 
+int wait_for_input(struct event_loop *loop)
+{
+	nodelay(stdscr, TRUE);
+	int key = getch();
+	if (key == ERR) {
+		//terminal resizes interrupt the wait, and are then returned from getch() as KEY_RESIZE
+		event_loop_wait(loop);
+		key = getch();
+	}
+	nodelay(stdscr, FALSE);
+	return key;
+}
+
+/**
+ * Update TLE database with TLE files and print the updated entries.
+ *
+ * \param filenames TLE files
+ * \param tle_db TLE database
+ * \param interactive_mode Whether to print the results using curses and wait for key input, or to print them to stdout
+ **/
+static void update_tle_database_with_files(string_array_t *filenames, struct tle_db *tle_db, bool interactive_mode);
+
 void update_tle_database(const char *string, struct tle_db *tle_db)
 {
 	bool interactive_mode = (string[0] == '\0');
@@ -90,9 +116,22 @@ void update_tle_database(const char *string, struct tle_db *tle_db)
 		strncpy(filename, string, MAX_NUM_CHARS);
 	}
 
-	//update TLE database with file
+	string_array_t filenames = {0};
+	string_array_add(&filenames, filename);
+	update_tle_database_with_files(&filenames, tle_db, interactive_mode);
+	string_array_free(&filenames);
+}
+
+void update_tle_database_from_files(string_array_t *filenames, struct tle_db *tle_db)
+{
+	update_tle_database_with_files(filenames, tle_db, false);
+}
+
+static void update_tle_database_with_files(string_array_t *filenames, struct tle_db *tle_db, bool interactive_mode)
+{
+	//update TLE database with files
 	int *update_status = (int*)calloc(tle_db->num_tles, sizeof(int));
-	tle_db_update(filename, tle_db, update_status);
+	tle_db_update_from_files(filenames, tle_db, update_status);
 
 	if (interactive_mode) {
 		move(12, 0);
@@ -106,13 +145,13 @@ void update_tle_database(const char *string, struct tle_db *tle_db)
 		if (update_status[i] & TLE_DB_UPDATED) {
 			//print updated entries
 			if (interactive_mode) {
-				printw("Updated %s (%ld)", tle_db->tles[i].name, tle_db->tles[i].satellite_number);
+				printw("Updated %s (%ld)", tle_db_entry_name(tle_db, i), tle_db_entry_satellite_number(tle_db, i));
 			} else {
-				printf("Updated %s (%ld)", tle_db->tles[i].name, tle_db->tles[i].satellite_number);
+				printf("Updated %s (%ld)", tle_db_entry_name(tle_db, i), tle_db_entry_satellite_number(tle_db, i));
 			}
 			if (update_status[i] & TLE_IN_NEW_FILE) {
 				if (!in_new_file) {
-					strncpy(new_file, tle_db->tles[i].filename, MAX_NUM_CHARS);
+					strncpy(new_file, tle_db_entry_filename(tle_db, i), MAX_NUM_CHARS);
 				}
 
 				in_new_file = true;
@@ -859,7 +898,7 @@ void general_program_info(const char *qthfile, struct tle_db *tle_db, struct tra
 void print_sun_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum)
 {
 	struct predict_observation sun;
-	predict_observe_sun(qth, daynum, &sun);
+	solar_system_observe_sun(qth, daynum, &sun);
 
 	attrset(COLOR_PAIR(4)|A_REVERSE|A_BOLD);
 	mvprintw(row++,col,"   Sun   ");
@@ -874,7 +913,7 @@ void print_sun_box(int row, int col, predict_observer_t *qth, predict_julian_dat
 void print_moon_box(int row, int col, predict_observer_t *qth, predict_julian_date_t daynum)
 {
 	struct predict_observation moon;
-	predict_observe_moon(qth, daynum, &moon);
+	solar_system_observe_moon(qth, daynum, &moon);
 
 	attrset(COLOR_PAIR(4)|A_REVERSE|A_BOLD);
 	mvprintw(row++,col,"   Moon  ");
@@ -898,6 +937,9 @@ void print_qth_box(int row, int col, predict_observer_t *qth)
 	mvprintw(row++,col,"%9s",maidenstr);
 }
 
+//length of the rolling window of precomputed passes (days)
+#define PASS_TABLE_WINDOW 2.0
+
 void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t *observer, struct tle_db *tle_db, struct transponder_db *sat_db, rotctld_info_t *rotctld, rigctld_info_t *downlink, rigctld_info_t *uplink)
 {
 	/* Start ncurses */
@@ -931,9 +973,27 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 	//prepare multitrack window
 	multitrack_listing_t *listing = multitrack_create_listing(observer, tle_db);
 
+	//compute upcoming passes in the background
+	struct pass_table *pass_table = pass_table_create(observer, tle_db, PASS_TABLE_WINDOW);
+	listing->pass_table = pass_table;
+
 	//window for printing main menu options
 	WINDOW *main_menu_win = newwin(MAIN_MENU_OPTS_WIN_HEIGHT, COLS, LINES-MAIN_MENU_OPTS_WIN_HEIGHT, 0);
 
+	//watch TLE and transponder files for changes
+	struct db_watcher *db_watcher = NULL;
+	bool *updated_tles = NULL;
+	if (tle_db->read_from_xdg) {
+		db_watcher = db_watcher_create();
+		updated_tles = (bool*)calloc(tle_db->num_tles+1, sizeof(bool));
+	}
+
+	//wake up on keyboard input, clock ticks, AOS/LOS and changes to the TLE and transponder files
+	struct event_loop *event_loop = event_loop_create(STDIN_FILENO, UI_TICK_INTERVAL);
+	if (db_watcher != NULL) {
+		event_loop_watch_fd(event_loop, db_watcher->fd);
+	}
+
 	refresh();
 
 	/* Display main menu and handle keyboard input */
@@ -957,6 +1017,12 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 
 		curr_time = predict_to_julian(time(NULL));
 
+		//reload changed TLE and transponder files
+		if ((db_watcher != NULL) && (db_watcher_reload(db_watcher, tle_db, sat_db, updated_tles) & DB_WATCHER_TLES_UPDATED)) {
+			multitrack_update_orbital_elements(listing, tle_db, updated_tles);
+			pass_table_refresh(pass_table, tle_db);
+		}
+
 		//refresh satellite list
 		multitrack_update_listing_data(listing, curr_time);
 		multitrack_display_listing(listing);
@@ -970,12 +1036,13 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 
 		//get input character
 		refresh();
-		halfdelay(HALF_DELAY_TIME);  // Increase if CPU load is too high
-		key = getch();
+		predict_julian_date_t next_event = multitrack_next_event(listing, curr_time);
+		if (next_event > 0) {
+			event_loop_schedule(event_loop, next_event);
+		}
+		key = wait_for_input(event_loop);
 
 		if (key != -1) {
-			cbreak(); //turn off halfdelay
-
 			//handle input to satellite list
 			bool handled = multitrack_handle_listing(listing, key);
 
@@ -983,17 +1050,18 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 			if (multitrack_option_selector_pop(listing->option_selector)) {
 				int option = multitrack_option_selector_get_option(listing->option_selector);
 				int satellite_index = multitrack_selected_entry(listing);
-				predict_orbital_elements_t *orbital_elements = tle_db_entry_to_orbital_elements(tle_db, satellite_index);
-				const char *sat_name = tle_db->tles[satellite_index].name;
+				struct tle_db_orbital_elements *orbital_elements_ref = tle_db_entry_get_orbital_elements(tle_db, satellite_index);
+				predict_orbital_elements_t *orbital_elements = orbital_elements_ref->elements;
+				const char *sat_name = tle_db_entry_name(tle_db, satellite_index);
 				switch (option) {
 					case OPTION_SINGLETRACK:
-						singletrack(satellite_index, observer, sat_db, tle_db, rotctld, downlink, uplink);
+						singletrack(satellite_index, observer, sat_db, tle_db, pass_table, rotctld, downlink, uplink);
 						break;
 					case OPTION_PREDICT_VISIBLE:
-						satellite_pass_display_schedule(sat_name, orbital_elements, observer, 'v');
+						satellite_pass_display_schedule(sat_name, orbital_elements, observer, pass_table, satellite_index, 'v');
 						break;
 					case OPTION_PREDICT:
-						satellite_pass_display_schedule(sat_name, orbital_elements, observer, 'p');
+						satellite_pass_display_schedule(sat_name, orbital_elements, observer, pass_table, satellite_index, 'p');
 						break;
 					case OPTION_DISPLAY_ORBITAL_DATA:
 						orbital_elements_display(sat_name, orbital_elements);
@@ -1005,7 +1073,7 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						solar_illumination_display_predictions(sat_name, orbital_elements);
 						break;
 				}
-				predict_destroy_orbital_elements(orbital_elements);
+				tle_db_orbital_elements_release(&orbital_elements_ref);
 				clear();
 				refresh();
 			}
@@ -1027,6 +1095,7 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						case 'U':
 						case 'u':
 							update_tle_database("", tle_db);
+							pass_table_refresh(pass_table, tle_db);
 							break;
 
 						case 'M':
@@ -1045,10 +1114,16 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 							break;
 
 						case 'G':
-						case 'g':
+						case 'g': {
+							//passes are only predicted again when the QTH coordinates changed
+							predict_observer_t previous_observer = *observer;
 							qth_editor(qthfile, observer);
-							multitrack_refresh_tles(listing, tle_db);
+							if ((observer->latitude != previous_observer.latitude) || (observer->longitude != previous_observer.longitude) || (observer->altitude != previous_observer.altitude)) {
+								pass_table_set_observer(pass_table, observer);
+								multitrack_update_qth(listing);
+							}
 							break;
+						}
 
 						case 'I':
 						case 'i':
@@ -1058,7 +1133,8 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 						case 'w':
 						case 'W':
 							whitelist_editor(tle_db, sat_db);
-							multitrack_refresh_tles(listing, tle_db);
+							pass_table_refresh(pass_table, tle_db);
+							multitrack_update_whitelist(listing, tle_db);
 							break;
 						case 'E':
 						case 'e':
@@ -1083,5 +1159,11 @@ void run_flyby_curses_ui(bool new_user, const char *qthfile, predict_observer_t
 	curses_shutdown();
 
 	delwin(main_menu_win);
+	event_loop_destroy(&event_loop);
 	multitrack_destroy_listing(&listing);
+	pass_table_destroy(&pass_table);
+	if (db_watcher != NULL) {
+		db_watcher_destroy(&db_watcher);
+	}
+	free(updated_tles);
 }
@@ -6,9 +6,19 @@
 #include "tle_db.h"
 #include "transponder_db.h"
 #include <curses.h>
+#include "event_loop.h"
 
 void any_key();
 
+/**
+ * Get keyboard input, sleeping in the event loop until a key is pressed or until the loop wakes up for another reason.
+ * Keys already buffered by curses are returned immediately.
+ *
+ * \param loop Event loop, watching standard input
+ * \return Key, or ERR when the event loop woke up without keyboard input
+ **/
+int wait_for_input(struct event_loop *loop);
+
 /**
  * Print sun azimuth/elevation to infobox on the standard screen.
  *
@@ -66,6 +76,15 @@ void bailout(const char *string);
  **/
 void update_tle_database(const char *string, struct tle_db *tle_db);
 
+/**
+ * Update the TLE database from multiple NASA 2-line element files in one pass, and print the
+ * updated entries to stdout. Each TLE file in the database is rewritten at most once.
+ *
+ * \param filenames TLE update files
+ * \param tle_db Pre-loaded TLE database
+ **/
+void update_tle_database_from_files(string_array_t *filenames, struct tle_db *tle_db);
+
 /**
  * Run flyby UI.
  *
@@ -0,0 +1,138 @@
+#include "worker_pool.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+//maximum number of threads in a worker pool
+#define WORKER_POOL_MAX_THREADS 16
+
+//number of chunks per thread the tasks of a run are divided into, for balancing uneven task durations
+#define WORKER_POOL_CHUNKS_PER_THREAD 8
+
+/**
+ * Run tasks of the current run until there are no more tasks to pick. Mutex must be locked when called, and
+ * is locked on return.
+ *
+ * \param pool Worker pool
+ **/
+static void worker_pool_work(struct worker_pool *pool)
+{
+	while (pool->next_task < pool->num_tasks) {
+		int begin = pool->next_task;
+		int end = begin + pool->chunk_size;
+		if (end > pool->num_tasks) {
+			end = pool->num_tasks;
+		}
+		pool->next_task = end;
+		worker_pool_task_t task = pool->task;
+		void *data = pool->data;
+
+		pthread_mutex_unlock(&(pool->mutex));
+		for (int i=begin; i < end; i++) {
+			task(data, i);
+		}
+		pthread_mutex_lock(&(pool->mutex));
+	}
+}
+
+/**
+ * Worker thread function. Waits for new runs, and works on them until the pool is shut down.
+ *
+ * \param data Worker pool
+ * \return NULL
+ **/
+static void *worker_pool_thread(void *data)
+{
+	struct worker_pool *pool = (struct worker_pool*)data;
+	unsigned long generation = 0;
+
+	pthread_mutex_lock(&(pool->mutex));
+	while (true) {
+		while (!pool->shutdown && (pool->generation == generation)) {
+			pthread_cond_wait(&(pool->work_available), &(pool->mutex));
+		}
+		if (pool->shutdown) {
+			break;
+		}
+		generation = pool->generation;
+
+		pool->num_active++;
+		worker_pool_work(pool);
+		pool->num_active--;
+		if (pool->num_active == 0) {
+			pthread_cond_signal(&(pool->work_done));
+		}
+	}
+	pthread_mutex_unlock(&(pool->mutex));
+	return NULL;
+}
+
+struct worker_pool *worker_pool_create(int num_threads)
+{
+	if (num_threads <= 0) {
+		num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (num_threads > WORKER_POOL_MAX_THREADS) {
+		num_threads = WORKER_POOL_MAX_THREADS;
+	}
+
+	struct worker_pool *pool = (struct worker_pool*)calloc(1, sizeof(struct worker_pool));
+	pthread_mutex_init(&(pool->mutex), NULL);
+	pthread_cond_init(&(pool->work_available), NULL);
+	pthread_cond_init(&(pool->work_done), NULL);
+
+	//the thread calling worker_pool_run() is the remaining thread
+	pool->threads = (pthread_t*)malloc(sizeof(pthread_t)*WORKER_POOL_MAX_THREADS);
+	for (int i=1; i < num_threads; i++) {
+		if (pthread_create(&(pool->threads[pool->num_threads]), NULL, worker_pool_thread, pool) == 0) {
+			pool->num_threads++;
+		}
+	}
+	return pool;
+}
+
+void worker_pool_destroy(struct worker_pool **pool)
+{
+	pthread_mutex_lock(&((*pool)->mutex));
+	(*pool)->shutdown = true;
+	pthread_cond_broadcast(&((*pool)->work_available));
+	pthread_mutex_unlock(&((*pool)->mutex));
+
+	for (int i=0; i < (*pool)->num_threads; i++) {
+		pthread_join((*pool)->threads[i], NULL);
+	}
+	pthread_cond_destroy(&((*pool)->work_available));
+	pthread_cond_destroy(&((*pool)->work_done));
+	pthread_mutex_destroy(&((*pool)->mutex));
+	free((*pool)->threads);
+	free(*pool);
+	*pool = NULL;
+}
+
+void worker_pool_run(struct worker_pool *pool, int num_tasks, worker_pool_task_t task, void *data)
+{
+	if (num_tasks <= 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&(pool->mutex));
+	pool->task = task;
+	pool->data = data;
+	pool->num_tasks = num_tasks;
+	pool->next_task = 0;
+	pool->chunk_size = num_tasks/((pool->num_threads + 1)*WORKER_POOL_CHUNKS_PER_THREAD);
+	if (pool->chunk_size < 1) {
+		pool->chunk_size = 1;
+	}
+	if (pool->num_threads > 0) {
+		pool->generation++;
+		pthread_cond_broadcast(&(pool->work_available));
+	}
+
+	worker_pool_work(pool);
+
+	//wait for workers still running the last picked tasks
+	while (pool->num_active > 0) {
+		pthread_cond_wait(&(pool->work_done), &(pool->mutex));
+	}
+	pthread_mutex_unlock(&(pool->mutex));
+}
@@ -0,0 +1,79 @@
+#ifndef WORKER_POOL_H_DEFINED
+#define WORKER_POOL_H_DEFINED
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Persistent pool of worker threads, used for running a number of independent tasks in parallel. The threads are
+ * started once and wait for work between runs, so that the pool can be used on every UI update without the
+ * overhead of starting new threads.
+ **/
+
+/**
+ * Task function. Called once for each task index in worker_pool_run().
+ *
+ * \param data User data
+ * \param index Task index
+ **/
+typedef void (*worker_pool_task_t)(void *data, int index);
+
+/**
+ * Worker pool.
+ **/
+struct worker_pool {
+	///Number of worker threads, in addition to the thread calling worker_pool_run()
+	int num_threads;
+	///Worker threads
+	pthread_t *threads;
+	///Mutex protecting the fields below
+	pthread_mutex_t mutex;
+	///Signalled when a new run is started, or the pool is shut down
+	pthread_cond_t work_available;
+	///Signalled when the last worker is done with the current run
+	pthread_cond_t work_done;
+	///Run counter, incremented for each new run
+	unsigned long generation;
+	///Whether worker threads should exit
+	bool shutdown;
+	///Task function of current run
+	worker_pool_task_t task;
+	///User data of current run
+	void *data;
+	///Number of tasks in current run
+	int num_tasks;
+	///Next task index to be picked
+	int next_task;
+	///Number of task indices picked at once
+	int chunk_size;
+	///Number of worker threads currently working on tasks
+	int num_active;
+};
+
+/**
+ * Create worker pool.
+ *
+ * \param num_threads Total number of threads to use, including the thread calling worker_pool_run(). Set to 0 to use the number of online processors
+ * \return Worker pool
+ **/
+struct worker_pool *worker_pool_create(int num_threads);
+
+/**
+ * Stop worker threads and free worker pool.
+ *
+ * \param pool Worker pool
+ **/
+void worker_pool_destroy(struct worker_pool **pool);
+
+/**
+ * Run tasks in parallel, and wait until all tasks are done. The calling thread runs tasks as well.
+ * Tasks are picked in index order, but can complete in any order.
+ *
+ * \param pool Worker pool
+ * \param num_tasks Number of tasks
+ * \param task Task function, called for each index from 0 to num_tasks-1
+ * \param data User data passed to the task function
+ **/
+void worker_pool_run(struct worker_pool *pool, int num_tasks, worker_pool_task_t task, void *data);
+
+#endif
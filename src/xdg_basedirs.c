@@ -20,6 +20,8 @@
 #define XDG_CONFIG_DIRS_DEFAULT "/etc/xdg/"
 #define XDG_CONFIG_HOME "XDG_CONFIG_HOME"
 #define XDG_CONFIG_HOME_DEFAULT ".config/"
+#define XDG_CACHE_HOME "XDG_CACHE_HOME"
+#define XDG_CACHE_HOME_DEFAULT ".cache/"
 
 /**
  * Check if dirpath contains a backslash at the end, and append one if not.
@@ -114,6 +116,11 @@ char *xdg_config_home()
 	return xdg_home(XDG_CONFIG_HOME, XDG_CONFIG_HOME_DEFAULT);
 }
 
+char *xdg_cache_home()
+{
+	return xdg_home(XDG_CACHE_HOME, XDG_CACHE_HOME_DEFAULT);
+}
+
 bool directory_exists(const char *dirpath)
 {
 	struct stat s;
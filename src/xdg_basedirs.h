@@ -22,6 +22,9 @@
 //default relative astronomical body tracking settings filename
 #define TRACK_ASTRONOMICAL_BODY_SETTINGS_FILE FLYBY_RELATIVE_ROOT_PATH "astronomical_body_tracking_settings.conf"
 
+//default relative startup snapshot filename
+#define DB_SNAPSHOT_RELATIVE_FILE_PATH FLYBY_RELATIVE_ROOT_PATH "startup.snapshot"
+
 /**
  * \return XDG_DATA_DIRS variable, or the xdg basedir specification default if the environment variable is empty
  **/
@@ -42,6 +45,11 @@ char *xdg_config_dirs();
  **/
 char *xdg_config_home();
 
+/**
+ * \return XDG_CACHE_HOME variable, or the xdg basedir specification default if XDG_CACHE_HOME is empty
+ **/
+char *xdg_cache_home();
+
 /**
  * Create XDG_CONFIG_HOME/flyby (normally .config/flyby) and XDG_DATA_HOME/flyby/tles/ (normally .local/share/flyby/tles) if these do not exist.
  **/
@@ -0,0 +1,403 @@
+#include "batch_propagation.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//geostationary satellite, propagated using libpredict
+#define GEO_TLE_LINE_1 "1 40732U 15034A   17225.50277778 -.00000287  00000-0  00000+0 0  9996"
+#define GEO_TLE_LINE_2 "2 40732   0.0290 301.2720 0001578 256.5450 189.6640  1.00270400  7897"
+
+//time step and duration of the prefilter test (days)
+#define PREFILTER_TIME_STEP (10.0/86400.0)
+#define PREFILTER_DURATION 1.0
+
+//tolerance in position and range (km), velocity and range rate (km/s) and angles (radians) compared to the reference
+//vectors and to libpredict, which uses the same SGP4 model. Differences come only from the order of floating point operations
+#define POSITION_TOLERANCE 1.0E-3
+#define VELOCITY_TOLERANCE 1.0E-6
+#define ANGLE_TOLERANCE 1.0E-6
+
+//time step and number of steps of the comparison against libpredict (days), not a divisor of the orbital periods
+#define LIBPREDICT_TIME_STEP (317.0/86400.0)
+#define LIBPREDICT_NUM_STEPS 1000
+
+//eclipse depth (radians) and elevation (radians) within which the eclipsed and visible flags can differ from libpredict
+#define FLAG_BOUNDARY_MARGIN 1.0E-6
+
+/**
+ * Check position and velocity of satellite in batch.
+ *
+ * \param batch Satellite batch
+ * \param index Satellite index
+ * \param position Expected position
+ * \param velocity Expected velocity
+ **/
+void assert_state_equal(struct batch_propagation *batch, int index, const double position[3], const double velocity[3])
+{
+	struct predict_position orbit;
+	struct predict_observation obs;
+	batch_propagation_get_result(batch, index, &orbit, &obs);
+	for (int i=0; i < 3; i++) {
+		assert_true(fabs(orbit.position[i] - position[i]) < POSITION_TOLERANCE);
+		assert_true(fabs(orbit.velocity[i] - velocity[i]) < VELOCITY_TOLERANCE);
+	}
+}
+
+void test_batch_propagation_reference(void **param)
+{
+	predict_orbital_elements_t *elements = predict_parse_tle(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2);
+	predict_orbital_elements_t *geo_elements = predict_parse_tle(GEO_TLE_LINE_1, GEO_TLE_LINE_2);
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+
+	struct batch_propagation *batch = batch_propagation_create(2);
+	batch_propagation_set_satellite(batch, 0, elements);
+	batch_propagation_set_satellite(batch, 1, geo_elements);
+	assert_false(batch->use_libpredict[0]);
+	assert_true(batch->use_libpredict[1]);
+
+	//epoch of 2000, day 179.78495062
+	predict_julian_date_t epoch = batch->sgp4.epoch[0];
+	assert_true(fabs(epoch - (7306.0 + 178.78495062)) < 1.0E-9);
+
+	//reference state vectors from Vallado et al.
+	batch_propagation_run(batch, observer, epoch);
+	const double position_0[3] = {7022.46529266, -1400.08296755, 0.03995155};
+	const double velocity_0[3] = {1.893841015, 6.405893759, 4.534807250};
+	assert_state_equal(batch, 0, position_0, velocity_0);
+
+	batch_propagation_run(batch, observer, epoch + 720.0/1440.0);
+	const double position_720[3] = {-7134.59340119, 6531.68641334, 3260.27186483};
+	const double velocity_720[3] = {-4.113793027, -2.911922039, -2.557327851};
+	assert_state_equal(batch, 0, position_720, velocity_720);
+
+	//observation is consistent with the position
+	struct predict_position orbit;
+	struct predict_observation obs;
+	batch_propagation_get_result(batch, 0, &orbit, &obs);
+	assert_true(obs.time == epoch + 720.0/1440.0);
+	assert_true(obs.range > 0);
+	assert_true((obs.elevation >= -M_PI/2.0) && (obs.elevation <= M_PI/2.0));
+	assert_true((obs.azimuth >= 0) && (obs.azimuth < 2*M_PI));
+	assert_true((orbit.longitude >= -M_PI) && (orbit.longitude <= M_PI));
+	double radius = sqrt(orbit.position[0]*orbit.position[0] + orbit.position[1]*orbit.position[1] + orbit.position[2]*orbit.position[2]);
+	assert_true(fabs(orbit.altitude - (radius - 6378.135)) < 30.0);
+	assert_false(orbit.decayed);
+
+	//satellite is decayed long after its epoch
+	batch_propagation_run(batch, observer, epoch + 1.0E7);
+	batch_propagation_get_result(batch, 0, &orbit, &obs);
+	assert_true(orbit.decayed);
+
+	batch_propagation_destroy(&batch);
+	assert_null(batch);
+	predict_destroy_observer(observer);
+	predict_destroy_orbital_elements(elements);
+	predict_destroy_orbital_elements(geo_elements);
+}
+
+/**
+ * Get difference between two angles.
+ *
+ * \param a First angle
+ * \param b Second angle
+ * \return Absolute difference, reduced to [0, pi]
+ **/
+double angle_difference(double a, double b)
+{
+	return fabs(remainder(a - b, 2*M_PI));
+}
+
+/**
+ * Propagate satellites in a batch over a few days, and compare the results of each step against predict_orbit() and
+ * predict_observe_orbit().
+ *
+ * \param observer Observer
+ * \param elements Orbital elements of the satellites
+ * \param num_satellites Number of satellites
+ * \param start_time Start time
+ **/
+void assert_batch_equal_to_libpredict(const predict_observer_t *observer, predict_orbital_elements_t **elements, int num_satellites, predict_julian_date_t start_time)
+{
+	struct batch_propagation *batch = batch_propagation_create(num_satellites);
+	for (int i=0; i < num_satellites; i++) {
+		batch_propagation_set_satellite(batch, i, elements[i]);
+	}
+
+	for (int step=0; step < LIBPREDICT_NUM_STEPS; step++) {
+		predict_julian_date_t time = start_time + step*LIBPREDICT_TIME_STEP;
+		batch_propagation_run(batch, observer, time);
+
+		for (int i=0; i < num_satellites; i++) {
+			struct predict_position orbit, expected_orbit;
+			struct predict_observation obs, expected_obs;
+			batch_propagation_get_result(batch, i, &orbit, &obs);
+			predict_orbit(elements[i], &expected_orbit, time);
+			predict_observe_orbit(observer, &expected_orbit, &expected_obs);
+
+			for (int j=0; j < 3; j++) {
+				assert_true(fabs(orbit.position[j] - expected_orbit.position[j]) < POSITION_TOLERANCE);
+				assert_true(fabs(orbit.velocity[j] - expected_orbit.velocity[j]) < VELOCITY_TOLERANCE);
+			}
+			assert_true(fabs(orbit.latitude - expected_orbit.latitude) < ANGLE_TOLERANCE);
+			assert_true(angle_difference(orbit.longitude, expected_orbit.longitude) < ANGLE_TOLERANCE);
+			assert_true(fabs(orbit.altitude - expected_orbit.altitude) < POSITION_TOLERANCE);
+			assert_int_equal(orbit.decayed, expected_orbit.decayed);
+
+			assert_true(angle_difference(obs.azimuth, expected_obs.azimuth) < ANGLE_TOLERANCE);
+			assert_true(fabs(obs.elevation - expected_obs.elevation) < ANGLE_TOLERANCE);
+			assert_true(fabs(obs.range - expected_obs.range) < POSITION_TOLERANCE);
+			assert_true(fabs(obs.range_rate - expected_obs.range_rate) < VELOCITY_TOLERANCE);
+
+			//flags can only differ when the satellite is on the edge of the shadow or on the horizon
+			bool eclipse_boundary = fabs(expected_orbit.eclipse_depth) < FLAG_BOUNDARY_MARGIN;
+			bool horizon_boundary = fabs(expected_obs.elevation) < FLAG_BOUNDARY_MARGIN;
+			if (!eclipse_boundary) {
+				assert_int_equal(orbit.eclipsed, expected_orbit.eclipsed);
+			}
+			if (!eclipse_boundary && !horizon_boundary) {
+				assert_int_equal(obs.visible, expected_obs.visible);
+			}
+		}
+	}
+
+	batch_propagation_destroy(&batch);
+}
+
+void test_batch_propagation_against_libpredict(void **param)
+{
+	predict_orbital_elements_t *elements[] = {predict_parse_tle(ISS_TLE_LINE_1, ISS_TLE_LINE_2),
+		predict_parse_tle(FO29_TLE_LINE_1, FO29_TLE_LINE_2),
+		predict_parse_tle(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2),
+		predict_parse_tle(GEO_TLE_LINE_1, GEO_TLE_LINE_2)};
+	int num_satellites = sizeof(elements)/sizeof(elements[0]);
+	predict_observer_t *observers[] = {predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0),
+		predict_create_observer("test", -33.87*M_PI/180.0, 151.21*M_PI/180.0, 500)};
+	int num_observers = sizeof(observers)/sizeof(observers[0]);
+
+	//low earth orbit satellites near their common epoch, the highly eccentric orbit near its own epoch. The
+	//geostationary satellite is propagated by libpredict in the batch, and is included for the deep space path
+	predict_orbital_elements_t *near_epoch_2016[] = {elements[0], elements[1], elements[3]};
+	predict_orbital_elements_t *near_epoch_2000[] = {elements[2], elements[3]};
+	for (int i=0; i < num_observers; i++) {
+		assert_batch_equal_to_libpredict(observers[i], near_epoch_2016, 3, orbital_elements_epoch(elements[0]));
+		assert_batch_equal_to_libpredict(observers[i], near_epoch_2000, 2, orbital_elements_epoch(elements[2]));
+	}
+
+	for (int i=0; i < num_observers; i++) {
+		predict_destroy_observer(observers[i]);
+	}
+	for (int i=0; i < num_satellites; i++) {
+		predict_destroy_orbital_elements(elements[i]);
+	}
+}
+
+/**
+ * Propagate satellites with and without the prefilter over a day, and check that skipped satellites are below the horizon.
+ *
+ * \param observer Observer
+ * \param elements Orbital elements of the satellites
+ * \param num_satellites Number of satellites
+ * \return Fraction of satellite propagations that were skipped
+ **/
+double assert_prefilter_skips_satellites_below_horizon(const predict_observer_t *observer, predict_orbital_elements_t **elements, int num_satellites)
+{
+	struct batch_propagation *batch = batch_propagation_create(num_satellites);
+	struct batch_propagation *reference = batch_propagation_create(num_satellites);
+	for (int i=0; i < num_satellites; i++) {
+		batch_propagation_set_satellite(batch, i, elements[i]);
+		batch_propagation_set_satellite(reference, i, elements[i]);
+	}
+
+	//last satellite is always required
+	bool *required = (bool*)calloc(num_satellites, sizeof(bool));
+	required[num_satellites-1] = true;
+
+	int num_skipped = 0;
+	int num_steps = PREFILTER_DURATION/PREFILTER_TIME_STEP;
+	predict_julian_date_t start_time = batch->sgp4.epoch[0];
+	for (int step=0; step < num_steps; step++) {
+		predict_julian_date_t time = start_time + step*PREFILTER_TIME_STEP;
+		batch_propagation_run_prefiltered(batch, observer, time, required);
+		batch_propagation_run(reference, observer, time);
+		assert_true(reference->propagated[0]);
+
+		for (int i=0; i < num_satellites; i++) {
+			if (batch->propagated[i]) {
+				assert_true(batch->elevation[i] == reference->elevation[i]);
+				assert_true(batch->position_x[i] == reference->position_x[i]);
+				assert_true(batch->range_rate[i] == reference->range_rate[i]);
+			} else {
+				assert_true(reference->elevation[i] < 0);
+				assert_false(reference->decayed[i]);
+				assert_false(required[i]);
+				num_skipped++;
+			}
+		}
+	}
+
+	free(required);
+	batch_propagation_destroy(&batch);
+	batch_propagation_destroy(&reference);
+	return num_skipped*1.0/(num_steps*num_satellites);
+}
+
+void test_batch_propagation_prefilter(void **param)
+{
+	predict_orbital_elements_t *elements[] = {predict_parse_tle(ISS_TLE_LINE_1, ISS_TLE_LINE_2),
+		predict_parse_tle(FO29_TLE_LINE_1, FO29_TLE_LINE_2),
+		predict_parse_tle(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2),
+		predict_parse_tle(ISS_TLE_LINE_1, ISS_TLE_LINE_2)};
+	int num_satellites = sizeof(elements)/sizeof(elements[0]);
+
+	//most propagations are skipped for a satellite that rises a few times a day
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+	assert_true(assert_prefilter_skips_satellites_below_horizon(observer, elements, num_satellites) > 0.25);
+	predict_destroy_observer(observer);
+
+	//ISS never rises above the horizon as far north as Svalbard
+	observer = predict_create_observer("test", 78.22*M_PI/180.0, 15.65*M_PI/180.0, 500);
+	assert_true(assert_prefilter_skips_satellites_below_horizon(observer, elements, num_satellites) > 0.25);
+	predict_destroy_observer(observer);
+
+	for (int i=0; i < num_satellites; i++) {
+		predict_destroy_orbital_elements(elements[i]);
+	}
+}
+
+void test_batch_propagation_run_selected(void **param)
+{
+	predict_orbital_elements_t *elements[] = {predict_parse_tle(ISS_TLE_LINE_1, ISS_TLE_LINE_2),
+		predict_parse_tle(GEO_TLE_LINE_1, GEO_TLE_LINE_2),
+		predict_parse_tle(FO29_TLE_LINE_1, FO29_TLE_LINE_2),
+		predict_parse_tle(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2)};
+	int num_satellites = sizeof(elements)/sizeof(elements[0]);
+	predict_observer_t *observer = predict_create_observer("test", 78.22*M_PI/180.0, 15.65*M_PI/180.0, 500);
+
+	struct batch_propagation *batch = batch_propagation_create(num_satellites);
+	struct batch_propagation *reference = batch_propagation_create(num_satellites);
+	for (int i=0; i < num_satellites; i++) {
+		batch_propagation_set_satellite(batch, i, elements[i]);
+		batch_propagation_set_satellite(reference, i, elements[i]);
+	}
+
+	int num_selected_steps = 0;
+	int num_steps = PREFILTER_DURATION/PREFILTER_TIME_STEP;
+	predict_julian_date_t start_time = batch->sgp4.epoch[0];
+	for (int step=0; step < num_steps; step++) {
+		predict_julian_date_t time = start_time + step*PREFILTER_TIME_STEP;
+		batch_propagation_run_prefiltered(batch, observer, time, NULL);
+		batch_propagation_run(reference, observer, time);
+
+		//first skipped satellite is selected, the others keep their flags and results
+		int selected = -1;
+		for (int i=0; i < num_satellites; i++) {
+			if (!batch->propagated[i]) {
+				selected = i;
+				break;
+			}
+		}
+		if (selected < 0) {
+			continue;
+		}
+		bool propagated[num_satellites];
+		double earliest_rise[num_satellites];
+		double elevation[num_satellites];
+		for (int i=0; i < num_satellites; i++) {
+			propagated[i] = batch->propagated[i];
+			earliest_rise[i] = batch->earliest_rise[i];
+			elevation[i] = batch->elevation[i];
+		}
+
+		batch_propagation_run_selected(batch, observer, &selected, 1);
+		assert_true(batch->time == time);
+		for (int i=0; i < num_satellites; i++) {
+			if (i == selected) {
+				assert_true(batch->propagated[i]);
+				assert_true(batch->elevation[i] == reference->elevation[i]);
+				assert_true(batch->position_x[i] == reference->position_x[i]);
+				assert_true(batch->range_rate[i] == reference->range_rate[i]);
+				assert_true(batch->earliest_rise[i] == reference->earliest_rise[i]);
+			} else {
+				assert_int_equal(batch->propagated[i], propagated[i]);
+				assert_true(batch->earliest_rise[i] == earliest_rise[i]);
+				assert_true(batch->elevation[i] == elevation[i]);
+			}
+		}
+		num_selected_steps++;
+	}
+	assert_true(num_selected_steps > 0);
+
+	batch_propagation_destroy(&batch);
+	batch_propagation_destroy(&reference);
+	predict_destroy_observer(observer);
+	for (int i=0; i < num_satellites; i++) {
+		predict_destroy_orbital_elements(elements[i]);
+	}
+}
+
+void test_batch_propagation_copy_satellite(void **param)
+{
+	predict_orbital_elements_t *elements[] = {predict_parse_tle(ISS_TLE_LINE_1, ISS_TLE_LINE_2),
+		predict_parse_tle(GEO_TLE_LINE_1, GEO_TLE_LINE_2),
+		predict_parse_tle(FO29_TLE_LINE_1, FO29_TLE_LINE_2)};
+	int num_satellites = sizeof(elements)/sizeof(elements[0]);
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+
+	struct batch_propagation *source = batch_propagation_create(num_satellites);
+	for (int i=0; i < num_satellites; i++) {
+		batch_propagation_set_satellite(source, i, elements[i]);
+	}
+	predict_julian_date_t time = source->sgp4.epoch[0];
+	batch_propagation_run_prefiltered(source, observer, time, NULL);
+
+	//last two satellites in reverse order, keeping the results of the last propagation
+	struct batch_propagation *batch = batch_propagation_create(num_satellites - 1);
+	for (int i=0; i < num_satellites - 1; i++) {
+		batch_propagation_copy_satellite(batch, i, source, num_satellites - 1 - i);
+	}
+	for (int i=0; i < num_satellites - 1; i++) {
+		int source_index = num_satellites - 1 - i;
+		assert_ptr_equal(batch->orbital_elements[i], elements[source_index]);
+		assert_true(batch->elevation[i] == source->elevation[source_index]);
+		assert_true(batch->earliest_rise[i] == source->earliest_rise[source_index]);
+	}
+
+	//satellites propagate and are skipped by the prefilter as in the source batch
+	for (int step=1; step < 10; step++) {
+		time += PREFILTER_TIME_STEP;
+		batch_propagation_run_prefiltered(source, observer, time, NULL);
+		batch_propagation_run_prefiltered(batch, observer, time, NULL);
+		for (int i=0; i < num_satellites - 1; i++) {
+			int source_index = num_satellites - 1 - i;
+			assert_int_equal(batch->propagated[i], source->propagated[source_index]);
+			assert_true(batch->elevation[i] == source->elevation[source_index]);
+			assert_true(batch->position_x[i] == source->position_x[source_index]);
+		}
+	}
+
+	batch_propagation_destroy(&batch);
+	batch_propagation_destroy(&source);
+	predict_destroy_observer(observer);
+	for (int i=0; i < num_satellites; i++) {
+		predict_destroy_orbital_elements(elements[i]);
+	}
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_batch_propagation_reference),
+		cmocka_unit_test(test_batch_propagation_against_libpredict),
+		cmocka_unit_test(test_batch_propagation_prefilter),
+		cmocka_unit_test(test_batch_propagation_run_selected),
+		cmocka_unit_test(test_batch_propagation_copy_satellite),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,247 @@
+#include "db_snapshot.h"
+#include "tle_db.h"
+#include "transponder_db.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_DATA_DIR "test_data/"
+
+/**
+ * Create temporary directory to be used as XDG_DATA_HOME, containing flyby/tles/.
+ *
+ * \param temp_dir Template for mkdtemp, overwritten with directory name
+ * \param ret_data_home Returned path to data home, with trailing '/'
+ **/
+void create_data_home(char *temp_dir, char *ret_data_home)
+{
+	assert_non_null(mkdtemp(temp_dir));
+	snprintf(ret_data_home, MAX_NUM_CHARS, "%s/", temp_dir);
+
+	char path[MAX_NUM_CHARS];
+	snprintf(path, MAX_NUM_CHARS, "%sflyby/", ret_data_home);
+	assert_int_equal(mkdir(path, 0777), 0);
+	snprintf(path, MAX_NUM_CHARS, "%sflyby/tles/", ret_data_home);
+	assert_int_equal(mkdir(path, 0777), 0);
+}
+
+/**
+ * Get snapshot sources using the supplied data home and the test data directory as data dirs and config home.
+ *
+ * \param data_home XDG_DATA_HOME
+ * \param ret_sources Returned sources
+ **/
+void get_sources(const char *data_home, struct db_snapshot_sources *ret_sources)
+{
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, TEST_DATA_DIR);
+	will_return(xdg_config_home, TEST_DATA_DIR);
+	db_snapshot_sources_from_search_paths(ret_sources);
+}
+
+void test_db_snapshot_sources_from_search_paths(void **param)
+{
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	char data_home[MAX_NUM_CHARS];
+	create_data_home(temp_dir, data_home);
+
+	char tle_file[MAX_NUM_CHARS];
+	snprintf(tle_file, MAX_NUM_CHARS, "%sflyby/tles/test.tle", data_home);
+	FILE *fd = fopen(tle_file, "w");
+	fclose(fd);
+
+	struct db_snapshot_sources sources = {0};
+	get_sources(data_home, &sources);
+
+	char expected_path[MAX_NUM_CHARS];
+	int index = 0;
+	snprintf(expected_path, MAX_NUM_CHARS, "%sflyby/tles/", data_home);
+	assert_string_equal(string_array_get(&(sources.paths), index++), expected_path);
+	assert_string_equal(string_array_get(&(sources.paths), index++), tle_file);
+	assert_string_equal(string_array_get(&(sources.paths), index++), TEST_DATA_DIR "flyby/tles/");
+	assert_string_equal(string_array_get(&(sources.paths), index++), TEST_DATA_DIR "flyby/flyby.whitelist");
+	snprintf(expected_path, MAX_NUM_CHARS, "%sflyby/flyby.db", data_home);
+	assert_string_equal(string_array_get(&(sources.paths), index++), expected_path);
+	assert_string_equal(string_array_get(&(sources.paths), index++), TEST_DATA_DIR "flyby/flyby.db");
+	assert_int_equal(string_array_size(&(sources.paths)), index);
+
+	//file properties are recorded when the list is created
+	assert_true(sources.file_info[1].exists);
+	assert_int_equal(sources.file_info[1].size, 0);
+	assert_true(sources.file_info[3].exists);
+	assert_false(sources.file_info[4].exists);
+	db_snapshot_sources_free(&sources);
+
+	unlink(tle_file);
+	snprintf(expected_path, MAX_NUM_CHARS, "%sflyby/tles/", data_home);
+	rmdir(expected_path);
+	snprintf(expected_path, MAX_NUM_CHARS, "%sflyby/", data_home);
+	rmdir(expected_path);
+	rmdir(temp_dir);
+}
+
+void test_db_snapshot_read_write(void **param)
+{
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	char data_home[MAX_NUM_CHARS];
+	create_data_home(temp_dir, data_home);
+
+	char snapshot_file[MAX_NUM_CHARS];
+	snprintf(snapshot_file, MAX_NUM_CHARS, "%ssnapshot", data_home);
+
+	//databases to write to snapshot
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(TEST_DATA_DIR "old_tles/part1.tle", tle_db);
+	assert_true(tle_db->num_tles > 3);
+	tle_db->read_from_xdg = true;
+	tle_db_entry_set_enabled(tle_db, 0, true);
+	tle_db_entry_set_enabled(tle_db, 2, true);
+	struct transponder_db *transponder_db = transponder_db_create(tle_db);
+	assert_int_equal(transponder_db_from_file(TEST_DATA_DIR "flyby/flyby.db", tle_db, transponder_db, LOCATION_DATA_DIRS), 0);
+	transponder_db->loaded = true;
+
+	struct db_snapshot_sources sources = {0};
+	get_sources(data_home, &sources);
+	assert_int_equal(db_snapshot_to_file(snapshot_file, &sources, tle_db, transponder_db), 0);
+
+	//non-existing snapshot
+	struct tle_db *read_tle_db = tle_db_create();
+	struct transponder_db *read_transponder_db = NULL;
+	assert_int_equal(db_snapshot_from_file("/dev/NULL", &sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_FILE_READING_ERROR);
+
+	//databases are restored exactly
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_SUCCESS);
+	assert_int_equal(read_tle_db->num_tles, tle_db->num_tles);
+	assert_true(read_tle_db->read_from_xdg);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		const struct tle_db_entry *expected = tle_db_get_entry(tle_db, i);
+		const struct tle_db_entry *entry = tle_db_get_entry(read_tle_db, i);
+		assert_int_equal(entry->satellite_number, expected->satellite_number);
+		assert_string_equal(entry->name, expected->name);
+		assert_string_equal(entry->filename, expected->filename);
+		assert_string_equal(entry->line1, expected->line1);
+		assert_string_equal(entry->line2, expected->line2);
+		assert_true(entry->epoch == expected->epoch);
+		assert_int_equal(entry->enabled, expected->enabled);
+		assert_int_equal(tle_db_find_entry(read_tle_db, entry->satellite_number), tle_db_find_entry(tle_db, entry->satellite_number));
+	}
+
+	assert_non_null(read_transponder_db);
+	assert_true(read_transponder_db->loaded);
+	assert_int_equal(read_transponder_db->num_sats, transponder_db->num_sats);
+	for (int i=0; i < transponder_db->num_sats; i++) {
+		assert_int_equal(read_transponder_db->sats[i].location, transponder_db->sats[i].location);
+		assert_true(transponder_db_entry_equal(&(read_transponder_db->sats[i]), &(transponder_db->sats[i])));
+	}
+	tle_db_destroy(&read_tle_db);
+	transponder_db_destroy(&read_transponder_db);
+
+	//snapshot is outdated when a TLE file is added
+	char tle_file[MAX_NUM_CHARS];
+	snprintf(tle_file, MAX_NUM_CHARS, "%sflyby/tles/test.tle", data_home);
+	FILE *fd = fopen(tle_file, "w");
+	fclose(fd);
+
+	struct db_snapshot_sources new_sources = {0};
+	get_sources(data_home, &new_sources);
+	read_tle_db = tle_db_create();
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_OUTDATED);
+	assert_int_equal(read_tle_db->num_tles, 0);
+	assert_null(read_transponder_db);
+
+	//snapshot is outdated when a TLE file is modified
+	assert_int_equal(db_snapshot_to_file(snapshot_file, &new_sources, tle_db, transponder_db), 0);
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_SUCCESS);
+	tle_db_destroy(&read_tle_db);
+	transponder_db_destroy(&read_transponder_db);
+
+	fd = fopen(tle_file, "w");
+	fprintf(fd, "\n");
+	fclose(fd);
+	db_snapshot_sources_free(&new_sources);
+	get_sources(data_home, &new_sources);
+	read_tle_db = tle_db_create();
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_OUTDATED);
+	assert_int_equal(read_tle_db->num_tles, 0);
+
+	//file properties recorded before the databases were read are stored, so that a TLE file modified while reading
+	//the databases makes the snapshot outdated
+	assert_int_equal(db_snapshot_to_file(snapshot_file, &new_sources, tle_db, transponder_db), 0);
+	fd = fopen(tle_file, "w");
+	fprintf(fd, "\n\n");
+	fclose(fd);
+	db_snapshot_sources_free(&new_sources);
+	get_sources(data_home, &new_sources);
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_OUTDATED);
+	assert_int_equal(read_tle_db->num_tles, 0);
+
+	//truncated snapshot is rejected
+	assert_int_equal(db_snapshot_to_file(snapshot_file, &new_sources, tle_db, transponder_db), 0);
+	struct stat file_stat;
+	assert_int_equal(stat(snapshot_file, &file_stat), 0);
+	assert_int_equal(truncate(snapshot_file, file_stat.st_size - 10), 0);
+	assert_int_equal(db_snapshot_from_file(snapshot_file, &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_INVALID);
+	assert_int_equal(read_tle_db->num_tles, 0);
+	assert_null(read_transponder_db);
+
+	//file of wrong format is rejected
+	assert_int_equal(db_snapshot_from_file(TEST_DATA_DIR "old_tles/part1.tle", &new_sources, read_tle_db, &read_transponder_db), DB_SNAPSHOT_INVALID);
+
+	tle_db_destroy(&read_tle_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+	db_snapshot_sources_free(&sources);
+	db_snapshot_sources_free(&new_sources);
+
+	unlink(tle_file);
+	unlink(snapshot_file);
+	char path[MAX_NUM_CHARS];
+	snprintf(path, MAX_NUM_CHARS, "%sflyby/tles/", data_home);
+	rmdir(path);
+	snprintf(path, MAX_NUM_CHARS, "%sflyby/", data_home);
+	rmdir(path);
+	rmdir(temp_dir);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_cache_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_xdg_dirs()
+{
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_db_snapshot_sources_from_search_paths),
+		cmocka_unit_test(test_db_snapshot_read_write),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,278 @@
+#include "db_watcher.h"
+#include "tle_db.h"
+#include "transponder_db.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define TEST_DATA_DIR "test_data/"
+
+/**
+ * Copy file.
+ *
+ * \param source Source file
+ * \param destination Destination file
+ **/
+void copy_file(const char *source, const char *destination)
+{
+	FILE *in = fopen(source, "r");
+	FILE *out = fopen(destination, "w");
+	assert_non_null(in);
+	assert_non_null(out);
+	char buffer[MAX_NUM_CHARS];
+	size_t length;
+	while ((length = fread(buffer, 1, MAX_NUM_CHARS, in)) > 0) {
+		fwrite(buffer, 1, length, out);
+	}
+	fclose(in);
+	fclose(out);
+}
+
+void test_db_watcher_reload(void **param)
+{
+	//XDG_DATA_HOME with TLE directory
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	assert_non_null(mkdtemp(temp_dir));
+	char data_home[MAX_NUM_CHARS];
+	snprintf(data_home, MAX_NUM_CHARS, "%s/", temp_dir);
+	char flyby_dir[MAX_NUM_CHARS];
+	snprintf(flyby_dir, MAX_NUM_CHARS, "%sflyby/", data_home);
+	assert_int_equal(mkdir(flyby_dir, 0777), 0);
+	char tle_dir[MAX_NUM_CHARS];
+	snprintf(tle_dir, MAX_NUM_CHARS, "%sflyby/tles/", data_home);
+	assert_int_equal(mkdir(tle_dir, 0777), 0);
+	char tle_file[MAX_NUM_CHARS];
+	snprintf(tle_file, MAX_NUM_CHARS, "%sold.tle", tle_dir);
+	copy_file(TEST_DATA_DIR "old_tles/part1.tle", tle_file);
+
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_directory(tle_dir, tle_db);
+	assert_true(tle_db->num_tles > 0);
+	struct transponder_db *transponder_db = transponder_db_create(tle_db);
+	bool *updated_tles = (bool*)calloc(tle_db->num_tles, sizeof(bool));
+
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	struct db_watcher *watcher = db_watcher_create();
+	assert_int_not_equal(watcher->fd, -1);
+	assert_int_equal(watcher->num_watches, 2);
+
+	//nothing has changed
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), 0);
+
+	//new file with more recent TLEs is dropped into the TLE directory
+	char new_tle_file[MAX_NUM_CHARS];
+	snprintf(new_tle_file, MAX_NUM_CHARS, "%snew.tle", tle_dir);
+	copy_file(TEST_DATA_DIR "newer_tles/amateur.txt", new_tle_file);
+
+	struct tle_db *orig_db = tle_db_create();
+	tle_db_from_file(tle_file, orig_db);
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), DB_WATCHER_TLES_UPDATED);
+	assert_int_equal(tle_db->num_tles, orig_db->num_tles);
+	bool updated = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		if (updated_tles[i]) {
+			updated = true;
+			assert_true(tle_db_entry_is_newer_than(tle_db->tles[i], orig_db->tles[i]));
+			assert_string_equal(tle_db->tles[i].filename, tle_file);
+			assert_string_equal(tle_db->tles[i].name, orig_db->tles[i].name);
+		} else {
+			assert_string_equal(tle_db->tles[i].line1, orig_db->tles[i].line1);
+		}
+	}
+	assert_true(updated);
+
+	//rewriting the old file does not revert the update
+	copy_file(TEST_DATA_DIR "old_tles/part1.tle", tle_file);
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), 0);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		assert_false(updated_tles[i]);
+	}
+
+	//transponder database is reloaded from the search paths
+	char db_file[MAX_NUM_CHARS];
+	snprintf(db_file, MAX_NUM_CHARS, "%sflyby.db", flyby_dir);
+	copy_file(TEST_DATA_DIR "flyby/flyby.db", db_file);
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, "/dev/NULL/");
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), DB_WATCHER_TRANSPONDERS_UPDATED);
+	assert_true(transponder_db->loaded);
+	assert_int_equal(transponder_db->num_sats, tle_db->num_tles);
+	int index = tle_db_find_entry(tle_db, 33493);
+	assert_int_not_equal(index, -1);
+	assert_int_equal(transponder_db->sats[index].num_transponders, 1);
+	assert_int_equal(transponder_db->sats[index].location, LOCATION_DATA_HOME);
+
+	db_watcher_destroy(&watcher);
+	assert_null(watcher);
+	free(updated_tles);
+	tle_db_destroy(&orig_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+
+	unlink(db_file);
+	unlink(tle_file);
+	unlink(new_tle_file);
+	rmdir(tle_dir);
+	rmdir(flyby_dir);
+	rmdir(temp_dir);
+}
+
+/**
+ * Create temporary data directory containing flyby/tles/.
+ *
+ * \param temp_dir Template for mkdtemp, overwritten with directory name
+ * \param ret_data_dir Returned path to data directory, with trailing '/'
+ * \param ret_tle_dir Returned path to TLE directory, with trailing '/'
+ **/
+void create_data_dir(char *temp_dir, char *ret_data_dir, char *ret_tle_dir)
+{
+	assert_non_null(mkdtemp(temp_dir));
+	snprintf(ret_data_dir, MAX_NUM_CHARS, "%s/", temp_dir);
+	char flyby_dir[MAX_NUM_CHARS];
+	snprintf(flyby_dir, MAX_NUM_CHARS, "%sflyby/", ret_data_dir);
+	assert_int_equal(mkdir(flyby_dir, 0777), 0);
+	snprintf(ret_tle_dir, MAX_NUM_CHARS, "%sflyby/tles/", ret_data_dir);
+	assert_int_equal(mkdir(ret_tle_dir, 0777), 0);
+}
+
+/**
+ * Remove data directory created using create_data_dir().
+ *
+ * \param temp_dir Directory name
+ * \param data_dir Path to data directory, with trailing '/'
+ * \param tle_dir Path to TLE directory, with trailing '/'
+ **/
+void remove_data_dir(const char *temp_dir, const char *data_dir, const char *tle_dir)
+{
+	char flyby_dir[MAX_NUM_CHARS];
+	snprintf(flyby_dir, MAX_NUM_CHARS, "%sflyby/", data_dir);
+	rmdir(tle_dir);
+	rmdir(flyby_dir);
+	rmdir(temp_dir);
+}
+
+void test_db_watcher_reload_precedence(void **param)
+{
+	//XDG_DATA_HOME and a single XDG_DATA_DIRS entry, both with TLE files
+	char home_temp_dir[] = "/tmp/flybytestXXXXXX";
+	char data_home[MAX_NUM_CHARS];
+	char home_tle_dir[MAX_NUM_CHARS];
+	create_data_dir(home_temp_dir, data_home, home_tle_dir);
+	char home_tle_file[MAX_NUM_CHARS];
+	snprintf(home_tle_file, MAX_NUM_CHARS, "%spart1.tle", home_tle_dir);
+	copy_file(TEST_DATA_DIR "old_tles/part1.tle", home_tle_file);
+
+	char system_temp_dir[] = "/tmp/flybytestXXXXXX";
+	char data_dir[MAX_NUM_CHARS];
+	char system_tle_dir[MAX_NUM_CHARS];
+	create_data_dir(system_temp_dir, data_dir, system_tle_dir);
+	char system_tle_file[MAX_NUM_CHARS];
+	snprintf(system_tle_file, MAX_NUM_CHARS, "%spart2.tle", system_tle_dir);
+	copy_file(TEST_DATA_DIR "old_tles/part2.tle", system_tle_file);
+
+	//read TLE database as in tle_db_from_search_paths()
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_directory(home_tle_dir, tle_db);
+	struct tle_db *system_db = tle_db_create();
+	tle_db_from_directory(system_tle_dir, system_db);
+	tle_db_merge(system_db, tle_db, TLE_OVERWRITE_NONE);
+	tle_db_destroy(&system_db);
+	struct transponder_db *transponder_db = transponder_db_create(tle_db);
+	bool *updated_tles = (bool*)calloc(tle_db->num_tles, sizeof(bool));
+
+	struct tle_db *orig_db = tle_db_create();
+	for (int i=0; i < tle_db->num_tles; i++) {
+		tle_db_add_entry(orig_db, &(tle_db->tles[i]));
+	}
+
+	will_return(xdg_data_home, data_home);
+	will_return(xdg_data_dirs, data_dir);
+	struct db_watcher *watcher = db_watcher_create();
+	assert_int_equal(watcher->num_watches, 4);
+
+	//more recent TLEs dropped into the system directory update only the entries read from the system directory
+	char new_system_tle_file[MAX_NUM_CHARS];
+	snprintf(new_system_tle_file, MAX_NUM_CHARS, "%snew.tle", system_tle_dir);
+	copy_file(TEST_DATA_DIR "newer_tles/amateur.txt", new_system_tle_file);
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), DB_WATCHER_TLES_UPDATED);
+	bool system_updated = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		assert_string_equal(tle_db->tles[i].filename, orig_db->tles[i].filename);
+		assert_string_equal(tle_db->tles[i].name, orig_db->tles[i].name);
+		if (strcmp(orig_db->tles[i].filename, home_tle_file) == 0) {
+			assert_false(updated_tles[i]);
+			assert_string_equal(tle_db->tles[i].line1, orig_db->tles[i].line1);
+		} else if (updated_tles[i]) {
+			assert_string_equal(tle_db->tles[i].filename, system_tle_file);
+			assert_true(tle_db_entry_is_newer_than(tle_db->tles[i], orig_db->tles[i]));
+			system_updated = true;
+		}
+	}
+	assert_true(system_updated);
+
+	//the same TLEs dropped into the home directory update the remaining entries
+	char new_home_tle_file[MAX_NUM_CHARS];
+	snprintf(new_home_tle_file, MAX_NUM_CHARS, "%snew.tle", home_tle_dir);
+	copy_file(TEST_DATA_DIR "newer_tles/amateur.txt", new_home_tle_file);
+	assert_int_equal(db_watcher_reload(watcher, tle_db, transponder_db, updated_tles), DB_WATCHER_TLES_UPDATED);
+	bool home_updated = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		assert_string_equal(tle_db->tles[i].filename, orig_db->tles[i].filename);
+		if (updated_tles[i]) {
+			assert_string_equal(tle_db->tles[i].filename, home_tle_file);
+			home_updated = true;
+		}
+	}
+	assert_true(home_updated);
+
+	db_watcher_destroy(&watcher);
+	free(updated_tles);
+	tle_db_destroy(&orig_db);
+	tle_db_destroy(&tle_db);
+	transponder_db_destroy(&transponder_db);
+
+	unlink(home_tle_file);
+	unlink(new_home_tle_file);
+	unlink(system_tle_file);
+	unlink(new_system_tle_file);
+	remove_data_dir(home_temp_dir, data_home, home_tle_dir);
+	remove_data_dir(system_temp_dir, data_dir, system_tle_dir);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_xdg_dirs()
+{
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_db_watcher_reload),
+		cmocka_unit_test(test_db_watcher_reload_precedence),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
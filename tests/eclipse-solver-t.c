@@ -0,0 +1,120 @@
+#include "eclipse_solver.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//time step of the sampled eclipse flags the solver is compared against (days)
+#define SAMPLE_STEP (1.0/86400.0)
+
+//duration of the comparison (days)
+#define DURATION 1.0
+
+//tolerance of shadow entry and exit times and of the eclipsed time per day compared to the sampled eclipse flags (days)
+#define EVENT_TOLERANCE (SAMPLE_STEP + ECLIPSE_SOLVER_TOLERANCE)
+#define ECLIPSED_TIME_TOLERANCE (10.0/86400.0)
+
+//upper bound for the number of propagations needed for a day, compared to 1440 for sampling each minute
+#define MAX_PROPAGATIONS_PER_DAY 600
+
+/**
+ * Get eclipse flag from libpredict.
+ *
+ * \param orbital_elements Orbital elements
+ * \param time Time
+ * \return True if the satellite is eclipsed
+ **/
+bool eclipsed(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t time)
+{
+	struct predict_position orbit;
+	predict_orbit(orbital_elements, &orbit, time);
+	return orbit.eclipsed;
+}
+
+/**
+ * Find next eclipse using the eclipse solver.
+ *
+ * \param orbital_elements Orbital elements
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \param ret_eclipse Returned eclipse, with entry and exit at the end of the search if no eclipse was found
+ **/
+void next_eclipse(const predict_orbital_elements_t *orbital_elements, predict_julian_date_t start_time, predict_julian_date_t end_time, struct eclipse_events *ret_eclipse)
+{
+	enum eclipse_solver_status status = eclipse_solver_next_eclipse(orbital_elements, start_time, end_time, ret_eclipse, NULL);
+	assert_int_not_equal(status, ECLIPSE_SOLVER_FAILED);
+	if (status == ECLIPSE_SOLVER_NO_ECLIPSE) {
+		ret_eclipse->entry = end_time;
+		ret_eclipse->exit = end_time;
+	}
+}
+
+/**
+ * Compare eclipses found using the eclipse solver against eclipse flags from libpredict sampled each second.
+ *
+ * \param line1 First TLE line
+ * \param line2 Second TLE line
+ **/
+void assert_eclipses_equal_to_libpredict(const char *line1, const char *line2)
+{
+	predict_orbital_elements_t *orbital_elements = predict_parse_tle(line1, line2);
+	predict_julian_date_t start_time = orbital_elements_epoch(orbital_elements);
+	predict_julian_date_t end_time = start_time + DURATION;
+
+	//every transition of the sampled eclipse flag is found by the solver
+	predict_julian_date_t time = start_time;
+	bool prev_eclipsed = eclipsed(orbital_elements, time);
+	double sampled_eclipsed_time = 0;
+	struct eclipse_events eclipse;
+	next_eclipse(orbital_elements, time, end_time, &eclipse);
+	for (time = start_time + SAMPLE_STEP; time < end_time; time += SAMPLE_STEP) {
+		bool curr_eclipsed = eclipsed(orbital_elements, time);
+		if (curr_eclipsed) {
+			sampled_eclipsed_time += SAMPLE_STEP;
+		}
+		if (curr_eclipsed && !prev_eclipsed) {
+			assert_true(fabs(eclipse.entry - time) < EVENT_TOLERANCE);
+		} else if (!curr_eclipsed && prev_eclipsed) {
+			assert_true(fabs(eclipse.exit - time) < EVENT_TOLERANCE);
+
+			//eclipse in progress is found with its actual entry
+			struct eclipse_events current_eclipse;
+			assert_int_equal(eclipse_solver_next_eclipse(orbital_elements, (eclipse.entry + eclipse.exit)/2.0, end_time, &current_eclipse, NULL), ECLIPSE_SOLVER_ECLIPSE_FOUND);
+			assert_true(fabs(current_eclipse.entry - eclipse.entry) < EVENT_TOLERANCE);
+			assert_true(fabs(current_eclipse.exit - eclipse.exit) < EVENT_TOLERANCE);
+
+			next_eclipse(orbital_elements, eclipse.exit + SAMPLE_STEP, end_time, &eclipse);
+		}
+		prev_eclipsed = curr_eclipsed;
+	}
+
+	//eclipsed time agrees with the sampled eclipse flags, with fewer propagations than sampling each minute
+	double eclipsed_time;
+	int num_propagations;
+	assert_true(eclipse_solver_eclipsed_time(orbital_elements, start_time, end_time, &eclipsed_time, &num_propagations));
+	assert_true(fabs(eclipsed_time - sampled_eclipsed_time) < ECLIPSED_TIME_TOLERANCE);
+	assert_true(num_propagations < MAX_PROPAGATIONS_PER_DAY);
+
+	predict_destroy_orbital_elements(orbital_elements);
+}
+
+void test_eclipse_solver_against_libpredict(void **param)
+{
+	assert_eclipses_equal_to_libpredict(ISS_TLE_LINE_1, ISS_TLE_LINE_2);
+	assert_eclipses_equal_to_libpredict(FO29_TLE_LINE_1, FO29_TLE_LINE_2);
+	assert_eclipses_equal_to_libpredict(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_eclipse_solver_against_libpredict),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
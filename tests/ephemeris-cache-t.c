@@ -0,0 +1,92 @@
+#include "ephemeris_cache.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//tolerance in position (km), velocity and range rate (km/s) and doppler shift (Hz), above the noise of the kepler equation solver in libpredict
+#define POSITION_TOLERANCE 2.0E-2
+#define VELOCITY_TOLERANCE 2.0E-5
+#define RANGE_RATE_TOLERANCE 3.0E-5
+#define DOPPLER_TOLERANCE 0.05
+
+//downlink frequency used for checking the doppler shift (Hz)
+#define DOWNLINK_FREQUENCY 435.0E6
+
+//time step between queries (days) and duration of the queries (days)
+#define QUERY_TIME_STEP (0.37/86400.0)
+#define QUERY_DURATION 0.5
+
+/**
+ * Compare positions, velocities, range rates and doppler shifts from the ephemeris cache against libpredict
+ * at sub-second times.
+ *
+ * \param line1 First TLE line
+ * \param line2 Second TLE line
+ **/
+void assert_cache_equal_to_libpredict(const char *line1, const char *line2)
+{
+	predict_orbital_elements_t *orbital_elements = predict_parse_tle(line1, line2);
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+	struct ephemeris_cache *cache = ephemeris_cache_create(orbital_elements, EPHEMERIS_CACHE_DEFAULT_WINDOW);
+
+	//start within a window after epoch
+	predict_julian_date_t start_time = ceil(orbital_elements_epoch(orbital_elements)/EPHEMERIS_CACHE_DEFAULT_WINDOW)*EPHEMERIS_CACHE_DEFAULT_WINDOW + 0.123/86400.0;
+	int num_steps = QUERY_DURATION/QUERY_TIME_STEP;
+	for (int step=0; step < num_steps; step++) {
+		predict_julian_date_t time = start_time + step*QUERY_TIME_STEP;
+		struct predict_position orbit;
+		assert_true(ephemeris_cache_orbit(cache, time, &orbit));
+		assert_true(orbit.time == time);
+
+		struct predict_position expected_orbit;
+		predict_orbit(orbital_elements, &expected_orbit, time);
+		for (int i=0; i < 3; i++) {
+			assert_true(fabs(orbit.position[i] - expected_orbit.position[i]) < POSITION_TOLERANCE);
+			assert_true(fabs(orbit.velocity[i] - expected_orbit.velocity[i]) < VELOCITY_TOLERANCE);
+		}
+
+		struct predict_observation obs;
+		struct predict_observation expected_obs;
+		assert_true(ephemeris_cache_observe(cache, observer, time, &obs));
+		predict_observe_orbit(observer, &expected_orbit, &expected_obs);
+		assert_true(fabs(obs.range_rate - expected_obs.range_rate) < RANGE_RATE_TOLERANCE);
+		assert_true(fabs(predict_doppler_shift(&obs, DOWNLINK_FREQUENCY) - predict_doppler_shift(&expected_obs, DOWNLINK_FREQUENCY)) < DOPPLER_TOLERANCE);
+	}
+
+	//one fit per window
+	int num_windows = ceil(QUERY_DURATION/EPHEMERIS_CACHE_DEFAULT_WINDOW);
+	assert_true(abs(cache->num_fits - num_windows) <= 1);
+
+	//going back in time refits the earlier window
+	int num_fits = cache->num_fits;
+	struct predict_position orbit;
+	ephemeris_cache_orbit(cache, start_time, &orbit);
+	assert_int_equal(cache->num_fits, num_fits + 1);
+
+	ephemeris_cache_destroy(&cache);
+	assert_null(cache);
+	predict_destroy_observer(observer);
+	predict_destroy_orbital_elements(orbital_elements);
+}
+
+void test_ephemeris_cache_against_libpredict(void **param)
+{
+	assert_cache_equal_to_libpredict(ISS_TLE_LINE_1, ISS_TLE_LINE_2);
+	assert_cache_equal_to_libpredict(FO29_TLE_LINE_1, FO29_TLE_LINE_2);
+	assert_cache_equal_to_libpredict(VALLADO_TLE_LINE_1, VALLADO_TLE_LINE_2);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_ephemeris_cache_against_libpredict),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,149 @@
+#include "event_loop.h"
+#include "defines.h"
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//tick interval used when the ticks should not interfere with the tested wakeup (seconds)
+#define LONG_TICK_INTERVAL 3600.0
+
+//tick interval used for testing the ticks (seconds)
+#define SHORT_TICK_INTERVAL 0.2
+
+//time until scheduled events, and until later events that must not be the ones waking up the loop (seconds)
+#define EVENT_DELAY 0.05
+#define LATE_EVENT_DELAY 10.0
+
+//allowed lateness of wakeups, generous for loaded machines while well below the late events and the long tick interval (seconds)
+#define WAKEUP_TOLERANCE 2.0
+
+/**
+ * Get wall clock time.
+ *
+ * \return Seconds since the unix epoch
+ **/
+double current_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return now.tv_sec + now.tv_nsec*1.0e-9;
+}
+
+/**
+ * Convert wall clock time to julian date.
+ *
+ * \param time Seconds since the unix epoch
+ * \return Julian date
+ **/
+predict_julian_date_t to_julian(double time)
+{
+	return (time - JULIAN_EPOCH_UNIX_TIME)/SECDAY;
+}
+
+void test_event_loop_input(void **param)
+{
+	int input[2];
+	assert_int_equal(pipe(input), 0);
+	struct event_loop *loop = event_loop_create(input[0], LONG_TICK_INTERVAL);
+
+	//available input wakes up the loop immediately
+	char character = 'a';
+	assert_int_equal(write(input[1], &character, 1), 1);
+	double start = current_time();
+	assert_int_equal(event_loop_wait(loop), EVENT_LOOP_INPUT);
+	assert_true(current_time() - start < WAKEUP_TOLERANCE);
+
+	event_loop_destroy(&loop);
+	assert_null(loop);
+	close(input[0]);
+	close(input[1]);
+}
+
+void test_event_loop_watched_fd(void **param)
+{
+	int input[2];
+	int watched[2];
+	assert_int_equal(pipe(input), 0);
+	assert_int_equal(pipe(watched), 0);
+	struct event_loop *loop = event_loop_create(input[0], LONG_TICK_INTERVAL);
+	assert_false(event_loop_watch_fd(loop, -1));
+	assert_true(event_loop_watch_fd(loop, watched[0]));
+
+	char character = 'a';
+	assert_int_equal(write(watched[1], &character, 1), 1);
+	assert_int_equal(event_loop_wait(loop), EVENT_LOOP_WATCHED_FD);
+
+	event_loop_destroy(&loop);
+	close(input[0]);
+	close(input[1]);
+	close(watched[0]);
+	close(watched[1]);
+}
+
+void test_event_loop_scheduled_event(void **param)
+{
+	int input[2];
+	assert_int_equal(pipe(input), 0);
+	struct event_loop *loop = event_loop_create(input[0], LONG_TICK_INTERVAL);
+
+	//the earliest scheduled event is used
+	double start = current_time();
+	event_loop_schedule(loop, to_julian(start + LATE_EVENT_DELAY));
+	event_loop_schedule(loop, to_julian(start + EVENT_DELAY));
+	event_loop_schedule(loop, to_julian(start + 2*LATE_EVENT_DELAY));
+	assert_int_equal(event_loop_wait(loop), EVENT_LOOP_TIMER);
+	double elapsed = current_time() - start;
+	assert_true(elapsed >= EVENT_DELAY - 0.001);
+	assert_true(elapsed < EVENT_DELAY + WAKEUP_TOLERANCE);
+
+	//events in the past wake up the loop immediately
+	start = current_time();
+	event_loop_schedule(loop, to_julian(start - 1.0));
+	assert_int_equal(event_loop_wait(loop), EVENT_LOOP_TIMER);
+	assert_true(current_time() - start < WAKEUP_TOLERANCE);
+
+	event_loop_destroy(&loop);
+	close(input[0]);
+	close(input[1]);
+}
+
+void test_event_loop_ticks(void **param)
+{
+	int input[2];
+	assert_int_equal(pipe(input), 0);
+	struct event_loop *loop = event_loop_create(input[0], SHORT_TICK_INTERVAL);
+
+	//ticks are aligned to whole multiples of the interval, so that each wakeup is in a later interval than the
+	//previous one. The schedule is cleared after each wait, and the past event does not wake up the loop again
+	event_loop_schedule(loop, to_julian(current_time() + EVENT_DELAY));
+	assert_int_equal(event_loop_wait(loop), EVENT_LOOP_TIMER);
+	double tick = floor(current_time()/SHORT_TICK_INTERVAL);
+	for (int i=0; i < 3; i++) {
+		assert_int_equal(event_loop_wait(loop), EVENT_LOOP_TIMER);
+		double next_tick = floor(current_time()/SHORT_TICK_INTERVAL);
+		assert_true(next_tick > tick);
+		tick = next_tick;
+	}
+
+	event_loop_destroy(&loop);
+	close(input[0]);
+	close(input[1]);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_event_loop_input),
+		cmocka_unit_test(test_event_loop_watched_fd),
+		cmocka_unit_test(test_event_loop_scheduled_event),
+		cmocka_unit_test(test_event_loop_ticks),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,219 @@
+#include "pass_predictions.h"
+#include "tle_db.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//duration of the predictions (days)
+#define PREDICTION_DURATION 2.0
+
+//duration of the predictions for a satellite drifting slowly over the observer (days)
+#define SLOW_DRIFT_PREDICTION_DURATION 10.0
+
+//longest pass supported by the pass solver (days)
+#define PASS_SOLVER_MAX_PASS_DURATION 1.0
+
+/**
+ * Find passes of a single satellite sequentially, for comparison.
+ *
+ * \param tle_db TLE database
+ * \param tle_index Index in TLE database
+ * \param observer Observer
+ * \param start_time Start of search
+ * \param end_time End of search
+ * \param min_elevation Minimum maximum elevation
+ * \param ret_passes Returned passes
+ * \param max_passes Maximum number of returned passes
+ * \return Number of passes
+ **/
+int sequential_passes(struct tle_db *tle_db, int tle_index, const predict_observer_t *observer, predict_julian_date_t start_time, predict_julian_date_t end_time, double min_elevation, struct pass_events *ret_passes, int max_passes)
+{
+	struct tle_db_orbital_elements *orbital_elements = tle_db_entry_get_orbital_elements(tle_db, tle_index);
+	int num_passes = 0;
+	predict_julian_date_t time = start_time;
+	struct pass_events pass;
+	while ((num_passes < max_passes) && (pass_solver_next_pass(observer, orbital_elements->elements, time, end_time, &pass, NULL) == PASS_SOLVER_PASS_FOUND) && (pass.aos < end_time)) {
+		if (pass.max_elevation >= min_elevation) {
+			ret_passes[num_passes++] = pass;
+		}
+		time = pass.los + 1.0/86400.0;
+	}
+	tle_db_orbital_elements_release(&orbital_elements);
+	return num_passes;
+}
+
+/**
+ * Check that the predicted passes are in AOS order with steps from AOS to LOS, and agree with sequential
+ * pass solving for each enabled satellite.
+ *
+ * \param min_elevation Minimum maximum elevation of passes
+ **/
+void check_pass_predictions(double min_elevation)
+{
+	char tle_file[] = "/tmp/flybytestXXXXXX";
+	struct tle_db *tle_db = create_tle_db(tle_file);
+	predict_observer_t *observer = predict_create_observer("test", 59.95*M_PI/180.0, 10.75*M_PI/180.0, 0);
+	predict_julian_date_t start_time = predict_to_julian(time(NULL));
+	predict_julian_date_t end_time = start_time + PREDICTION_DURATION;
+
+	struct pass_events expected_passes[NUM_SATELLITES][100];
+	int num_expected_passes[NUM_SATELLITES] = {0};
+	int total_expected_passes = 0;
+	for (int i=1; i < NUM_SATELLITES; i++) {
+		num_expected_passes[i] = sequential_passes(tle_db, i, observer, start_time, end_time, min_elevation, expected_passes[i], 100);
+		total_expected_passes += num_expected_passes[i];
+	}
+
+	struct pass_predictions *predictions = pass_predictions_create(tle_db, observer, start_time, end_time, min_elevation, 2);
+	int num_passes[NUM_SATELLITES] = {0};
+	int total_passes = 0;
+	predict_julian_date_t previous_aos = 0;
+	const struct pass_prediction *pass;
+	while ((pass = pass_predictions_next(predictions)) != NULL) {
+		//disabled satellite is skipped
+		assert_true((pass->tle_index > 0) && (pass->tle_index < NUM_SATELLITES));
+
+		//passes are in AOS order
+		assert_true(pass->events.aos >= previous_aos);
+		previous_aos = pass->events.aos;
+		assert_true(pass->events.max_elevation >= min_elevation);
+
+		//same passes as when solved sequentially
+		assert_true(num_passes[pass->tle_index] < num_expected_passes[pass->tle_index]);
+		struct pass_events *expected = &(expected_passes[pass->tle_index][num_passes[pass->tle_index]]);
+		assert_true(pass->events.aos == expected->aos);
+		assert_true(pass->events.los == expected->los);
+		num_passes[pass->tle_index]++;
+		total_passes++;
+
+		//steps go from AOS to LOS
+		assert_true(pass->num_steps >= 2);
+		assert_true(pass->steps[0].time == pass->events.aos);
+		assert_true(pass->steps[pass->num_steps-1].time == pass->events.los);
+		for (int i=1; i < pass->num_steps; i++) {
+			assert_true(pass->steps[i].time > pass->steps[i-1].time);
+		}
+	}
+	assert_int_equal(total_passes, total_expected_passes);
+
+	pass_predictions_destroy(&predictions);
+	assert_null(predictions);
+	predict_destroy_observer(observer);
+	tle_db_destroy(&tle_db);
+	unlink(tle_file);
+}
+
+void test_pass_predictions(void **param)
+{
+	check_pass_predictions(0);
+}
+
+void test_pass_predictions_min_elevation(void **param)
+{
+	check_pass_predictions(30.0*M_PI/180.0);
+}
+
+/**
+ * Write TLE file with a near-equatorial satellite above the geostationary orbit, which drifts slowly westwards over
+ * the observer and has passes lasting several days.
+ *
+ * \param filename Output file
+ **/
+void write_slow_drift_tle_file(const char *filename)
+{
+	time_t curr_time = time(NULL);
+	struct tm epoch;
+	gmtime_r(&curr_time, &epoch);
+	double day_of_year = epoch.tm_yday + 1 + (epoch.tm_hour + (epoch.tm_min + epoch.tm_sec/60.0)/60.0)/24.0;
+
+	char line1[MAX_NUM_CHARS];
+	char line2[MAX_NUM_CHARS];
+	snprintf(line1, MAX_NUM_CHARS, "1 41000U 15034A   %02d%012.8f  .00000000  00000-0  00000-0 0  999", epoch.tm_year % 100, day_of_year);
+	snprintf(line2, MAX_NUM_CHARS, "2 41000   0.0500 301.2720 0001000 256.5450 189.6640  0.80000000    1");
+	append_checksum(line1);
+	append_checksum(line2);
+
+	FILE *file = fopen(filename, "w");
+	assert_non_null(file);
+	fprintf(file, "SLOW-DRIFT\n%s\n%s\n", line1, line2);
+	fclose(file);
+}
+
+void test_pass_predictions_solver_fallback(void **param)
+{
+	char tle_file[] = "/tmp/flybytestXXXXXX";
+	int fd = mkstemp(tle_file);
+	assert_true(fd >= 0);
+	close(fd);
+	write_slow_drift_tle_file(tle_file);
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(tle_file, tle_db);
+	assert_int_equal(tle_db->num_tles, 1);
+	tle_db_entry_set_enabled(tle_db, 0, true);
+
+	predict_observer_t *observer = predict_create_observer("test", 0.0, 10.75*M_PI/180.0, 0);
+	predict_julian_date_t start_time = predict_to_julian(time(NULL));
+	predict_julian_date_t end_time = start_time + SLOW_DRIFT_PREDICTION_DURATION;
+	struct tle_db_orbital_elements *orbital_elements = tle_db_entry_get_orbital_elements(tle_db, 0);
+
+	//passes are longer than the pass solver supports
+	struct pass_events solver_pass;
+	assert_int_equal(pass_solver_next_pass(observer, orbital_elements->elements, start_time, end_time, &solver_pass, NULL), PASS_SOLVER_FAILED);
+
+	//passes are found using libpredict instead
+	struct pass_predictions *predictions = pass_predictions_create(tle_db, observer, start_time, end_time, 0, 1);
+	int num_passes = 0;
+	predict_julian_date_t previous_los = 0;
+	const struct pass_prediction *pass;
+	while ((pass = pass_predictions_next(predictions)) != NULL) {
+		assert_int_equal(pass->tle_index, 0);
+		assert_true(pass->events.aos >= previous_los);
+		assert_true(pass->events.aos < end_time);
+		if (pass->events.aos > start_time) {
+			assert_true(pass->events.los - pass->events.aos > PASS_SOLVER_MAX_PASS_DURATION);
+		}
+		previous_los = pass->events.los;
+
+		struct predict_observation los = predict_next_los(observer, orbital_elements->elements, pass->events.aos);
+		assert_true(pass->events.los == los.time);
+
+		struct predict_position orbit;
+		struct predict_observation obs;
+		predict_orbit(orbital_elements->elements, &orbit, (pass->events.aos + pass->events.los)/2.0);
+		predict_observe_orbit(observer, &orbit, &obs);
+		assert_true(obs.elevation > 0);
+
+		assert_true(pass->num_steps >= 2);
+		assert_true(pass->steps[0].time == pass->events.aos);
+		assert_true(pass->steps[pass->num_steps-1].time == pass->events.los);
+		num_passes++;
+	}
+	assert_true(num_passes > 0);
+
+	pass_predictions_destroy(&predictions);
+	tle_db_orbital_elements_release(&orbital_elements);
+	predict_destroy_observer(observer);
+	tle_db_destroy(&tle_db);
+	unlink(tle_file);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_pass_predictions),
+		cmocka_unit_test(test_pass_predictions_min_elevation),
+		cmocka_unit_test(test_pass_predictions_solver_fallback),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,125 @@
+/**
+ * Benchmark of the pass solver. Finds all passes over the next day for the satellites in a TLE file, using
+ * the pass solver and using separate predict_next_aos(), predict_next_los() and predict_at_max_elevation()
+ * calls, and prints the time and number of propagations per pass.
+ *
+ * Usage: pass-solver-benchmark [TLE file] [latitude] [longitude]
+ **/
+
+#include "pass_solver.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//default TLE file
+#define DEFAULT_TLE_FILE "test_data/newer_tles/amateur.txt"
+
+//length of the time interval searched for passes (days)
+#define SEARCH_INTERVAL 1.0
+
+//maximum number of satellites read from the TLE file
+#define MAX_NUM_SATELLITES 50000
+
+//maximum number of characters of a line in the TLE file
+#define MAX_LINE_LENGTH 256
+
+/**
+ * Get current time in seconds from a monotonic clock.
+ *
+ * \return Time (seconds)
+ **/
+double benchmark_time()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec*1.0e-9;
+}
+
+int main(int argc, char **argv)
+{
+	const char *tle_file = (argc > 1) ? argv[1] : DEFAULT_TLE_FILE;
+	double latitude = (argc > 2) ? atof(argv[2]) : 63.42;
+	double longitude = (argc > 3) ? atof(argv[3]) : 10.39;
+
+	FILE *file = fopen(tle_file, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Could not open %s\n", tle_file);
+		return 1;
+	}
+
+	//read satellites that have passes
+	predict_observer_t *observer = predict_create_observer("benchmark", latitude*M_PI/180.0, longitude*M_PI/180.0, 0);
+	predict_julian_date_t start_time = predict_to_julian(time(NULL));
+	predict_orbital_elements_t **satellites = (predict_orbital_elements_t**)malloc(sizeof(predict_orbital_elements_t*)*MAX_NUM_SATELLITES);
+	int num_satellites = 0;
+	char name[MAX_LINE_LENGTH], line1[MAX_LINE_LENGTH], line2[MAX_LINE_LENGTH];
+	while ((num_satellites < MAX_NUM_SATELLITES) && fgets(name, MAX_LINE_LENGTH, file) && fgets(line1, MAX_LINE_LENGTH, file) && fgets(line2, MAX_LINE_LENGTH, file)) {
+		line1[strcspn(line1, "\r\n")] = '\0';
+		line2[strcspn(line2, "\r\n")] = '\0';
+		predict_orbital_elements_t *orbital_elements = predict_parse_tle(line1, line2);
+		if (orbital_elements == NULL) {
+			continue;
+		}
+
+		struct predict_position orbit;
+		predict_orbit(orbital_elements, &orbit, start_time);
+		if (predict_is_geosynchronous(orbital_elements) || !predict_aos_happens(orbital_elements, observer->latitude) || orbit.decayed) {
+			predict_destroy_orbital_elements(orbital_elements);
+			continue;
+		}
+		satellites[num_satellites++] = orbital_elements;
+	}
+	fclose(file);
+
+	//pass solver
+	long solver_passes = 0;
+	long solver_propagations = 0;
+	double solver_start = benchmark_time();
+	for (int i=0; i < num_satellites; i++) {
+		predict_julian_date_t time = start_time;
+		struct pass_events pass;
+		int num_propagations;
+		while (pass_solver_next_pass(observer, satellites[i], time, start_time + SEARCH_INTERVAL, &pass, &num_propagations) == PASS_SOLVER_PASS_FOUND) {
+			solver_passes++;
+			solver_propagations += num_propagations;
+			time = pass.los + 1.0/86400.0;
+		}
+		solver_propagations += num_propagations;
+	}
+	double solver_duration = benchmark_time() - solver_start;
+
+	//separate libpredict searches
+	long libpredict_passes = 0;
+	double libpredict_start = benchmark_time();
+	for (int i=0; i < num_satellites; i++) {
+		predict_julian_date_t time = start_time;
+		while (true) {
+			struct predict_observation aos = predict_next_aos(observer, satellites[i], time);
+			if ((aos.time < time) || (aos.time > start_time + SEARCH_INTERVAL)) {
+				break;
+			}
+			struct predict_observation los = predict_next_los(observer, satellites[i], aos.time);
+			predict_at_max_elevation(observer, satellites[i], aos.time);
+			libpredict_passes++;
+			time = los.time + 1.0/86400.0;
+		}
+	}
+	double libpredict_duration = benchmark_time() - libpredict_start;
+
+	printf("%d satellites, passes over %.1f days\n", num_satellites, SEARCH_INTERVAL);
+	if (solver_passes > 0) {
+		printf("pass solver: %ld passes, %.1f propagations/pass (including the final search without AOS), %.1f us/pass\n", solver_passes, solver_propagations*1.0/solver_passes, solver_duration*1.0e6/solver_passes);
+	}
+	if (libpredict_passes > 0) {
+		printf("libpredict:  %ld passes, %.1f us/pass\n", libpredict_passes, libpredict_duration*1.0e6/libpredict_passes);
+	}
+
+	for (int i=0; i < num_satellites; i++) {
+		predict_destroy_orbital_elements(satellites[i]);
+	}
+	free(satellites);
+	predict_destroy_observer(observer);
+	return 0;
+}
@@ -0,0 +1,92 @@
+#include "pass_solver.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//number of consecutive passes compared against libpredict
+#define NUM_PASSES 30
+
+//tolerance of AOS and LOS times compared to libpredict (days)
+#define AOSLOS_TOLERANCE (5.0/86400.0)
+
+//tolerance of time of maximum elevation compared to libpredict (days)
+#define MAX_ELEVATION_TIME_TOLERANCE (30.0/86400.0)
+
+//tolerance of maximum elevation compared to libpredict (radians)
+#define MAX_ELEVATION_TOLERANCE (0.05*M_PI/180.0)
+
+//upper bound for the average number of propagations needed for finding a pass
+#define MAX_PROPAGATIONS_PER_PASS 80
+
+/**
+ * Compare consecutive passes found using the pass solver against the passes found using libpredict.
+ *
+ * \param line1 First TLE line
+ * \param line2 Second TLE line
+ **/
+void assert_passes_equal_to_libpredict(const char *line1, const char *line2)
+{
+	predict_orbital_elements_t *orbital_elements = predict_parse_tle(line1, line2);
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+
+	//start after the pass in progress at epoch, if any, since predict_next_aos() skips it
+	predict_julian_date_t time = orbital_elements_epoch(orbital_elements);
+	struct pass_events pass;
+	assert_int_equal(pass_solver_next_pass(observer, orbital_elements, time, time + 10.0, &pass, NULL), PASS_SOLVER_PASS_FOUND);
+	if (pass.aos < time) {
+		time = pass.los + 1.0/1440.0;
+	}
+
+	int total_propagations = 0;
+	for (int i=0; i < NUM_PASSES; i++) {
+		int num_propagations;
+		assert_int_equal(pass_solver_next_pass(observer, orbital_elements, time, time + 10.0, &pass, &num_propagations), PASS_SOLVER_PASS_FOUND);
+		total_propagations += num_propagations;
+
+		predict_julian_date_t aos = predict_next_aos(observer, orbital_elements, time).time;
+		predict_julian_date_t los = predict_next_los(observer, orbital_elements, aos).time;
+		struct predict_observation max_elevation = predict_at_max_elevation(observer, orbital_elements, (aos + los)/2.0);
+		assert_true(fabs(pass.aos - aos) < AOSLOS_TOLERANCE);
+		assert_true(fabs(pass.los - los) < AOSLOS_TOLERANCE);
+		assert_true(fabs(pass.max_elevation_time - max_elevation.time) < MAX_ELEVATION_TIME_TOLERANCE);
+		assert_true(fabs(pass.max_elevation - max_elevation.elevation) < MAX_ELEVATION_TOLERANCE);
+		assert_true((pass.aos < pass.max_elevation_time) && (pass.max_elevation_time < pass.los));
+
+		//pass in progress is found with its actual AOS
+		struct pass_events current_pass;
+		assert_int_equal(pass_solver_next_pass(observer, orbital_elements, pass.max_elevation_time, pass.max_elevation_time, &current_pass, NULL), PASS_SOLVER_PASS_FOUND);
+		assert_true(fabs(current_pass.aos - pass.aos) < AOSLOS_TOLERANCE);
+		assert_true(fabs(current_pass.los - pass.los) < AOSLOS_TOLERANCE);
+		assert_true(fabs(current_pass.max_elevation - pass.max_elevation) < MAX_ELEVATION_TOLERANCE);
+
+		time = pass.los + 1.0/1440.0;
+	}
+	assert_true(total_propagations/NUM_PASSES < MAX_PROPAGATIONS_PER_PASS);
+
+	//no AOS right after LOS
+	assert_int_equal(pass_solver_next_pass(observer, orbital_elements, time, time, &pass, NULL), PASS_SOLVER_NO_PASS);
+
+	predict_destroy_orbital_elements(orbital_elements);
+	predict_destroy_observer(observer);
+}
+
+void test_pass_solver_against_libpredict(void **param)
+{
+	assert_passes_equal_to_libpredict(ISS_TLE_LINE_1, ISS_TLE_LINE_2);
+	assert_passes_equal_to_libpredict(FO29_TLE_LINE_1, FO29_TLE_LINE_2);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_pass_solver_against_libpredict),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,128 @@
+#include "pass_table.h"
+#include "tle_db.h"
+#include "test-helpers.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//maximum time to wait for the background thread (seconds)
+#define WAIT_TIMEOUT 30
+
+/**
+ * Wait until the pass table has processed a satellite.
+ *
+ * \param pass_table Pass table
+ * \param index Satellite index
+ * \param ret_pass Returned pass
+ * \return Status of pass_table_next_pass() at the current time
+ **/
+enum pass_table_status wait_for_pass(struct pass_table *pass_table, int index, struct pass_events *ret_pass)
+{
+	enum pass_table_status status = PASS_TABLE_NOT_COMPUTED;
+	struct timespec delay = {.tv_sec = 0, .tv_nsec = 10000000};
+	for (int i=0; i < WAIT_TIMEOUT*100; i++) {
+		status = pass_table_next_pass(pass_table, index, predict_to_julian(time(NULL)), ret_pass);
+		if (status != PASS_TABLE_NOT_COMPUTED) {
+			break;
+		}
+		nanosleep(&delay, NULL);
+	}
+	return status;
+}
+
+void test_pass_table_next_pass(void **param)
+{
+	char tle_file[] = "/tmp/flybytestXXXXXX";
+	struct tle_db *tle_db = create_tle_db(tle_file);
+	predict_observer_t *observer = predict_create_observer("test", 59.95*M_PI/180.0, 10.75*M_PI/180.0, 0);
+	struct pass_table *pass_table = pass_table_create(observer, tle_db, 1.0);
+
+	//disabled satellite has no passes
+	struct pass_events pass;
+	assert_int_equal(wait_for_pass(pass_table, 0, &pass), PASS_TABLE_NO_PASSES);
+
+	for (int i=1; i < NUM_SATELLITES; i++) {
+		assert_int_equal(wait_for_pass(pass_table, i, &pass), PASS_TABLE_PASS_FOUND);
+		predict_julian_date_t curr_time = predict_to_julian(time(NULL));
+		assert_true(pass.los > curr_time);
+		assert_true(pass.aos <= pass.los);
+		assert_true((pass.max_elevation_time >= pass.aos) && (pass.max_elevation_time <= pass.los));
+
+		//following passes are in time order and do not overlap
+		struct pass_events next_pass;
+		while (pass_table_next_pass(pass_table, i, pass.los, &next_pass) == PASS_TABLE_PASS_FOUND) {
+			assert_true(next_pass.aos > pass.los);
+			assert_true(next_pass.aos <= next_pass.los);
+			pass = next_pass;
+		}
+	}
+
+	//invalid indices are never computed
+	assert_int_equal(pass_table_next_pass(pass_table, -1, predict_to_julian(time(NULL)), &pass), PASS_TABLE_NOT_COMPUTED);
+	assert_int_equal(pass_table_next_pass(pass_table, NUM_SATELLITES, predict_to_julian(time(NULL)), &pass), PASS_TABLE_NOT_COMPUTED);
+
+	pass_table_destroy(&pass_table);
+	assert_null(pass_table);
+	predict_destroy_observer(observer);
+	tle_db_destroy(&tle_db);
+	unlink(tle_file);
+}
+
+void test_pass_table_refresh(void **param)
+{
+	char tle_file[] = "/tmp/flybytestXXXXXX";
+	struct tle_db *tle_db = create_tle_db(tle_file);
+	predict_observer_t *observer = predict_create_observer("test", 59.95*M_PI/180.0, 10.75*M_PI/180.0, 0);
+	struct pass_table *pass_table = pass_table_create(observer, tle_db, 1.0);
+
+	struct pass_events pass;
+	assert_int_equal(wait_for_pass(pass_table, 0, &pass), PASS_TABLE_NO_PASSES);
+	assert_int_equal(wait_for_pass(pass_table, 1, &pass), PASS_TABLE_PASS_FOUND);
+
+	//enabled satellites get passes, disabled satellites lose them
+	tle_db_entry_set_enabled(tle_db, 0, true);
+	tle_db_entry_set_enabled(tle_db, 1, false);
+	pass_table_refresh(pass_table, tle_db);
+	assert_int_equal(wait_for_pass(pass_table, 0, &pass), PASS_TABLE_PASS_FOUND);
+	assert_int_equal(wait_for_pass(pass_table, 1, &pass), PASS_TABLE_NO_PASSES);
+
+	//passes are recomputed for new observer
+	struct pass_events old_pass;
+	assert_int_equal(wait_for_pass(pass_table, 2, &old_pass), PASS_TABLE_PASS_FOUND);
+	predict_observer_t *new_observer = predict_create_observer("test", -33.92*M_PI/180.0, 18.42*M_PI/180.0, 0);
+	pass_table_set_observer(pass_table, new_observer);
+	bool changed = false;
+	struct timespec delay = {.tv_sec = 0, .tv_nsec = 10000000};
+	for (int i=0; (i < WAIT_TIMEOUT*100) && !changed; i++) {
+		if (pass_table_next_pass(pass_table, 2, predict_to_julian(time(NULL)), &pass) == PASS_TABLE_PASS_FOUND) {
+			changed = (pass.aos != old_pass.aos) || (pass.max_elevation != old_pass.max_elevation);
+		}
+		nanosleep(&delay, NULL);
+	}
+	assert_true(changed);
+
+	pass_table_destroy(&pass_table);
+	predict_destroy_observer(observer);
+	predict_destroy_observer(new_observer);
+	tle_db_destroy(&tle_db);
+	unlink(tle_file);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_pass_table_next_pass),
+		cmocka_unit_test(test_pass_table_refresh),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,212 @@
+#include "prediction_output.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//2016-06-20 22:30 UTC, chosen along with the step length to be exactly representable as a julian date
+#define TEST_UNIX_TIME 1466461800
+
+//time between steps through the test pass (seconds)
+#define STEP_LENGTH 675
+
+//number of steps through the test pass
+#define NUM_STEPS 3
+
+//number of passes written when testing output larger than the buffer
+#define NUM_LARGE_OUTPUT_PASSES 5000
+
+/**
+ * Create test pass with NUM_STEPS steps.
+ *
+ * \param steps Steps of the pass
+ * \param ret_pass Returned pass
+ **/
+void create_pass(struct pass_prediction_step *steps, struct pass_prediction *ret_pass)
+{
+	predict_julian_date_t aos = predict_to_julian(TEST_UNIX_TIME);
+	for (int i=0; i < NUM_STEPS; i++) {
+		steps[i].time = aos + i*STEP_LENGTH/86400.0;
+		steps[i].elevation = (i == 1) ? 45.0*M_PI/180.0 : 0;
+		steps[i].azimuth = i*M_PI/2.0;
+		steps[i].range = 1000.0 + i;
+		steps[i].latitude = 60.0*M_PI/180.0;
+		steps[i].longitude = 10.0*M_PI/180.0;
+		steps[i].phase = M_PI;
+		steps[i].revolutions = 1234;
+		steps[i].visibility = "+* "[i];
+	}
+
+	memset(ret_pass, 0, sizeof(struct pass_prediction));
+	ret_pass->tle_index = 0;
+	ret_pass->events.aos = steps[0].time;
+	ret_pass->events.los = steps[NUM_STEPS-1].time;
+	ret_pass->events.max_elevation_time = steps[1].time;
+	ret_pass->events.max_elevation = steps[1].elevation;
+	ret_pass->num_steps = NUM_STEPS;
+	ret_pass->steps = steps;
+}
+
+/**
+ * Read back everything written to a temporary file.
+ *
+ * \param file File
+ * \return Contents of file, to be freed by the caller
+ **/
+char *read_file(FILE *file)
+{
+	long length = ftell(file);
+	rewind(file);
+	char *contents = (char*)malloc(length + 1);
+	assert_int_equal(fread(contents, 1, length, file), length);
+	contents[length] = '\0';
+	fclose(file);
+	return contents;
+}
+
+/**
+ * Count occurrences of a substring.
+ *
+ * \param string String
+ * \param substring Substring
+ * \return Number of occurrences
+ **/
+int count_occurrences(const char *string, const char *substring)
+{
+	int count = 0;
+	for (const char *match = strstr(string, substring); match != NULL; match = strstr(match + 1, substring)) {
+		count++;
+	}
+	return count;
+}
+
+void test_prediction_output_format_from_string(void **param)
+{
+	enum prediction_output_format format;
+	assert_true(prediction_output_format_from_string("text", &format));
+	assert_int_equal(format, PREDICTION_OUTPUT_TEXT);
+	assert_true(prediction_output_format_from_string("csv", &format));
+	assert_int_equal(format, PREDICTION_OUTPUT_CSV);
+	assert_true(prediction_output_format_from_string("jsonl", &format));
+	assert_int_equal(format, PREDICTION_OUTPUT_JSONL);
+	assert_true(prediction_output_format_from_string("ics", &format));
+	assert_int_equal(format, PREDICTION_OUTPUT_ICS);
+	assert_false(prediction_output_format_from_string("xml", &format));
+}
+
+void test_prediction_output_csv(void **param)
+{
+	struct pass_prediction_step steps[NUM_STEPS];
+	struct pass_prediction pass;
+	create_pass(steps, &pass);
+	struct astronomical_body_event event = {.type = ASTRONOMICAL_BODY_RISE, .time = pass.events.aos, .azimuth = M_PI/2.0, .elevation = 0};
+
+	FILE *file = tmpfile();
+	struct prediction_output *output = prediction_output_create(file, PREDICTION_OUTPUT_CSV);
+	prediction_output_pass(output, "TEST, \"SAT\"", 12345, &pass);
+	prediction_output_event(output, "Sun", "rise", &event);
+	assert_true(prediction_output_destroy(&output));
+	assert_null(output);
+	char *contents = read_file(file);
+
+	//one row per step, with the name quoted, followed by a new header for the events
+	const char *expected_start = "satellite,satellite_number,aos,los,max_elevation,time,elevation,azimuth,phase,latitude,longitude,range,revolutions,visibility\n"
+		"\"TEST, \"\"SAT\"\"\",12345,2016-06-20T22:30:00.000Z,2016-06-20T22:52:30.000Z,45.000,2016-06-20T22:30:00.000Z,0.000,0.000,180.000,60.000,10.000,1000.000,1234,visible\n";
+	assert_int_equal(strncmp(contents, expected_start, strlen(expected_start)), 0);
+	assert_int_equal(count_occurrences(contents, "\n\"TEST"), NUM_STEPS);
+	assert_non_null(strstr(contents, "\n\nbody,event,time,azimuth,elevation\nSun,rise,2016-06-20T22:30:00.000Z,90.000,0.000\n"));
+	free(contents);
+}
+
+void test_prediction_output_jsonl(void **param)
+{
+	struct pass_prediction_step steps[NUM_STEPS];
+	struct pass_prediction pass;
+	create_pass(steps, &pass);
+
+	FILE *file = tmpfile();
+	struct prediction_output *output = prediction_output_create(file, PREDICTION_OUTPUT_JSONL);
+	prediction_output_pass(output, "TEST \"SAT\"\\", 12345, &pass);
+	assert_true(prediction_output_destroy(&output));
+	char *contents = read_file(file);
+
+	//single line with escaped name and all steps
+	const char *expected_start = "{\"satellite\":\"TEST \\\"SAT\\\"\\\\\",\"satellite_number\":12345,";
+	assert_int_equal(strncmp(contents, expected_start, strlen(expected_start)), 0);
+	assert_int_equal(count_occurrences(contents, "\n"), 1);
+	assert_int_equal(count_occurrences(contents, "{\"time\":"), NUM_STEPS);
+	assert_non_null(strstr(contents, "\"visibility\":\"eclipsed\"}]}\n"));
+	free(contents);
+}
+
+void test_prediction_output_ics(void **param)
+{
+	struct pass_prediction_step steps[NUM_STEPS];
+	struct pass_prediction pass;
+	create_pass(steps, &pass);
+	char long_name[MAX_NUM_CHARS] = {0};
+	memset(long_name, 'A', 200);
+
+	FILE *file = tmpfile();
+	struct prediction_output *output = prediction_output_create(file, PREDICTION_OUTPUT_ICS);
+	prediction_output_pass(output, "TEST; SAT", 12345, &pass);
+	prediction_output_pass(output, long_name, 12346, &pass);
+	assert_true(prediction_output_destroy(&output));
+	char *contents = read_file(file);
+
+	assert_int_equal(strncmp(contents, "BEGIN:VCALENDAR\r\nVERSION:2.0\r\n", 30), 0);
+	assert_int_equal(strcmp(contents + strlen(contents) - 15, "END:VCALENDAR\r\n"), 0);
+	assert_int_equal(count_occurrences(contents, "BEGIN:VEVENT\r\n"), 2);
+	assert_non_null(strstr(contents, "\r\nDTSTART:20160620T223000Z\r\nDTEND:20160620T225230Z\r\n"));
+	assert_non_null(strstr(contents, "\r\nSUMMARY:TEST\\; SAT pass\\, max elevation 45 deg\r\n"));
+
+	//all lines are terminated by CRLF and folded to at most 75 octets
+	for (char *line = contents; *line != '\0';) {
+		char *end = strstr(line, "\r\n");
+		assert_non_null(end);
+		assert_true(end - line <= 75);
+		assert_null(memchr(line, '\n', end - line));
+		line = end + 2;
+	}
+	free(contents);
+}
+
+void test_prediction_output_larger_than_buffer(void **param)
+{
+	struct pass_prediction_step steps[NUM_STEPS];
+	struct pass_prediction pass;
+	create_pass(steps, &pass);
+
+	FILE *file = tmpfile();
+	struct prediction_output *output = prediction_output_create(file, PREDICTION_OUTPUT_TEXT);
+	for (int i=0; i < NUM_LARGE_OUTPUT_PASSES; i++) {
+		prediction_output_pass(output, "TEST", 12345, &pass);
+	}
+	assert_true(prediction_output_destroy(&output));
+	char *contents = read_file(file);
+
+	//header, steps and empty line for each pass
+	assert_true(strlen(contents) > PREDICTION_OUTPUT_BUFFER_SIZE);
+	assert_int_equal(count_occurrences(contents, "TEST (12345)  AOS 2016-06-20T22:30:00Z  LOS 2016-06-20T22:52:30Z  Max elevation 45.0\n"), NUM_LARGE_OUTPUT_PASSES);
+	assert_int_equal(count_occurrences(contents, "\n"), NUM_LARGE_OUTPUT_PASSES*(NUM_STEPS + 2));
+	free(contents);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_prediction_output_format_from_string),
+		cmocka_unit_test(test_prediction_output_csv),
+		cmocka_unit_test(test_prediction_output_jsonl),
+		cmocka_unit_test(test_prediction_output_ics),
+		cmocka_unit_test(test_prediction_output_larger_than_buffer),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,101 @@
+#include "root_finder.h"
+#include <math.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//tolerance of the found roots
+#define TOLERANCE 1.0e-9
+
+/**
+ * Cosine, counting the number of evaluations.
+ *
+ * \param data Number of evaluations, int
+ * \param x Argument
+ * \return cos(x)
+ **/
+double cosine(void *data, double x)
+{
+	(*(int*)data)++;
+	return cos(x);
+}
+
+/**
+ * Function with a short dip below zero around x = 1, with rate of change 1.
+ *
+ * \param data Depth of the dip, double
+ * \param x Argument
+ * \return Function value
+ **/
+double dip(void *data, double x)
+{
+	return fabs(x - 1.0) - *(double*)data;
+}
+
+/**
+ * Function that is undefined everywhere but at the bracket ends used in the tests.
+ *
+ * \param data Unused
+ * \param x Argument
+ * \return NAN
+ **/
+double undefined(void *data, double x)
+{
+	return NAN;
+}
+
+void test_root_finder_brent(void **param)
+{
+	int num_evaluations = 0;
+	double root = root_finder_brent(cosine, &num_evaluations, 0.0, cos(0.0), 3.0, cos(3.0), TOLERANCE);
+	assert_true(fabs(root - M_PI/2.0) < TOLERANCE);
+	assert_true(num_evaluations < 20);
+
+	//reversed bracket
+	root = root_finder_brent(cosine, &num_evaluations, 3.0, cos(3.0), 0.0, cos(0.0), TOLERANCE);
+	assert_true(fabs(root - M_PI/2.0) < TOLERANCE);
+}
+
+void test_root_finder_first_crossing(void **param)
+{
+	double depth = 0.01;
+	double root, x, fx;
+
+	//samples of opposite sign
+	assert_true(root_finder_first_crossing(dip, &depth, 1.0, 1.0e-6, TOLERANCE, 0.0, dip(&depth, 0.0), 1.0, dip(&depth, 1.0), &root, &x, &fx));
+	assert_true(fabs(root - 0.99) < TOLERANCE);
+	assert_true(x == 1.0);
+	assert_true(fx < 0);
+
+	//dip between two positive samples is found by subdivision, in both directions
+	assert_true(root_finder_first_crossing(dip, &depth, 1.0, 1.0e-6, TOLERANCE, 0.0, dip(&depth, 0.0), 2.2, dip(&depth, 2.2), &root, &x, &fx));
+	assert_true(fabs(root - 0.99) < TOLERANCE);
+	assert_true(fx < 0);
+	assert_true(root_finder_first_crossing(dip, &depth, 1.0, 1.0e-6, TOLERANCE, 2.2, dip(&depth, 2.2), 0.0, dip(&depth, 0.0), &root, &x, &fx));
+	assert_true(fabs(root - 1.01) < TOLERANCE);
+	assert_true(fx < 0);
+
+	//function staying above zero
+	depth = -0.01;
+	assert_false(root_finder_first_crossing(dip, &depth, 1.0, 1.0e-6, TOLERANCE, 0.0, dip(&depth, 0.0), 2.2, dip(&depth, 2.2), &root, &x, &fx));
+
+	//rate bound rules out a root between the samples
+	assert_false(root_finder_first_crossing(dip, &depth, 0.1, 1.0e-6, TOLERANCE, 0.0, dip(&depth, 0.0), 2.2, dip(&depth, 2.2), &root, &x, &fx));
+
+	//undefined function values stop the search
+	assert_false(root_finder_first_crossing(undefined, NULL, 1.0, 1.0e-6, TOLERANCE, 0.0, 1.0, 2.2, 1.0, &root, &x, &fx));
+	assert_false(root_finder_first_crossing(undefined, NULL, 1.0, 1.0e-6, TOLERANCE, 0.0, -1.0, 2.2, NAN, &root, &x, &fx));
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_root_finder_brent),
+		cmocka_unit_test(test_root_finder_first_crossing),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,96 @@
+#include "solar_system.h"
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+//June solstice of 2016, 2016-06-20 22:34 UTC
+#define SOLSTICE_UNIX_TIME 1466462040
+
+//obliquity of the ecliptic (radians) and tolerance of the sun declination at the solstice (radians)
+#define OBLIQUITY (23.437*M_PI/180.0)
+#define DECLINATION_TOLERANCE (0.01*M_PI/180.0)
+
+//astronomical unit (km) and relative tolerance of the distance to the sun
+#define ASTRONOMICAL_UNIT 1.49597870691E8
+#define DISTANCE_TOLERANCE 0.02
+
+void test_solar_system_sun_position(void **param)
+{
+	predict_julian_date_t time = predict_to_julian(SOLSTICE_UNIX_TIME);
+	double position[3];
+	solar_system_sun_position(time, position);
+	double distance = sqrt(position[0]*position[0] + position[1]*position[1] + position[2]*position[2]);
+	assert_true(fabs(distance/ASTRONOMICAL_UNIT - 1.0) < DISTANCE_TOLERANCE);
+	assert_true(fabs(asin(position[2]/distance) - OBLIQUITY) < DECLINATION_TOLERANCE);
+
+	//memoized position is returned for the same time, and recalculated for other times
+	double memoized_position[3];
+	solar_system_sun_position(time, memoized_position);
+	for (int i=0; i < 3; i++) {
+		assert_true(memoized_position[i] == position[i]);
+	}
+	double later_position[3];
+	solar_system_sun_position(time + 0.5, later_position);
+	assert_true(later_position[0] != position[0]);
+}
+
+/**
+ * Check that memoized observations equal the observations from libpredict.
+ *
+ * \param observer Observer
+ * \param time Time
+ **/
+void assert_observations_equal_to_libpredict(const predict_observer_t *observer, predict_julian_date_t time)
+{
+	struct predict_observation obs, expected_obs;
+	solar_system_observe_sun(observer, time, &obs);
+	predict_observe_sun(observer, time, &expected_obs);
+	assert_true(obs.time == expected_obs.time);
+	assert_true(obs.azimuth == expected_obs.azimuth);
+	assert_true(obs.elevation == expected_obs.elevation);
+
+	solar_system_observe_moon(observer, time, &obs);
+	predict_observe_moon(observer, time, &expected_obs);
+	assert_true(obs.time == expected_obs.time);
+	assert_true(obs.azimuth == expected_obs.azimuth);
+	assert_true(obs.elevation == expected_obs.elevation);
+}
+
+void test_solar_system_observations(void **param)
+{
+	predict_observer_t *observer = predict_create_observer("test", 63.42*M_PI/180.0, 10.39*M_PI/180.0, 0);
+	predict_observer_t *other_observer = predict_create_observer("test", -33.92*M_PI/180.0, 18.42*M_PI/180.0, 0);
+	predict_julian_date_t time = predict_to_julian(SOLSTICE_UNIX_TIME);
+
+	//repeated observations, and observations at other times and from other observers, are not mixed up
+	assert_observations_equal_to_libpredict(observer, time);
+	assert_observations_equal_to_libpredict(observer, time);
+	assert_observations_equal_to_libpredict(observer, time + 1.0/86400.0);
+	assert_observations_equal_to_libpredict(other_observer, time + 1.0/86400.0);
+	assert_observations_equal_to_libpredict(observer, time);
+
+	//observer changed in place
+	other_observer->latitude = observer->latitude;
+	assert_observations_equal_to_libpredict(other_observer, time);
+	other_observer->latitude = 0;
+	assert_observations_equal_to_libpredict(other_observer, time);
+
+	predict_destroy_observer(observer);
+	predict_destroy_observer(other_observer);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_solar_system_sun_position),
+		cmocka_unit_test(test_solar_system_observations),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
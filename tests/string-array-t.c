@@ -34,6 +34,16 @@ void test_string_array(void **param)
 	string_array_free(&string_array);
 	assert_int_equal(string_array_size(&string_array), 0);
 	assert_null(string_array_get(&string_array, 0));
+
+	//sort
+	string_array_sort(&string_array);
+	stringsplit("visual.txt:amateur.txt:cubesat.txt:amateur.txt", &string_array);
+	string_array_sort(&string_array);
+	assert_string_equal(string_array_get(&string_array, 0), "amateur.txt");
+	assert_string_equal(string_array_get(&string_array, 1), "amateur.txt");
+	assert_string_equal(string_array_get(&string_array, 2), "cubesat.txt");
+	assert_string_equal(string_array_get(&string_array, 3), "visual.txt");
+	string_array_free(&string_array);
 }
 
 #define NUM_STRINGS 5
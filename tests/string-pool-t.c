@@ -0,0 +1,68 @@
+#include "string_pool.h"
+#include <string.h>
+#include <stdio.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+void test_string_pool_intern(void **param)
+{
+	string_pool_t string_pool = {0};
+	assert_int_equal(string_pool_size(&string_pool), 0);
+
+	//add strings
+	char buffer[] = "test";
+	const char *string_1 = string_pool_intern(&string_pool, buffer);
+	const char *string_2 = string_pool_intern(&string_pool, "other test");
+	assert_string_equal(string_1, "test");
+	assert_string_equal(string_2, "other test");
+	assert_true(string_1 != buffer);
+	assert_int_equal(string_pool_size(&string_pool), 2);
+
+	//duplicates are returned as the same pointer
+	strcpy(buffer, "test");
+	assert_true(string_pool_intern(&string_pool, buffer) == string_1);
+	assert_int_equal(string_pool_size(&string_pool), 2);
+
+	//NULL is interned as empty string
+	const char *empty_string = string_pool_intern(&string_pool, NULL);
+	assert_string_equal(empty_string, "");
+	assert_true(string_pool_intern(&string_pool, "") == empty_string);
+
+	//free
+	string_pool_free(&string_pool);
+	assert_int_equal(string_pool_size(&string_pool), 0);
+}
+
+#define NUM_STRINGS 20000
+void test_string_pool_many_strings(void **param)
+{
+	//check that previously returned pointers stay valid across block allocations and hash table resizes
+	string_pool_t string_pool = {0};
+	const char *strings[NUM_STRINGS];
+	for (int i=0; i < NUM_STRINGS; i++) {
+		char string[64];
+		snprintf(string, 64, "satellite %d", i);
+		strings[i] = string_pool_intern(&string_pool, string);
+	}
+	assert_int_equal(string_pool_size(&string_pool), NUM_STRINGS);
+
+	for (int i=0; i < NUM_STRINGS; i++) {
+		char string[64];
+		snprintf(string, 64, "satellite %d", i);
+		assert_string_equal(strings[i], string);
+		assert_true(string_pool_intern(&string_pool, string) == strings[i]);
+	}
+	string_pool_free(&string_pool);
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {cmocka_unit_test(test_string_pool_intern),
+	cmocka_unit_test(test_string_pool_many_strings)};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
@@ -0,0 +1,85 @@
+#include "test-helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+void append_checksum(char *line)
+{
+	int sum = 0;
+	for (int i=0; i < strlen(line); i++) {
+		if ((line[i] >= '0') && (line[i] <= '9')) {
+			sum += line[i] - '0';
+		} else if (line[i] == '-') {
+			sum++;
+		}
+	}
+	sprintf(line + strlen(line), "%d", sum % 10);
+}
+
+void write_tle_file(const char *filename)
+{
+	time_t curr_time = time(NULL);
+	struct tm epoch;
+	gmtime_r(&curr_time, &epoch);
+	double day_of_year = epoch.tm_yday + 1 + (epoch.tm_hour + (epoch.tm_min + epoch.tm_sec/60.0)/60.0)/24.0;
+
+	FILE *file = fopen(filename, "w");
+	assert_non_null(file);
+	for (int i=0; i < NUM_SATELLITES; i++) {
+		char line1[MAX_NUM_CHARS];
+		char line2[MAX_NUM_CHARS];
+		snprintf(line1, MAX_NUM_CHARS, "1 %05dU 98067A   %02d%012.8f  .00000000  00000-0  00000-0 0  999", 40000 + i, epoch.tm_year % 100, day_of_year);
+		snprintf(line2, MAX_NUM_CHARS, "2 %05d  51.6400 %08.4f 0006700 130.5300 325.0200 15.50000000    1", 40000 + i, 90.0*i);
+		append_checksum(line1);
+		append_checksum(line2);
+		fprintf(file, "TEST-%d\n%s\n%s\n", i, line1, line2);
+	}
+	fclose(file);
+}
+
+struct tle_db *create_tle_db(char *tle_file)
+{
+	int fd = mkstemp(tle_file);
+	assert_true(fd >= 0);
+	close(fd);
+	write_tle_file(tle_file);
+
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(tle_file, tle_db);
+	assert_int_equal(tle_db->num_tles, NUM_SATELLITES);
+	for (int i=0; i < NUM_SATELLITES; i++) {
+		tle_db_entry_set_enabled(tle_db, i, i > 0);
+	}
+	return tle_db;
+}
+
+predict_julian_date_t orbital_elements_epoch(const predict_orbital_elements_t *orbital_elements)
+{
+	return tle_db_epoch(orbital_elements->epoch_year, orbital_elements->epoch_day);
+}
+
+char *xdg_data_dirs()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_data_home()
+{
+	return strdup((char*)mock());
+}
+
+char *xdg_config_home()
+{
+	return strdup((char*)mock());
+}
+
+void create_xdg_dirs()
+{
+}
@@ -0,0 +1,55 @@
+#ifndef TEST_HELPERS_H_DEFINED
+#define TEST_HELPERS_H_DEFINED
+
+#include "tle_db.h"
+
+/**
+ * Helpers shared between the tests that need a TLE database with predictable passes, or satellites in different
+ * orbits to compare against libpredict.
+ **/
+
+//low earth orbit satellites with different inclinations and eccentricities
+#define ISS_TLE_LINE_1 "1 25544U 98067A   16084.55798796  .00004357  00000-0  72721-4 0  9997"
+#define ISS_TLE_LINE_2 "2 25544  51.6434 120.1135 0001857 353.9995 119.8334 15.54240309991812"
+#define FO29_TLE_LINE_1 "1 24278U 96046B   16084.42997947 -.00000008  00000-0  26090-4 0  9998"
+#define FO29_TLE_LINE_2 "2 24278  98.5819  20.7415 0351351  62.1607 301.4670 13.53065762968051"
+
+//highly eccentric orbit of satellite 00005 from Vallado et al., "Revisiting Spacetrack Report #3" (AIAA 2006-6753)
+#define VALLADO_TLE_LINE_1 "1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753"
+#define VALLADO_TLE_LINE_2 "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667"
+
+//number of satellites in the test database
+#define NUM_SATELLITES 4
+
+/**
+ * Append TLE checksum to TLE line.
+ *
+ * \param line TLE line, without checksum
+ **/
+void append_checksum(char *line);
+
+/**
+ * Write TLE file with low earth orbit satellites with epoch at the current time, so that the passes are
+ * predictable regardless of when the test is run.
+ *
+ * \param filename Output file
+ **/
+void write_tle_file(const char *filename);
+
+/**
+ * Create TLE database from test TLE file, with the first satellite disabled.
+ *
+ * \param tle_file Template for mkstemp, overwritten with the name of the written TLE file
+ * \return TLE database
+ **/
+struct tle_db *create_tle_db(char *tle_file);
+
+/**
+ * Get epoch of orbital elements.
+ *
+ * \param orbital_elements Orbital elements
+ * \return Epoch
+ **/
+predict_julian_date_t orbital_elements_epoch(const predict_orbital_elements_t *orbital_elements);
+
+#endif
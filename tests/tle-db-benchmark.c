@@ -0,0 +1,47 @@
+/**
+ * Benchmark of loading a TLE file into the TLE database. Prints the number of loaded entries, the load time and the
+ * peak resident set size of the process.
+ *
+ * Usage: tle-db-benchmark [TLE file]
+ **/
+
+#include "tle_db.h"
+#include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+
+//default TLE file
+#define DEFAULT_TLE_FILE "test_data/newer_tles/amateur.txt"
+
+/**
+ * Get current time in seconds from a monotonic clock.
+ *
+ * \return Time (seconds)
+ **/
+double benchmark_time()
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec*1.0e-9;
+}
+
+int main(int argc, char **argv)
+{
+	const char *tle_file = (argc > 1) ? argv[1] : DEFAULT_TLE_FILE;
+
+	double start = benchmark_time();
+	struct tle_db *tle_db = tle_db_create();
+	if (tle_db_from_file(tle_file, tle_db) != 0) {
+		fprintf(stderr, "Could not read %s\n", tle_file);
+		tle_db_destroy(&tle_db);
+		return 1;
+	}
+	double duration = benchmark_time() - start;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	printf("%zu entries, %.1f ms, peak RSS %ld KiB\n", tle_db->num_tles, duration*1.0e3, usage.ru_maxrss);
+
+	tle_db_destroy(&tle_db);
+	return 0;
+}
@@ -6,6 +6,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <time.h>
 
 #include <setjmp.h>
 #include <stdarg.h>
@@ -28,13 +29,41 @@ void test_tle_db_find_entry(void **param)
 	long new_satellite_number = 83;
 	int index = 63;
 
-	tle_db->tles[index].satellite_number = new_satellite_number;
+	struct tle_db_entry new_entry = {0};
+	new_entry.satellite_number = new_satellite_number;
+	tle_db_overwrite_entry(index, tle_db, &new_entry);
 
 	assert_int_equal(tle_db_find_entry(tle_db, new_satellite_number), index);
+	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), -1);
 
 	index = 40;
 	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), index);
 	assert_int_equal(tle_db_find_entry(tle_db, 200), -1);
+
+	//remaining entries are still found after the changed satellite number, first entry is returned for the multiply defined number
+	assert_int_equal(tle_db_find_entry(tle_db, new_satellite_number), 63);
+	for (int i=0; i < expected_num_sats; i++) {
+		if ((i != 63) && (i + satnum_offset != new_satellite_number)) {
+			assert_int_equal(tle_db_find_entry(tle_db, i + satnum_offset), i);
+		}
+	}
+
+	//first entry is returned for multiply defined satellite numbers
+	struct tle_db_entry duplicate_entry = {0};
+	duplicate_entry.satellite_number = index + satnum_offset;
+	tle_db_add_entry(tle_db, &duplicate_entry);
+	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), index);
+
+	//duplicate is found when the first entry is changed
+	new_entry.satellite_number = 300;
+	tle_db_overwrite_entry(index, tle_db, &new_entry);
+	assert_int_equal(tle_db_find_entry(tle_db, index + satnum_offset), expected_num_sats);
+	assert_int_equal(tle_db_find_entry(tle_db, 300), index);
+
+	//index is reset when database is re-read
+	tle_db_from_file("/dev/NULL", tle_db);
+	assert_int_equal(tle_db_find_entry(tle_db, 300), -1);
+	tle_db_destroy(&tle_db);
 }
 
 void test_tle_db_add_entry(void **param)
@@ -73,14 +102,87 @@ void test_tle_db_from_file(void **param)
 	assert_string_equal(tle_db->tles[0].name, "CUTE-1.7+APD II (CO-65)");
 	assert_string_equal(tle_db->tles[0].line1, "1 32785U 08021C   13115.72547332  .00001052  00000-0  13319-3 0  6142");
 	assert_string_equal(tle_db->tles[0].line2, "2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098");
+	assert_int_equal(tle_db->tles[0].satellite_number, 32785);
+
+	//epoch is extracted from line 1 (2013, day 115.72547332)
+	struct tm epoch_time = {0};
+	epoch_time.tm_year = 2013-1900;
+	epoch_time.tm_mon = 3;
+	epoch_time.tm_mday = 25;
+	epoch_time.tm_hour = 17;
+	epoch_time.tm_min = 24;
+	epoch_time.tm_sec = 40;
+	assert_true(labs(predict_from_julian(tle_db->tles[0].epoch) - timegm(&epoch_time)) <= 1);
+
+	//CRLF line endings, padded names and invalid entries
+	char tempfile[] = "/tmp/tle-db-test-XXXXXX";
+	int fd = mkstemp(tempfile);
+	const char *contents = "CUTE-1.7+APD II (CO-65)   \r\n"
+	"1 32785U 08021C   13115.72547332  .00001052  00000-0  13319-3 0  6142\r\n"
+	"2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098\r\n"
+	"INVALID\n"
+	"1 32785U 08021C   13115.72547332  .00001052  00000-0  13319-3 0  6143\n"
+	"2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098\n"
+	"SHORT\n"
+	"1 32785U 08021C\n"
+	"2 32785  97.7560\n"
+	"A NAME THAT IS LONGER THAN THE TLE NAME FIELD\n"
+	"1 35933U 09051C   13115.83979722  .00000632  00000-0  16119-3 0  2924\n"
+	"2 35933  98.3513 224.0841 0005397 226.9721 279.2955 14.53892524190336";
+	assert_int_equal(write(fd, contents, strlen(contents)), strlen(contents));
+	close(fd);
+
+	retval = tle_db_from_file(tempfile, tle_db);
+	unlink(tempfile);
+	assert_int_equal(retval, 0);
+	assert_int_equal(tle_db->num_tles, 2);
+	assert_string_equal(tle_db->tles[0].name, "CUTE-1.7+APD II (CO-65)");
+	assert_string_equal(tle_db->tles[0].line2, "2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098");
+	assert_string_equal(tle_db->tles[1].name, "A NAME THAT IS LONGER TH");
+	assert_int_equal(tle_db->tles[1].satellite_number, 35933);
+	tle_db_destroy(&tle_db);
+}
+
+void test_tle_db_from_changing_file(void **param)
+{
+	struct tle_db *tle_db = tle_db_create();
+	struct tle_db *mapped_tle_db = tle_db_create();
+
+	//missing files and directories are not read
+	assert_int_not_equal(tle_db_from_changing_file("/dev/NULL", tle_db), 0);
+	assert_int_not_equal(tle_db_from_changing_file(TEST_TLE_DIR, tle_db), 0);
+	assert_int_equal(tle_db->num_tles, 0);
+
+	//same entries as when the file is memory mapped
+	assert_int_equal(tle_db_from_changing_file(TEST_TLE_DIR "newer_tles/amateur.txt", tle_db), 0);
+	assert_int_equal(tle_db_from_file(TEST_TLE_DIR "newer_tles/amateur.txt", mapped_tle_db), 0);
+	assert_true(tle_db->num_tles > 0);
+	assert_int_equal(tle_db->num_tles, mapped_tle_db->num_tles);
+	for (int i=0; i < tle_db->num_tles; i++) {
+		assert_string_equal(tle_db->tles[i].name, mapped_tle_db->tles[i].name);
+		assert_string_equal(tle_db->tles[i].line1, mapped_tle_db->tles[i].line1);
+		assert_string_equal(tle_db->tles[i].line2, mapped_tle_db->tles[i].line2);
+		assert_string_equal(tle_db->tles[i].filename, mapped_tle_db->tles[i].filename);
+	}
+
+	//empty file
+	char tempfile[] = "/tmp/tle-db-test-XXXXXX";
+	int fd = mkstemp(tempfile);
+	close(fd);
+	assert_int_equal(tle_db_from_changing_file(tempfile, tle_db), 0);
+	unlink(tempfile);
+	assert_int_equal(tle_db->num_tles, 0);
+
+	tle_db_destroy(&tle_db);
+	tle_db_destroy(&mapped_tle_db);
 }
 
 void test_tle_db_overwrite_entry(void **param)
 {
-	struct tle_db_entry entry_1;
+	struct tle_db_entry entry_1 = {0};
 	entry_1.satellite_number = 100;
 	char name[] = "name";
-	strcpy(entry_1.name, name);
+	entry_1.name = name;
 	char line1[] = "line_1";
 	strcpy(entry_1.line1, line1);
 	char line2[] = "line_2";
@@ -108,14 +210,14 @@ void test_tle_db_overwrite_entry(void **param)
 
 void test_tle_db_entry_is_newer_than(void **param)
 {
-	struct tle_db_entry old_entry;
-	strcpy(old_entry.name, "BEESAT");
+	struct tle_db_entry old_entry = {0};
+	old_entry.name = "BEESAT";
 	old_entry.satellite_number = 35933;
 	strcpy(old_entry.line1, "1 35933U 09051C   13115.83979722  .00000632  00000-0  16119-3 0  2924");
 	strcpy(old_entry.line2, "2 35933  98.3513 224.0841 0005397 226.9721 279.2955 14.53892524190336");
 
-	struct tle_db_entry new_entry;
-	strcpy(new_entry.name, "BEESAT");
+	struct tle_db_entry new_entry = {0};
+	new_entry.name = "BEESAT";
 	new_entry.satellite_number = 35933;
 	strcpy(new_entry.line1, "1 35933U 09051C   16083.86818462  .00000300  00000-0  79122-4 0  9997");
 	strcpy(new_entry.line2, "2 35933  98.4372 211.0478 0005599 197.7075 162.3928 14.55908579344897");
@@ -124,6 +226,43 @@ void test_tle_db_entry_is_newer_than(void **param)
 	assert_false(tle_db_entry_is_newer_than(old_entry, new_entry));
 }
 
+void test_tle_db_entry_get_orbital_elements(void **param)
+{
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "old_tles/part1.tle", tle_db);
+	assert_true(tle_db->num_tles > 1);
+
+	//out of bounds
+	assert_null(tle_db_entry_get_orbital_elements(tle_db, -1));
+	assert_null(tle_db_entry_get_orbital_elements(tle_db, tle_db->num_tles));
+
+	//TLE is parsed once and shared between all references
+	struct tle_db_orbital_elements *elements_1 = tle_db_entry_get_orbital_elements(tle_db, 0);
+	struct tle_db_orbital_elements *elements_2 = tle_db_entry_get_orbital_elements(tle_db, 0);
+	assert_non_null(elements_1);
+	assert_ptr_equal(elements_1, elements_2);
+	assert_int_equal(elements_1->refcount, 3);
+	assert_int_equal(elements_1->elements->satellite_number, tle_db->tles[0].satellite_number);
+	tle_db_orbital_elements_release(&elements_2);
+	assert_null(elements_2);
+	assert_int_equal(elements_1->refcount, 2);
+
+	//overwriting the entry invalidates the cache, but keeps the old reference valid
+	tle_db_overwrite_entry(0, tle_db, &(tle_db->tles[1]));
+	elements_2 = tle_db_entry_get_orbital_elements(tle_db, 0);
+	assert_ptr_not_equal(elements_1, elements_2);
+	assert_int_equal(elements_1->refcount, 1);
+	assert_int_equal(elements_2->elements->satellite_number, tle_db->tles[1].satellite_number);
+
+	//references outlive the database
+	long satellite_number = tle_db->tles[1].satellite_number;
+	tle_db_destroy(&tle_db);
+	assert_int_equal(elements_2->refcount, 1);
+	assert_int_equal(elements_2->elements->satellite_number, satellite_number);
+	tle_db_orbital_elements_release(&elements_1);
+	tle_db_orbital_elements_release(&elements_2);
+}
+
 void test_tle_db_from_directory(void **param)
 {
 	struct tle_db *tle_db = tle_db_create();
@@ -170,7 +309,34 @@ void test_tle_db_from_directory(void **param)
 	}
 	assert_true(in_both); //check that we actually encounter a TLE in both new and old databases
 
+	//TLEs with equal epochs are taken from the first file in filename order
+	char tempdir[] = "/tmp/tle-db-test-XXXXXX";
+	assert_non_null(mkdtemp(tempdir));
+	const char *filenames[] = {"c.tle", "a.tle", "b.tle"};
+	const char *names[] = {"NAME IN C", "NAME IN A", "NAME IN B"};
+	for (int i=0; i < 3; i++) {
+		char filepath[MAX_NUM_CHARS];
+		snprintf(filepath, MAX_NUM_CHARS, "%s/%s", tempdir, filenames[i]);
+		FILE *fd = fopen(filepath, "w");
+		fprintf(fd, "%s\n", names[i]);
+		fprintf(fd, "1 32785U 08021C   13115.72547332  .00001052  00000-0  13319-3 0  6142\n");
+		fprintf(fd, "2 32785  97.7560 174.7469 0015936 118.7374  28.1173 14.83745831270098\n");
+		fclose(fd);
+	}
+	tle_db_from_file("/dev/NULL", tle_db);
+	tle_db_from_directory(tempdir, tle_db);
+	assert_int_equal(tle_db->num_tles, 1);
+	assert_string_equal(tle_db->tles[0].name, "NAME IN A");
+	for (int i=0; i < 3; i++) {
+		char filepath[MAX_NUM_CHARS];
+		snprintf(filepath, MAX_NUM_CHARS, "%s/%s", tempdir, filenames[i]);
+		unlink(filepath);
+	}
+	rmdir(tempdir);
+
 	tle_db_destroy(&tle_db);
+	tle_db_destroy(&old_tles);
+	tle_db_destroy(&new_tles);
 }
 
 void test_tle_db_enabled(void **param)
@@ -465,7 +631,9 @@ void test_whitelist_from_search_paths(void **param)
 void set_filenames(struct tle_db *tle_db, const char *filename)
 {
 	for (int i=0; i < tle_db->num_tles; i++) {
-		strcpy(tle_db->tles[i].filename, filename);
+		struct tle_db_entry entry = tle_db->tles[i];
+		entry.filename = filename;
+		tle_db_overwrite_entry(i, tle_db, &entry);
 	}
 }
 
@@ -600,13 +768,88 @@ void test_tle_db_update(void **param)
 	free(update_status);
 }
 
+void test_tle_db_update_from_files(void **param)
+{
+	struct tle_db *tle_db = tle_db_create();
+	tle_db_from_directory(TEST_TLE_DIR "old_tles/", tle_db);
+	int num_tles = tle_db->num_tles;
+
+	//distribute TLE entries over two writable files
+	char temp_dir[] = "/tmp/flybytestXXXXXX";
+	assert_non_null(mkdtemp(temp_dir));
+	char filenames[2][MAX_NUM_CHARS];
+	for (int i=0; i < 2; i++) {
+		snprintf(filenames[i], MAX_NUM_CHARS, "%s/%d.tle", temp_dir, i);
+	}
+	for (int i=0; i < tle_db->num_tles; i++) {
+		struct tle_db_entry entry = tle_db->tles[i];
+		entry.filename = filenames[i % 2];
+		tle_db_overwrite_entry(i, tle_db, &entry);
+	}
+
+	for (int i=0; i < 2; i++) {
+		int fid = open(filenames[i], O_WRONLY|O_CREAT|O_TRUNC, 0777);
+		close(fid);
+	}
+
+	//update using the newer TLEs, the older TLEs and a missing file at once
+	string_array_t update_files = {0};
+	string_array_add(&update_files, TEST_TLE_DIR "old_tles/part1.tle");
+	string_array_add(&update_files, TEST_TLE_DIR "newer_tles/amateur.txt");
+	string_array_add(&update_files, "/dev/NULL");
+	int *update_status = (int*)calloc(tle_db->num_tles, sizeof(int));
+	tle_db_update_from_files(&update_files, tle_db, update_status);
+	string_array_free(&update_files);
+
+	struct tle_db *new_tles = tle_db_create();
+	tle_db_from_file(TEST_TLE_DIR "newer_tles/amateur.txt", new_tles);
+	bool updated = false;
+	for (int i=0; i < tle_db->num_tles; i++) {
+		int new_ind = tle_db_find_entry(new_tles, tle_db->tles[i].satellite_number);
+		if (update_status[i] & TLE_DB_UPDATED) {
+			updated = true;
+			assert_true(update_status[i] & TLE_FILE_UPDATED);
+			assert_false(update_status[i] & TLE_IN_NEW_FILE);
+			assert_int_not_equal(new_ind, -1);
+			assert_string_equal(tle_db->tles[i].line1, new_tles->tles[new_ind].line1);
+		}
+		assert_string_equal(tle_db->tles[i].filename, filenames[i % 2]);
+	}
+	assert_true(updated);
+	assert_int_equal(tle_db->num_tles, num_tles);
+
+	//each file contains exactly its own entries, in database order and with the updated TLEs
+	for (int i=0; i < 2; i++) {
+		struct tle_db *file_db = tle_db_create();
+		assert_int_equal(tle_db_from_file(filenames[i], file_db), 0);
+		int file_index = 0;
+		for (int j=i; j < tle_db->num_tles; j += 2) {
+			assert_true(file_index < file_db->num_tles);
+			assert_int_equal(file_db->tles[file_index].satellite_number, tle_db->tles[j].satellite_number);
+			assert_string_equal(file_db->tles[file_index].line1, tle_db->tles[j].line1);
+			assert_string_equal(file_db->tles[file_index].line2, tle_db->tles[j].line2);
+			file_index++;
+		}
+		assert_int_equal(file_db->num_tles, file_index);
+		tle_db_destroy(&file_db);
+		unlink(filenames[i]);
+	}
+	rmdir(temp_dir);
+
+	free(update_status);
+	tle_db_destroy(&new_tles);
+	tle_db_destroy(&tle_db);
+}
+
 int main()
 {
 	struct CMUnitTest tests[] = {cmocka_unit_test(test_tle_db_add_entry),
 	cmocka_unit_test(test_tle_db_find_entry),
 	cmocka_unit_test(test_tle_db_from_file),
+	cmocka_unit_test(test_tle_db_from_changing_file),
 	cmocka_unit_test(test_tle_db_overwrite_entry),
 	cmocka_unit_test(test_tle_db_entry_is_newer_than),
+	cmocka_unit_test(test_tle_db_entry_get_orbital_elements),
 	cmocka_unit_test(test_tle_db_from_directory),
 	cmocka_unit_test(test_tle_db_filenames),
 	cmocka_unit_test(test_whitelist_from_file),
@@ -614,6 +857,7 @@ int main()
 	cmocka_unit_test(test_tle_db_merge),
 	cmocka_unit_test(test_whitelist_from_search_paths),
 	cmocka_unit_test(test_tle_db_update),
+	cmocka_unit_test(test_tle_db_update_from_files),
 	cmocka_unit_test(test_tle_db_from_search_paths),
 	cmocka_unit_test(test_tle_db_enabled)
 	};
@@ -352,7 +352,7 @@ void test_transponder_db_with_num_transponders_near_and_above_maximum_limit(void
 	for (int i=0; i < transponder_db->num_sats; i++) {
 		should_write[i] = true;
 		for (int j=0; j < MAX_NUM_TRANSPONDERS; j++) {
-			snprintf(transponder_db->sats[i].transponders[j].name, MAX_NUM_CHARS, "%s-%d", tle_db->tles[i].name, j);
+			snprintf(transponder_db->sats[i].transponders[j].name, MAX_NUM_CHARS, "%s-%d", tle_db_entry_name(tle_db, i), j);
 			transponder_db->sats[i].transponders[j].downlink_start = j+1;
 			transponder_db->sats[i].transponders[j].downlink_end = j+1;
 		}
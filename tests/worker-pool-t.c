@@ -0,0 +1,59 @@
+#include "worker_pool.h"
+#include <stdlib.h>
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+
+#define NUM_TASKS 10000
+
+/**
+ * Task function used in tests. Increments the task's counter.
+ *
+ * \param data Array of counters
+ * \param index Task index
+ **/
+void increment_task(void *data, int index)
+{
+	int *counters = (int*)data;
+	counters[index]++;
+}
+
+void test_worker_pool_run(void **param)
+{
+	int num_threads[] = {1, 2, 4, 0};
+	for (int i=0; i < sizeof(num_threads)/sizeof(num_threads[0]); i++) {
+		struct worker_pool *pool = worker_pool_create(num_threads[i]);
+		int *counters = (int*)calloc(NUM_TASKS, sizeof(int));
+
+		//all tasks are run exactly once per run
+		worker_pool_run(pool, NUM_TASKS, increment_task, counters);
+		for (int j=0; j < NUM_TASKS; j++) {
+			assert_int_equal(counters[j], 1);
+		}
+
+		//pool can be reused, also for fewer tasks than threads
+		worker_pool_run(pool, 1, increment_task, counters);
+		worker_pool_run(pool, 0, increment_task, counters);
+		worker_pool_run(pool, NUM_TASKS, increment_task, counters);
+		assert_int_equal(counters[0], 3);
+		for (int j=1; j < NUM_TASKS; j++) {
+			assert_int_equal(counters[j], 2);
+		}
+
+		free(counters);
+		worker_pool_destroy(&pool);
+		assert_null(pool);
+	}
+}
+
+int main()
+{
+	struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_worker_pool_run),
+	};
+
+	int rc = cmocka_run_group_tests(tests, NULL, NULL);
+	return rc;
+}
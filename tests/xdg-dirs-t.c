@@ -26,6 +26,7 @@ void test_directory_exists(void **param)
 #define DEFAULT_XDG_DATA_HOME_BASE ".local/"
 #define DEFAULT_XDG_DATA_HOME DEFAULT_XDG_DATA_HOME_BASE "share/"
 #define DEFAULT_XDG_CONFIG_HOME ".config/"
+#define DEFAULT_XDG_CACHE_HOME ".cache/"
 #define TMP_DIR "/tmp/"
 
 void test_xdg_data_dirs(void **param)
@@ -91,6 +92,23 @@ void test_xdg_config_home(void **param)
 	assert_string_equal(xdg_config_home(), "./" DEFAULT_XDG_CONFIG_HOME);
 }
 
+void test_xdg_cache_home(void **param)
+{
+	//return XDG_CACHE_HOME if defined
+	setenv("XDG_CACHE_HOME", "/tmp/", 1);
+	assert_string_equal(xdg_cache_home(), "/tmp/");
+
+	setenv("XDG_CACHE_HOME", "/tmp", 1);
+	assert_string_equal(xdg_cache_home(), "/tmp/");
+
+	//return $HOME/.cache if not
+	setenv("XDG_CACHE_HOME", "", 1);
+	setenv("HOME", ".", 1);
+	assert_string_equal(xdg_cache_home(), "./" DEFAULT_XDG_CACHE_HOME);
+	unsetenv("XDG_CACHE_HOME");
+	assert_string_equal(xdg_cache_home(), "./" DEFAULT_XDG_CACHE_HOME);
+}
+
 /**
  * Add extra tailing directory to a path string.
  *
@@ -262,6 +280,7 @@ int main()
 		cmocka_unit_test(test_xdg_data_dirs),
 		cmocka_unit_test(test_xdg_config_dirs),
 		cmocka_unit_test(test_xdg_config_home),
+		cmocka_unit_test(test_xdg_cache_home),
 		cmocka_unit_test(test_xdg_data_home),
 		cmocka_unit_test(test_create_xdg_dirs_when_xdg_directories_are_welldefined),
 		cmocka_unit_test(test_create_xdg_dirs_when_dotlocal_and_dotconfig_have_not_been_created),